@@ -19,6 +19,7 @@ doc_files=(
 	'Display.md'
     'Buzzer.md'
 	'Sonar.md'
+	'Gyro.md'
 	'Profiles.md'
     'Modes.md'
     'Inflight Adjustments.md'
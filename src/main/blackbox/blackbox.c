@@ -189,6 +189,7 @@ static const blackboxMainFieldDefinition_t blackboxMainFields[] = {
 
     {"vbatLatest",    -1, UNSIGNED, .Ipredict = PREDICT(VBATREF),  .Iencode = ENCODING(NEG_14BIT),   .Ppredict = PREDICT(PREVIOUS),  .Pencode = ENCODING(TAG8_8SVB), FLIGHT_LOG_FIELD_CONDITION_VBAT},
     {"amperageLatest",-1, UNSIGNED, .Ipredict = PREDICT(0),        .Iencode = ENCODING(UNSIGNED_VB), .Ppredict = PREDICT(PREVIOUS),  .Pencode = ENCODING(TAG8_8SVB), FLIGHT_LOG_FIELD_CONDITION_AMPERAGE},
+    {"rssi",          -1, UNSIGNED, .Ipredict = PREDICT(0),        .Iencode = ENCODING(UNSIGNED_VB), .Ppredict = PREDICT(PREVIOUS),  .Pencode = ENCODING(TAG8_8SVB), FLIGHT_LOG_FIELD_CONDITION_RSSI},
 
 #ifdef MAG
     {"magADC",      0, SIGNED,   .Ipredict = PREDICT(0),       .Iencode = ENCODING(SIGNED_VB),   .Ppredict = PREDICT(PREVIOUS),      .Pencode = ENCODING(TAG8_8SVB), FLIGHT_LOG_FIELD_CONDITION_MAG},
@@ -264,6 +265,10 @@ extern uint8_t motorCount;
 //From mw.c:
 extern uint32_t currentTime;
 
+//From rx.c:
+extern uint16_t rssi;
+extern int16_t telemTemperature1;
+
 static BlackboxState blackboxState = BLACKBOX_STATE_DISABLED;
 
 static struct {
@@ -346,6 +351,10 @@ static bool testBlackboxConditionUncached(FlightLogFieldCondition condition)
         case FLIGHT_LOG_FIELD_CONDITION_AMPERAGE:
             return feature(FEATURE_CURRENT_METER);
 
+        case FLIGHT_LOG_FIELD_CONDITION_RSSI:
+            // with a serial receiver and no other source rssi is the link quality
+            return masterConfig.rxConfig.rssi_channel > 0 || feature(FEATURE_RSSI_ADC | FEATURE_RX_SERIAL);
+
         case FLIGHT_LOG_FIELD_CONDITION_NOT_LOGGING_EVERY_FRAME:
             return masterConfig.blackbox_rate_num < masterConfig.blackbox_rate_denom;
 
@@ -451,6 +460,10 @@ static void writeIntraframe(void)
         blackboxWriteUnsignedVB(blackboxCurrent->amperageLatest);
     }
 
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RSSI)) {
+        blackboxWriteUnsignedVB(blackboxCurrent->rssi);
+    }
+
 #ifdef MAG
         if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_MAG)) {
             for (x = 0; x < XYZ_AXIS_COUNT; x++) {
@@ -547,7 +560,7 @@ static void writeInterframe(void)
 
     blackboxWriteTag8_4S16(deltas);
 
-    //Check for sensors that are updated periodically (so deltas are normally zero) VBAT, Amperage, MAG, BARO
+    //Check for sensors that are updated periodically (so deltas are normally zero) VBAT, Amperage, RSSI, MAG, BARO
     int optionalFieldCount = 0;
 
     if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
@@ -558,6 +571,10 @@ static void writeInterframe(void)
         deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->amperageLatest - blackboxLast->amperageLatest;
     }
 
+    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RSSI)) {
+        deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->rssi - blackboxLast->rssi;
+    }
+
 #ifdef MAG
     if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_MAG)) {
         for (x = 0; x < XYZ_AXIS_COUNT; x++) {
@@ -761,6 +778,7 @@ static void loadBlackboxState(void)
 
     blackboxCurrent->vbatLatest = vbatLatestADC;
     blackboxCurrent->amperageLatest = amperageLatestADC;
+    blackboxCurrent->rssi = rssi;
 
 #ifdef MAG
     for (i = 0; i < XYZ_AXIS_COUNT; i++) {
@@ -858,6 +876,30 @@ static bool sendFieldDefinition(const char * const *headerNames, unsigned int he
     return xmitState.headerIndex < headerCount;
 }
 
+/**
+ * Print a header line listing the learnt gyro temperature compensation table, the still window count of each point
+ * for axis < 0, otherwise the bias of that axis at each point in 1/16 LSB.
+ */
+static int blackboxPrintGyroTempCompHeader(int8_t axis)
+{
+    const gyroTempCompensation_t *table = &masterConfig.gyroTempCompensation;
+    int charsWritten;
+    uint8_t point;
+
+    if (axis < 0) {
+        charsWritten = blackboxPrint("H gyro_temp_comp_windows:");
+    } else {
+        charsWritten = blackboxPrintf("H gyro_temp_comp[%d]:", axis);
+    }
+
+    for (point = 0; point < GYRO_TEMP_COMP_POINT_COUNT; point++) {
+        charsWritten += blackboxPrintf(point > 0 ? ",%d" : "%d", axis < 0 ? table->windowCount[point] : table->bias[point][axis]);
+    }
+    charsWritten += blackboxPrint("\n");
+
+    return charsWritten;
+}
+
 /**
  * Transmit a portion of the system information headers. Call the first time with xmitState.headerIndex == 0. Returns
  * true iff transmission is complete, otherwise call again later to continue transmission.
@@ -921,6 +963,18 @@ static bool blackboxWriteSysinfo()
         case 13:
             xmitState.u.serialBudget -= blackboxPrintf("H currentMeter:%d,%d\n", masterConfig.batteryConfig.currentMeterOffset, masterConfig.batteryConfig.currentMeterScale);
         break;
+        case 14:
+            xmitState.u.serialBudget -= blackboxPrintf("H gyro_temperature:%d\n", telemTemperature1);
+        break;
+        case 15:
+            xmitState.u.serialBudget -= blackboxPrintf("H gyro_temp_comp_points:%d,%d\n", GYRO_TEMP_COMP_MIN_TEMPERATURE, GYRO_TEMP_COMP_POINT_SPACING);
+        break;
+        case 16:
+        case 17:
+        case 18:
+        case 19:
+            xmitState.u.serialBudget -= blackboxPrintGyroTempCompHeader(xmitState.headerIndex - 17);
+        break;
         default:
             return true;
     }
@@ -36,6 +36,7 @@ typedef struct blackboxValues_t {
 
     uint16_t vbatLatest;
     uint16_t amperageLatest;
+    uint16_t rssi;
 
 #ifdef BARO
     int32_t BaroAlt;
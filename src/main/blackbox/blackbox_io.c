@@ -477,7 +477,7 @@ bool blackboxDeviceOpen(void)
                 return false;
             }
 
-            return true;
+            return flashfsLogBegin(millis());
         break;
 #endif
         default:
@@ -505,7 +505,8 @@ void blackboxDeviceClose(void)
             break;
 #ifdef USE_FLASHFS
         case BLACKBOX_DEVICE_FLASH:
-            // No-op since the flash doesn't have a "close" and there's nobody else to hand control of it to.
+            // Record the length of the log in the volume index, there's nobody else to hand control of the flash to.
+            flashfsLogEnd();
             break;
 #endif
     }
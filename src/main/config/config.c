@@ -17,6 +17,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "platform.h"
@@ -26,15 +27,16 @@
 #include "common/color.h"
 #include "common/axis.h"
 #include "common/maths.h"
+#include "common/crc.h"
+#include "common/utils.h"
 
 #include "drivers/sensor.h"
 #include "drivers/accgyro.h"
 #include "drivers/compass.h"
 #include "drivers/system.h"
-#include "drivers/gpio.h"
-#include "drivers/timer.h"
-#include "drivers/pwm_rx.h"
+#include "drivers/input_filtering.h"
 #include "drivers/serial.h"
+#include "drivers/config_flash.h"
 
 #include "sensors/sensors.h"
 #include "sensors/gyro.h"
@@ -44,6 +46,7 @@
 #include "sensors/boardalignment.h"
 #include "sensors/battery.h"
 
+#include "io/beeper.h"
 #include "io/statusindicator.h"
 #include "io/serial.h"
 #include "io/gimbal.h"
@@ -55,6 +58,8 @@
 
 #include "rx/rx.h"
 
+#include "io/rc_interpolation.h"
+
 #include "telemetry/telemetry.h"
 
 #include "flight/mixer.h"
@@ -66,6 +71,7 @@
 
 #include "config/runtime_config.h"
 #include "config/config.h"
+#include "config/config_storage.h"
 
 #include "config/config_profile.h"
 #include "config/config_master.h"
@@ -86,39 +92,16 @@ void mixerUseConfigs(
 );
 void useRcControlsConfig(modeActivationCondition_t *modeActivationConditions, escAndServoConfig_t *escAndServoConfigToUse, pidProfile_t *pidProfileToUse);
 
-#define FLASH_TO_RESERVE_FOR_CONFIG 0x800
-
-#ifndef FLASH_PAGE_COUNT
-#ifdef STM32F303xC
-#define FLASH_PAGE_COUNT 128
-#define FLASH_PAGE_SIZE                 ((uint16_t)0x800)
-#endif
-
-#ifdef STM32F10X_MD
-#define FLASH_PAGE_COUNT 128
-#define FLASH_PAGE_SIZE                 ((uint16_t)0x400)
-#endif
-
-#ifdef STM32F10X_HD
-#define FLASH_PAGE_COUNT 128
-#define FLASH_PAGE_SIZE                 ((uint16_t)0x800)
-#endif
-#endif
-
-#if !defined(FLASH_PAGE_COUNT) || !defined(FLASH_PAGE_SIZE)
-#error "Flash page count not defined for target."
-#endif
-
-// use the last flash pages for storage
-#define CONFIG_START_FLASH_ADDRESS (0x08000000 + (uint32_t)((FLASH_PAGE_SIZE * FLASH_PAGE_COUNT) - FLASH_TO_RESERVE_FOR_CONFIG))
-
 master_t masterConfig;                 // master config struct with data independent from profiles
 profile_t *currentProfile;
 
 static uint8_t currentControlRateProfileIndex = 0;
 controlRateConfig_t *currentControlRateProfile;
 
-static const uint8_t EEPROM_CONF_VERSION = 94;
+static const uint8_t EEPROM_CONF_VERSION = 99;
+
+// set when a config change could not be written to flash right away, it is written on the next disarm
+static bool configSavePending = false;
 
 static void resetAccelerometerTrims(flightDynamicsTrims_t *accelerometerTrims)
 {
@@ -238,6 +221,7 @@ void resetBatteryConfig(batteryConfig_t *batteryConfig)
     batteryConfig->currentMeterOffset = 0;
     batteryConfig->currentMeterScale = 400; // for Allegro ACS758LCB-100U (40mV/A)
     batteryConfig->batteryCapacity = 0;
+    batteryConfig->batteryResistance = 0;
     batteryConfig->currentMeterType = CURRENT_SENSOR_ADC;
 }
 
@@ -328,6 +312,16 @@ static void setControlRateProfile(uint8_t profileIndex)
     currentControlRateProfile = &masterConfig.controlRateProfiles[profileIndex];
 }
 
+static void setProfileAndDefaultControlRateProfile(uint8_t profileIndex)
+{
+    setProfile(profileIndex);
+
+    if (currentProfile->defaultRateProfileIndex > MAX_CONTROL_RATE_PROFILE_COUNT - 1) // sanity check
+        currentProfile->defaultRateProfileIndex = 0;
+
+    setControlRateProfile(currentProfile->defaultRateProfileIndex);
+}
+
 // Default settings
 static void resetConf(void)
 {
@@ -381,6 +375,9 @@ static void resetConf(void)
     masterConfig.rxConfig.maxcheck = 1900;
     masterConfig.rxConfig.rssi_channel = 0;
     masterConfig.rxConfig.rssi_scale = RSSI_SCALE_DEFAULT;
+    masterConfig.rxConfig.rc_interpolation = RC_INTERPOLATION_LINEAR;
+    masterConfig.rxConfig.rc_interpolation_hz = 20;
+    masterConfig.rxConfig.input_median_channels = 0;
 
     masterConfig.inputFilteringMode = INPUT_FILTERING_DISABLED;
 
@@ -578,45 +575,418 @@ static void resetConf(void)
     }
 }
 
-static uint8_t calculateChecksum(const uint8_t *data, uint32_t length)
-{
-    uint8_t checksum = 0;
-    const uint8_t *byteOffset;
+#define CONFIG_CRC_LENGTH offsetof(master_t, crc)
 
-    for (byteOffset = data; byteOffset < (data + length); byteOffset++)
-        checksum ^= *byteOffset;
-    return checksum;
+// reads part of a stored config image, returns false if it is out of range
+typedef bool (*configImageReadFn)(uint32_t offset, void *dest, uint32_t length);
+
+static uint32_t calculateStoredCRC(configImageReadFn readImage, uint32_t length)
+{
+    uint8_t buffer[CONFIG_STORAGE_BLOCK_SIZE];
+    uint32_t crc = 0;
+    uint32_t offset;
+    uint32_t chunkLength;
+
+    for (offset = 0; offset < length; offset += chunkLength) {
+        chunkLength = MIN(sizeof(buffer), length - offset);
+        readImage(offset, buffer, chunkLength);
+        crc = crc32Update(crc, buffer, chunkLength);
+    }
+    return crc;
 }
 
 static bool isEEPROMContentValid(void)
 {
-    const master_t *temp = (const master_t *) CONFIG_START_FLASH_ADDRESS;
-    uint8_t checksum = 0;
+    uint8_t version;
+    uint16_t size;
+    uint8_t magic_be;
+    uint8_t magic_ef;
+    uint32_t crc;
+
+    if (configStorageGetImageSize() != sizeof(master_t))
+        return false;
+
+    configStorageRead(offsetof(master_t, version), &version, sizeof(version));
+    configStorageRead(offsetof(master_t, size), &size, sizeof(size));
+    configStorageRead(offsetof(master_t, magic_be), &magic_be, sizeof(magic_be));
+    configStorageRead(offsetof(master_t, magic_ef), &magic_ef, sizeof(magic_ef));
+    configStorageRead(offsetof(master_t, crc), &crc, sizeof(crc));
 
     // check version number
-    if (EEPROM_CONF_VERSION != temp->version)
+    if (EEPROM_CONF_VERSION != version)
         return false;
 
     // check size and magic numbers
-    if (temp->size != sizeof(master_t) || temp->magic_be != 0xBE || temp->magic_ef != 0xEF)
+    if (size != sizeof(master_t) || magic_be != 0xBE || magic_ef != 0xEF)
         return false;
 
-    // verify integrity of temporary copy
-    checksum = calculateChecksum((const uint8_t *) temp, sizeof(master_t));
-    if (checksum != 0)
+    // verify integrity of stored copy
+    if (calculateStoredCRC(configStorageRead, CONFIG_CRC_LENGTH) != crc)
         return false;
 
     // looks good, let's roll!
     return true;
 }
 
+/*
+ * Migration of configs written by older firmware.
+ *
+ * Each entry describes the layout of one old EEPROM_CONF_VERSION as a list of fields to copy into master_t, anything
+ * not listed keeps its default value. Versions without an entry are reset to defaults as before. When bumping
+ * EEPROM_CONF_VERSION add an entry for the version being replaced and check that the existing entries still describe
+ * the old layouts, the BUILD_BUG_ONs in migrateEEPROM() pin the offsets they rely on and config_migration_unittest
+ * builds the old images at the offsets the ARM targets stored them at.
+ */
+typedef struct configMigrationField_s {
+    uint16_t oldOffset;
+    uint16_t newOffset;
+    uint16_t size;
+} configMigrationField_t;
+
+typedef struct configMigration_s {
+    uint8_t version;
+    uint16_t size;                                  // sizeof(master_t) of that version
+    uint16_t magicEfOffset;
+    bool xorChecksum;                               // versions up to 94 used an 8 bit XOR checksum, later ones a CRC32
+    const configMigrationField_t *fields;
+    uint8_t fieldCount;
+} configMigration_t;
+
+#define CONFIG_MIGRATION_FIELD(oldOffset, newOffset, size) { (oldOffset), (newOffset), (size) }
+#define CONFIG_MIGRATION_UNCHANGED(firstField, endField) \
+    CONFIG_MIGRATION_FIELD(offsetof(master_t, firstField), offsetof(master_t, firstField), offsetof(master_t, endField) - offsetof(master_t, firstField))
+
+// version 94 ended with "uint8_t magic_ef; uint8_t chk;", later versions with "uint8_t magic_ef; uint32_t crc;".
+#define CONFIG_XOR_IMAGE_SIZE(magicEfOffset) (((magicEfOffset) + 2 + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+#define CONFIG_CRC_IMAGE_SIZE(magicEfOffset) ((((magicEfOffset) + 1 + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1)) + sizeof(uint32_t))
+
+// versions up to 98 ended with the blackbox settings, gyroTempCompensation was added after them.
+#ifdef BLACKBOX
+#define CONFIG_V98_MAGIC_EF_OFFSET (offsetof(master_t, blackbox_device) + sizeof(masterConfig.blackbox_device))
+#else
+#define CONFIG_V98_MAGIC_EF_OFFSET (offsetof(master_t, controlRateProfiles) + sizeof(masterConfig.controlRateProfiles))
+#endif
+
+/*
+ * Old versions differ from the current one between batteryConfig and telemetryConfig only, the layouts of that region
+ * are frozen below as the ARM targets stored them. Enums are a single byte there (-fshort-enums), hence uint8_t. The
+ * region starts at magZero, which is word aligned, so that its padding is the one of master_t.
+ */
+typedef struct configV95BatteryConfig_s {
+    uint8_t vbatscale;
+    uint8_t vbatmaxcellvoltage;
+    uint8_t vbatmincellvoltage;
+    uint8_t vbatwarningcellvoltage;
+    int16_t currentMeterScale;
+    uint16_t currentMeterOffset;
+    uint8_t currentMeterType;
+    uint8_t multiwiiCurrentMeterOutput;
+    uint16_t batteryCapacity;
+} configV95BatteryConfig_t;
+
+typedef struct configV96BatteryConfig_s {
+    uint8_t vbatscale;
+    uint8_t vbatmaxcellvoltage;
+    uint8_t vbatmincellvoltage;
+    uint8_t vbatwarningcellvoltage;
+    int16_t currentMeterScale;
+    uint16_t currentMeterOffset;
+    uint8_t currentMeterType;
+    uint8_t multiwiiCurrentMeterOutput;
+    uint8_t batteryResistance;
+    uint16_t batteryCapacity;
+} configV96BatteryConfig_t;
+
+typedef struct configV96RxConfig_s {
+    uint8_t rcmap[MAX_MAPPABLE_RX_INPUTS];
+    uint8_t serialrx_provider;
+    uint8_t spektrum_sat_bind;
+    uint8_t rssi_channel;
+    uint8_t rssi_scale;
+    uint16_t midrc;
+    uint16_t mincheck;
+    uint16_t maxcheck;
+} configV96RxConfig_t;
+
+typedef struct configV97RxConfig_s {
+    uint8_t rcmap[MAX_MAPPABLE_RX_INPUTS];
+    uint8_t serialrx_provider;
+    uint8_t spektrum_sat_bind;
+    uint8_t rssi_channel;
+    uint8_t rssi_scale;
+    uint16_t midrc;
+    uint16_t mincheck;
+    uint16_t maxcheck;
+    uint8_t rc_interpolation;
+    uint8_t rc_interpolation_hz;
+} configV97RxConfig_t;
+
+#ifdef GPS
+#define CONFIG_REGION_GPS_CONFIG gpsConfig_t gpsConfig;
+#else
+#define CONFIG_REGION_GPS_CONFIG
+#endif
+
+// what follows rxConfig in every layout of the region
+#define CONFIG_REGION_COMMON_MEMBERS \
+    uint8_t inputFilteringMode; \
+    uint8_t retarded_arm; \
+    uint8_t disarm_kill_switch; \
+    uint8_t auto_disarm_delay; \
+    uint8_t small_angle; \
+    mixerConfig_t mixerConfig; \
+    airplaneConfig_t airplaneConfig; \
+    CONFIG_REGION_GPS_CONFIG \
+    serialConfig_t serialConfig; \
+    telemetryConfig_t telemetryConfig;
+
+// from magZero up to and including telemetryConfig, placed at offsetof(master_t, magZero)
+typedef struct configV95Region_s {
+    flightDynamicsTrims_t magZero;
+    configV95BatteryConfig_t batteryConfig;
+    configV96RxConfig_t rxConfig;
+    CONFIG_REGION_COMMON_MEMBERS
+} configV95Region_t;
+
+typedef struct configV96Region_s {
+    flightDynamicsTrims_t magZero;
+    configV96BatteryConfig_t batteryConfig;
+    configV96RxConfig_t rxConfig;
+    CONFIG_REGION_COMMON_MEMBERS
+} configV96Region_t;
+
+typedef struct configV97Region_s {
+    flightDynamicsTrims_t magZero;
+    configV96BatteryConfig_t batteryConfig;
+    configV97RxConfig_t rxConfig;
+    CONFIG_REGION_COMMON_MEMBERS
+} configV97Region_t;
+
+// how much lower than today everything from telemetryConfig on was stored
+#define CONFIG_REGION_SHIFT(regionType) \
+    (offsetof(master_t, telemetryConfig) - offsetof(master_t, magZero) - offsetof(regionType, telemetryConfig))
+#define CONFIG_REGION_MAGIC_EF_OFFSET(regionType) (CONFIG_V98_MAGIC_EF_OFFSET - CONFIG_REGION_SHIFT(regionType))
+
+#define CONFIG_MIGRATION_REGION_FIELD(regionType, oldField, newField, size) \
+    CONFIG_MIGRATION_FIELD(offsetof(master_t, magZero) + offsetof(regionType, oldField), offsetof(master_t, newField), (size))
+#define CONFIG_MIGRATION_MOVED(regionType, field) \
+    CONFIG_MIGRATION_REGION_FIELD(regionType, field, field, sizeof(masterConfig.field))
+
+#ifdef GPS
+#define CONFIG_MIGRATION_GPS_CONFIG(regionType) CONFIG_MIGRATION_MOVED(regionType, gpsConfig),
+#else
+#define CONFIG_MIGRATION_GPS_CONFIG(regionType)
+#endif
+
+// CONFIG_REGION_COMMON_MEMBERS, and everything after the region up to the end of version 98
+#define CONFIG_MIGRATION_REGION_COMMON_FIELDS(regionType) \
+    CONFIG_MIGRATION_MOVED(regionType, inputFilteringMode), \
+    CONFIG_MIGRATION_MOVED(regionType, retarded_arm), \
+    CONFIG_MIGRATION_MOVED(regionType, disarm_kill_switch), \
+    CONFIG_MIGRATION_MOVED(regionType, auto_disarm_delay), \
+    CONFIG_MIGRATION_MOVED(regionType, small_angle), \
+    CONFIG_MIGRATION_MOVED(regionType, mixerConfig), \
+    CONFIG_MIGRATION_MOVED(regionType, airplaneConfig), \
+    CONFIG_MIGRATION_GPS_CONFIG(regionType) \
+    CONFIG_MIGRATION_MOVED(regionType, serialConfig), \
+    CONFIG_MIGRATION_REGION_FIELD(regionType, telemetryConfig, telemetryConfig, CONFIG_V98_MAGIC_EF_OFFSET - offsetof(master_t, telemetryConfig))
+
+// versions 94 and 95 had no batteryConfig.batteryResistance, 95 only replaced the checksum
+#define CONFIG_V95_MAGIC_EF_OFFSET CONFIG_REGION_MAGIC_EF_OFFSET(configV95Region_t)
+
+static const configMigrationField_t configV95Fields[] = {
+    CONFIG_MIGRATION_UNCHANGED(mixerMode, batteryConfig),
+    CONFIG_MIGRATION_REGION_FIELD(configV95Region_t, batteryConfig, batteryConfig, offsetof(configV95BatteryConfig_t, batteryCapacity)),
+    CONFIG_MIGRATION_MOVED(configV95Region_t, batteryConfig.batteryCapacity),
+    CONFIG_MIGRATION_REGION_FIELD(configV95Region_t, rxConfig, rxConfig, sizeof(configV96RxConfig_t)),
+    CONFIG_MIGRATION_REGION_COMMON_FIELDS(configV95Region_t),
+};
+
+// version 96 had no rc_interpolation settings
+#define CONFIG_V96_MAGIC_EF_OFFSET CONFIG_REGION_MAGIC_EF_OFFSET(configV96Region_t)
+
+static const configMigrationField_t configV96Fields[] = {
+    CONFIG_MIGRATION_UNCHANGED(mixerMode, batteryConfig),
+    CONFIG_MIGRATION_REGION_FIELD(configV96Region_t, batteryConfig, batteryConfig, sizeof(configV96BatteryConfig_t)),
+    CONFIG_MIGRATION_REGION_FIELD(configV96Region_t, rxConfig, rxConfig, sizeof(configV96RxConfig_t)),
+    CONFIG_MIGRATION_REGION_COMMON_FIELDS(configV96Region_t),
+};
+
+// version 97 had no input_median_channels
+#define CONFIG_V97_MAGIC_EF_OFFSET CONFIG_REGION_MAGIC_EF_OFFSET(configV97Region_t)
+
+static const configMigrationField_t configV97Fields[] = {
+    CONFIG_MIGRATION_UNCHANGED(mixerMode, batteryConfig),
+    CONFIG_MIGRATION_REGION_FIELD(configV97Region_t, batteryConfig, batteryConfig, sizeof(configV96BatteryConfig_t)),
+    CONFIG_MIGRATION_REGION_FIELD(configV97Region_t, rxConfig, rxConfig, sizeof(configV97RxConfig_t)),
+    CONFIG_MIGRATION_REGION_COMMON_FIELDS(configV97Region_t),
+};
+
+// version 98 had no gyroTempCompensation
+static const configMigrationField_t configV98Fields[] = {
+    CONFIG_MIGRATION_FIELD(offsetof(master_t, mixerMode), offsetof(master_t, mixerMode), CONFIG_V98_MAGIC_EF_OFFSET - offsetof(master_t, mixerMode)),
+};
+
+static const configMigration_t configMigrations[] = {
+    { 94, CONFIG_XOR_IMAGE_SIZE(CONFIG_V95_MAGIC_EF_OFFSET), CONFIG_V95_MAGIC_EF_OFFSET, true, configV95Fields, ARRAYLEN(configV95Fields) },
+    { 95, CONFIG_CRC_IMAGE_SIZE(CONFIG_V95_MAGIC_EF_OFFSET), CONFIG_V95_MAGIC_EF_OFFSET, false, configV95Fields, ARRAYLEN(configV95Fields) },
+    { 96, CONFIG_CRC_IMAGE_SIZE(CONFIG_V96_MAGIC_EF_OFFSET), CONFIG_V96_MAGIC_EF_OFFSET, false, configV96Fields, ARRAYLEN(configV96Fields) },
+    { 97, CONFIG_CRC_IMAGE_SIZE(CONFIG_V97_MAGIC_EF_OFFSET), CONFIG_V97_MAGIC_EF_OFFSET, false, configV97Fields, ARRAYLEN(configV97Fields) },
+    { 98, CONFIG_CRC_IMAGE_SIZE(CONFIG_V98_MAGIC_EF_OFFSET), CONFIG_V98_MAGIC_EF_OFFSET, false, configV98Fields, ARRAYLEN(configV98Fields) },
+};
+
+static uint8_t calculateStoredXorChecksum(configImageReadFn readImage, uint32_t length)
+{
+    uint8_t buffer[CONFIG_STORAGE_BLOCK_SIZE];
+    uint8_t checksum = 0;
+    uint32_t offset;
+    uint32_t chunkLength;
+    uint8_t i;
+
+    for (offset = 0; offset < length; offset += chunkLength) {
+        chunkLength = MIN(sizeof(buffer), length - offset);
+        readImage(offset, buffer, chunkLength);
+        for (i = 0; i < chunkLength; i++) {
+            checksum ^= buffer[i];
+        }
+    }
+    return checksum;
+}
+
+static const configMigration_t *findValidMigration(configImageReadFn readImage, uint32_t imageSize)
+{
+    const configMigration_t *migration;
+    uint8_t version;
+    uint16_t size;
+    uint8_t magic_be;
+    uint8_t magic_ef;
+    uint32_t crc;
+    uint8_t index;
+
+    // version, size and magic_be have been at the start of the struct in every version
+    if (!readImage(offsetof(master_t, version), &version, sizeof(version))
+            || !readImage(offsetof(master_t, size), &size, sizeof(size))
+            || !readImage(offsetof(master_t, magic_be), &magic_be, sizeof(magic_be))) {
+        return NULL;
+    }
+
+    for (index = 0; index < ARRAYLEN(configMigrations); index++) {
+        migration = &configMigrations[index];
+
+        if (migration->version != version) {
+            continue;
+        }
+
+        if (size != migration->size || imageSize != migration->size || magic_be != 0xBE) {
+            return NULL;
+        }
+
+        readImage(migration->magicEfOffset, &magic_ef, sizeof(magic_ef));
+        if (magic_ef != 0xEF) {
+            return NULL;
+        }
+
+        if (migration->xorChecksum) {
+            if (calculateStoredXorChecksum(readImage, migration->size) != 0) {
+                return NULL;
+            }
+        } else {
+            readImage(migration->size - sizeof(crc), &crc, sizeof(crc));
+            if (calculateStoredCRC(readImage, migration->size - sizeof(crc)) != crc) {
+                return NULL;
+            }
+        }
+
+        return migration;
+    }
+    return NULL;
+}
+
+/*
+ * Firmware before the config storage kept the raw master_t in the last CONFIG_LEGACY_FLASH_SIZE bytes of the flash,
+ * which are now the end of the flash reserved for config. That area is in the second storage bank, so it is only read
+ * while the storage holds no usable config, the first write after the migration erases it.
+ */
+#define CONFIG_LEGACY_FLASH_SIZE 0x800
+
+static bool readLegacyImage(uint32_t offset, void *dest, uint32_t length)
+{
+    if (configFlashGetSize() < CONFIG_LEGACY_FLASH_SIZE || offset + length > CONFIG_LEGACY_FLASH_SIZE) {
+        return false;
+    }
+
+    memcpy(dest, configFlashGetAddress(configFlashGetSize() - CONFIG_LEGACY_FLASH_SIZE + offset), length);
+    return true;
+}
+
+static uint32_t getLegacyImageSize(void)
+{
+    uint16_t size;
+
+    if (!readLegacyImage(offsetof(master_t, size), &size, sizeof(size)) || size > CONFIG_LEGACY_FLASH_SIZE) {
+        return 0;
+    }
+    return size;
+}
+
+static bool migrateEEPROM(void)
+{
+    configImageReadFn readImage = configStorageRead;
+    const configMigration_t *migration = findValidMigration(readImage, configStorageGetImageSize());
+    const configMigrationField_t *field;
+    uint8_t index;
+
+    // The frozen layouts must match what the ARM targets stored, compilers with short enums lay out master_t like them.
+    BUILD_BUG_ON(sizeof(configV95BatteryConfig_t) != 12);
+    BUILD_BUG_ON(sizeof(configV96BatteryConfig_t) != 14);
+    BUILD_BUG_ON(sizeof(configV96RxConfig_t) != 18);
+    BUILD_BUG_ON(sizeof(configV97RxConfig_t) != 20);
+    BUILD_BUG_ON(offsetof(configV95Region_t, inputFilteringMode) != 36);
+    BUILD_BUG_ON(offsetof(configV96Region_t, inputFilteringMode) != 38);
+    BUILD_BUG_ON(offsetof(configV97Region_t, inputFilteringMode) != 40);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, magZero) != 256);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, batteryConfig) != 262);
+    BUILD_BUG_ON(sizeof(currentSensor_e) == 1
+        && offsetof(batteryConfig_t, multiwiiCurrentMeterOutput) + 1 != offsetof(configV95BatteryConfig_t, batteryCapacity));
+    BUILD_BUG_ON(sizeof(currentSensor_e) == 1 && sizeof(batteryConfig_t) != sizeof(configV96BatteryConfig_t));
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, batteryConfig.batteryResistance) != 272);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, batteryConfig.batteryCapacity) != 274);
+    BUILD_BUG_ON(offsetof(rxConfig_t, maxcheck) + sizeof(uint16_t) != sizeof(configV96RxConfig_t));
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, rxConfig) != 276);
+    BUILD_BUG_ON(offsetof(rxConfig_t, rc_interpolation_hz) + sizeof(uint8_t) != sizeof(configV97RxConfig_t));
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, rxConfig.rc_interpolation) != 294);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, rxConfig.rc_interpolation_hz) != 295);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, rxConfig.input_median_channels) != 296);
+    BUILD_BUG_ON(sizeof(inputFilteringMode_e) == 1 && offsetof(master_t, inputFilteringMode) != 298);
+
+    if (!migration) {
+        readImage = readLegacyImage;
+        migration = findValidMigration(readImage, getLegacyImageSize());
+    }
+
+    if (!migration) {
+        return false;
+    }
+
+    resetConf();
+
+    for (index = 0; index < migration->fieldCount; index++) {
+        field = &migration->fields[index];
+        readImage(field->oldOffset, (uint8_t *) &masterConfig + field->newOffset, field->size);
+    }
+
+    writeEEPROM();
+    return true;
+}
+
 void activateControlRateConfig(void)
 {
     generatePitchRollCurve(currentControlRateProfile);
     generateThrottleCurve(currentControlRateProfile, &masterConfig.escAndServoConfig);
 }
 
-void activateConfig(void)
+// Applies the settings that depend on the current profile, this does not touch the flash.
+static void activateProfile(void)
 {
     static imuRuntimeConfig_t imuRuntimeConfig;
 
@@ -630,12 +1000,6 @@ void activateConfig(void)
         &currentProfile->pidProfile
     );
 
-    useGyroConfig(&masterConfig.gyroConfig);
-
-#ifdef TELEMETRY
-    useTelemetryConfig(&masterConfig.telemetryConfig);
-#endif
-
     pidSetController(currentProfile->pidProfile.pidController);
 
 #ifdef GPS
@@ -644,7 +1008,6 @@ void activateConfig(void)
 #endif
 
     useFailsafeConfig(&currentProfile->failsafeConfig);
-    setAccelerationTrims(&masterConfig.accZero);
 
     mixerUseConfigs(
 #ifdef USE_SERVOS
@@ -684,6 +1047,21 @@ void activateConfig(void)
 #endif
 }
 
+void activateConfig(void)
+{
+    activateProfile();
+
+    useGyroConfig(&masterConfig.gyroConfig, &masterConfig.gyroTempCompensation);
+
+    useRcInterpolationConfig(&masterConfig.rxConfig);
+
+#ifdef TELEMETRY
+    useTelemetryConfig(&masterConfig.telemetryConfig);
+#endif
+
+    setAccelerationTrims(&masterConfig.accZero);
+}
+
 void validateAndFixConfig(void)
 {
     if (!(feature(FEATURE_RX_PARALLEL_PWM) || feature(FEATURE_RX_PPM) || feature(FEATURE_RX_SERIAL) || feature(FEATURE_RX_MSP))) {
@@ -725,6 +1103,16 @@ void validateAndFixConfig(void)
     }
 
 
+#ifdef USE_DSHOT
+    if (feature(FEATURE_DSHOT)) {
+        featureClear(FEATURE_ONESHOT125);
+        // 3D neutral would be sent as a forward throttle value
+        featureClear(FEATURE_3D);
+    }
+#else
+    featureClear(FEATURE_DSHOT);
+#endif
+
 #if defined(LED_STRIP) && (defined(USE_SOFTSERIAL1) || defined(USE_SOFTSERIAL2))
     if (feature(FEATURE_SOFTSERIAL) && (
             0
@@ -769,6 +1157,7 @@ void validateAndFixConfig(void)
 
 void initEEPROM(void)
 {
+    configStorageInit();
 }
 
 void readEEPROM(void)
@@ -778,17 +1167,12 @@ void readEEPROM(void)
         failureMode(10);
 
     // Read flash
-    memcpy(&masterConfig, (char *) CONFIG_START_FLASH_ADDRESS, sizeof(master_t));
+    configStorageRead(0, &masterConfig, sizeof(master_t));
 
     if (masterConfig.current_profile_index > MAX_PROFILE_COUNT - 1) // sanity check
         masterConfig.current_profile_index = 0;
 
-    setProfile(masterConfig.current_profile_index);
-
-    if (currentProfile->defaultRateProfileIndex > MAX_CONTROL_RATE_PROFILE_COUNT - 1) // sanity check
-        currentProfile->defaultRateProfileIndex = 0;
-
-    setControlRateProfile(currentProfile->defaultRateProfileIndex);
+    setProfileAndDefaultControlRateProfile(masterConfig.current_profile_index);
 
     validateAndFixConfig();
     activateConfig();
@@ -803,11 +1187,12 @@ void readEEPROMAndNotify(void)
 
 void writeEEPROM(void)
 {
-    // Generate compile time error if the config does not fit in the reserved area of flash.
-    BUILD_BUG_ON(sizeof(master_t) > FLASH_TO_RESERVE_FOR_CONFIG);
+    // Generate compile time error if the config does not fit in the config storage.
+    BUILD_BUG_ON(sizeof(master_t) > CONFIG_STORAGE_MAX_IMAGE_SIZE);
+    // the CRC covers everything before it, there must be nothing after it.
+    BUILD_BUG_ON(offsetof(master_t, crc) + sizeof(uint32_t) != sizeof(master_t));
 
-    FLASH_Status status = 0;
-    uint32_t wordOffset;
+    bool success = false;
     int8_t attemptsRemaining = 3;
 
     // prepare checksum/version constants
@@ -815,40 +1200,17 @@ void writeEEPROM(void)
     masterConfig.size = sizeof(master_t);
     masterConfig.magic_be = 0xBE;
     masterConfig.magic_ef = 0xEF;
-    masterConfig.chk = 0; // erase checksum before recalculating
-    masterConfig.chk = calculateChecksum((const uint8_t *) &masterConfig, sizeof(master_t));
-
-    // write it
-    FLASH_Unlock();
-    while (attemptsRemaining--) {
-#ifdef STM32F303
-        FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
-#endif
-#ifdef STM32F10X
-        FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
-#endif
-        for (wordOffset = 0; wordOffset < sizeof(master_t); wordOffset += 4) {
-            if (wordOffset % FLASH_PAGE_SIZE == 0) {
-                status = FLASH_ErasePage(CONFIG_START_FLASH_ADDRESS + wordOffset);
-                if (status != FLASH_COMPLETE) {
-                    break;
-                }
-            }
+    masterConfig.crc = crc32Update(0, &masterConfig, CONFIG_CRC_LENGTH);
 
-            status = FLASH_ProgramWord(CONFIG_START_FLASH_ADDRESS + wordOffset,
-                    *(uint32_t *) ((char *) &masterConfig + wordOffset));
-            if (status != FLASH_COMPLETE) {
-                break;
-            }
-        }
-        if (status == FLASH_COMPLETE) {
-            break;
-        }
+    // only the blocks that changed since the last write are appended to the config log
+    while (!success && attemptsRemaining--) {
+        success = configStorageWrite(&masterConfig, sizeof(master_t));
     }
-    FLASH_Lock();
+
+    configSavePending = false;
 
     // Flash write failed - just die now
-    if (status != FLASH_COMPLETE || !isEEPROMContentValid()) {
+    if (!success || !isEEPROMContentValid()) {
         failureMode(10);
     }
 }
@@ -859,6 +1221,10 @@ void ensureEEPROMContainsValidData(void)
         return;
     }
 
+    if (migrateEEPROM()) {
+        return;
+    }
+
     resetEEPROM();
 }
 
@@ -874,11 +1240,39 @@ void saveConfigAndNotify(void)
     readEEPROMAndNotify();
 }
 
+/*
+ * For changes made while flying, or learnt so often that writing each one would wear the flash.
+ */
+void scheduleConfigSaveOnDisarm(void)
+{
+    configSavePending = true;
+}
+
+void writeEEPROMIfPending(void)
+{
+    if (configSavePending) {
+        writeEEPROM();
+    }
+}
+
 void changeProfile(uint8_t profileIndex)
 {
+    if (profileIndex > MAX_PROFILE_COUNT - 1) {
+        profileIndex = MAX_PROFILE_COUNT - 1;
+    }
+
     masterConfig.current_profile_index = profileIndex;
+    setProfileAndDefaultControlRateProfile(profileIndex);
+    activateProfile();
+
+    if (ARMING_FLAG(ARMED)) {
+        // writing the flash would stall the loop, the profile index is saved on disarm instead.
+        configSavePending = true;
+        queueConfirmationBeep(profileIndex + 1);
+        return;
+    }
+
     writeEEPROM();
-    readEEPROM();
     blinkLedAndSoundBeeper(2, 40, profileIndex + 1);
 }
 
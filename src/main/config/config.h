@@ -41,7 +41,10 @@ typedef enum {
     FEATURE_LED_STRIP = 1 << 16,
     FEATURE_DISPLAY = 1 << 17,
     FEATURE_ONESHOT125 = 1 << 18,
-    FEATURE_BLACKBOX = 1 << 19
+    FEATURE_BLACKBOX = 1 << 19,
+    FEATURE_AIRMODE = 1 << 20,
+    FEATURE_DSHOT = 1 << 21,
+    FEATURE_GYRO_TEMP_COMP = 1 << 22
 } features_e;
 
 bool feature(uint32_t mask);
@@ -57,6 +60,8 @@ void resetEEPROM(void);
 void readEEPROM(void);
 void readEEPROMAndNotify(void);
 void writeEEPROM();
+void scheduleConfigSaveOnDisarm(void);
+void writeEEPROMIfPending(void);
 void ensureEEPROMContainsValidData(void);
 void saveConfigAndNotify(void);
 
@@ -94,8 +94,10 @@ typedef struct master_t {
     uint8_t blackbox_device;
 #endif
 
+    gyroTempCompensation_t gyroTempCompensation;  // learnt, reset by "defaults"
+
     uint8_t magic_ef;                       // magic number, should be 0xEF
-    uint8_t chk;                            // XOR checksum
+    uint32_t crc;                           // CRC32 of everything before this field, must be the last member
 } master_t;
 
 extern master_t masterConfig;
@@ -0,0 +1,460 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Log-structured storage for the configuration image in the on-chip flash reserved for config.
+ *
+ * The reserved flash is split into two banks. The active bank starts with a header followed by a log of fixed size
+ * records, each holding one CONFIG_STORAGE_BLOCK_SIZE block of the image. Saving the configuration only appends
+ * records for the blocks that changed, so most saves need no page erase at all. When the active bank is full the
+ * current image is compacted into the other bank, the header of which is written last so that an interrupted
+ * compaction leaves the previous bank in charge.
+ *
+ * A record is programmed header first, then its data, then the commit marker. Records with a missing commit marker or
+ * a bad checksum (e.g. power was lost mid-write) are skipped when the log is mounted.
+ *
+ * The inactive bank can also hold a staged image, e.g. a config upload that arrives in pieces, see
+ * configStorageStageBegin(). It is programmed raw after a header which is left erased, so the bank is never mounted.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "build_config.h"
+
+#include "common/utils.h"
+
+#include "drivers/config_flash.h"
+
+#include "config/config_storage.h"
+
+#define CONFIG_BANK_MAGIC 0xC5F1
+#define CONFIG_BANK_COUNT 2
+
+#define CONFIG_RECORD_ERASED 0xFFFF
+#define CONFIG_RECORD_COMMITTED 0x0000
+
+typedef struct configBankHeader_s {
+    uint16_t magic;
+    uint16_t imageSize;
+    uint32_t generation;
+} configBankHeader_t;
+
+typedef struct configRecord_s {
+    uint8_t block;
+    uint8_t checksum;
+    uint16_t commit;
+    uint8_t data[CONFIG_STORAGE_BLOCK_SIZE];
+} configRecord_t;
+
+static uint32_t imageSize;
+static uint8_t blockCount;
+
+static uint32_t bankSize;
+static uint8_t activeBank;
+static uint32_t generation;
+static bool storageValid;
+
+// offset of the next free record within the active bank
+static uint32_t writeOffset;
+
+// offset of the most recent record of each block within the active bank, 0 if the block has no record
+static uint16_t blockRecordOffset[CONFIG_STORAGE_MAX_BLOCK_COUNT];
+
+static uint8_t stageBank;
+static uint32_t stageSize;
+static uint32_t stageOffset;
+// the bytes of the word at the end of the staged image which are not programmed yet
+static union {
+    uint8_t bytes[sizeof(uint32_t)];
+    uint32_t word;
+} stageWord;
+
+static uint32_t bankStart(uint8_t bank)
+{
+    return bank * bankSize;
+}
+
+static const configBankHeader_t *getBankHeader(uint8_t bank)
+{
+    return (const configBankHeader_t *) configFlashGetAddress(bankStart(bank));
+}
+
+static const configRecord_t *getRecord(uint8_t bank, uint32_t recordOffset)
+{
+    return (const configRecord_t *) configFlashGetAddress(bankStart(bank) + recordOffset);
+}
+
+static uint8_t calculateRecordChecksum(uint8_t block, const uint8_t *data)
+{
+    uint8_t checksum = block;
+
+    for (uint8_t i = 0; i < CONFIG_STORAGE_BLOCK_SIZE; i++) {
+        checksum ^= data[i];
+    }
+    return checksum;
+}
+
+static bool isRecordErased(const configRecord_t *record)
+{
+    return (record->block | (record->checksum << 8)) == CONFIG_RECORD_ERASED;
+}
+
+static bool isRecordValid(const configRecord_t *record)
+{
+    return record->commit == CONFIG_RECORD_COMMITTED
+        && record->block < blockCount
+        && record->checksum == calculateRecordChecksum(record->block, record->data);
+}
+
+static uint8_t blockLength(uint8_t block)
+{
+    uint32_t blockOffset = block * CONFIG_STORAGE_BLOCK_SIZE;
+
+    if (imageSize - blockOffset < CONFIG_STORAGE_BLOCK_SIZE) {
+        return imageSize - blockOffset;
+    }
+    return CONFIG_STORAGE_BLOCK_SIZE;
+}
+
+static const uint8_t *getStoredBlock(uint8_t block)
+{
+    return getRecord(activeBank, blockRecordOffset[block])->data;
+}
+
+/*
+ * Replays the log of a bank into the block index, returns true if every block of the image has a valid record.
+ */
+static bool mountBank(uint8_t bank)
+{
+    uint32_t recordOffset;
+    uint8_t block;
+
+    memset(blockRecordOffset, 0, sizeof(blockRecordOffset));
+
+    for (recordOffset = sizeof(configBankHeader_t); recordOffset + sizeof(configRecord_t) <= bankSize; recordOffset += sizeof(configRecord_t)) {
+        const configRecord_t *record = getRecord(bank, recordOffset);
+
+        if (isRecordErased(record)) {
+            break;
+        }
+
+        if (isRecordValid(record)) {
+            blockRecordOffset[record->block] = recordOffset;
+        }
+    }
+
+    activeBank = bank;
+    writeOffset = recordOffset;
+
+    for (block = 0; block < blockCount; block++) {
+        if (!blockRecordOffset[block]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool programRecord(uint32_t recordStart, uint8_t block, const uint8_t *image)
+{
+    union {
+        uint8_t bytes[CONFIG_STORAGE_BLOCK_SIZE];
+        uint32_t words[CONFIG_STORAGE_BLOCK_SIZE / sizeof(uint32_t)];
+    } data;
+    uint8_t wordIndex;
+    bool success;
+
+    memset(data.bytes, 0, sizeof(data.bytes));
+    memcpy(data.bytes, image + block * CONFIG_STORAGE_BLOCK_SIZE, blockLength(block));
+
+    success = configFlashProgramHalfWord(recordStart, block | (calculateRecordChecksum(block, data.bytes) << 8));
+
+    for (wordIndex = 0; success && wordIndex < ARRAYLEN(data.words); wordIndex++) {
+        success = configFlashProgramWord(recordStart + offsetof(configRecord_t, data) + wordIndex * sizeof(uint32_t), data.words[wordIndex]);
+    }
+
+    if (success) {
+        success = configFlashProgramHalfWord(recordStart + offsetof(configRecord_t, commit), CONFIG_RECORD_COMMITTED);
+    }
+
+    return success;
+}
+
+static bool appendRecord(uint8_t block, const uint8_t *image)
+{
+    bool success = programRecord(bankStart(activeBank) + writeOffset, block, image);
+
+    // the slot is used up even if programming failed, it will be skipped on mount
+    if (success) {
+        blockRecordOffset[block] = writeOffset;
+    }
+    writeOffset += sizeof(configRecord_t);
+
+    return success;
+}
+
+/*
+ * Writes the complete image into the inactive bank and makes it the active one.
+ *
+ * The active bank is only switched once the new header is committed, a failed compaction leaves it untouched so that
+ * a retry targets the same inactive bank again instead of erasing the last good copy.
+ */
+static bool compact(const uint8_t *image)
+{
+    uint8_t targetBank = activeBank ^ 1;
+    uint32_t targetStart = bankStart(targetBank);
+    uint32_t targetOffset = sizeof(configBankHeader_t);
+    uint32_t pageOffset;
+    uint8_t block;
+    bool success = true;
+
+    storageValid = false;
+
+    if (sizeof(configBankHeader_t) + blockCount * sizeof(configRecord_t) > bankSize) {
+        return false;
+    }
+
+    for (pageOffset = 0; success && pageOffset < bankSize; pageOffset += configFlashGetPageSize()) {
+        success = configFlashErasePage(targetStart + pageOffset);
+    }
+
+    for (block = 0; success && block < blockCount; block++) {
+        success = programRecord(targetStart + targetOffset, block, image);
+        targetOffset += sizeof(configRecord_t);
+    }
+
+    if (!success) {
+        return false;
+    }
+
+    // the header commits the bank, the magic goes in last
+    success = configFlashProgramHalfWord(targetStart + offsetof(configBankHeader_t, imageSize), imageSize)
+        && configFlashProgramWord(targetStart + offsetof(configBankHeader_t, generation), generation + 1)
+        && configFlashProgramHalfWord(targetStart + offsetof(configBankHeader_t, magic), CONFIG_BANK_MAGIC);
+
+    if (success) {
+        activeBank = targetBank;
+        writeOffset = targetOffset;
+        for (block = 0; block < blockCount; block++) {
+            blockRecordOffset[block] = sizeof(configBankHeader_t) + block * sizeof(configRecord_t);
+        }
+        generation++;
+        storageValid = true;
+    }
+
+    return success;
+}
+
+static void setImageSize(uint32_t size)
+{
+    imageSize = size;
+    blockCount = (size + CONFIG_STORAGE_BLOCK_SIZE - 1) / CONFIG_STORAGE_BLOCK_SIZE;
+}
+
+void configStorageInit(void)
+{
+    const configBankHeader_t *header;
+    bool bankFound = false;
+    uint8_t bank;
+
+    bankSize = configFlashGetSize() / CONFIG_BANK_COUNT;
+
+    activeBank = 0;
+    generation = 0;
+    storageValid = false;
+    setImageSize(0);
+
+    // the newest committed bank wins
+    for (bank = 0; bank < CONFIG_BANK_COUNT; bank++) {
+        header = getBankHeader(bank);
+
+        if (header->magic != CONFIG_BANK_MAGIC) {
+            continue;
+        }
+
+        if (!bankFound || header->generation > generation) {
+            generation = header->generation;
+            activeBank = bank;
+            bankFound = true;
+        }
+    }
+
+    if (!bankFound) {
+        return;
+    }
+
+    header = getBankHeader(activeBank);
+    if (header->imageSize > CONFIG_STORAGE_MAX_IMAGE_SIZE) {
+        return;
+    }
+
+    // the image may have been written by a firmware with a different config layout, see configStorageGetImageSize()
+    setImageSize(header->imageSize);
+    storageValid = mountBank(activeBank);
+}
+
+bool configStorageIsValid(void)
+{
+    return storageValid;
+}
+
+uint32_t configStorageGetImageSize(void)
+{
+    return storageValid ? imageSize : 0;
+}
+
+bool configStorageRead(uint32_t offset, void *dest, uint32_t length)
+{
+    uint8_t *destination = dest;
+    uint8_t block;
+    uint8_t offsetInBlock;
+    uint32_t chunkLength;
+
+    if (!storageValid || offset + length > imageSize) {
+        return false;
+    }
+
+    while (length > 0) {
+        block = offset / CONFIG_STORAGE_BLOCK_SIZE;
+        offsetInBlock = offset % CONFIG_STORAGE_BLOCK_SIZE;
+        chunkLength = CONFIG_STORAGE_BLOCK_SIZE - offsetInBlock;
+        if (chunkLength > length) {
+            chunkLength = length;
+        }
+
+        memcpy(destination, getStoredBlock(block) + offsetInBlock, chunkLength);
+
+        destination += chunkLength;
+        offset += chunkLength;
+        length -= chunkLength;
+    }
+    return true;
+}
+
+bool configStorageWrite(const void *image, uint32_t size)
+{
+    const uint8_t *source = image;
+    uint8_t changedBlocks[CONFIG_STORAGE_MAX_BLOCK_COUNT];
+    uint8_t changedBlockCount = 0;
+    uint8_t block;
+    bool success = true;
+
+    if (size > CONFIG_STORAGE_MAX_IMAGE_SIZE) {
+        return false;
+    }
+
+    configFlashUnlock();
+
+    if (storageValid && size == imageSize) {
+        for (block = 0; block < blockCount; block++) {
+            if (memcmp(getStoredBlock(block), source + block * CONFIG_STORAGE_BLOCK_SIZE, blockLength(block)) != 0) {
+                changedBlocks[changedBlockCount++] = block;
+            }
+        }
+
+        if (writeOffset + changedBlockCount * sizeof(configRecord_t) <= bankSize) {
+            for (block = 0; success && block < changedBlockCount; block++) {
+                success = appendRecord(changedBlocks[block], source);
+            }
+        } else {
+            success = compact(source);
+        }
+    } else {
+        setImageSize(size);
+        success = compact(source);
+    }
+
+    configFlashLock();
+
+    if (!success) {
+        storageValid = false;
+    }
+
+    return success;
+}
+
+/*
+ * Erases the inactive bank to receive an image of the given size with configStorageStageWrite(). The active bank and
+ * the image read by configStorageRead() are left alone.
+ */
+bool configStorageStageBegin(uint32_t size)
+{
+    uint32_t pageOffset;
+    bool success = true;
+
+    stageBank = activeBank ^ 1;
+    stageSize = 0;
+    stageOffset = 0;
+    stageWord.word = 0xFFFFFFFF;
+
+    if (sizeof(configBankHeader_t) + size > bankSize) {
+        return false;
+    }
+
+    configFlashUnlock();
+    for (pageOffset = 0; success && pageOffset < bankSize; pageOffset += configFlashGetPageSize()) {
+        success = configFlashErasePage(bankStart(stageBank) + pageOffset);
+    }
+    configFlashLock();
+
+    if (success) {
+        stageSize = size;
+    }
+    return success;
+}
+
+/*
+ * Appends the next piece of the staged image.
+ */
+bool configStorageStageWrite(const void *data, uint32_t length)
+{
+    const uint8_t *source = data;
+    uint32_t stageStart = bankStart(stageBank) + sizeof(configBankHeader_t);
+    bool success = true;
+
+    if (length > stageSize - stageOffset) {
+        return false;
+    }
+
+    configFlashUnlock();
+
+    while (success && length > 0) {
+        stageWord.bytes[stageOffset % sizeof(uint32_t)] = *source++;
+        stageOffset++;
+        length--;
+
+        if (stageOffset % sizeof(uint32_t) == 0 || stageOffset == stageSize) {
+            success = configFlashProgramWord(stageStart + ((stageOffset - 1) & ~(sizeof(uint32_t) - 1)), stageWord.word);
+            stageWord.word = 0xFFFFFFFF;
+        }
+    }
+
+    configFlashLock();
+
+    return success;
+}
+
+/*
+ * The staged image, only complete once configStorageStageWrite() has been given all of it. A save which compacts the
+ * log into the inactive bank overwrites it, so check it before use.
+ */
+const void *configStorageGetStagedImage(void)
+{
+    return configFlashGetAddress(bankStart(stageBank) + sizeof(configBankHeader_t));
+}
@@ -0,0 +1,33 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define CONFIG_STORAGE_BLOCK_SIZE 32
+#define CONFIG_STORAGE_MAX_BLOCK_COUNT 96
+#define CONFIG_STORAGE_MAX_IMAGE_SIZE (CONFIG_STORAGE_BLOCK_SIZE * CONFIG_STORAGE_MAX_BLOCK_COUNT)
+
+void configStorageInit(void);
+bool configStorageIsValid(void);
+uint32_t configStorageGetImageSize(void);
+
+bool configStorageRead(uint32_t offset, void *dest, uint32_t length);
+bool configStorageWrite(const void *image, uint32_t size);
+
+bool configStorageStageBegin(uint32_t size);
+bool configStorageStageWrite(const void *data, uint32_t length);
+const void *configStorageGetStagedImage(void);
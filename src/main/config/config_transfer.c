@@ -0,0 +1,179 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/axis.h"
+#include "common/maths.h"
+#include "common/color.h"
+#include "common/crc.h"
+
+#include "drivers/system.h"
+#include "drivers/sensor.h"
+#include "drivers/accgyro.h"
+#include "drivers/compass.h"
+#include "drivers/serial.h"
+#include "drivers/input_filtering.h"
+
+#include "io/escservo.h"
+#include "io/gps.h"
+#include "io/gimbal.h"
+#include "io/rc_controls.h"
+#include "io/serial.h"
+#include "io/ledstrip.h"
+
+#include "rx/rx.h"
+
+#include "sensors/battery.h"
+#include "sensors/boardalignment.h"
+#include "sensors/sensors.h"
+#include "sensors/acceleration.h"
+#include "sensors/gyro.h"
+#include "sensors/compass.h"
+#include "sensors/barometer.h"
+
+#include "flight/pid.h"
+#include "flight/imu.h"
+#include "flight/mixer.h"
+#include "flight/navigation.h"
+#include "flight/failsafe.h"
+
+#include "telemetry/telemetry.h"
+
+#include "config/runtime_config.h"
+#include "config/config.h"
+#include "config/config_profile.h"
+#include "config/config_master.h"
+#include "config/config_storage.h"
+
+#include "config/config_transfer.h"
+
+/*
+ * Bulk transfer of the whole master_t, so a configurator can mirror the config with a handful of large reads
+ * instead of one request per setting.
+ *
+ * Writes are staged chunk by chunk and in order starting at offset 0 in the inactive bank of the config storage, which
+ * saves keeping a second master_t in RAM. The running config and the stored copy are left untouched until the commit.
+ * The commit checks the CRC of the staged image, copies it over masterConfig and then saves and activates it the same
+ * way MSP_EEPROM_WRITE does. A transfer that sees no
+ * chunk for CONFIG_TRANSFER_IDLE_TIMEOUT_MS, e.g. because the configurator went away, is aborted. Arming and saving
+ * are prevented while a transfer is in progress.
+ */
+
+static bool transferInProgress = false;
+static uint16_t transferOffset;
+static uint32_t transferLastChunkAt;
+
+void configTransferGetSchema(configTransferSchema_t *schema)
+{
+    schema->schemaVersion = CONFIG_TRANSFER_SCHEMA_VERSION;
+    schema->configVersion = masterConfig.version;
+    schema->size = sizeof(master_t);
+    schema->profileOffset = offsetof(master_t, profile);
+    schema->profileSize = sizeof(profile_t);
+    schema->profileCount = MAX_PROFILE_COUNT;
+    schema->controlRateProfileOffset = offsetof(master_t, controlRateProfiles);
+    schema->controlRateProfileSize = sizeof(controlRateConfig_t);
+    schema->controlRateProfileCount = MAX_CONTROL_RATE_PROFILE_COUNT;
+    schema->crc = crc32Update(0, &masterConfig, sizeof(master_t));
+}
+
+uint16_t configTransferRead(uint16_t offset, uint8_t *dest, uint16_t length)
+{
+    if (offset >= sizeof(master_t)) {
+        return 0;
+    }
+
+    length = MIN(length, sizeof(master_t) - offset);
+    memcpy(dest, (uint8_t *)&masterConfig + offset, length);
+    return length;
+}
+
+void configTransferAbort(void)
+{
+    if (!transferInProgress) {
+        return;
+    }
+
+    transferInProgress = false;
+}
+
+void configTransferCheckTimeout(void)
+{
+    if (transferInProgress && millis() - transferLastChunkAt >= CONFIG_TRANSFER_IDLE_TIMEOUT_MS) {
+        configTransferAbort();
+    }
+}
+
+bool configTransferWriteChunk(uint16_t offset, const uint8_t *data, uint16_t length)
+{
+    if (ARMING_FLAG(ARMED)) {
+        return false;
+    }
+
+    if (offset == 0) {
+        transferInProgress = configStorageStageBegin(sizeof(master_t));
+        transferOffset = 0;
+    }
+
+    if (!transferInProgress || offset != transferOffset || length > sizeof(master_t) - offset
+            || !configStorageStageWrite(data, length)) {
+        configTransferAbort();
+        return false;
+    }
+
+    transferOffset += length;
+    transferLastChunkAt = millis();
+    return true;
+}
+
+bool configTransferCommit(uint32_t crc)
+{
+    const master_t *transferImage = configStorageGetStagedImage();
+
+    if (!transferInProgress) {
+        return false;
+    }
+
+    if (transferOffset != sizeof(master_t)
+            || crc32Update(0, transferImage, sizeof(master_t)) != crc
+            || transferImage->version != masterConfig.version
+            || transferImage->size != sizeof(master_t)
+            || transferImage->magic_be != 0xBE
+            || transferImage->magic_ef != 0xEF) {
+        configTransferAbort();
+        return false;
+    }
+
+    transferInProgress = false;
+
+    // readEEPROM() validates and activates the new config
+    memcpy(&masterConfig, transferImage, sizeof(master_t));
+    writeEEPROM();
+    readEEPROM();
+    return true;
+}
+
+bool configTransferInProgress(void)
+{
+    return transferInProgress;
+}
@@ -0,0 +1,45 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define CONFIG_TRANSFER_SCHEMA_VERSION 1
+
+#define CONFIG_TRANSFER_IDLE_TIMEOUT_MS 2000
+
+// Describes the layout of the transferred image, together with the parameter offsets from MSP_PARAMETER_INFO.
+typedef struct configTransferSchema_s {
+    uint8_t schemaVersion;
+    uint8_t configVersion;
+    uint16_t size;
+    uint16_t profileOffset;
+    uint16_t profileSize;
+    uint8_t profileCount;
+    uint16_t controlRateProfileOffset;
+    uint16_t controlRateProfileSize;
+    uint8_t controlRateProfileCount;
+    uint32_t crc;                           // CRC32 of the whole image
+} configTransferSchema_t;
+
+void configTransferGetSchema(configTransferSchema_t *schema);
+uint16_t configTransferRead(uint16_t offset, uint8_t *dest, uint16_t length);
+
+bool configTransferWriteChunk(uint16_t offset, const uint8_t *data, uint16_t length);
+bool configTransferCommit(uint32_t crc);
+void configTransferAbort(void);
+void configTransferCheckTimeout(void);
+bool configTransferInProgress(void);
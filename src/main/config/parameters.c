@@ -0,0 +1,401 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/axis.h"
+#include "common/maths.h"
+#include "common/color.h"
+#include "common/utils.h"
+
+#include "drivers/sensor.h"
+#include "drivers/accgyro.h"
+#include "drivers/compass.h"
+#include "drivers/serial.h"
+#include "drivers/input_filtering.h"
+
+#include "io/escservo.h"
+#include "io/gps.h"
+#include "io/gimbal.h"
+#include "io/rc_controls.h"
+#include "io/serial.h"
+#include "io/ledstrip.h"
+
+#include "rx/rx.h"
+#include "rx/spektrum.h"
+
+#include "io/rc_interpolation.h"
+
+#include "sensors/battery.h"
+#include "sensors/boardalignment.h"
+#include "sensors/sensors.h"
+#include "sensors/acceleration.h"
+#include "sensors/gyro.h"
+#include "sensors/compass.h"
+#include "sensors/barometer.h"
+
+#include "flight/pid.h"
+#include "flight/imu.h"
+#include "flight/mixer.h"
+#include "flight/navigation.h"
+#include "flight/failsafe.h"
+
+#include "telemetry/telemetry.h"
+#include "telemetry/frsky.h"
+
+#include "config/runtime_config.h"
+#include "config/config.h"
+#include "config/config_profile.h"
+#include "config/config_master.h"
+
+#include "config/parameters.h"
+
+#define MASTER_OFFSET(field) offsetof(master_t, field)
+#define PROFILE_OFFSET(field) offsetof(profile_t, field)
+#define CONTROL_RATE_OFFSET(field) offsetof(controlRateConfig_t, field)
+
+/*
+ * The single list of user settable parameters, used by the CLI and MSP.
+ *
+ * Keep it sorted by name (case insensitive), lookups are done with a binary search.
+ */
+const parameter_t parameterTable[] = {
+    { "3d_deadband_high",           VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(flight3DConfig.deadband3d_high), PWM_RANGE_ZERO, PWM_RANGE_MAX }, // FIXME lower limit should match code in the mixer, 1500 currently
+    { "3d_deadband_low",            VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(flight3DConfig.deadband3d_low), PWM_RANGE_ZERO, PWM_RANGE_MAX }, // FIXME upper limit should match code in the mixer, 1500 currently
+    { "3d_deadband_throttle",       VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(flight3DConfig.deadband3d_throttle), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "3d_neutral",                 VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(flight3DConfig.neutral3d), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "acc_hardware",               VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(acc_hardware), 0, ACC_MAX },
+    { "acc_lpf_factor",             VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(acc_lpf_factor), 0, 250 },
+    { "acc_trim_pitch",             VAR_INT16  | PROFILE_VALUE, PROFILE_OFFSET(accelerometerTrims.values.pitch), -300, 300 },
+    { "acc_trim_roll",              VAR_INT16  | PROFILE_VALUE, PROFILE_OFFSET(accelerometerTrims.values.roll), -300, 300 },
+    { "acc_unarmedcal",             VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(acc_unarmedcal), 0, 1 },
+    { "accxy_deadband",             VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(accDeadband.xy), 0, 100 },
+    { "accz_deadband",              VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(accDeadband.z), 0, 100 },
+    { "accz_lpf_cutoff",            VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(accz_lpf_cutoff), 1, 20 },
+    { "align_acc",                  VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(sensorAlignmentConfig.acc_align), 0, 8 },
+    { "align_board_pitch",          VAR_INT16  | MASTER_VALUE,  MASTER_OFFSET(boardAlignment.pitchDegrees), -180, 360 },
+    { "align_board_roll",           VAR_INT16  | MASTER_VALUE,  MASTER_OFFSET(boardAlignment.rollDegrees), -180, 360 },
+    { "align_board_yaw",            VAR_INT16  | MASTER_VALUE,  MASTER_OFFSET(boardAlignment.yawDegrees), -180, 360 },
+    { "align_gyro",                 VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(sensorAlignmentConfig.gyro_align), 0, 8 },
+    { "align_mag",                  VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(sensorAlignmentConfig.mag_align), 0, 8 },
+    { "alt_hold_deadband",          VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(rcControlsConfig.alt_hold_deadband), 1, 250 },
+    { "alt_hold_fast_change",       VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(rcControlsConfig.alt_hold_fast_change), 0, 1 },
+    { "auto_disarm_delay",          VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(auto_disarm_delay), 0, 60 },
+    { "baro_cf_alt",                VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(barometerConfig.baro_cf_alt), 0, 1 },
+    { "baro_cf_vel",                VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(barometerConfig.baro_cf_vel), 0, 1 },
+    { "baro_noise_lpf",             VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(barometerConfig.baro_noise_lpf), 0, 1 },
+    { "baro_tab_size",              VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(barometerConfig.baro_sample_count), 0, BARO_SAMPLE_COUNT_MAX },
+    { "battery_capacity",           VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.batteryCapacity), 0, 20000 },
+    { "battery_resistance",         VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.batteryResistance), 0, 255 },
+#ifdef BLACKBOX
+    { "blackbox_device",            VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(blackbox_device), 0, 1 },
+    { "blackbox_rate_denom",        VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(blackbox_rate_denom), 1, 32 },
+    { "blackbox_rate_num",          VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(blackbox_rate_num), 1, 32 },
+#endif
+    { "current_meter_offset",       VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.currentMeterOffset), 0, 3300 },
+    { "current_meter_scale",        VAR_INT16  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.currentMeterScale), -10000, 10000 },
+    { "current_meter_type",         VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.currentMeterType), 0, CURRENT_SENSOR_MAX },
+    { "d_alt",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDALT]), 0, 200 },
+    { "d_level",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDLEVEL]), 0, 200 },
+    { "d_pitch",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PITCH]), 0, 200 },
+    { "d_pitchf",                   VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D_f[PITCH]), 0, 100 },
+    { "d_roll",                     VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[ROLL]), 0, 200 },
+    { "d_rollf",                    VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D_f[ROLL]), 0, 100 },
+    { "d_vel",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDVEL]), 0, 200 },
+    { "d_yaw",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[YAW]), 0, 200 },
+    { "d_yawf",                     VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D_f[YAW]), 0, 100 },
+    { "deadband",                   VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(rcControlsConfig.deadband), 0, 32 },
+    { "default_rate_profile",       VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(defaultRateProfileIndex), 0, MAX_CONTROL_RATE_PROFILE_COUNT - 1 },
+    { "disarm_kill_switch",         VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(disarm_kill_switch), 0, 1 },
+    { "emf_avoidance",              VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(emf_avoidance), 0, 1 },
+    { "failsafe_delay",             VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(failsafeConfig.failsafe_delay), 0, 200 },
+    { "failsafe_max_usec",          VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(failsafeConfig.failsafe_max_usec), 100, PWM_RANGE_MAX + (PWM_RANGE_MAX - PWM_RANGE_MIN) },
+    { "failsafe_min_usec",          VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(failsafeConfig.failsafe_min_usec), 100, PWM_RANGE_MAX },
+    { "failsafe_off_delay",         VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(failsafeConfig.failsafe_off_delay), 0, 200 },
+    { "failsafe_throttle",          VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(failsafeConfig.failsafe_throttle), PWM_RANGE_MIN, PWM_RANGE_MAX },
+    { "fixedwing_althold_dir",      VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(airplaneConfig.fixedwing_althold_dir), -1, 1 },
+    { "flaps_speed",                VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(airplaneConfig.flaps_speed), 0, 100 },
+    { "frsky_coordinates_format",   VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.frsky_coordinate_format), 0, FRSKY_FORMAT_NMEA },
+    { "frsky_default_lattitude",    VAR_FLOAT  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.gpsNoFixLatitude), -90.0, 90.0 },
+    { "frsky_default_longitude",    VAR_FLOAT  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.gpsNoFixLongitude), -180.0, 180.0 },
+    { "frsky_unit",                 VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.frsky_unit), 0, FRSKY_UNIT_IMPERIALS },
+    { "frsky_vfas_precision",       VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.frsky_vfas_precision), FRSKY_VFAS_PRECISION_LOW, FRSKY_VFAS_PRECISION_HIGH },
+#ifdef USE_SERVOS
+    { "gimbal_flags",               VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(gimbalConfig.gimbal_flags), 0, 255 },
+#endif
+#ifdef GPS
+    { "gps_auto_baud",              VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(gpsConfig.autoBaud), GPS_AUTOBAUD_OFF, GPS_AUTOBAUD_ON },
+    { "gps_auto_config",            VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(gpsConfig.autoConfig), GPS_AUTOCONFIG_OFF, GPS_AUTOCONFIG_ON },
+    { "gps_nav_d",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDNAVR]), 0, 200 },
+    { "gps_nav_i",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDNAVR]), 0, 200 },
+    { "gps_nav_p",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDNAVR]), 0, 200 },
+    { "gps_pos_d",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDPOS]), 0, 200 },
+    { "gps_pos_i",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDPOS]), 0, 200 },
+    { "gps_pos_p",                  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDPOS]), 0, 200 },
+    { "gps_posr_d",                 VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.D8[PIDPOSR]), 0, 200 },
+    { "gps_posr_i",                 VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDPOSR]), 0, 200 },
+    { "gps_posr_p",                 VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDPOSR]), 0, 200 },
+    { "gps_provider",               VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(gpsConfig.provider), 0, GPS_PROVIDER_MAX },
+    { "gps_sbas_mode",              VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(gpsConfig.sbasMode), 0, SBAS_MODE_MAX },
+    { "gps_wp_radius",              VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(gpsProfile.gps_wp_radius), 0, 2000 },
+#endif
+    { "gyro_cmpf_factor",           VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(gyro_cmpf_factor), 100, 1000 },
+    { "gyro_cmpfm_factor",          VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(gyro_cmpfm_factor), 100, 1000 },
+    { "gyro_lpf",                   VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(gyro_lpf), 0, 256 },
+    { "i_alt",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDALT]), 0, 200 },
+    { "i_level",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDLEVEL]), 0, 200 },
+    { "i_pitch",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PITCH]), 0, 200 },
+    { "i_pitchf",                   VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I_f[PITCH]), 0, 100 },
+    { "i_roll",                     VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[ROLL]), 0, 200 },
+    { "i_rollf",                    VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I_f[ROLL]), 0, 100 },
+    { "i_vel",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[PIDVEL]), 0, 200 },
+    { "i_yaw",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I8[YAW]), 0, 200 },
+    { "i_yawf",                     VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.I_f[YAW]), 0, 100 },
+    { "input_filtering_mode",       VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(inputFilteringMode), 0, 1 },
+    { "input_median_channels",      VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(rxConfig.input_median_channels), 0, (1 << MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT) - 1 },
+    { "level_angle",                VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.A_level), 0, 10 },
+    { "level_horizon",              VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.H_level), 0, 10 },
+    { "looptime",                   VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(looptime), 0, 9000 },
+    { "mag_declination",            VAR_INT16  | PROFILE_VALUE, PROFILE_OFFSET(mag_declination), -18000, 18000 },
+    { "mag_hardware",               VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(mag_hardware), 0, MAG_MAX },
+    { "max_angle_inclination",      VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(max_angle_inclination), 100, 900 },
+    { "max_check",                  VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(rxConfig.maxcheck), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "max_throttle",               VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(escAndServoConfig.maxthrottle), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "mid_rc",                     VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(rxConfig.midrc), 1200, 1700 },
+    { "min_check",                  VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(rxConfig.mincheck), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "min_command",                VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(escAndServoConfig.mincommand), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "min_throttle",               VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(escAndServoConfig.minthrottle), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+    { "moron_threshold",            VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(gyroConfig.gyroMovementCalibrationThreshold), 0, 128 },
+    { "motor_pwm_rate",             VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(motor_pwm_rate), 50, 32000 },
+    { "multiwii_current_meter_output", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.multiwiiCurrentMeterOutput), 0, 1 },
+#ifdef GPS
+    { "nav_controls_heading",       VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(gpsProfile.nav_controls_heading), 0, 1 },
+    { "nav_slew_rate",              VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(gpsProfile.nav_slew_rate), 0, 100 },
+    { "nav_speed_max",              VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(gpsProfile.nav_speed_max), 10, 2000 },
+    { "nav_speed_min",              VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(gpsProfile.nav_speed_min), 10, 2000 },
+#endif
+    { "p_alt",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDALT]), 0, 200 },
+    { "p_level",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDLEVEL]), 0, 200 },
+    { "p_pitch",                    VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PITCH]), 0, 200 },
+    { "p_pitchf",                   VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P_f[PITCH]), 0, 100 },
+    { "p_roll",                     VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[ROLL]), 0, 200 },
+    { "p_rollf",                    VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P_f[ROLL]), 0, 100 },
+    { "p_vel",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[PIDVEL]), 0, 200 },
+    { "p_yaw",                      VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P8[YAW]), 0, 200 },
+    { "p_yawf",                     VAR_FLOAT  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.P_f[YAW]), 0, 100 },
+    { "pid_at_min_throttle",        VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(mixerConfig.pid_at_min_throttle), 0, 1 },
+    { "pid_controller",             VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.pidController), 0, 5 },
+    { "pitch_rate",                 VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(rates[FD_PITCH]), 0, 100 },
+    { "rc_expo",                    VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(rcExpo8), 0, 100 },
+    { "rc_interpolation",           VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(rxConfig.rc_interpolation), 0, RC_INTERPOLATION_MODE_MAX },
+    { "rc_interpolation_hz",        VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(rxConfig.rc_interpolation_hz), 0, 100 },
+    { "rc_rate",                    VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(rcRate8), 0, 250 },
+    { "reboot_character",           VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.reboot_character), 48, 126 },
+    { "retarded_arm",               VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(retarded_arm), 0, 1 },
+    { "roll_rate",                  VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(rates[FD_ROLL]), 0, 100 },
+    { "rssi_channel",               VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(rxConfig.rssi_channel), 0, MAX_SUPPORTED_RC_CHANNEL_COUNT },
+    { "rssi_scale",                 VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(rxConfig.rssi_scale), RSSI_SCALE_MIN, RSSI_SCALE_MAX },
+    { "sensitivity_horizon",        VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(pidProfile.H_sensitivity), 0, 250 },
+    { "serial_port_1_blackbox_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[0].blackbox_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_1_functions",    VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[0].functionMask), 0, 0xFFFF },
+    { "serial_port_1_gps_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[0].gps_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_1_msp_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[0].msp_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_1_telemetry_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[0].telemetry_baudrateIndex), BAUD_AUTO, BAUD_115200 },
+#if (SERIAL_PORT_COUNT >= 2)
+    { "serial_port_2_blackbox_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[1].blackbox_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_2_functions",    VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[1].functionMask), 0, 0xFFFF },
+    { "serial_port_2_gps_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[1].gps_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_2_msp_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[1].msp_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_2_telemetry_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[1].telemetry_baudrateIndex), BAUD_AUTO, BAUD_115200 },
+#endif
+#if (SERIAL_PORT_COUNT >= 3)
+    { "serial_port_3_blackbox_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[2].blackbox_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_3_functions",    VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[2].functionMask), 0, 0xFFFF },
+    { "serial_port_3_gps_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[2].gps_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_3_msp_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[2].msp_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_3_telemetry_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[2].telemetry_baudrateIndex), BAUD_AUTO, BAUD_115200 },
+#endif
+#if (SERIAL_PORT_COUNT >= 4)
+    { "serial_port_4_blackbox_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[3].blackbox_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_4_functions",    VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[3].functionMask), 0, 0xFFFF },
+    { "serial_port_4_gps_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[3].gps_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_4_msp_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[3].msp_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_4_telemetry_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[3].telemetry_baudrateIndex), BAUD_AUTO, BAUD_115200 },
+#endif
+#if (SERIAL_PORT_COUNT >= 5)
+    { "serial_port_5_blackbox_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[4].blackbox_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_5_functions",    VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[4].functionMask), 0, 0xFFFF },
+    { "serial_port_5_gps_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[4].gps_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_5_msp_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[4].msp_baudrateIndex), BAUD_9600, BAUD_115200 },
+    { "serial_port_5_telemetry_baudrate", VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(serialConfig.portConfigs[4].telemetry_baudrateIndex), BAUD_AUTO, BAUD_115200 },
+#endif
+    { "serialrx_provider",          VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(rxConfig.serialrx_provider), 0, SERIALRX_PROVIDER_MAX },
+    { "servo_center_pulse",         VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(escAndServoConfig.servoCenterPulse), PWM_RANGE_ZERO, PWM_RANGE_MAX },
+#ifdef USE_SERVOS
+    { "servo_lowpass_enable",       VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(mixerConfig.servo_lowpass_enable), 0, 1 },
+    { "servo_lowpass_freq",         VAR_INT16  | MASTER_VALUE,  MASTER_OFFSET(mixerConfig.servo_lowpass_freq), 10, 400 },
+#endif
+    { "servo_pwm_rate",             VAR_UINT16 | MASTER_VALUE,  MASTER_OFFSET(servo_pwm_rate), 50, 498 },
+    { "small_angle",                VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(small_angle), 0, 180 },
+    { "spektrum_sat_bind",          VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(rxConfig.spektrum_sat_bind), SPEKTRUM_SAT_BIND_DISABLED, SPEKTRUM_SAT_BIND_MAX },
+    { "telemetry_inversion",        VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.telemetry_inversion), 0, 1 },
+    { "telemetry_switch",           VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(telemetryConfig.telemetry_switch), 0, 1 },
+    { "thr_expo",                   VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(thrExpo8), 0, 100 },
+    { "thr_mid",                    VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(thrMid8), 0, 100 },
+    { "throttle_correction_angle",  VAR_UINT16 | PROFILE_VALUE, PROFILE_OFFSET(throttle_correction_angle), 1, 900 },
+    { "throttle_correction_value",  VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(throttle_correction_value), 0, 150 },
+    { "tpa_breakpoint",             VAR_UINT16 | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(tpa_breakpoint), PWM_RANGE_MIN, PWM_RANGE_MAX },
+    { "tpa_rate",                   VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(dynThrPID), 0, 100 },
+#ifdef USE_SERVOS
+    { "tri_unarmed_servo",          VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(mixerConfig.tri_unarmed_servo), 0, 1 },
+#endif
+    { "vbat_max_cell_voltage",      VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.vbatmaxcellvoltage), 10, 50 },
+    { "vbat_min_cell_voltage",      VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.vbatmincellvoltage), 10, 50 },
+    { "vbat_scale",                 VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.vbatscale), VBAT_SCALE_MIN, VBAT_SCALE_MAX },
+    { "vbat_warning_cell_voltage",  VAR_UINT8  | MASTER_VALUE,  MASTER_OFFSET(batteryConfig.vbatwarningcellvoltage), 10, 50 },
+    { "yaw_control_direction",      VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(yaw_control_direction), -1, 1 },
+    { "yaw_deadband",               VAR_UINT8  | PROFILE_VALUE, PROFILE_OFFSET(rcControlsConfig.yaw_deadband), 0, 100 },
+    { "yaw_direction",              VAR_INT8   | MASTER_VALUE,  MASTER_OFFSET(mixerConfig.yaw_direction), -1, 1 },
+    { "yaw_rate",                   VAR_UINT8  | CONTROL_RATE_VALUE, CONTROL_RATE_OFFSET(rates[FD_YAW]), 0, 100 },
+};
+
+const uint16_t parameterCount = ARRAYLEN(parameterTable);
+
+static void *parameterGetPointer(const parameter_t *parameter)
+{
+    switch (parameter->type & SECTION_MASK) {
+        case PROFILE_VALUE:
+            return (uint8_t *)&masterConfig.profile[masterConfig.current_profile_index] + parameter->offset;
+
+        case CONTROL_RATE_VALUE:
+            return (uint8_t *)&masterConfig.controlRateProfiles[getCurrentControlRateProfile()] + parameter->offset;
+
+        default:
+            return (uint8_t *)&masterConfig + parameter->offset;
+    }
+}
+
+static int compareName(const char *name, uint8_t length, const parameter_t *parameter)
+{
+    int result = strncasecmp(name, parameter->name, length);
+    if (result == 0 && parameter->name[length] != '\0') {
+        return -1; // name is a prefix of the parameter name
+    }
+    return result;
+}
+
+const parameter_t *parameterFind(const char *name, uint8_t length)
+{
+    int low = 0;
+    int high = parameterCount - 1;
+    int middle;
+    int result;
+
+    while (low <= high) {
+        middle = (low + high) / 2;
+        result = compareName(name, length, &parameterTable[middle]);
+        if (result == 0) {
+            return &parameterTable[middle];
+        }
+        if (result < 0) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return NULL;
+}
+
+const parameter_t *parameterGetByIndex(uint16_t index)
+{
+    if (index >= parameterCount) {
+        return NULL;
+    }
+    return &parameterTable[index];
+}
+
+int_float_value_t parameterGetValue(const parameter_t *parameter)
+{
+    int_float_value_t value;
+    void *ptr = parameterGetPointer(parameter);
+
+    switch (parameter->type & VALUE_TYPE_MASK) {
+        case VAR_UINT8:
+            value.int_value = *(uint8_t *)ptr;
+            break;
+
+        case VAR_INT8:
+            value.int_value = *(int8_t *)ptr;
+            break;
+
+        case VAR_UINT16:
+            value.int_value = *(uint16_t *)ptr;
+            break;
+
+        case VAR_INT16:
+            value.int_value = *(int16_t *)ptr;
+            break;
+
+        case VAR_UINT32:
+            value.int_value = *(uint32_t *)ptr;
+            break;
+
+        case VAR_FLOAT:
+        default:
+            value.float_value = *(float *)ptr;
+            break;
+    }
+    return value;
+}
+
+void parameterSetValue(const parameter_t *parameter, const int_float_value_t value)
+{
+    void *ptr = parameterGetPointer(parameter);
+
+    switch (parameter->type & VALUE_TYPE_MASK) {
+        case VAR_UINT8:
+        case VAR_INT8:
+            *(int8_t *)ptr = value.int_value;
+            break;
+
+        case VAR_UINT16:
+        case VAR_INT16:
+            *(int16_t *)ptr = value.int_value;
+            break;
+
+        case VAR_UINT32:
+            *(uint32_t *)ptr = value.int_value;
+            break;
+
+        case VAR_FLOAT:
+            *(float *)ptr = (float)value.float_value;
+            break;
+    }
+}
+
+bool parameterIsValueInRange(const parameter_t *parameter, const int_float_value_t value)
+{
+    if (parameter->type & VAR_FLOAT) {
+        return value.float_value >= parameter->min && value.float_value <= parameter->max;
+    }
+    return value.int_value >= parameter->min && value.int_value <= parameter->max;
+}
@@ -165,6 +165,7 @@ static void mpu6050AccInit(void);
 static void mpu6050AccRead(int16_t *accData);
 static void mpu6050GyroInit(void);
 static void mpu6050GyroRead(int16_t *gyroData);
+static void mpu6050ReadTemp(int16_t *tempData);
 
 typedef enum {
     MPU_6050_HALF_RESOLUTION,
@@ -275,6 +276,7 @@ bool mpu6050GyroDetect(const mpu6050Config_t *configToUse, gyro_t *gyro, uint16_
 
     gyro->init = mpu6050GyroInit;
     gyro->read = mpu6050GyroRead;
+    gyro->temperature = mpu6050ReadTemp;
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -359,3 +361,15 @@ static void mpu6050GyroRead(int16_t *gyroData)
     gyroData[1] = (int16_t)((buf[2] << 8) | buf[3]);
     gyroData[2] = (int16_t)((buf[4] << 8) | buf[5]);
 }
+
+static void mpu6050ReadTemp(int16_t *tempData)
+{
+    uint8_t buf[2];
+
+    if (!i2cRead(MPU6050_ADDRESS, MPU_RA_TEMP_OUT_H, 2, buf)) {
+        return;
+    }
+
+    // degrees C = raw / 340 + 36.53
+    *tempData = ((int32_t)(int16_t)((buf[0] << 8) | buf[1]) + 12420) / 340;
+}
@@ -317,6 +317,7 @@ bool mpu6000SpiGyroDetect(gyro_t *gyro, uint16_t lpf)
     }
     gyro->init = mpu6000SpiGyroInit;
     gyro->read = mpu6000SpiGyroRead;
+    gyro->temperature = mpu6000SpiReadTemp;
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
     //gyro->scale = (4.0f / 16.4f) * (M_PIf / 180.0f) * 0.000001f;
@@ -349,3 +350,15 @@ void mpu6000SpiAccRead(int16_t *gyroData)
     gyroData[Y] = (int16_t)((buf[2] << 8) | buf[3]);
     gyroData[Z] = (int16_t)((buf[4] << 8) | buf[5]);
 }
+
+void mpu6000SpiReadTemp(int16_t *tempData)
+{
+    uint8_t buf[2];
+
+    spiSetDivisor(MPU6000_SPI_INSTANCE, SPI_18MHZ_CLOCK_DIVIDER);  // 18 MHz SPI clock
+
+    mpu6000ReadRegister(MPU6000_TEMP_OUT_H, buf, 2);
+
+    // degrees C = raw / 340 + 36.53
+    *tempData = ((int32_t)(int16_t)((buf[0] << 8) | buf[1]) + 12420) / 340;
+}
@@ -18,3 +18,4 @@ bool mpu6000SpiGyroDetect(gyro_t *gyro, uint16_t lpf);
 
 void mpu6000SpiGyroRead(int16_t *gyroData);
 void mpu6000SpiAccRead(int16_t *gyroData);
+void mpu6000SpiReadTemp(int16_t *tempData);
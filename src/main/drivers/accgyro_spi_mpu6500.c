@@ -75,6 +75,7 @@ static void mpu6500AccInit(void);
 static void mpu6500AccRead(int16_t *accData);
 static void mpu6500GyroInit(void);
 static void mpu6500GyroRead(int16_t *gyroData);
+static void mpu6500ReadTemp(int16_t *tempData);
 
 extern uint16_t acc_1G;
 
@@ -125,6 +126,7 @@ bool mpu6500SpiGyroDetect(gyro_t *gyro, uint16_t lpf)
 
     gyro->init = mpu6500GyroInit;
     gyro->read = mpu6500GyroRead;
+    gyro->temperature = mpu6500ReadTemp;
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -198,3 +200,13 @@ static void mpu6500GyroRead(int16_t *gyroData)
     gyroData[Y] = (int16_t)((buf[2] << 8) | buf[3]);
     gyroData[Z] = (int16_t)((buf[4] << 8) | buf[5]);
 }
+
+static void mpu6500ReadTemp(int16_t *tempData)
+{
+    uint8_t buf[2];
+
+    mpu6500ReadRegister(MPU6500_RA_TEMP_OUT_H, buf, 2);
+
+    // degrees C = raw / 333.87 + 21
+    *tempData = ((int32_t)(int16_t)((buf[0] << 8) | buf[1]) + 7011) / 334;
+}
@@ -17,6 +17,7 @@
 
 #define MPU6500_RA_WHOAMI                   (0x75)
 #define MPU6500_RA_ACCEL_XOUT_H             (0x3B)
+#define MPU6500_RA_TEMP_OUT_H               (0x41)
 #define MPU6500_RA_GYRO_XOUT_H              (0x43)
 #define MPU6500_RA_BANK_SEL                 (0x6D)
 #define MPU6500_RA_MEM_RW                   (0x6F)
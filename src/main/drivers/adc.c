@@ -30,7 +30,8 @@
 
 #ifdef USE_ADC
 adc_config_t adcConfig[ADC_CHANNEL_COUNT];
-volatile uint16_t adcValues[ADC_CHANNEL_COUNT];
+volatile uint16_t adcValues[ADC_CHANNEL_COUNT * ADC_OVERSAMPLE_COUNT];
+uint8_t adcScanChannelCount;
 
 extern int16_t debug[4];
 
@@ -50,7 +51,12 @@ uint16_t adcGetChannel(uint8_t channel)
         debug[3] = adcValues[adcConfig[3].dmaIndex];
     }
 #endif
-    return adcValues[adcConfig[channel].dmaIndex];
+    // scans are stored one after the other, so samples of a channel are adcScanChannelCount apart
+    uint32_t sampleTotal = 0;
+    for (uint8_t sampleIndex = 0; sampleIndex < ADC_OVERSAMPLE_COUNT; sampleIndex++) {
+        sampleTotal += adcValues[adcConfig[channel].dmaIndex + sampleIndex * adcScanChannelCount];
+    }
+    return sampleTotal / ADC_OVERSAMPLE_COUNT;
 }
 
 #else
@@ -27,6 +27,9 @@ typedef enum {
 
 #define ADC_CHANNEL_COUNT (ADC_CHANNEL_MAX + 1)
 
+// the DMA keeps this many scans of every channel, readings are averaged over them
+#define ADC_OVERSAMPLE_COUNT 8
+
 typedef struct adc_config_t {
     uint8_t adcChannel;         // ADC1_INxx channel number
     uint8_t dmaIndex;           // index into DMA buffer in case of sparse channels
@@ -106,6 +106,8 @@ void adcInit(drv_adc_config_t *init)
     }
 #endif
 
+    adcScanChannelCount = configuredAdcChannels;
+
     RCC_ADCCLKConfig(RCC_PCLK2_Div8);  // 9MHz from 72MHz APB2 clock(HSE), 8MHz from 64MHz (HSI)
 
     RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
@@ -117,9 +119,9 @@ void adcInit(drv_adc_config_t *init)
     dma.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;
     dma.DMA_MemoryBaseAddr = (uint32_t)adcValues;
     dma.DMA_DIR = DMA_DIR_PeripheralSRC;
-    dma.DMA_BufferSize = configuredAdcChannels;
+    dma.DMA_BufferSize = configuredAdcChannels * ADC_OVERSAMPLE_COUNT;
     dma.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-    dma.DMA_MemoryInc = configuredAdcChannels > 1 ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    dma.DMA_MemoryInc = DMA_MemoryInc_Enable;
     dma.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
     dma.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
     dma.DMA_Mode = DMA_Mode_Circular;
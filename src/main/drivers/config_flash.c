@@ -0,0 +1,103 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "build_config.h"
+
+#include "drivers/config_flash.h"
+
+// must match the space excluded from the FLASH region in the linker script
+#ifndef FLASH_TO_RESERVE_FOR_CONFIG
+#define FLASH_TO_RESERVE_FOR_CONFIG 0x2000
+#endif
+
+#ifndef FLASH_PAGE_COUNT
+#ifdef STM32F303xC
+#define FLASH_PAGE_COUNT 128
+#define FLASH_PAGE_SIZE                 ((uint16_t)0x800)
+#endif
+
+#ifdef STM32F10X_MD
+#define FLASH_PAGE_COUNT 128
+#define FLASH_PAGE_SIZE                 ((uint16_t)0x400)
+#endif
+
+#ifdef STM32F10X_HD
+#define FLASH_PAGE_COUNT 128
+#define FLASH_PAGE_SIZE                 ((uint16_t)0x800)
+#endif
+#endif
+
+#if !defined(FLASH_PAGE_COUNT) || !defined(FLASH_PAGE_SIZE)
+#error "Flash page count not defined for target."
+#endif
+
+// use the last flash pages for storage
+#define CONFIG_START_FLASH_ADDRESS (0x08000000 + (uint32_t)((FLASH_PAGE_SIZE * FLASH_PAGE_COUNT) - FLASH_TO_RESERVE_FOR_CONFIG))
+
+uint32_t configFlashGetSize(void)
+{
+    // config storage splits the reserved area into two banks of whole pages
+    BUILD_BUG_ON(FLASH_TO_RESERVE_FOR_CONFIG % (2 * FLASH_PAGE_SIZE) != 0);
+
+    return FLASH_TO_RESERVE_FOR_CONFIG;
+}
+
+uint16_t configFlashGetPageSize(void)
+{
+    return FLASH_PAGE_SIZE;
+}
+
+const uint8_t *configFlashGetAddress(uint32_t offset)
+{
+    return (const uint8_t *) (CONFIG_START_FLASH_ADDRESS + offset);
+}
+
+void configFlashUnlock(void)
+{
+    FLASH_Unlock();
+#ifdef STM32F303
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
+#endif
+#ifdef STM32F10X
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+#endif
+}
+
+void configFlashLock(void)
+{
+    FLASH_Lock();
+}
+
+bool configFlashErasePage(uint32_t offset)
+{
+    return FLASH_ErasePage(CONFIG_START_FLASH_ADDRESS + offset) == FLASH_COMPLETE;
+}
+
+bool configFlashProgramHalfWord(uint32_t offset, uint16_t value)
+{
+    return FLASH_ProgramHalfWord(CONFIG_START_FLASH_ADDRESS + offset, value) == FLASH_COMPLETE;
+}
+
+bool configFlashProgramWord(uint32_t offset, uint32_t value)
+{
+    return FLASH_ProgramWord(CONFIG_START_FLASH_ADDRESS + offset, value) == FLASH_COMPLETE;
+}
@@ -0,0 +1,34 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Access to the region of on-chip flash reserved for configuration storage, all offsets are relative to its start.
+
+uint32_t configFlashGetSize(void);
+uint16_t configFlashGetPageSize(void);
+const uint8_t *configFlashGetAddress(uint32_t offset);
+
+void configFlashUnlock(void);
+void configFlashLock(void);
+
+bool configFlashErasePage(uint32_t offset);
+bool configFlashProgramHalfWord(uint32_t offset, uint16_t value);
+bool configFlashProgramWord(uint32_t offset, uint32_t value);
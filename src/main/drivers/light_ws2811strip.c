@@ -31,18 +31,75 @@
 
 #include "build_config.h"
 
+#include "common/utils.h"
 #include "common/color.h"
 #include "common/colorconversion.h"
 #include "drivers/light_ws2811strip.h"
 
-uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
+uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE] __attribute__((aligned(4)));
 volatile uint8_t ws2811LedDataTransferInProgress = 0;
 
 static hsvColor_t ledColorBuffer[WS2811_LED_STRIP_LENGTH];
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+// The encoded colours, expanded into the DMA buffer a few LEDs at a time while the strip is being transferred.
+static rgbColor24bpp_t ledStripPackedColor[WS2811_LED_STRIP_LENGTH];
+
+static uint16_t dmaFillLedIndex;
+static uint16_t dmaFillResetSlots;      // reset slots queued after the last LED
+static uint16_t dmaFillLastResetSlots;  // reset slots in the half buffer queued most recently
+#endif
+
+/*
+ * The colours currently encoded in the DMA buffer and one bit per LED whose colour may have been changed since then.
+ * Only dirty LEDs that actually changed colour are converted and re-encoded, and if none changed no transfer is started.
+ */
+static hsvColor_t ledEncodedColor[WS2811_LED_STRIP_LENGTH];
+static uint32_t ledDirtyMask[(WS2811_LED_STRIP_LENGTH + 31) / 32];
+
+#define HSV_TO_RGB_CACHE_SIZE 16 // must be a power of 2
+
+typedef struct hsvToRgbCacheEntry_s {
+    hsvColor_t hsv;
+    rgbColor24bpp_t rgb;
+} hsvToRgbCacheEntry_t;
+
+/*
+ * Most layers use a handful of colours, so a small direct-mapped cache saves nearly all of the conversions.
+ * Zeroed entries are valid, black converts to black.
+ */
+static hsvToRgbCacheEntry_t hsvToRgbCache[HSV_TO_RGB_CACHE_SIZE];
+
+STATIC_UNIT_TESTED uint32_t hsvToRgbCacheMisses;
+STATIC_UNIT_TESTED uint32_t ws2811LedsEncoded;
+
+static bool hsvColorEquals(const hsvColor_t *a, const hsvColor_t *b)
+{
+    return a->h == b->h && a->s == b->s && a->v == b->v;
+}
+
+static void markLedDirty(uint16_t index)
+{
+    ledDirtyMask[index / 32] |= 1U << (index % 32);
+}
+
+STATIC_UNIT_TESTED rgbColor24bpp_t *cachedHsvToRgb24(const hsvColor_t *color)
+{
+    hsvToRgbCacheEntry_t *entry = &hsvToRgbCache[(color->h ^ (color->s << 1) ^ (color->v << 3)) & (HSV_TO_RGB_CACHE_SIZE - 1)];
+
+    if (!hsvColorEquals(&entry->hsv, color)) {
+        entry->hsv = *color;
+        entry->rgb = *hsvToRgb24(color);
+        hsvToRgbCacheMisses++;
+    }
+
+    return &entry->rgb;
+}
+
 void setLedHsv(uint16_t index, const hsvColor_t *color)
 {
     ledColorBuffer[index] = *color;
+    markLedDirty(index);
 }
 
 void getLedHsv(uint16_t index, hsvColor_t *color)
@@ -53,11 +110,13 @@ void getLedHsv(uint16_t index, hsvColor_t *color)
 void setLedValue(uint16_t index, const uint8_t value)
 {
     ledColorBuffer[index].v = value;
+    markLedDirty(index);
 }
 
 void scaleLedValue(uint16_t index, const uint8_t scalePercent)
 {
     ledColorBuffer[index].v = ((uint16_t)ledColorBuffer[index].v * scalePercent / 100);
+    markLedDirty(index);
 }
 
 void setStripColor(const hsvColor_t *color)
@@ -79,6 +138,13 @@ void setStripColors(const hsvColor_t *colors)
 void ws2811LedStripInit(void)
 {
     memset(&ledStripDMABuffer, 0, WS2811_DMA_BUFFER_SIZE);
+
+    // nothing has been encoded yet, so no LED may match its encoded colour
+    for (uint16_t index = 0; index < WS2811_LED_STRIP_LENGTH; index++) {
+        ledEncodedColor[index].h = HSV_HUE_MAX + 1;
+        markLedDirty(index);
+    }
+
     ws2811LedStripHardwareInit();
     ws2811UpdateStrip();
 }
@@ -88,75 +154,137 @@ bool isWS2811LedStripReady(void)
     return !ws2811LedDataTransferInProgress;
 }
 
-STATIC_UNIT_TESTED uint16_t dmaBufferOffset;
-static int16_t ledIndex;
+#define WS2811_BIT(nibble, mask) ((nibble) & (mask) ? BIT_COMPARE_1 : BIT_COMPARE_0)
+#define WS2811_NIBBLE(n) (WS2811_BIT(n, 8) | WS2811_BIT(n, 4) << 8 | WS2811_BIT(n, 2) << 16 | (uint32_t)WS2811_BIT(n, 1) << 24)
 
-#define USE_FAST_DMA_BUFFER_IMPL
-#ifdef USE_FAST_DMA_BUFFER_IMPL
+// compare values of the four bits of a nibble, MSB first, in little endian memory order
+static const uint32_t ws2811NibbleCompareValues[16] = {
+    WS2811_NIBBLE(0),  WS2811_NIBBLE(1),  WS2811_NIBBLE(2),  WS2811_NIBBLE(3),
+    WS2811_NIBBLE(4),  WS2811_NIBBLE(5),  WS2811_NIBBLE(6),  WS2811_NIBBLE(7),
+    WS2811_NIBBLE(8),  WS2811_NIBBLE(9),  WS2811_NIBBLE(10), WS2811_NIBBLE(11),
+    WS2811_NIBBLE(12), WS2811_NIBBLE(13), WS2811_NIBBLE(14), WS2811_NIBBLE(15)
+};
 
-STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color)
+/*
+ * Writes the WS2811_BITS_PER_LED compare values of a colour, sent in GRB order MSB first.
+ */
+STATIC_UNIT_TESTED void ws2811ExpandLed(const rgbColor24bpp_t *color, uint8_t *dst)
 {
-    uint32_t grb = (color->rgb.g << 16) | (color->rgb.r << 8) | (color->rgb.b);
+    const uint8_t grb[3] = { color->rgb.g, color->rgb.r, color->rgb.b };
 
-    for (int8_t index = 23; index >= 0; index--) {
-        ledStripDMABuffer[dmaBufferOffset++] = (grb & (1 << index)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+    for (uint8_t index = 0; index < 3; index++) {
+        memcpy(dst, &ws2811NibbleCompareValues[grb[index] >> 4], 4);
+        memcpy(dst + 4, &ws2811NibbleCompareValues[grb[index] & 0x0F], 4);
+        dst += 8;
     }
 }
-#else
-STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
+
+#ifdef USE_LED_STRIP_PACKED_DMA
+
+/*
+ * Expands the next LEDs, followed by the reset period, into one half of the DMA buffer.
+ * Called for each half once it has been transferred, returns false once the reset period has been
+ * transferred too and the DMA should be stopped.  The half in flight then only holds reset slots.
+ */
+bool ws2811FillDMAHalfBuffer(uint8_t half)
 {
-    uint8_t bitIndex;
+    if (dmaFillResetSlots - dmaFillLastResetSlots >= WS2811_DELAY_BUFFER_LENGTH) {
+        return false;
+    }
 
-    for (bitIndex = 0; bitIndex < 8; bitIndex++)
-    {
-        if ((componentValue << bitIndex) & 0x80 )    // data sent MSB first, j = 0 is MSB j = 7 is LSB
-        {
-            ledStripDMABuffer[dmaBufferOffset] = BIT_COMPARE_1;
-        }
-        else
-        {
-            ledStripDMABuffer[dmaBufferOffset] = BIT_COMPARE_0;   // compare value for logical 0
-        }
-        dmaBufferOffset++;
+    uint8_t *dst = &ledStripDMABuffer[half * WS2811_DMA_HALF_BUFFER_SIZE];
+    uint8_t *end = dst + WS2811_DMA_HALF_BUFFER_SIZE;
+
+    while (dst < end && dmaFillLedIndex < WS2811_LED_STRIP_LENGTH) {
+        ws2811ExpandLed(&ledStripPackedColor[dmaFillLedIndex++], dst);
+        dst += WS2811_BITS_PER_LED;
     }
+
+    dmaFillLastResetSlots = end - dst;
+    memset(dst, 0, dmaFillLastResetSlots);
+    dmaFillResetSlots += dmaFillLastResetSlots;
+
+    return true;
+}
+
+static void ws2811StartDMAFill(void)
+{
+    dmaFillLedIndex = 0;
+    dmaFillResetSlots = 0;
+    dmaFillLastResetSlots = 0;
+
+    ws2811FillDMAHalfBuffer(0);
+    ws2811FillDMAHalfBuffer(1);
 }
+
+#else
+
+STATIC_UNIT_TESTED uint16_t dmaBufferOffset;
+
+STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color)
+{
+    ws2811ExpandLed(color, &ledStripDMABuffer[dmaBufferOffset]);
+    dmaBufferOffset += WS2811_BITS_PER_LED;
+}
+
 #endif
 
+static void ws2811EncodeLed(uint16_t index)
+{
+    rgbColor24bpp_t *rgb24 = cachedHsvToRgb24(&ledColorBuffer[index]);
+
+#ifdef USE_LED_STRIP_PACKED_DMA
+    ledStripPackedColor[index] = *rgb24;
+#else
+    dmaBufferOffset = index * WS2811_BITS_PER_LED;
+    fastUpdateLEDDMABuffer(rgb24);
+#endif
+
+    ledEncodedColor[index] = ledColorBuffer[index];
+    ws2811LedsEncoded++;
+}
+
 /*
  * This method is non-blocking unless an existing LED update is in progress.
  * it does not wait until all the LEDs have been updated, that happens in the background.
+ *
+ * Nothing is transferred if no LED changed colour since the last update.
  */
 void ws2811UpdateStrip(void)
 {
     static uint32_t waitCounter = 0;
-    static rgbColor24bpp_t *rgb24;
+    bool changed = false;
 
     // wait until previous transfer completes
     while(ws2811LedDataTransferInProgress) {
         waitCounter++;
     }
 
-    dmaBufferOffset = 0;                // reset buffer memory index
-    ledIndex = 0;                       // reset led index
+    // re-encode the compare values of the LEDs whose colour changed
+    for (uint8_t word = 0; word < ARRAYLEN(ledDirtyMask); word++) {
+        uint32_t dirty = ledDirtyMask[word];
+        ledDirtyMask[word] = 0;
 
-    // fill transmit buffer with correct compare values to achieve
-    // correct pulse widths according to color values
-    while (ledIndex < WS2811_LED_STRIP_LENGTH)
-    {
-        rgb24 = hsvToRgb24(&ledColorBuffer[ledIndex]);
+        while (dirty) {
+            uint8_t bit = __builtin_ctz(dirty);
+            dirty &= dirty - 1;
 
-#ifdef USE_FAST_DMA_BUFFER_IMPL
-        fastUpdateLEDDMABuffer(rgb24);
-#else
-        updateLEDDMABuffer(rgb24->rgb.g);
-        updateLEDDMABuffer(rgb24->rgb.r);
-        updateLEDDMABuffer(rgb24->rgb.b);
-#endif
+            uint16_t ledIndex = word * 32 + bit;
+            if (!hsvColorEquals(&ledColorBuffer[ledIndex], &ledEncodedColor[ledIndex])) {
+                ws2811EncodeLed(ledIndex);
+                changed = true;
+            }
+        }
+    }
 
-        ledIndex++;
+    if (!changed) {
+        return;
     }
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+    ws2811StartDMAFill();
+#endif
+
     ws2811LedDataTransferInProgress = 1;
     ws2811LedStripDMAEnable();
 }
-
@@ -21,9 +21,17 @@
 #define WS2811_BITS_PER_LED 24
 #define WS2811_DELAY_BUFFER_LENGTH 42 // for 50us delay
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+// colours are kept packed and expanded into a ping-pong DMA buffer from the half and full transfer interrupts
+#define WS2811_DMA_BUFFER_LEDS 4
+#define WS2811_DMA_HALF_BUFFER_SIZE (WS2811_BITS_PER_LED * WS2811_DMA_BUFFER_LEDS / 2)
+
+#define WS2811_DMA_BUFFER_SIZE (WS2811_DMA_HALF_BUFFER_SIZE * 2)
+#else
 #define WS2811_DATA_BUFFER_SIZE (WS2811_BITS_PER_LED * WS2811_LED_STRIP_LENGTH)
 
 #define WS2811_DMA_BUFFER_SIZE (WS2811_DATA_BUFFER_SIZE + WS2811_DELAY_BUFFER_LENGTH)   // number of bytes needed is #LEDs * 24 bytes + 42 trailing bytes)
+#endif
 
 #define BIT_COMPARE_1 17 // timer compare value for logical 1
 #define BIT_COMPARE_0 9  // timer compare value for logical 0
@@ -46,6 +54,10 @@ void setStripColors(const hsvColor_t *colors);
 
 bool isWS2811LedStripReady(void);
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+bool ws2811FillDMAHalfBuffer(uint8_t half);
+#endif
+
 extern uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
 extern volatile uint8_t ws2811LedDataTransferInProgress;
 
@@ -89,7 +89,11 @@ void ws2811LedStripHardwareInit(void)
     DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
     DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
     DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+#ifdef USE_LED_STRIP_PACKED_DMA
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+#else
     DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+#endif
     DMA_InitStructure.DMA_Priority = DMA_Priority_High;
     DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
 
@@ -98,7 +102,11 @@ void ws2811LedStripHardwareInit(void)
     /* TIM3 CC1 DMA Request enable */
     TIM_DMACmd(TIM3, TIM_DMA_CC1, ENABLE);
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+    DMA_ITConfig(DMA1_Channel6, DMA_IT_HT | DMA_IT_TC, ENABLE);
+#else
     DMA_ITConfig(DMA1_Channel6, DMA_IT_TC, ENABLE);
+#endif
 
     NVIC_InitTypeDef NVIC_InitStructure;
 
@@ -112,6 +120,27 @@ void ws2811LedStripHardwareInit(void)
     ws2811UpdateStrip();
 }
 
+#ifdef USE_LED_STRIP_PACKED_DMA
+void DMA1_Channel6_IRQHandler(void)
+{
+    uint8_t half;
+
+    if (DMA_GetFlagStatus(DMA1_FLAG_HT6)) {
+        DMA_ClearFlag(DMA1_FLAG_HT6);               // first half transferred, the second half is in flight
+        half = 0;
+    } else if (DMA_GetFlagStatus(DMA1_FLAG_TC6)) {
+        DMA_ClearFlag(DMA1_FLAG_TC6);               // second half transferred, wrapped around to the first half
+        half = 1;
+    } else {
+        return;
+    }
+
+    if (!ws2811FillDMAHalfBuffer(half)) {
+        DMA_Cmd(DMA1_Channel6, DISABLE);            // the reset period has been sent
+        ws2811LedDataTransferInProgress = 0;
+    }
+}
+#else
 void DMA1_Channel6_IRQHandler(void)
 {
     if (DMA_GetFlagStatus(DMA1_FLAG_TC6)) {
@@ -120,6 +149,7 @@ void DMA1_Channel6_IRQHandler(void)
         DMA_ClearFlag(DMA1_FLAG_TC6);               // clear DMA1 Channel 6 transfer complete flag
     }
 }
+#endif
 
 void ws2811LedStripDMAEnable(void)
 {
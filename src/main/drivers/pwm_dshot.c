@@ -0,0 +1,72 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pwm_mapping.h"
+
+#include "pwm_dshot.h"
+
+/*
+ * A frame is 11 bits of throttle, a telemetry request bit and a 4 bit checksum, sent MSB first.
+ *
+ * Each bit is one timer period, the pulse is high for 3/4 of the period for a 1 and 3/8 for a 0.
+ * The ESC measures the pulse against the bit period so it needs no calibration.
+ */
+
+uint16_t dshotConvertFromPulse(uint16_t pulse)
+{
+    uint32_t throttle;
+
+    if (pulse <= PULSE_1MS) {
+        return DSHOT_MOTOR_STOP;
+    }
+
+    throttle = DSHOT_MIN_THROTTLE + (uint32_t)(pulse - PULSE_1MS) * (DSHOT_MAX_THROTTLE - DSHOT_MIN_THROTTLE) / PULSE_1MS;
+    if (throttle > DSHOT_MAX_THROTTLE) {
+        throttle = DSHOT_MAX_THROTTLE;
+    }
+    return throttle;
+}
+
+uint16_t dshotEncodeFrame(uint16_t throttle, bool requestTelemetry)
+{
+    uint16_t packet = (throttle << 1) | (requestTelemetry ? 1 : 0);
+
+    // checksum is the xor of the three nibbles of the packet
+    uint16_t checksum = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0F;
+
+    return (packet << 4) | checksum;
+}
+
+/*
+ * Writes the compare values for one motor into a timer burst buffer, the buffer holds one row per bit
+ * and stride compare registers per row.  The reset slots at the end of the frame are left at 0.
+ */
+void dshotLoadFrame(uint16_t *bitBuffer, uint8_t stride, uint16_t frame)
+{
+    uint8_t bitIndex;
+
+    for (bitIndex = 0; bitIndex < DSHOT_FRAME_BITS; bitIndex++) {
+        bitBuffer[bitIndex * stride] = (frame & 0x8000) ? DSHOT_BIT_COMPARE_1 : DSHOT_BIT_COMPARE_0;
+        frame <<= 1;
+    }
+    for (; bitIndex < DSHOT_BIT_SLOTS; bitIndex++) {
+        bitBuffer[bitIndex * stride] = 0;
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define DSHOT_FRAME_BITS 16
+#define DSHOT_RESET_BITS 2      // bit periods with no pulse after each frame, the line idles low until the next frame
+#define DSHOT_BIT_SLOTS (DSHOT_FRAME_BITS + DSHOT_RESET_BITS)
+
+#define DSHOT_MOTOR_STOP 0
+#define DSHOT_MIN_THROTTLE 48   // 1..47 are reserved for ESC commands
+#define DSHOT_MAX_THROTTLE 2047
+
+// DSHOT600, 1.67us per bit
+#define DSHOT_TIMER_MHZ 24
+#define DSHOT_BIT_PERIOD 40
+#define DSHOT_BIT_COMPARE_1 30  // timer compare value for logical 1
+#define DSHOT_BIT_COMPARE_0 15  // timer compare value for logical 0
+
+uint16_t dshotConvertFromPulse(uint16_t pulse);
+uint16_t dshotEncodeFrame(uint16_t throttle, bool requestTelemetry);
+void dshotLoadFrame(uint16_t *bitBuffer, uint8_t stride, uint16_t frame);
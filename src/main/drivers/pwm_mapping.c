@@ -32,6 +32,9 @@
 void pwmBrushedMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t motorPwmRate, uint16_t idlePulse);
 void pwmBrushlessMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t motorPwmRate, uint16_t idlePulse);
 void pwmOneshotMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t idlePulse);
+#ifdef USE_DSHOT
+bool pwmDshotMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex);
+#endif
 void pwmServoConfig(const timerHardware_t *timerHardware, uint8_t servoIndex, uint16_t servoPwmRate, uint16_t servoCenterPulse);
 
 /*
@@ -485,6 +488,13 @@ pwmOutputConfiguration_t *pwmInit(drv_pwm_config_t *init)
             pwmInConfig(timerHardwarePtr, channelIndex);
             channelIndex++;
         } else if (type == MAP_TO_MOTOR_OUTPUT) {
+#ifdef USE_DSHOT
+            // a motor on a timer without a free burst DMA channel falls back to standard PWM rather than staying silent
+            if (init->useDshot && pwmDshotMotorConfig(timerHardwarePtr, pwmOutputConfiguration.motorCount)) {
+                pwmOutputConfiguration.motorCount++;
+                continue;
+            }
+#endif
             if (init->useOneshot) {
                 pwmOneshotMotorConfig(timerHardwarePtr, pwmOutputConfiguration.motorCount, init->idlePulse);
             } else if (init->motorPwmRate > 500) {
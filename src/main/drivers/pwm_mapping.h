@@ -47,6 +47,9 @@ typedef struct drv_pwm_config_t {
 #endif
     bool useVbat;
     bool useOneshot;
+#ifdef USE_DSHOT
+    bool useDshot;
+#endif
     bool useSoftSerial;
     bool useLEDStrip;
 #ifdef USE_SERVOS
@@ -28,6 +28,9 @@
 #include "flight/failsafe.h" // FIXME dependency into the main code from a driver
 
 #include "pwm_mapping.h"
+#ifdef USE_DSHOT
+#include "pwm_dshot.h"
+#endif
 
 #include "pwm_output.h"
 
@@ -38,6 +41,9 @@ typedef struct {
     TIM_TypeDef *tim;
     uint16_t period;
     pwmWriteFuncPtr pwmWritePtr;
+#ifdef USE_DSHOT
+    uint16_t *dshotBitBuffer;
+#endif
 } pwmOutputPort_t;
 
 static pwmOutputPort_t pwmOutputPorts[MAX_PWM_OUTPUT_PORTS];
@@ -51,6 +57,50 @@ static pwmOutputPort_t *servos[MAX_PWM_SERVOS];
 
 static uint8_t allocatedOutputPortCount = 0;
 
+// timers driving motors, oneshot restarts them all together once every motor value is staged
+static TIM_TypeDef *motorTimers[MAX_PWM_MOTORS];
+static uint8_t motorTimerCount = 0;
+
+// counter clock of the free running motor timers, 0 when the motor pulses are started by the mixer
+static uint8_t motorTimerMhz = 0;
+
+#ifdef USE_DSHOT
+/*
+ * Every DMA burst writes CCR1..CCR4 of a timer through its DMAR register, so the compare values of all the
+ * motors on a timer are loaded together at the start of each bit period.
+ */
+#define DSHOT_BURST_CHANNELS 4
+#define DSHOT_BURST_BUFFER_SIZE (DSHOT_BIT_SLOTS * DSHOT_BURST_CHANNELS)
+
+#define DSHOT_TRIGGER_COMPARE (DSHOT_BIT_PERIOD / 2)
+
+typedef struct dshotTimerHardware_s {
+    TIM_TypeDef *tim;
+    DMA_Channel_TypeDef *dmaChannel;
+    uint16_t dmaSource;
+} dshotTimerHardware_t;
+
+#ifdef STM32F10X
+static const dshotTimerHardware_t dshotTimerHardware[] = {
+    // TIM1_UP shares DMA1 channel 5 with USART1 RX, compare channel 2 has no pin on any target so it triggers the burst instead.
+    { TIM1, DMA1_Channel3, TIM_DMA_CC2 },
+    { TIM2, DMA1_Channel2, TIM_DMA_Update },
+    { TIM3, DMA1_Channel3, TIM_DMA_Update },
+    { TIM4, DMA1_Channel7, TIM_DMA_Update },
+};
+#endif
+
+#define DSHOT_TIMER_HARDWARE_COUNT (sizeof(dshotTimerHardware) / sizeof(dshotTimerHardware[0]))
+
+typedef struct dshotTimer_s {
+    const dshotTimerHardware_t *hardware;
+    uint16_t bitBuffer[DSHOT_BURST_BUFFER_SIZE];
+} dshotTimer_t;
+
+static dshotTimer_t dshotTimers[DSHOT_TIMER_HARDWARE_COUNT];
+static uint8_t dshotTimerCount = 0;
+#endif
+
 static void pwmOCConfig(TIM_TypeDef *tim, uint8_t channel, uint16_t value)
 {
     TIM_OCInitTypeDef  TIM_OCInitStructure;
@@ -126,6 +176,18 @@ static pwmOutputPort_t *pwmOutConfig(const timerHardware_t *timerHardware, uint8
     return p;
 }
 
+static void pwmAddMotorTimer(TIM_TypeDef *tim)
+{
+    uint8_t index;
+
+    for (index = 0; index < motorTimerCount; index++) {
+        if (motorTimers[index] == tim) {
+            return;
+        }
+    }
+    motorTimers[motorTimerCount++] = tim;
+}
+
 static void pwmWriteBrushed(uint8_t index, uint16_t value)
 {
     *motors[index]->ccr = (value - 1000) * motors[index]->period / 1000;
@@ -145,28 +207,36 @@ void pwmWriteMotor(uint8_t index, uint16_t value)
 void pwmCompleteOneshotMotorUpdate(uint8_t motorCount)
 {
     uint8_t index;
-    TIM_TypeDef *lastTimerPtr = NULL;
 
-    for(index = 0; index < motorCount; index++){
+    // Every motor value is waiting in a preloaded compare register, the forced overflow loads them and starts the pulses on all timers together.
+    timerForceOverflowGroup(motorTimers, motorTimerCount);
 
-        // Force the timer to overflow if it's the first motor to output, or if we change timers
-        if(motors[index]->tim != lastTimerPtr){
-            lastTimerPtr = motors[index]->tim;
-
-            timerForceOverflow(motors[index]->tim);
+    for(index = 0; index < motorCount; index++){
+        if (!motors[index]) {
+            continue;
         }
-
         // Set the compare register to 0, which stops the output pulsing if the timer overflows before the main loop completes again.
         // This compare register will be set to the output value on the next main loop.
         *motors[index]->ccr = 0;
     }
 }
 
+uint16_t pwmGetMotorPulseStartDelay(void)
+{
+    if (!motorTimerMhz || !motors[0]) {
+        return 0; // started by the mixer
+    }
+
+    // free running timers load the staged values and start the next pulse when they overflow
+    return (motors[0]->period - motors[0]->tim->CNT) / motorTimerMhz;
+}
+
 void pwmBrushedMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t motorPwmRate, uint16_t idlePulse)
 {
     uint32_t hz = PWM_BRUSHED_TIMER_MHZ * 1000000;
     motors[motorIndex] = pwmOutConfig(timerHardware, PWM_BRUSHED_TIMER_MHZ, hz / motorPwmRate, idlePulse);
     motors[motorIndex]->pwmWritePtr = pwmWriteBrushed;
+    motorTimerMhz = PWM_BRUSHED_TIMER_MHZ;
 }
 
 void pwmBrushlessMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t motorPwmRate, uint16_t idlePulse)
@@ -174,14 +244,123 @@ void pwmBrushlessMotorConfig(const timerHardware_t *timerHardware, uint8_t motor
     uint32_t hz = PWM_TIMER_MHZ * 1000000;
     motors[motorIndex] = pwmOutConfig(timerHardware, PWM_TIMER_MHZ, hz / motorPwmRate, idlePulse);
     motors[motorIndex]->pwmWritePtr = pwmWriteStandard;
+    motorTimerMhz = PWM_TIMER_MHZ;
 }
 
 void pwmOneshotMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex, uint16_t idlePulse)
 {
     motors[motorIndex] = pwmOutConfig(timerHardware, ONESHOT125_TIMER_MHZ, 0xFFFF, idlePulse);
     motors[motorIndex]->pwmWritePtr = pwmWriteStandard;
+    pwmAddMotorTimer(timerHardware->tim);
 }
 
+#ifdef USE_DSHOT
+static void pwmWriteDshot(uint8_t index, uint16_t value)
+{
+    dshotLoadFrame(motors[index]->dshotBitBuffer, DSHOT_BURST_CHANNELS, dshotEncodeFrame(dshotConvertFromPulse(value), false));
+}
+
+void pwmCompleteDshotMotorUpdate(void)
+{
+    uint8_t timerIndex;
+
+    // the previous frame finished long ago, rewind the DMA so the next burst trigger starts the new frame
+    for (timerIndex = 0; timerIndex < dshotTimerCount; timerIndex++) {
+        DMA_Channel_TypeDef *dmaChannel = dshotTimers[timerIndex].hardware->dmaChannel;
+
+        DMA_Cmd(dmaChannel, DISABLE);
+        DMA_SetCurrDataCounter(dmaChannel, DSHOT_BURST_BUFFER_SIZE);
+        DMA_Cmd(dmaChannel, ENABLE);
+    }
+}
+
+static void dshotDMAConfig(dshotTimer_t *dshotTimer)
+{
+    const dshotTimerHardware_t *hardware = dshotTimer->hardware;
+    DMA_InitTypeDef DMA_InitStructure;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(hardware->dmaChannel);
+
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&hardware->tim->DMAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)dshotTimer->bitBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = DSHOT_BURST_BUFFER_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(hardware->dmaChannel, &DMA_InitStructure);
+
+    TIM_DMAConfig(hardware->tim, TIM_DMABase_CCR1, TIM_DMABurstLength_4Transfers);
+
+    if (hardware->dmaSource == TIM_DMA_CC2) {
+        // the burst rewrites CCR2 as well, keep the trigger point in every row
+        uint8_t bitIndex;
+        for (bitIndex = 0; bitIndex < DSHOT_BIT_SLOTS; bitIndex++) {
+            dshotTimer->bitBuffer[bitIndex * DSHOT_BURST_CHANNELS + 1] = DSHOT_TRIGGER_COMPARE;
+        }
+        TIM_SetCompare2(hardware->tim, DSHOT_TRIGGER_COMPARE);
+    }
+    TIM_DMACmd(hardware->tim, hardware->dmaSource, ENABLE);
+}
+
+static dshotTimer_t *dshotTimerConfig(TIM_TypeDef *tim)
+{
+    const dshotTimerHardware_t *hardware = NULL;
+    uint8_t index;
+
+    for (index = 0; index < dshotTimerCount; index++) {
+        if (dshotTimers[index].hardware->tim == tim) {
+            return &dshotTimers[index];
+        }
+    }
+
+    for (index = 0; index < DSHOT_TIMER_HARDWARE_COUNT; index++) {
+        if (dshotTimerHardware[index].tim == tim) {
+            hardware = &dshotTimerHardware[index];
+            break;
+        }
+    }
+    if (!hardware) {
+        return NULL;
+    }
+
+    // timers that share a DMA channel cannot both be used, the first one configured keeps it
+    for (index = 0; index < dshotTimerCount; index++) {
+        if (dshotTimers[index].hardware->dmaChannel == hardware->dmaChannel) {
+            return NULL;
+        }
+    }
+
+    dshotTimer_t *dshotTimer = &dshotTimers[dshotTimerCount++];
+    dshotTimer->hardware = hardware;
+    dshotDMAConfig(dshotTimer);
+    return dshotTimer;
+}
+
+bool pwmDshotMotorConfig(const timerHardware_t *timerHardware, uint8_t motorIndex)
+{
+    dshotTimer_t *dshotTimer = dshotTimerConfig(timerHardware->tim);
+    if (!dshotTimer) {
+        return false;
+    }
+
+    motors[motorIndex] = pwmOutConfig(timerHardware, DSHOT_TIMER_MHZ, DSHOT_BIT_PERIOD, 0);
+    motors[motorIndex]->pwmWritePtr = pwmWriteDshot;
+    motors[motorIndex]->dshotBitBuffer = &dshotTimer->bitBuffer[timerHardware->channel / 4]; // TIM_Channel_1..4 are 0x0..0xC
+
+    dshotLoadFrame(motors[motorIndex]->dshotBitBuffer, DSHOT_BURST_CHANNELS, dshotEncodeFrame(DSHOT_MOTOR_STOP, false));
+
+    return true;
+}
+#endif
+
 #ifdef USE_SERVOS
 void pwmServoConfig(const timerHardware_t *timerHardware, uint8_t servoIndex, uint16_t servoPwmRate, uint16_t servoCenterPulse)
 {
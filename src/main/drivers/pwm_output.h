@@ -19,5 +19,9 @@
 
 void pwmWriteMotor(uint8_t index, uint16_t value);
 void pwmCompleteOneshotMotorUpdate(uint8_t motorCount);
+uint16_t pwmGetMotorPulseStartDelay(void);
+#ifdef USE_DSHOT
+void pwmCompleteDshotMotorUpdate(void);
+#endif
 
 void pwmWriteServo(uint8_t index, uint16_t value);
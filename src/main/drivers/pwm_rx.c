@@ -228,6 +228,9 @@ static void ppmEdgeCallback(timerCCHandlerRec_t* cbRec, captureCompare_t capture
 
 #define MAX_MISSED_PWM_EVENTS 10
 
+#define PWM_IN_MIN_PULSE_US 750
+#define PWM_IN_MAX_PULSE_US 2250
+
 static void pwmOverflowCallback(timerOvrHandlerRec_t* cbRec, captureCompare_t capture)
 {
     UNUSED(capture);
@@ -253,12 +256,16 @@ static void pwmEdgeCallback(timerCCHandlerRec_t *cbRec, captureCompare_t capture
 
         // compute and store capture
         pwmInputPort->capture = pwmInputPort->fall - pwmInputPort->rise;
-        captures[pwmInputPort->channel] = pwmInputPort->capture;
+
+        // a glitch keeps the last valid pulse, a channel without valid pulses times out in pwmOverflowCallback
+        if (pwmInputPort->capture > PWM_IN_MIN_PULSE_US && pwmInputPort->capture < PWM_IN_MAX_PULSE_US) {
+            captures[pwmInputPort->channel] = pwmInputPort->capture;
+            pwmInputPort->missedEvents = 0;
+        }
 
         // switch state
         pwmInputPort->state = 0;
         pwmICConfig(timerHardwarePtr->tim, timerHardwarePtr->channel, TIM_ICPolarity_Rising);
-        pwmInputPort->missedEvents = 0;
     }
 }
 
@@ -40,6 +40,18 @@ void serialWrite(serialPort_t *instance, uint8_t ch)
     instance->vTable->serialWrite(instance, ch);
 }
 
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    if (instance->vTable->writeBuf) {
+        instance->vTable->writeBuf(instance, data, count);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        instance->vTable->serialWrite(instance, data[i]);
+    }
+}
+
 uint8_t serialTotalBytesWaiting(serialPort_t *instance)
 {
     return instance->vTable->serialTotalBytesWaiting(instance);
@@ -68,9 +68,13 @@ struct serialPortVTable {
     bool (*isSerialTransmitBufferEmpty)(serialPort_t *instance);
 
     void (*setMode)(serialPort_t *instance, portMode_t mode);
+
+    // Optional, drivers which can transmit a block more efficiently than byte by byte provide this.
+    void (*writeBuf)(serialPort_t *instance, const uint8_t *data, int count);
 };
 
 void serialWrite(serialPort_t *instance, uint8_t ch);
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count);
 uint8_t serialTotalBytesWaiting(serialPort_t *instance);
 uint8_t serialRead(serialPort_t *instance);
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate);
@@ -99,7 +99,32 @@ void usbVcpWrite(serialPort_t *instance, uint8_t c)
 
 }
 
-const struct serialPortVTable usbVTable[] = { { usbVcpWrite, usbVcpAvailable, usbVcpRead, usbVcpSetBaudRate, isUsbVcpTransmitBufferEmpty, usbVcpSetMode } };
+/**
+ * Send a whole buffer, packing as many bytes as possible into each USB packet rather than sending one per byte.
+ */
+void usbVcpWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    UNUSED(instance);
+
+    uint32_t start = millis();
+
+    if (!(usbIsConnected() && usbIsConfigured())) {
+        return;
+    }
+
+    while (count > 0 && (millis() - start < USB_TIMEOUT)) {
+        uint32_t txed = CDC_Send_DATA((uint8_t*)data, count > 255 ? 255 : count);
+
+        data += txed;
+        count -= txed;
+
+        if (txed > 0) {
+            start = millis();
+        }
+    }
+}
+
+const struct serialPortVTable usbVTable[] = { { usbVcpWrite, usbVcpAvailable, usbVcpRead, usbVcpSetBaudRate, isUsbVcpTransmitBufferEmpty, usbVcpSetMode, usbVcpWriteBuf } };
 
 serialPort_t *usbVcpOpen(void)
 {
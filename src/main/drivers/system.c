@@ -43,9 +43,21 @@ static void cycleCounterInit(void)
 }
 
 // SysTick
+static sysTickCallbackPtr sysTickCallback = NULL;
+
 void SysTick_Handler(void)
 {
     sysTickUptime++;
+
+    if (sysTickCallback) {
+        sysTickCallback();
+    }
+}
+
+// only one callback is supported, it runs in interrupt context every millisecond
+void setSysTickCallback(sysTickCallbackPtr callback)
+{
+    sysTickCallback = callback;
 }
 
 // Return system uptime in microseconds (rollover in 70minutes)
@@ -24,6 +24,9 @@ void delay(uint32_t ms);
 uint32_t micros(void);
 uint32_t millis(void);
 
+typedef void (*sysTickCallbackPtr)(void);
+void setSysTickCallback(sysTickCallbackPtr callback);
+
 // failure
 void failureMode(uint8_t mode);
 
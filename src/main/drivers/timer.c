@@ -852,3 +852,26 @@ void timerForceOverflow(TIM_TypeDef *tim)
         tim->EGR |= TIM_EGR_UG;
     }
 }
+
+// Forces an overflow on several timers back to back, so outputs on different timers start their period within a few cycles of each other
+void timerForceOverflowGroup(TIM_TypeDef * const *timers, uint8_t timerCount)
+{
+    timerConfig_t *configs[USED_TIMER_COUNT];
+    uint8_t index;
+
+    if (timerCount > USED_TIMER_COUNT) {
+        timerCount = USED_TIMER_COUNT;
+    }
+
+    // look the timers up first, so only the register accesses remain between the first and the last overflow
+    for (index = 0; index < timerCount; index++) {
+        configs[index] = &timerConfig[lookupTimerIndex((const TIM_TypeDef *)timers[index])];
+    }
+
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        for (index = 0; index < timerCount; index++) {
+            configs[index]->forcedOverflowTimerValue = timers[index]->CNT + 1;
+            timers[index]->EGR = TIM_EGR_UG; // EGR reads as zero, no need to read-modify-write
+        }
+    }
+}
@@ -110,6 +110,7 @@ void timerChInit(const timerHardware_t *timHw, channelType_t type, int irqPriori
 void timerInit(void);
 void timerStart(void);
 void timerForceOverflow(TIM_TypeDef *tim);
+void timerForceOverflowGroup(TIM_TypeDef * const *timers, uint8_t timerCount);
 
 void configTimeBase(TIM_TypeDef *tim, uint16_t period, uint8_t mhz);  // TODO - just for migration
 
@@ -141,6 +141,18 @@ void failsafeUpdateState(void)
     }
 }
 
+/**
+ * Should be called for each frame a serial receiver delivers, with its serialrxFrameState_t flags.
+ */
+void failsafeOnRxFrame(uint8_t frameStatus)
+{
+    // in failsafe, or after losing a frame, the receiver repeats old channel data so the link is no better than before
+    if (frameStatus & (SERIAL_RX_FRAME_FAILSAFE | SERIAL_RX_FRAME_DROPPED)) {
+        return;
+    }
+    failsafeReset();
+}
+
 /**
  * Should be called once each time RX data is processed by the system.
  */
@@ -38,6 +38,7 @@ void useFailsafeConfig(failsafeConfig_t *failsafeConfigToUse);
 
 void failsafeEnable(void);
 void failsafeOnRxCycle(void);
+void failsafeOnRxFrame(uint8_t frameStatus);
 void failsafeCheckPulse(uint8_t channel, uint16_t pulseDuration);
 void failsafeUpdateState(void);
 
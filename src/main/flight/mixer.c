@@ -63,6 +63,10 @@ uint8_t motorCount = 0;
 int16_t motor[MAX_SUPPORTED_MOTORS];
 int16_t motor_disarmed[MAX_SUPPORTED_MOTORS];
 
+motorOutputLatency_t motorOutputLatency;
+static uint32_t motorMixedAt;
+static bool motorMixPending = false;
+
 static mixerConfig_t *mixerConfig;
 static flight3DConfig_t *flight3DConfig;
 static escAndServoConfig_t *escAndServoConfig;
@@ -72,6 +76,19 @@ static rxConfig_t *rxConfig;
 static motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
 static mixerMode_e currentMixerMode;
 
+// currentMixer in Q15 fixed point, as used by mixTable(). int32_t since coefficients can exceed 1.0 (e.g. Y6 yaw).
+#define MIXER_Q15_SHIFT 15
+#define MIXER_Q15_ONE (1 << MIXER_Q15_SHIFT)
+
+typedef struct motorMixerQ15_s {
+    int32_t throttle;
+    int32_t roll;
+    int32_t pitch;
+    int32_t yaw;
+} motorMixerQ15_t;
+
+static motorMixerQ15_t currentMixerQ15[MAX_SUPPORTED_MOTORS];
+
 #ifdef USE_SERVOS
 static gimbalConfig_t *gimbalConfig;
 int16_t servo[MAX_SUPPORTED_SERVOS];
@@ -286,6 +303,23 @@ int servoDirection(int nr, int lr)
 }
 #endif
 
+static int32_t floatToQ15(float value)
+{
+    return (int32_t)(value * MIXER_Q15_ONE + (value < 0 ? -0.5f : 0.5f));
+}
+
+static void updateFixedPointMixer(void)
+{
+    int i;
+
+    for (i = 0; i < motorCount; i++) {
+        currentMixerQ15[i].throttle = floatToQ15(currentMixer[i].throttle);
+        currentMixerQ15[i].roll = floatToQ15(currentMixer[i].roll);
+        currentMixerQ15[i].pitch = floatToQ15(currentMixer[i].pitch);
+        currentMixerQ15[i].yaw = floatToQ15(currentMixer[i].yaw);
+    }
+}
+
 #ifndef USE_QUAD_MIXER_ONLY
 void mixerInit(mixerMode_e mixerMode, motorMixer_t *initialCustomMixers)
 {
@@ -340,6 +374,8 @@ void mixerUsePWMOutputConfiguration(pwmOutputConfiguration_t *pwmOutputConfigura
         }
     }
 
+    updateFixedPointMixer();
+
     // set flag that we're on something with wings
     if (currentMixerMode == MIXER_FLYING_WING ||
             currentMixerMode == MIXER_AIRPLANE)
@@ -389,6 +425,8 @@ void mixerUsePWMOutputConfiguration(pwmOutputConfiguration_t *pwmOutputConfigura
         currentMixer[i] = mixerQuadX[i];
     }
 
+    updateFixedPointMixer();
+
     mixerResetMotors();
 }
 #endif
@@ -483,10 +521,19 @@ void writeServos(void)
 }
 #endif
 
+static void updateMotorOutputLatency(void)
+{
+    uint32_t latency = micros() - motorMixedAt + pwmGetMotorPulseStartDelay();
+
+    motorOutputLatency.last = MIN(latency, UINT16_MAX);
+    motorOutputLatency.max = MAX(motorOutputLatency.max, motorOutputLatency.last);
+}
+
 void writeMotors(void)
 {
     uint8_t i;
 
+    // stage every motor value first, the outputs only pick them up on the next timer update
     for (i = 0; i < motorCount; i++)
         pwmWriteMotor(i, motor[i]);
 
@@ -494,6 +541,16 @@ void writeMotors(void)
     if (feature(FEATURE_ONESHOT125)) {
         pwmCompleteOneshotMotorUpdate(motorCount);
     }
+#ifdef USE_DSHOT
+    if (feature(FEATURE_DSHOT)) {
+        pwmCompleteDshotMotorUpdate();
+    }
+#endif
+
+    if (motorMixPending) {
+        updateMotorOutputLatency();
+        motorMixPending = false;
+    }
 }
 
 void writeAllMotors(int16_t mc)
@@ -561,9 +618,53 @@ static void airplaneMixer(void)
 }
 #endif
 
+/*
+ * Airmode style saturation handling: when the roll/pitch/yaw corrections need more than the range between
+ * minthrottle and maxthrottle they are scaled down evenly, then throttle is moved so every motor fits. This keeps
+ * the differential between the motors, and therefore attitude authority, instead of clipping single motors.
+ */
+static void fitMotorsToThrottleRange(const int16_t *rollPitchYawMix)
+{
+    uint32_t i;
+    int16_t rollPitchYawMin = rollPitchYawMix[0];
+    int16_t rollPitchYawMax = rollPitchYawMix[0];
+    int16_t motorMin;
+    int16_t motorMax;
+    int32_t rollPitchYawRange;
+    int32_t throttleRange = escAndServoConfig->maxthrottle - escAndServoConfig->minthrottle;
+
+    for (i = 1; i < motorCount; i++) {
+        rollPitchYawMin = MIN(rollPitchYawMin, rollPitchYawMix[i]);
+        rollPitchYawMax = MAX(rollPitchYawMax, rollPitchYawMix[i]);
+    }
+
+    rollPitchYawRange = rollPitchYawMax - rollPitchYawMin;
+    if (rollPitchYawRange > throttleRange) {
+        for (i = 0; i < motorCount; i++) {
+            motor[i] += (rollPitchYawMix[i] * throttleRange) / rollPitchYawRange - rollPitchYawMix[i];
+        }
+    }
+
+    motorMin = motor[0];
+    motorMax = motor[0];
+    for (i = 1; i < motorCount; i++) {
+        motorMin = MIN(motorMin, motor[i]);
+        motorMax = MAX(motorMax, motor[i]);
+    }
+
+    for (i = 0; i < motorCount; i++) {
+        if (motorMax > escAndServoConfig->maxthrottle) {
+            motor[i] -= motorMax - escAndServoConfig->maxthrottle;
+        } else if (motorMin < escAndServoConfig->minthrottle) {
+            motor[i] += escAndServoConfig->minthrottle - motorMin;
+        }
+    }
+}
+
 void mixTable(void)
 {
     uint32_t i;
+    int16_t rollPitchYawMix[MAX_SUPPORTED_MOTORS];
 
     if (motorCount > 3) {
         // prevent "yaw jump" during yaw correction
@@ -572,12 +673,17 @@ void mixTable(void)
 
     // motors for non-servo mixes
     if (motorCount > 1) {
+        int32_t yaw = -mixerConfig->yaw_direction * axisPID[YAW];
+        int32_t rollPitchYaw;
+
         for (i = 0; i < motorCount; i++) {
-            motor[i] =
-                rcCommand[THROTTLE] * currentMixer[i].throttle +
-                axisPID[PITCH] * currentMixer[i].pitch +
-                axisPID[ROLL] * currentMixer[i].roll +
-                -mixerConfig->yaw_direction * axisPID[YAW] * currentMixer[i].yaw;
+            rollPitchYaw =
+                axisPID[PITCH] * currentMixerQ15[i].pitch +
+                axisPID[ROLL] * currentMixerQ15[i].roll +
+                yaw * currentMixerQ15[i].yaw;
+
+            rollPitchYawMix[i] = (rollPitchYaw + MIXER_Q15_ONE / 2) >> MIXER_Q15_SHIFT;
+            motor[i] = (rcCommand[THROTTLE] * currentMixerQ15[i].throttle + rollPitchYaw + MIXER_Q15_ONE / 2) >> MIXER_Q15_SHIFT;
         }
     }
 
@@ -676,6 +782,10 @@ void mixTable(void)
 
     if (ARMING_FLAG(ARMED)) {
 
+        if (feature(FEATURE_AIRMODE) && !feature(FEATURE_3D) && motorCount > 1) {
+            fitMotorsToThrottleRange(rollPitchYawMix);
+        }
+
         // Find the maximum motor output.
         int16_t maxMotor = motor[0];
         for (i = 1; i < motorCount; i++) {
@@ -706,7 +816,7 @@ void mixTable(void)
                 if ((rcData[THROTTLE]) < rxConfig->mincheck) {
                     if (feature(FEATURE_MOTOR_STOP)) {
                         motor[i] = escAndServoConfig->mincommand;
-                    } else if (mixerConfig->pid_at_min_throttle == 0) {
+                    } else if (mixerConfig->pid_at_min_throttle == 0 && !feature(FEATURE_AIRMODE)) {
                         motor[i] = escAndServoConfig->minthrottle;
                     }
                 }
@@ -717,6 +827,9 @@ void mixTable(void)
             motor[i] = motor_disarmed[i];
         }
     }
+
+    motorMixedAt = micros();
+    motorMixPending = true;
 }
 
 #ifdef USE_SERVOS
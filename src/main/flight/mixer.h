@@ -105,6 +105,13 @@ void filterServos(void);
 extern int16_t motor[MAX_SUPPORTED_MOTORS];
 extern int16_t motor_disarmed[MAX_SUPPORTED_MOTORS];
 
+typedef struct motorOutputLatency_s {
+    uint16_t last;  // microseconds from the end of mixTable() to the start of the motor pulses
+    uint16_t max;
+} motorOutputLatency_t;
+
+extern motorOutputLatency_t motorOutputLatency;
+
 void writeAllMotors(int16_t mc);
 void mixerLoadMix(int index, motorMixer_t *customMixers);
 void mixerResetMotors(void);
@@ -25,12 +25,30 @@
  * Note that bits can only be set to 0 when writing, not back to 1 from 0. You must erase sectors in order
  * to bring bits back to 1 again.
  *
+ * The first sector of the device holds an index of the logs on the volume. It starts with a volume header, followed
+ * by one fixed-size entry per log. Entries are only ever appended, and each field of an entry is programmed before the
+ * state bit which marks it as valid, so that a power loss at any point leaves behind an index we can still mount:
+ *
+ * - flashfsLogBegin() appends an entry with the start address and timestamp of the new log. If the flash is busy, e.g.
+ *   with the background erase when the blackbox starts at arming, the entry is kept in RAM and programmed once the
+ *   flash is ready, before any of the log's data.
+ * - flashfsLogEnd() programs the length of the log into the entry.
+ * - flashfsEraseLog() erases the sectors which no longer hold any live log in the background, and marks the entry as
+ *   deleted once they are erased.
+ *
+ * Logs are stored back-to-back in the rest of the device, so the start of the free space is simply the end of the
+ * last log. If the last log was never closed, its end is found by searching for erased pages after its start.
+ *
+ * Volumes written by older firmware don't have an index (their first sector holds log data instead), these are
+ * appended to as before and logs can't be listed until the volume is erased.
+ *
  * In future, we can add support for multiple different flash chips by adding a flash device driver vtable
  * and make calls through that, at the moment flashfs just calls m25p16_* routines explicitly.
  */
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "drivers/flash_m25p16.h"
@@ -54,6 +72,69 @@ static uint16_t tailIndexInPage = 0;
 
 static bool shouldFlush = false;
 
+/*
+ * A chip erase, or the erase of a deleted log's sectors, is carried out in the background one sector at a time, see
+ * flashfsEraseUpdate(). Sectors from eraseStartSector up to eraseNextSector have been erased (or are being erased, if
+ * the flash is busy). When no erase is in progress they are all zero.
+ */
+static uint16_t eraseStartSector = 0;
+static uint16_t eraseNextSector = 0;
+static uint16_t eraseEndSector = 0;
+// The index slot of the log whose sectors are being erased, or 0 if the erase is one of the whole volume
+static uint16_t eraseLogSlot = 0;
+
+static void flashfsMarkEraseComplete();
+static void flashfsMarkLogErased();
+static bool flashfsProgramPendingIndex(bool sync);
+
+// Sector erases take 0.6s typically and 3s at most, so this is how long we're prepared to wait for the flash
+#define FLASHFS_SECTOR_ERASE_TIMEOUT_MILLIS 5000
+
+static uint8_t flashReadAheadBuffer[FLASHFS_READ_AHEAD_SIZE];
+static uint32_t readAheadAddress = 0;
+// The number of valid bytes in the read-ahead buffer, it is emptied whenever the flash is written to or erased
+static uint16_t readAheadLength = 0;
+
+#define FLASHFS_INDEX_MAGIC 0x474F4C46 // "FLOG"
+#define FLASHFS_INDEX_VERSION 1
+
+#define FLASHFS_INDEX_ENTRY_SIZE 16
+
+// The state bits of an index entry start out erased (1) and are cleared in this order as the log progresses
+#define FLASHFS_INDEX_STATE_BEGUN   (1 << 0)
+#define FLASHFS_INDEX_STATE_ENDED   (1 << 1)
+#define FLASHFS_INDEX_STATE_DELETED (1 << 2)
+
+// The erase state of the volume header is cleared once the background erase which created the volume has completed
+#define FLASHFS_ERASE_STATE_COMPLETE 0x00
+
+typedef struct flashfsVolumeHeader_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t eraseState;
+    uint8_t reserved[10];
+} flashfsVolumeHeader_t;
+
+typedef struct flashfsIndexEntry_t {
+    uint32_t start;
+    uint32_t length;
+    uint32_t timestamp;
+    uint8_t reserved[3];
+    uint8_t state;
+} flashfsIndexEntry_t;
+
+// True if the first sector of the volume is reserved for the log index
+static bool volumeIndexed = false;
+// The number of used slots in the index, including the volume header in slot 0
+static uint16_t indexSlotsUsed = 0;
+// The slot of the log currently being written, or 0 if there is none
+static uint16_t openLogSlot = 0;
+// The index entry of the open log as it is (or will be) programmed
+static flashfsIndexEntry_t openLogEntry;
+// The volume header and the entry of the open log which are waiting for the flash to become ready
+static bool pendingVolumeHeader = false;
+static bool pendingLogEntry = false;
+
 static void flashfsClearBuffer()
 {
     bufferTail = bufferHead = 0;
@@ -68,19 +149,123 @@ static bool flashfsBufferIsEmpty()
 static void flashfsSetTailAddress(uint32_t address)
 {
     tailAddress = address;
+    readAheadLength = 0;
 
     if (m25p16_getGeometry()->pageSize > 0) {
         tailIndexInPage = tailAddress % m25p16_getGeometry()->pageSize;
     }
 }
 
-void flashfsEraseCompletely()
+static uint32_t flashfsGetDataStart()
 {
-    m25p16_eraseCompletely();
+    return volumeIndexed ? m25p16_getGeometry()->sectorSize : 0;
+}
 
+/**
+ * Start erasing the whole volume in the background, flashfsEraseUpdate() must be called regularly until it completes.
+ *
+ * Writes to sectors which have already been erased are allowed while the erase carries on ahead of them.
+ */
+void flashfsEraseCompletely()
+{
     flashfsClearBuffer();
 
-    flashfsSetTailAddress(0);
+    // An erased volume has an empty index, the volume header is written along with the first log entry
+    volumeIndexed = m25p16_getGeometry()->sectors > 1;
+    indexSlotsUsed = 1;
+    openLogSlot = 0;
+    pendingVolumeHeader = pendingLogEntry = false;
+
+    eraseStartSector = eraseNextSector = 0;
+    eraseEndSector = m25p16_getGeometry()->sectors;
+    eraseLogSlot = 0;
+
+    flashfsSetTailAddress(flashfsGetDataStart());
+
+    flashfsEraseUpdate();
+}
+
+static void flashfsEraseNextSector()
+{
+    m25p16_eraseSector(eraseNextSector * m25p16_getGeometry()->sectorSize);
+
+    eraseNextSector++;
+    readAheadLength = 0;
+}
+
+/**
+ * Advance the background erase, call this regularly from the main loop. It never waits for the flash.
+ *
+ * A single sector erase keeps the flash busy for a long time, during which nothing can be written. So while a log is
+ * being written, the next sector of a chip erase is only erased once the write head is about to catch up with it, and
+ * the erase of a deleted log waits for the log to end.
+ */
+void flashfsEraseUpdate()
+{
+    flashfsProgramPendingIndex(false);
+
+    if (eraseEndSector == 0 || !m25p16_isReady()) {
+        return;
+    }
+
+    if (eraseNextSector >= eraseEndSector) {
+        // The last sector erase has completed
+        eraseStartSector = eraseNextSector = eraseEndSector = 0;
+
+        if (eraseLogSlot) {
+            flashfsMarkLogErased();
+        } else if (volumeIndexed && indexSlotsUsed > 1 && !pendingVolumeHeader) {
+            // A pending volume header is programmed with the erase marked as complete already
+            flashfsMarkEraseComplete();
+        }
+        return;
+    }
+
+    if ((!openLogSlot && flashfsBufferIsEmpty())
+            || (!eraseLogSlot && tailAddress / m25p16_getGeometry()->sectorSize + 1 >= eraseNextSector)) {
+        flashfsEraseNextSector();
+    }
+}
+
+/**
+ * Returns true if the background erase has passed the sector containing the given address, or won't reach it.
+ *
+ * If `sync` is true, wait for the erase to reach it and for the flash to become ready instead, returning false if the
+ * flash doesn't become ready in time. Never call it with `sync` on the armed path, a sector erase takes seconds.
+ */
+static bool flashfsWaitForErase(uint32_t address, bool sync)
+{
+    uint32_t sector = address / m25p16_getGeometry()->sectorSize;
+
+    while (sector >= eraseNextSector && sector < eraseEndSector) {
+        if (!sync || !m25p16_waitForReady(FLASHFS_SECTOR_ERASE_TIMEOUT_MILLIS)) {
+            return false;
+        }
+
+        flashfsEraseNextSector();
+    }
+
+    // Wait for the sector erase to complete too
+    return !sync || m25p16_waitForReady(FLASHFS_SECTOR_ERASE_TIMEOUT_MILLIS);
+}
+
+/**
+ * Returns the progress of the background erase as a percentage, or 100 if no erase is in progress.
+ */
+uint8_t flashfsGetEraseProgress()
+{
+    uint16_t sectorsErased = eraseNextSector - eraseStartSector;
+
+    if (eraseEndSector == 0) {
+        return 100;
+    }
+
+    // The last sector we started erasing isn't done until the flash is ready again
+    if (sectorsErased > 0 && !m25p16_isReady()) {
+        sectorsErased--;
+    }
+
+    return sectorsErased * 100 / (eraseEndSector - eraseStartSector);
 }
 
 /**
@@ -108,14 +293,16 @@ void flashfsEraseRange(uint32_t start, uint32_t end)
     for (int i = startSector; i < endSector; i++) {
         m25p16_eraseSector(i * geometry->sectorSize);
     }
+
+    readAheadLength = 0;
 }
 
 /**
- * Return true if the flash is not currently occupied with an operation.
+ * Return true if the flash is not currently occupied with an operation, including a background erase.
  */
 bool flashfsIsReady()
 {
-    return m25p16_isReady();
+    return eraseEndSector == 0 && m25p16_isReady();
 }
 
 uint32_t flashfsGetSize()
@@ -167,7 +354,8 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
         bytesTotal += bufferSizes[i];
     }
 
-    if (!sync && !m25p16_isReady()) {
+    // The index entry of the log has to be on the flash before any of its data
+    if (!flashfsProgramPendingIndex(sync) || (!sync && !m25p16_isReady())) {
         return 0;
     }
 
@@ -195,6 +383,11 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
             break;
         }
 
+        // Don't write ahead of the background erase
+        if (!flashfsWaitForErase(tailAddress, sync)) {
+            break;
+        }
+
         m25p16_pageProgramBegin(tailAddress);
 
         bytesRemainThisIteration = bytesTotalThisIteration;
@@ -455,9 +648,43 @@ void flashfsWrite(const uint8_t *data, unsigned int len, bool sync)
     }
 }
 
+/**
+ * Return a pointer to the data at the given address in the read-ahead buffer, reading a whole buffer's worth from the
+ * flash if it isn't in there already. `available` is set to the number of bytes available from the pointer onwards,
+ * which is zero at the end of the volume or if the read fails.
+ */
+static const uint8_t *flashfsReadAhead(uint32_t address, uint32_t *available)
+{
+    // Since the read could overlap data in our dirty buffers, force a sync to clear those first
+    flashfsFlushSync();
+
+    if (address < readAheadAddress || address >= readAheadAddress + readAheadLength) {
+        uint32_t len = flashfsGetSize() - address;
+
+        if (address >= flashfsGetSize()) {
+            *available = 0;
+            return flashReadAheadBuffer;
+        }
+
+        if (len > FLASHFS_READ_AHEAD_SIZE) {
+            len = FLASHFS_READ_AHEAD_SIZE;
+        }
+
+        readAheadAddress = address;
+        readAheadLength = m25p16_readBytes(address, flashReadAheadBuffer, len);
+    }
+
+    *available = readAheadAddress + readAheadLength - address;
+
+    return flashReadAheadBuffer + (address - readAheadAddress);
+}
+
 /**
  * Read `len` bytes from the given address into the supplied buffer.
  *
+ * Reads shorter than the read-ahead buffer are served from it, so that reading a volume sequentially in small
+ * chunks doesn't cost a flash transaction for every chunk.
+ *
  * Returns the number of bytes actually read which may be less than that requested.
  */
 int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
@@ -470,6 +697,31 @@ int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
         len = flashfsGetSize() - address;
     }
 
+    if (len < FLASHFS_READ_AHEAD_SIZE) {
+        bytesRead = 0;
+
+        while (len > 0) {
+            uint32_t available;
+            const uint8_t *data = flashfsReadAhead(address, &available);
+
+            if (available == 0) {
+                break;
+            }
+
+            if (available > len) {
+                available = len;
+            }
+
+            memcpy(buffer + bytesRead, data, available);
+
+            bytesRead += available;
+            address += available;
+            len -= available;
+        }
+
+        return bytesRead;
+    }
+
     // Since the read could overlap data in our dirty buffers, force a sync to clear those first
     flashfsFlushSync();
 
@@ -478,6 +730,68 @@ int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
     return bytesRead;
 }
 
+/**
+ * Read up to `len` bytes from the given address, compressing runs of erased bytes with FLASHFS_COMPRESSION_RLE_ERASED,
+ * until the supplied buffer of `bufferSize` bytes is full.
+ *
+ * Erased bytes are rare in log data but make up the whole of the free space, so they're the only ones worth encoding.
+ *
+ * Returns the number of bytes stored in the buffer, and sets `bytesRead` to the number of bytes read from the flash.
+ */
+int flashfsReadAbsCompressed(uint32_t address, unsigned int len, uint8_t *buffer, unsigned int bufferSize, unsigned int *bytesRead)
+{
+    unsigned int bytesWritten = 0;
+    uint32_t start = address;
+    uint32_t end = address + len;
+    uint32_t available;
+    const uint8_t *data;
+
+    if (end > flashfsGetSize()) {
+        end = flashfsGetSize();
+    }
+
+    *bytesRead = 0;
+
+    while (bytesWritten < bufferSize && address < end) {
+        data = flashfsReadAhead(address, &available);
+
+        if (available == 0) {
+            break;
+        }
+
+        if (*data != 0xFF) {
+            buffer[bytesWritten++] = *data;
+            address++;
+            continue;
+        }
+
+        // Don't split a run across two reads
+        if (bytesWritten + 2 > bufferSize) {
+            break;
+        }
+
+        uint8_t runLength = 0;
+
+        while (runLength < 0xFF && address < end) {
+            data = flashfsReadAhead(address, &available);
+
+            if (available == 0 || *data != 0xFF) {
+                break;
+            }
+
+            runLength++;
+            address++;
+        }
+
+        buffer[bytesWritten++] = 0xFF;
+        buffer[bytesWritten++] = runLength;
+    }
+
+    *bytesRead = address - start;
+
+    return bytesWritten;
+}
+
 /**
  * Find the offset of the start of the free space on the device (or the size of the device if it is full).
  */
@@ -550,6 +864,541 @@ bool flashfsIsEOF() {
     return tailAddress >= flashfsGetSize();
 }
 
+static uint32_t flashfsRoundUpToSector(uint32_t address)
+{
+    uint32_t sectorSize = m25p16_getGeometry()->sectorSize;
+
+    return ((address + sectorSize - 1) / sectorSize) * sectorSize;
+}
+
+static uint32_t flashfsGetIndexSlotCount()
+{
+    return m25p16_getGeometry()->sectorSize / FLASHFS_INDEX_ENTRY_SIZE;
+}
+
+static bool flashfsIsErased(const uint8_t *buffer, unsigned int len)
+{
+    for (unsigned int i = 0; i < len; i++) {
+        if (buffer[i] != 0xFF) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Program a small piece of metadata which lies within a single page. Returns false if the flash didn't become ready.
+ */
+static bool flashfsProgram(uint32_t address, const uint8_t *data, int length)
+{
+    // The flash could be busy with a sector erase, which would take longer than the page program is prepared to wait
+    if (!flashfsWaitForErase(address, true)) {
+        return false;
+    }
+
+    m25p16_pageProgram(address, data, length);
+
+    readAheadLength = 0;
+
+    return true;
+}
+
+/**
+ * Program the volume header and the entry of the open log if they are still waiting for the flash, one page program
+ * per call unless `sync` is true. Returns true if nothing is left waiting.
+ */
+static bool flashfsProgramPendingIndex(bool sync)
+{
+    while (pendingVolumeHeader || pendingLogEntry) {
+        // Outside of an erase the flash is only ever busy with a page program, which m25p16_pageProgram() waits out
+        if (!flashfsWaitForErase(0, sync) || (!sync && eraseEndSector != 0 && !m25p16_isReady())) {
+            return false;
+        }
+
+        if (pendingVolumeHeader) {
+            flashfsVolumeHeader_t header;
+
+            memset(&header, 0xFF, sizeof(header));
+            header.magic = FLASHFS_INDEX_MAGIC;
+            header.version = FLASHFS_INDEX_VERSION;
+
+            if (eraseEndSector == 0) {
+                header.eraseState = FLASHFS_ERASE_STATE_COMPLETE;
+            }
+
+            m25p16_pageProgram(0, (uint8_t *) &header, sizeof(header));
+            pendingVolumeHeader = false;
+        } else {
+            // The state byte is the last one in the entry, so it is programmed after the fields that it validates
+            m25p16_pageProgram(openLogSlot * FLASHFS_INDEX_ENTRY_SIZE, (uint8_t *) &openLogEntry, sizeof(openLogEntry));
+            pendingLogEntry = false;
+        }
+
+        readAheadLength = 0;
+    }
+
+    return true;
+}
+
+static void flashfsReadIndexEntry(uint16_t slot, flashfsIndexEntry_t *entry)
+{
+    // The entry of the open log might not have been programmed yet
+    if (slot == openLogSlot && openLogSlot) {
+        *entry = openLogEntry;
+        return;
+    }
+
+    m25p16_readBytes(slot * FLASHFS_INDEX_ENTRY_SIZE, (uint8_t *) entry, sizeof(*entry));
+}
+
+/**
+ * Clear the given state bit of the entry in the given index slot.
+ */
+static bool flashfsSetIndexEntryState(uint16_t slot, uint8_t state, uint8_t stateBit)
+{
+    state &= ~stateBit;
+
+    return flashfsProgram(slot * FLASHFS_INDEX_ENTRY_SIZE + offsetof(flashfsIndexEntry_t, state), &state, sizeof(state));
+}
+
+static void flashfsMarkEraseComplete()
+{
+    uint8_t eraseState = FLASHFS_ERASE_STATE_COMPLETE;
+
+    flashfsProgram(offsetof(flashfsVolumeHeader_t, eraseState), &eraseState, sizeof(eraseState));
+}
+
+static bool flashfsSetIndexEntryLength(uint16_t slot, uint32_t length)
+{
+    return flashfsProgram(slot * FLASHFS_INDEX_ENTRY_SIZE + offsetof(flashfsIndexEntry_t, length), (uint8_t *) &length, sizeof(length));
+}
+
+static bool flashfsIsLiveEntry(const flashfsIndexEntry_t *entry)
+{
+    return (entry->state & (FLASHFS_INDEX_STATE_BEGUN | FLASHFS_INDEX_STATE_DELETED)) == FLASHFS_INDEX_STATE_DELETED;
+}
+
+/**
+ * Find the number of slots in use in the index with a binary search, since the used slots are always contiguous.
+ *
+ * A slot counts as used as soon as any of its bytes have been programmed, so that an entry which was only partially
+ * written before a power loss will never be programmed a second time.
+ */
+static uint16_t flashfsCountUsedIndexSlots()
+{
+    flashfsIndexEntry_t entry;
+    int left = 1;
+    int right = flashfsGetIndexSlotCount();
+
+    while (left < right) {
+        int mid = (left + right) / 2;
+
+        flashfsReadIndexEntry(mid, &entry);
+
+        if (flashfsIsErased((uint8_t *) &entry, sizeof(entry))) {
+            right = mid;
+        } else {
+            left = mid + 1;
+        }
+    }
+
+    return left;
+}
+
+/**
+ * Find the end of the data written to the flash between the given addresses, with byte granularity. Used to recover
+ * the length of a log which was never closed.
+ */
+static uint32_t flashfsFindEndOfData(uint32_t start, uint32_t limit)
+{
+    enum {
+        FREE_PAGE_TEST_SIZE = 16,
+        READ_CHUNK_SIZE = 32
+    };
+
+    const flashGeometry_t *geometry = m25p16_getGeometry();
+    uint8_t buffer[READ_CHUNK_SIZE];
+
+    if (start >= limit) {
+        return limit;
+    }
+
+    // First find the first page after the start which begins with erased bytes
+    int left = start / geometry->pageSize + 1;
+    int right = limit / geometry->pageSize;
+
+    while (left < right) {
+        int mid = (left + right) / 2;
+
+        m25p16_readBytes(mid * geometry->pageSize, buffer, FREE_PAGE_TEST_SIZE);
+
+        if (flashfsIsErased(buffer, FREE_PAGE_TEST_SIZE)) {
+            right = mid;
+        } else {
+            left = mid + 1;
+        }
+    }
+
+    // Then find the last programmed byte in the page before it
+    uint32_t pageStart = (left - 1) * geometry->pageSize;
+    uint32_t searchStart = pageStart > start ? pageStart : start;
+    uint32_t address = left * geometry->pageSize;
+
+    while (address > searchStart) {
+        uint32_t chunkSize = address - searchStart < READ_CHUNK_SIZE ? address - searchStart : READ_CHUNK_SIZE;
+
+        address -= chunkSize;
+
+        m25p16_readBytes(address, buffer, chunkSize);
+
+        for (int i = chunkSize - 1; i >= 0; i--) {
+            if (buffer[i] != 0xFF) {
+                return address + i + 1;
+            }
+        }
+    }
+
+    return searchStart;
+}
+
+/**
+ * Find the start of the free space from the index. Sectors which follow the end of the last live log have been erased,
+ * either by a chip erase or by flashfsEraseLog().
+ */
+static uint32_t flashfsFindStartOfFreeSpaceFromIndex()
+{
+    flashfsIndexEntry_t entry;
+    bool logsDeleted = false;
+
+    for (int slot = indexSlotsUsed - 1; slot > 0; slot--) {
+        flashfsReadIndexEntry(slot, &entry);
+
+        if (flashfsIsLiveEntry(&entry)) {
+            if (logsDeleted) {
+                // The sectors of the logs after this one were erased when they were deleted
+                return flashfsRoundUpToSector(entry.start + entry.length);
+            }
+
+            return entry.start + entry.length;
+        }
+
+        if (!(entry.state & FLASHFS_INDEX_STATE_DELETED)) {
+            logsDeleted = true;
+        }
+    }
+
+    return flashfsGetDataStart();
+}
+
+/**
+ * Find the first sector from the given one onwards whose start is (or isn't) erased. Returns the sector count if there
+ * is none.
+ */
+static uint16_t flashfsFindSector(uint16_t sector, bool erased)
+{
+    const flashGeometry_t *geometry = m25p16_getGeometry();
+    uint8_t buffer[16];
+
+    for (; sector < geometry->sectors; sector++) {
+        m25p16_readBytes(sector * geometry->sectorSize, buffer, sizeof(buffer));
+
+        if (flashfsIsErased(buffer, sizeof(buffer)) == erased) {
+            break;
+        }
+    }
+
+    return sector;
+}
+
+/**
+ * Read the log index and seek to the start of the free space. Returns false if the volume doesn't have an index.
+ *
+ * If the background erase which created the volume was interrupted, it is resumed from where it got to.
+ */
+static bool flashfsMountIndex()
+{
+    const flashGeometry_t *geometry = m25p16_getGeometry();
+    flashfsVolumeHeader_t header;
+    flashfsIndexEntry_t entry;
+    uint16_t eraseFrontier = geometry->sectors;
+    uint32_t dataLimit = geometry->totalSize;
+
+    eraseStartSector = eraseNextSector = eraseEndSector = 0;
+    eraseLogSlot = 0;
+
+    if (geometry->sectors <= 1) {
+        return false;
+    }
+
+    m25p16_readBytes(0, (uint8_t *) &header, sizeof(header));
+
+    if (flashfsIsErased((uint8_t *) &header, sizeof(header))) {
+        // A freshly erased volume, the header will be written along with the first log entry
+        indexSlotsUsed = 1;
+    } else if (header.magic == FLASHFS_INDEX_MAGIC && header.version == FLASHFS_INDEX_VERSION) {
+        indexSlotsUsed = flashfsCountUsedIndexSlots();
+    } else {
+        return false;
+    }
+
+    volumeIndexed = true;
+    openLogSlot = 0;
+    pendingVolumeHeader = pendingLogEntry = false;
+
+    if (indexSlotsUsed > 1) {
+        uint16_t lastSlot = indexSlotsUsed - 1;
+
+        flashfsReadIndexEntry(lastSlot, &entry);
+
+        if (header.eraseState != FLASHFS_ERASE_STATE_COMPLETE) {
+            /*
+             * The background erase was interrupted. The last log is followed by the sectors it had erased, then by the
+             * old contents of the flash which it didn't reach.
+             */
+            uint32_t lastStart = (entry.state & FLASHFS_INDEX_STATE_BEGUN) ? flashfsGetDataStart() : entry.start;
+            uint16_t firstErasedSector = flashfsFindSector(lastStart / geometry->sectorSize + 1, true);
+
+            dataLimit = firstErasedSector * geometry->sectorSize;
+            eraseFrontier = flashfsFindSector(firstErasedSector, false);
+        }
+
+        // Was the power lost while the last log was being written? Recover its length from the data on the flash
+        if (flashfsIsLiveEntry(&entry) && (entry.state & FLASHFS_INDEX_STATE_ENDED)) {
+            uint32_t length = flashfsFindEndOfData(entry.start, dataLimit) - entry.start;
+
+            if (flashfsSetIndexEntryLength(lastSlot, length)) {
+                flashfsSetIndexEntryState(lastSlot, entry.state, FLASHFS_INDEX_STATE_ENDED);
+            }
+        }
+    } else {
+        eraseFrontier = flashfsFindSector(1, false);
+    }
+
+    flashfsSeekAbs(flashfsFindStartOfFreeSpaceFromIndex());
+
+    if (eraseFrontier < geometry->sectors) {
+        /*
+         * The sector before the first unerased one might have been part way through its erase. We know it wasn't if
+         * the volume holds data in it, since writes wait for their sector's erase to complete.
+         */
+        uint16_t dataEndSector = (tailAddress - 1) / geometry->sectorSize;
+
+        eraseNextSector = eraseFrontier - 1 > dataEndSector ? eraseFrontier - 1 : dataEndSector + 1;
+        eraseEndSector = geometry->sectors;
+    } else if (indexSlotsUsed > 1 && header.eraseState != FLASHFS_ERASE_STATE_COMPLETE) {
+        flashfsMarkEraseComplete();
+    }
+
+    return true;
+}
+
+bool flashfsIsIndexed()
+{
+    return volumeIndexed;
+}
+
+/**
+ * Start a new log at the current end of the volume and record it in the index. This doesn't wait for the flash, the
+ * entry is programmed before the first data of the log if the flash is busy.
+ *
+ * Returns false if the index has no room left for another log.
+ */
+bool flashfsLogBegin(uint32_t timestamp)
+{
+    if (!volumeIndexed) {
+        // Nothing to record, the log is simply appended to the volume
+        return true;
+    }
+
+    if (openLogSlot) {
+        flashfsLogEnd();
+    }
+
+    if (indexSlotsUsed >= flashfsGetIndexSlotCount()) {
+        return false;
+    }
+
+    // The erase of a deleted log can still reach the sector the free space starts in, begin after the erased range
+    if (eraseLogSlot && tailAddress / m25p16_getGeometry()->sectorSize < eraseEndSector) {
+        flashfsSeekAbs(eraseEndSector * m25p16_getGeometry()->sectorSize);
+    }
+
+    memset(&openLogEntry, 0xFF, sizeof(openLogEntry));
+    // Data written without a log could still be buffered, the log starts after it
+    openLogEntry.start = flashfsGetOffset();
+    openLogEntry.timestamp = timestamp;
+    openLogEntry.state &= ~FLASHFS_INDEX_STATE_BEGUN;
+
+    pendingVolumeHeader = indexSlotsUsed == 1;
+    pendingLogEntry = true;
+
+    openLogSlot = indexSlotsUsed;
+    indexSlotsUsed++;
+
+    flashfsProgramPendingIndex(false);
+
+    return true;
+}
+
+/**
+ * Flush the log currently being written and record its length in the index.
+ */
+void flashfsLogEnd()
+{
+    if (!openLogSlot) {
+        return;
+    }
+
+    if (flashfsProgramPendingIndex(true)) {
+        flashfsFlushSync();
+
+        if (flashfsSetIndexEntryLength(openLogSlot, tailAddress - openLogEntry.start)) {
+            flashfsSetIndexEntryState(openLogSlot, openLogEntry.state, FLASHFS_INDEX_STATE_ENDED);
+        }
+    } else if (pendingLogEntry) {
+        // The flash never became ready, so none of the log's data was written either. Forget the log.
+        flashfsClearBuffer();
+        pendingVolumeHeader = pendingLogEntry = false;
+        indexSlotsUsed--;
+    }
+
+    openLogSlot = 0;
+}
+
+/**
+ * Get the number of logs in the index. Deleted logs keep their index, so this includes them.
+ */
+uint16_t flashfsGetLogCount()
+{
+    return volumeIndexed ? indexSlotsUsed - 1 : 0;
+}
+
+/**
+ * Fetch the details of the log with the given index. Returns false if there is no such log.
+ */
+bool flashfsGetLog(uint16_t index, flashfsLog_t *log)
+{
+    flashfsIndexEntry_t entry;
+    uint16_t slot = index + 1;
+
+    if (!volumeIndexed || slot >= indexSlotsUsed) {
+        return false;
+    }
+
+    flashfsReadIndexEntry(slot, &entry);
+
+    if (entry.state & FLASHFS_INDEX_STATE_BEGUN) {
+        // An entry which was only partially written before a power loss
+        return false;
+    }
+
+    log->start = entry.start;
+    log->timestamp = entry.timestamp;
+    log->flags = 0;
+
+    if (slot == openLogSlot) {
+        log->length = flashfsGetOffset() - entry.start;
+        log->flags |= FLASHFS_LOG_FLAG_OPEN;
+    } else {
+        log->length = entry.length;
+    }
+
+    if (!(entry.state & FLASHFS_INDEX_STATE_DELETED)) {
+        log->flags |= FLASHFS_LOG_FLAG_DELETED;
+    }
+
+    return true;
+}
+
+/**
+ * Mark the log whose sectors the background erase has just finished as deleted, and reuse the space if it was the last
+ * live log. A log begun while the erase was running stays where it is.
+ */
+static void flashfsMarkLogErased()
+{
+    flashfsIndexEntry_t entry;
+    uint16_t slot = eraseLogSlot;
+
+    eraseLogSlot = 0;
+
+    flashfsReadIndexEntry(slot, &entry);
+    flashfsSetIndexEntryState(slot, entry.state, FLASHFS_INDEX_STATE_DELETED);
+
+    if (!openLogSlot) {
+        flashfsSeekAbs(flashfsFindStartOfFreeSpaceFromIndex());
+    }
+}
+
+/**
+ * Erase the log with the given index. Its sectors are erased in the background by flashfsEraseUpdate(), the log is
+ * listed as deleted once they are.
+ *
+ * Sectors that the log shares with its live neighbours are left alone, so its space is only reclaimed once those are
+ * deleted too. Space that ends up after the last live log is reused by the next log.
+ *
+ * Returns false if there is no such log, if it is still being written or if an erase is already in progress.
+ */
+bool flashfsEraseLog(uint16_t index)
+{
+    flashfsIndexEntry_t entry, neighbour;
+    uint16_t slot = index + 1;
+    int i;
+
+    if (!volumeIndexed || slot >= indexSlotsUsed || slot == openLogSlot || eraseEndSector != 0) {
+        return false;
+    }
+
+    flashfsReadIndexEntry(slot, &entry);
+
+    if (!flashfsIsLiveEntry(&entry)) {
+        return false;
+    }
+
+    const flashGeometry_t *geometry = m25p16_getGeometry();
+
+    // Sectors are free to erase between the end of the previous live log and the start of the next one
+    uint32_t eraseStart = flashfsGetDataStart();
+    uint32_t eraseEnd = flashfsRoundUpToSector(entry.start + entry.length);
+
+    for (i = slot - 1; i > 0; i--) {
+        flashfsReadIndexEntry(i, &neighbour);
+
+        if (flashfsIsLiveEntry(&neighbour)) {
+            eraseStart = flashfsRoundUpToSector(neighbour.start + neighbour.length);
+            break;
+        }
+    }
+
+    for (i = slot + 1; i < indexSlotsUsed; i++) {
+        flashfsReadIndexEntry(i, &neighbour);
+
+        if (flashfsIsLiveEntry(&neighbour)) {
+            eraseEnd = (neighbour.start / geometry->sectorSize) * geometry->sectorSize;
+            break;
+        }
+    }
+
+    // Only the sectors that this log occupied still need erasing, the others were erased along with their own logs
+    if (eraseStart < (entry.start / geometry->sectorSize) * geometry->sectorSize) {
+        eraseStart = (entry.start / geometry->sectorSize) * geometry->sectorSize;
+    }
+
+    eraseLogSlot = slot;
+
+    if (eraseStart >= eraseEnd) {
+        flashfsMarkLogErased();
+        return true;
+    }
+
+    eraseStartSector = eraseNextSector = eraseStart / geometry->sectorSize;
+    eraseEndSector = eraseEnd / geometry->sectorSize;
+
+    flashfsEraseUpdate();
+
+    return true;
+}
+
 /**
  * Call after initializing the flash chip in order to set up the filesystem.
  */
@@ -557,7 +1406,11 @@ void flashfsInit()
 {
     // If we have a flash chip present at all
     if (flashfsGetSize() > 0) {
-        // Start the file pointer off at the beginning of free space so caller can start writing immediately
-        flashfsSeekAbs(flashfsIdentifyStartOfFreeSpace());
+        if (!flashfsMountIndex()) {
+            volumeIndexed = false;
+
+            // Start the file pointer off at the beginning of free space so caller can start writing immediately
+            flashfsSeekAbs(flashfsIdentifyStartOfFreeSpace());
+        }
     }
 }
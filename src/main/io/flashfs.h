@@ -27,8 +27,30 @@
 // Automatically trigger a flush when this much data is in the buffer
 #define FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN 64
 
+// Small reads are served from a buffer of this size which is filled with a single read from the flash
+#define FLASHFS_READ_AHEAD_SIZE 256
+
+typedef enum {
+    FLASHFS_COMPRESSION_NONE = 0,
+    FLASHFS_COMPRESSION_RLE_ERASED = 1, // A 0xFF byte is followed by the number of 0xFF bytes in its run (1-255)
+} flashfsCompression_e;
+
+typedef enum {
+    FLASHFS_LOG_FLAG_OPEN = 1 << 0,    // The log is still being written, so its length is the current write offset
+    FLASHFS_LOG_FLAG_DELETED = 1 << 1,
+} flashfsLogFlags_e;
+
+typedef struct flashfsLog_t {
+    uint32_t start;
+    uint32_t length;
+    uint32_t timestamp;
+    uint8_t flags;
+} flashfsLog_t;
+
 void flashfsEraseCompletely();
 void flashfsEraseRange(uint32_t start, uint32_t end);
+void flashfsEraseUpdate();
+uint8_t flashfsGetEraseProgress();
 
 uint32_t flashfsGetSize();
 uint32_t flashfsGetOffset();
@@ -42,6 +64,7 @@ void flashfsWriteByte(uint8_t byte);
 void flashfsWrite(const uint8_t *data, unsigned int len, bool sync);
 
 int flashfsReadAbs(uint32_t offset, uint8_t *data, unsigned int len);
+int flashfsReadAbsCompressed(uint32_t address, unsigned int len, uint8_t *buffer, unsigned int bufferSize, unsigned int *bytesRead);
 
 bool flashfsFlushAsync();
 void flashfsFlushSync();
@@ -50,3 +73,10 @@ void flashfsInit();
 
 bool flashfsIsReady();
 bool flashfsIsEOF();
+
+bool flashfsIsIndexed();
+bool flashfsLogBegin(uint32_t timestamp);
+void flashfsLogEnd();
+uint16_t flashfsGetLogCount();
+bool flashfsGetLog(uint16_t index, flashfsLog_t *log);
+bool flashfsEraseLog(uint16_t index);
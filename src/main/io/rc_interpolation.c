@@ -0,0 +1,169 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/maths.h"
+
+#include "rx/rx.h"
+#include "io/rc_controls.h"
+
+#include "io/rc_interpolation.h"
+
+/*
+ * Smooths rcCommand between receiver frames. The loop runs many times per frame, without this rcCommand moves
+ * in steps every 9-22ms which show up in the D term and on the motors.
+ *
+ * Linear mode ramps from the last output to the new command over as many loops as the last frame took. It keeps
+ * the remaining distance as an offset on top of rcCommand rather than ramping to a snapshot of it, so changes that
+ * annexCode() makes between frames (e.g. headfree rotation) still pass straight through.
+ *
+ * Low pass mode runs rcCommand through a first order filter at rc_interpolation_hz.
+ *
+ * The divisions needed for either are done once per frame, each loop only adds and multiplies.
+ */
+
+#define RC_INTERPOLATION_AXIS_COUNT 4
+#define RC_FRACTION_BITS 8                  // the ramp and the filter keep rcCommand in 1/256 units
+#define RC_FRACTION_ONE (1 << RC_FRACTION_BITS)
+#define LOWPASS_GAIN_BITS 12
+
+static rxConfig_t *rxConfig;
+
+static rcInterpolationMode_e activeMode = RC_INTERPOLATION_OFF;
+
+static uint32_t previousFrameAt;
+static uint16_t loopsSinceFrame = RC_INTERPOLATION_MAX_STEPS + 1;
+
+static int16_t lastOutput[RC_INTERPOLATION_AXIS_COUNT];
+
+static int32_t rampOffset[RC_INTERPOLATION_AXIS_COUNT];
+static int32_t rampStep[RC_INTERPOLATION_AXIS_COUNT];
+static uint8_t rampStepsRemaining = 0;
+
+static int32_t filtered[RC_INTERPOLATION_AXIS_COUNT];
+static int32_t lowpassGain = 1 << LOWPASS_GAIN_BITS;
+
+void useRcInterpolationConfig(rxConfig_t *rxConfigToUse)
+{
+    rxConfig = rxConfigToUse;
+}
+
+static void applyCommandDirectly(void)
+{
+    uint8_t axis;
+
+    for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+        rampOffset[axis] = 0;
+        filtered[axis] = rcCommand[axis] * RC_FRACTION_ONE;
+    }
+    rampStepsRemaining = 0;
+}
+
+static void startRamp(uint8_t steps)
+{
+    int32_t reciprocal = (1 << 16) / steps;
+    int32_t distance;
+    uint8_t axis;
+
+    for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+        distance = lastOutput[axis] - rcCommand[axis];
+        rampOffset[axis] = distance * RC_FRACTION_ONE;
+        rampStep[axis] = -((distance * reciprocal) >> (16 - RC_FRACTION_BITS));
+    }
+    rampStepsRemaining = steps;
+}
+
+static void updateLowpassGain(uint32_t frameInterval, uint8_t loops)
+{
+    if (rxConfig->rc_interpolation_hz == 0) {
+        lowpassGain = 1 << LOWPASS_GAIN_BITS;
+        return;
+    }
+
+    float dT = frameInterval * 1e-6f / loops;
+    float RC = 1.0f / (2 * M_PIf * rxConfig->rc_interpolation_hz);
+
+    lowpassGain = dT / (RC + dT) * (1 << LOWPASS_GAIN_BITS) + 0.5f;
+}
+
+static void startFrame(uint32_t currentTime)
+{
+    uint32_t frameInterval = currentTime - previousFrameAt;
+    uint16_t loops = loopsSinceFrame;
+
+    previousFrameAt = currentTime;
+    loopsSinceFrame = 0;
+
+    if (rxConfig->rc_interpolation != activeMode) {
+        // the state of the other mode is stale
+        activeMode = rxConfig->rc_interpolation;
+        applyCommandDirectly();
+        return;
+    }
+
+    if (loops == 0 || loops > RC_INTERPOLATION_MAX_STEPS || frameInterval > RC_INTERPOLATION_MAX_FRAME_INTERVAL_US) {
+        applyCommandDirectly();
+        return;
+    }
+
+    if (activeMode == RC_INTERPOLATION_LINEAR) {
+        startRamp(loops);
+    } else {
+        updateLowpassGain(frameInterval, loops);
+    }
+}
+
+// Called every control loop after annexCode(), newFrame is set when rcData was updated since the last call.
+void interpolateRcCommand(bool newFrame, uint32_t currentTime)
+{
+    uint8_t axis;
+
+    if (newFrame) {
+        startFrame(currentTime);
+    }
+
+    if (loopsSinceFrame <= RC_INTERPOLATION_MAX_STEPS) {
+        loopsSinceFrame++;
+    }
+
+    if (activeMode == RC_INTERPOLATION_OFF) {
+        return;
+    }
+
+    if (activeMode == RC_INTERPOLATION_LINEAR) {
+        if (rampStepsRemaining) {
+            rampStepsRemaining--;
+            for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+                rampOffset[axis] = rampStepsRemaining ? rampOffset[axis] + rampStep[axis] : 0;
+            }
+        }
+        for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+            rcCommand[axis] += (rampOffset[axis] + RC_FRACTION_ONE / 2) >> RC_FRACTION_BITS;
+        }
+    } else {
+        for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+            filtered[axis] += ((rcCommand[axis] * RC_FRACTION_ONE - filtered[axis]) * lowpassGain + (1 << (LOWPASS_GAIN_BITS - 1))) >> LOWPASS_GAIN_BITS;
+            rcCommand[axis] = (filtered[axis] + RC_FRACTION_ONE / 2) >> RC_FRACTION_BITS;
+        }
+    }
+
+    for (axis = 0; axis < RC_INTERPOLATION_AXIS_COUNT; axis++) {
+        lastOutput[axis] = rcCommand[axis];
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+typedef enum {
+    RC_INTERPOLATION_OFF = 0,
+    RC_INTERPOLATION_LINEAR,
+    RC_INTERPOLATION_LOWPASS
+} rcInterpolationMode_e;
+
+#define RC_INTERPOLATION_MODE_MAX RC_INTERPOLATION_LOWPASS
+
+#define RC_INTERPOLATION_MAX_STEPS 255
+#define RC_INTERPOLATION_MAX_FRAME_INTERVAL_US 50000    // longer gaps are a lost link, the next frame is applied directly
+
+void useRcInterpolationConfig(rxConfig_t *rxConfigToUse);
+void interpolateRcCommand(bool newFrame, uint32_t currentTime);
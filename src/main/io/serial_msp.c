@@ -39,10 +39,14 @@
 #include "drivers/bus_i2c.h"
 #include "drivers/gpio.h"
 #include "drivers/timer.h"
+#include "drivers/serial_uart.h"
+#include "drivers/serial_softserial.h"
 #include "drivers/pwm_rx.h"
 
 #include "rx/rx.h"
 #include "rx/msp.h"
+#include "rx/rx_latency.h"
+#include "rx/rx_stats.h"
 
 #include "io/escservo.h"
 #include "io/rc_controls.h"
@@ -76,6 +80,8 @@
 #include "config/config.h"
 #include "config/config_profile.h"
 #include "config/config_master.h"
+#include "config/parameters.h"
+#include "config/config_transfer.h"
 
 #include "version.h"
 #ifdef NAZE
@@ -89,6 +95,7 @@ static serialPort_t *mspSerialPort;
 extern uint16_t cycleTime; // FIXME dependency on mw.c
 extern uint16_t rssi; // FIXME dependency on mw.c
 extern int16_t debug[4]; // FIXME dependency on mw.c
+extern int16_t telemTemperature1; // FIXME dependency on mw.c
 
 void useRcControlsConfig(modeActivationCondition_t *modeActivationConditions, escAndServoConfig_t *escAndServoConfigToUse, pidProfile_t *pidProfileToUse);
 
@@ -131,7 +138,7 @@ void useRcControlsConfig(modeActivationCondition_t *modeActivationConditions, es
 #define MSP_PROTOCOL_VERSION                0
 
 #define API_VERSION_MAJOR                   1 // increment when major changes are made
-#define API_VERSION_MINOR                   7 // increment when any change is made, reset to zero when major changes are released after changing API_VERSION_MAJOR
+#define API_VERSION_MINOR                   16 // increment when any change is made, reset to zero when major changes are released after changing API_VERSION_MAJOR
 
 #define API_VERSION_LENGTH                  2
 
@@ -234,9 +241,26 @@ const char *boardIdentifier = TARGET_BOARD_IDENTIFIER;
 #define MSP_BF_BUILD_INFO               69 //out message build date as well as some space for future expansion
 
 #define MSP_DATAFLASH_SUMMARY           70 //out message - get description of dataflash chip
-#define MSP_DATAFLASH_READ              71 //out message - get content of dataflash chip
+#define MSP_DATAFLASH_READ              71 //out message - get content of dataflash chip, optionally compressed
 #define MSP_DATAFLASH_ERASE             72 //in message - erase dataflash chip
 
+#define MSP_PARAMETER_INFO              73 //out message - get name, type and range of the parameter with the given index
+#define MSP_PARAMETER_VALUES            74 //out message - get the values of consecutive parameters, starting at the given index
+#define MSP_SET_PARAMETER               75 //in message - set the parameter with the given index
+
+#define MSP_CONFIG_SCHEMA               76 //out message - layout, size and CRC32 of the config image
+#define MSP_CONFIG_READ                 77 //out message - get a chunk of the config image
+#define MSP_SET_CONFIG_CHUNK            78 //in message - write a chunk of the config image, chunks must be sent in order
+#define MSP_SET_CONFIG_COMMIT           79 //in message - check the CRC32 of the written image, then save and activate it
+
+#define MSP_DATAFLASH_LOGS              80 //out message - get the index entries of consecutive dataflash logs, starting at the given index
+#define MSP_DATAFLASH_ERASE_LOG         81 //in message - erase the dataflash log with the given index
+
+#define MSP_MOTOR_LATENCY               82 //out message - microseconds from the end of the mixer to the start of the motor pulses, last and peak
+#define MSP_RX_LATENCY                  83 //out message - microseconds from the end of a receiver frame to the start of the motor pulses, last and peak
+#define MSP_RX_STATS                    84 //out message - serial receiver frame counters, rates, link quality and frame interval jitter histogram
+#define MSP_GYRO_TEMP_COMP              85 //out message - gyro temperature, learnt bias against temperature table and the correction applied now
+
 //
 // Multwii original MSP commands
 //
@@ -387,6 +411,15 @@ static mspPort_t mspPorts[MAX_MSP_PORT_COUNT];
 
 static mspPort_t *currentPort;
 
+static void serializeBuf(const uint8_t *data, int count)
+{
+    for (int i = 0; i < count; i++) {
+        currentPort->checksum ^= data[i];
+    }
+
+    serialWriteBuf(mspSerialPort, data, count);
+}
+
 static void serialize32(uint32_t a)
 {
     static uint8_t t;
@@ -440,8 +473,14 @@ static uint32_t read32(void)
     return t;
 }
 
+#define MSP_RESPONSE_OVERHEAD 6 // '$', 'M', direction, size, command and checksum
+
+static uint8_t lastResponseBodySize;
+
 static void headSerialResponse(uint8_t err, uint8_t responseBodySize)
 {
+    lastResponseBodySize = responseBodySize;
+
     serialize8('$');
     serialize8('M');
     serialize8(err ? '!' : '>');
@@ -539,18 +578,20 @@ reset:
 
 static void serializeDataflashSummaryReply(void)
 {
-    headSerialReply(1 + 3 * 4);
+    headSerialReply(1 + 3 * 4 + 1);
 #ifdef USE_FLASHFS
     const flashGeometry_t *geometry = flashfsGetGeometry();
     serialize8(flashfsIsReady() ? 1 : 0);
     serialize32(geometry->sectors);
     serialize32(geometry->totalSize);
     serialize32(flashfsGetOffset()); // Effectively the current number of bytes stored on the volume
+    serialize8(flashfsGetEraseProgress()); // Percentage, the flash isn't ready until a background erase completes
 #else
     serialize8(0);
     serialize32(0);
     serialize32(0);
     serialize32(0);
+    serialize8(0);
 #endif
 }
 
@@ -564,19 +605,171 @@ static void serializeDataflashReadReply(uint32_t address, uint8_t size)
         size = sizeof(buffer);
     }
 
-    headSerialReply(4 + size);
+    // bytesRead will be lower than that requested if we reach end of volume
+    bytesRead = flashfsReadAbs(address, buffer, size);
+
+    headSerialReply(4 + bytesRead);
 
     serialize32(address);
+    serializeBuf(buffer, bytesRead);
+}
 
-    // bytesRead will be lower than that requested if we reach end of volume
-    bytesRead = flashfsReadAbs(address, buffer, size);
+/*
+ * The whole reply frame has to fit into the transmit buffer of the port, the UART and softserial drivers don't block
+ * when it is full and would overwrite the start of the frame. Their buffers are 256 bytes, of which 255 can be used.
+ */
+#define MSP_PORT_TX_BUFFER_SIZE 256
 
-    for (int i = 0; i < bytesRead; i++) {
-        serialize8(buffer[i]);
+#define DATAFLASH_READ_REPLY_HEADER_SIZE (4 + 2 + 1)
+#define DATAFLASH_READ_REPLY_MAX_DATA_SIZE (MSP_PORT_TX_BUFFER_SIZE - 1 - MSP_RESPONSE_OVERHEAD - DATAFLASH_READ_REPLY_HEADER_SIZE)
+
+/**
+ * Reply to a read request which specifies the number of bytes wanted and whether the reply may be compressed.
+ *
+ * The reply carries the number of bytes read from the flash, which is larger than the payload when compressed.
+ */
+static void serializeDataflashReadReplyCompressed(uint32_t address, uint16_t size, flashfsCompression_e compression)
+{
+    uint8_t buffer[DATAFLASH_READ_REPLY_MAX_DATA_SIZE];
+    unsigned int bytesRead;
+    int bytesWritten;
+
+    BUILD_BUG_ON(MSP_PORT_TX_BUFFER_SIZE > UART1_TX_BUFFER_SIZE || MSP_PORT_TX_BUFFER_SIZE > UART2_TX_BUFFER_SIZE
+        || MSP_PORT_TX_BUFFER_SIZE > UART3_TX_BUFFER_SIZE || MSP_PORT_TX_BUFFER_SIZE > SOFTSERIAL_BUFFER_SIZE);
+
+    if (compression == FLASHFS_COMPRESSION_RLE_ERASED) {
+        bytesWritten = flashfsReadAbsCompressed(address, size, buffer, sizeof(buffer), &bytesRead);
+    } else {
+        compression = FLASHFS_COMPRESSION_NONE;
+        bytesRead = bytesWritten = flashfsReadAbs(address, buffer, MIN(size, sizeof(buffer)));
     }
+
+    headSerialReply(DATAFLASH_READ_REPLY_HEADER_SIZE + bytesWritten);
+
+    serialize32(address);
+    serialize16(bytesRead);
+    serialize8(compression);
+    serializeBuf(buffer, bytesWritten);
 }
 #endif
 
+#ifdef USE_FLASHFS
+#define DATAFLASH_LOGS_PER_REPLY 8
+
+static void serializeDataflashLogsReply(uint16_t index)
+{
+    flashfsLog_t log;
+    uint16_t logCount = flashfsGetLogCount();
+    uint8_t entryCount = 0;
+
+    if (index < logCount) {
+        entryCount = MIN(logCount - index, DATAFLASH_LOGS_PER_REPLY);
+    }
+
+    headSerialReply(2 + entryCount * (1 + 3 * 4));
+
+    serialize16(logCount);
+
+    for (int i = 0; i < entryCount; i++) {
+        if (!flashfsGetLog(index + i, &log)) {
+            // A log entry which was interrupted before it was written, report it as deleted
+            memset(&log, 0, sizeof(log));
+            log.flags = FLASHFS_LOG_FLAG_DELETED;
+        }
+
+        serialize8(log.flags);
+        serialize32(log.start);
+        serialize32(log.length);
+        serialize32(log.timestamp);
+    }
+}
+#endif
+
+static void serializeParameterInfoReply(uint16_t index)
+{
+    const parameter_t *parameter = parameterGetByIndex(index);
+    const char *name;
+    uint8_t nameLength;
+
+    if (!parameter) {
+        headSerialError(0);
+        return;
+    }
+
+    name = parameter->name;
+    nameLength = strlen(name);
+
+    headSerialReply(2 + 2 + 2 + 4 + 4 + nameLength);
+    serialize16(index);
+    serialize16(parameter->type);
+    serialize16(parameter->offset);
+    serialize32(parameter->min);
+    serialize32(parameter->max);
+    while (nameLength--) {
+        serialize8(*name++);
+    }
+}
+
+#define MSP_PARAMETER_VALUES_MAX_COUNT 16
+
+static void serializeParameterValuesReply(uint16_t index)
+{
+    uint8_t count;
+
+    if (index >= parameterCount) {
+        headSerialError(0);
+        return;
+    }
+
+    count = MIN(MSP_PARAMETER_VALUES_MAX_COUNT, parameterCount - index);
+
+    headSerialReply(2 + count * 4);
+    serialize16(index);
+    while (count--) {
+        // floats are sent as their IEEE 754 bit pattern
+        serialize32(parameterGetValue(parameterGetByIndex(index++)).int_value);
+    }
+}
+
+static void serializeConfigSchemaReply(void)
+{
+    configTransferSchema_t schema;
+
+    configTransferGetSchema(&schema);
+
+    headSerialReply(1 + 1 + 2 + 2 + 2 + 1 + 2 + 2 + 1 + 4);
+    serialize8(schema.schemaVersion);
+    serialize8(schema.configVersion);
+    serialize16(schema.size);
+    serialize16(schema.profileOffset);
+    serialize16(schema.profileSize);
+    serialize8(schema.profileCount);
+    serialize16(schema.controlRateProfileOffset);
+    serialize16(schema.controlRateProfileSize);
+    serialize8(schema.controlRateProfileCount);
+    serialize32(schema.crc);
+}
+
+static void serializeConfigReadReply(uint16_t offset, uint8_t size)
+{
+    uint8_t buffer[128];
+    uint16_t bytesRead;
+    uint16_t i;
+
+    if (size > sizeof(buffer)) {
+        size = sizeof(buffer);
+    }
+
+    // bytesRead will be lower than that requested at the end of the image
+    bytesRead = configTransferRead(offset, buffer, size);
+
+    headSerialReply(2 + bytesRead);
+    serialize16(offset);
+    for (i = 0; i < bytesRead; i++) {
+        serialize8(buffer[i]);
+    }
+}
+
 static void resetMspPort(mspPort_t *mspPortToReset, serialPort_t *serialPort, mspPortUsage_e usage)
 {
     memset(mspPortToReset, 0, sizeof(mspPort_t));
@@ -692,7 +885,7 @@ void mspInit(serialConfig_t *serialConfig)
 
 static bool processOutCommand(uint8_t cmdMSP)
 {
-    uint32_t i, tmp, junk;
+    uint32_t i, j, tmp, junk;
 
 #ifdef GPS
     uint8_t wp_no;
@@ -851,6 +1044,46 @@ static bool processOutCommand(uint8_t cmdMSP)
     case MSP_MOTOR:
         s_struct((uint8_t *)motor, 16);
         break;
+    case MSP_MOTOR_LATENCY:
+        headSerialReply(4);
+        serialize16(motorOutputLatency.last);
+        serialize16(motorOutputLatency.max);
+        break;
+    case MSP_RX_LATENCY:
+        headSerialReply(4);
+        serialize16(rxLatency.last);
+        serialize16(rxLatency.max);
+        break;
+    case MSP_RX_STATS:
+        headSerialReply(4 * 4 + 2 * 2 + 2 + 2 * RX_STATS_JITTER_BUCKET_COUNT);
+        serialize32(rxStats.framesReceived);
+        serialize32(rxStats.framesLost);
+        serialize32(rxStats.crcErrors);
+        serialize32(rxStats.signalLossFrames);
+        serialize16(rxStats.framesPerSecond);
+        serialize16(rxStats.frameIntervalUs);
+        serialize8(rxStats.lostFramePercent);
+        serialize8(rxStats.linkQuality);
+        for (i = 0; i < RX_STATS_JITTER_BUCKET_COUNT; i++) {
+            serialize16(rxStats.jitterHistogram[i]);
+        }
+        break;
+    case MSP_GYRO_TEMP_COMP:
+        headSerialReply(2 + 1 + 1 + 1 + GYRO_TEMP_COMP_POINT_COUNT * (1 + 2 * XYZ_AXIS_COUNT) + 2 * XYZ_AXIS_COUNT);
+        serialize16(telemTemperature1);
+        serialize8(GYRO_TEMP_COMP_MIN_TEMPERATURE);
+        serialize8(GYRO_TEMP_COMP_POINT_SPACING);
+        serialize8(GYRO_TEMP_COMP_POINT_COUNT);
+        for (i = 0; i < GYRO_TEMP_COMP_POINT_COUNT; i++) {
+            serialize8(masterConfig.gyroTempCompensation.windowCount[i]);
+            for (j = 0; j < XYZ_AXIS_COUNT; j++) {
+                serialize16(masterConfig.gyroTempCompensation.bias[i][j]);
+            }
+        }
+        for (i = 0; i < XYZ_AXIS_COUNT; i++) {
+            serialize16(gyroGetTemperatureCorrection(i));
+        }
+        break;
     case MSP_RC:
         headSerialReply(2 * rxRuntimeConfig.channelCount);
         for (i = 0; i < rxRuntimeConfig.channelCount; i++)
@@ -1198,11 +1431,38 @@ static bool processOutCommand(uint8_t cmdMSP)
         {
             uint32_t readAddress = read32();
 
-            serializeDataflashReadReply(readAddress, 128);
+            // Requests which only carry an address get the original, uncompressed 128 byte reply
+            if (currentPort->dataSize >= 4 + 2 + 1) {
+                uint16_t readLength = read16();
+
+                serializeDataflashReadReplyCompressed(readAddress, readLength, read8());
+            } else {
+                serializeDataflashReadReply(readAddress, 128);
+            }
         }
         break;
+
+    case MSP_DATAFLASH_LOGS:
+        serializeDataflashLogsReply(read16());
+        break;
 #endif
 
+    case MSP_PARAMETER_INFO:
+        serializeParameterInfoReply(read16());
+        break;
+
+    case MSP_PARAMETER_VALUES:
+        serializeParameterValuesReply(read16());
+        break;
+
+    case MSP_CONFIG_SCHEMA:
+        serializeConfigSchemaReply();
+        break;
+
+    case MSP_CONFIG_READ:
+        serializeConfigReadReply(read16(), 128);
+        break;
+
     case MSP_BF_BUILD_INFO:
         headSerialReply(11 + 4 + 4);
         for (i = 0; i < 11; i++)
@@ -1306,6 +1566,37 @@ static bool processInCommand(void)
             headSerialError(0);
         }
         break;
+    case MSP_SET_PARAMETER:
+        {
+            const parameter_t *parameter = parameterGetByIndex(read16());
+            int_float_value_t value;
+
+            value.int_value = read32();
+            if (parameter && parameterIsValueInRange(parameter, value)) {
+                parameterSetValue(parameter, value);
+            } else {
+                headSerialError(0);
+            }
+        }
+        break;
+
+    case MSP_SET_CONFIG_CHUNK:
+        if (currentPort->dataSize >= 2) {
+            tmp = read16();
+            if (!configTransferWriteChunk(tmp, &currentPort->inBuf[currentPort->indRX], currentPort->dataSize - 2)) {
+                headSerialError(0);
+            }
+        } else {
+            headSerialError(0);
+        }
+        break;
+
+    case MSP_SET_CONFIG_COMMIT:
+        if (!configTransferCommit(read32())) {
+            headSerialError(0);
+        }
+        break;
+
     case MSP_SET_ADJUSTMENT_RANGE:
         i = read8();
         if (i < MAX_ADJUSTMENT_RANGE_COUNT) {
@@ -1415,7 +1706,7 @@ static bool processInCommand(void)
             ENABLE_STATE(CALIBRATE_MAG);
         break;
     case MSP_EEPROM_WRITE:
-        if (ARMING_FLAG(ARMED)) {
+        if (ARMING_FLAG(ARMED) || configTransferInProgress()) {
             headSerialError(0);
             return true;
         }
@@ -1427,6 +1718,12 @@ static bool processInCommand(void)
     case MSP_DATAFLASH_ERASE:
         flashfsEraseCompletely();
         break;
+
+    case MSP_DATAFLASH_ERASE_LOG:
+        if (ARMING_FLAG(ARMED) || !flashfsEraseLog(read16())) {
+            headSerialError(0);
+        }
+        break;
 #endif
 
 #ifdef GPS
@@ -1702,21 +1999,19 @@ void mspProcess(void)
     }
 }
 
-static const uint8_t mspTelemetryCommandSequence[] = {
-    MSP_BOXNAMES,   // repeat boxnames, in case the first transmission was lost or never received.
-    MSP_STATUS,
-    MSP_IDENT,
-    MSP_RAW_IMU,
-    MSP_ALTITUDE,
-    MSP_RAW_GPS,
-    MSP_RC,
-    MSP_MOTOR_PINS,
-    MSP_ATTITUDE,
-    MSP_SERVO
+static const uint8_t mspTelemetryCommands[MSP_TELEMETRY_COMMAND_COUNT] = {
+    [MSP_TELEMETRY_BOXNAMES]   = MSP_BOXNAMES,   // repeat boxnames, in case the first transmission was lost or never received.
+    [MSP_TELEMETRY_STATUS]     = MSP_STATUS,
+    [MSP_TELEMETRY_IDENT]      = MSP_IDENT,
+    [MSP_TELEMETRY_RAW_IMU]    = MSP_RAW_IMU,
+    [MSP_TELEMETRY_ALTITUDE]   = MSP_ALTITUDE,
+    [MSP_TELEMETRY_RAW_GPS]    = MSP_RAW_GPS,
+    [MSP_TELEMETRY_RC]         = MSP_RC,
+    [MSP_TELEMETRY_MOTOR_PINS] = MSP_MOTOR_PINS,
+    [MSP_TELEMETRY_ATTITUDE]   = MSP_ATTITUDE,
+    [MSP_TELEMETRY_SERVO]      = MSP_SERVO
 };
 
-#define TELEMETRY_MSP_COMMAND_SEQUENCE_ENTRY_COUNT (sizeof(mspTelemetryCommandSequence) / sizeof(mspTelemetryCommandSequence[0]))
-
 static mspPort_t *mspTelemetryPort = NULL;
 
 void mspSetTelemetryPort(serialPort_t *serialPort)
@@ -1752,21 +2047,20 @@ void mspSetTelemetryPort(serialPort_t *serialPort)
     resetMspPort(mspTelemetryPort, serialPort, FOR_TELEMETRY);
 }
 
-void sendMspTelemetry(void)
+/*
+ * Returns the number of bytes written, so the caller can pace the replies to the baud rate.
+ */
+uint16_t sendMspTelemetry(mspTelemetryCommand_e command)
 {
-    static uint32_t sequenceIndex = 0;
-
     if (!mspTelemetryPort) {
-        return;
+        return 0;
     }
 
     setCurrentPort(mspTelemetryPort);
 
-    processOutCommand(mspTelemetryCommandSequence[sequenceIndex]);
+    lastResponseBodySize = 0;
+    processOutCommand(mspTelemetryCommands[command]);
     tailSerialReply();
 
-    sequenceIndex++;
-    if (sequenceIndex >= TELEMETRY_MSP_COMMAND_SEQUENCE_ENTRY_COUNT) {
-        sequenceIndex = 0;
-    }
+    return MSP_RESPONSE_OVERHEAD + lastResponseBodySize;
 }
@@ -23,10 +23,25 @@
 // Each MSP port requires state and a receive buffer, revisit this default if someone needs more than 2 MSP ports.
 #define MAX_MSP_PORT_COUNT 2
 
+// The replies telemetry can send, the telemetry backend decides how often each one goes out.
+typedef enum {
+    MSP_TELEMETRY_BOXNAMES = 0,
+    MSP_TELEMETRY_STATUS,
+    MSP_TELEMETRY_IDENT,
+    MSP_TELEMETRY_RAW_IMU,
+    MSP_TELEMETRY_ALTITUDE,
+    MSP_TELEMETRY_RAW_GPS,
+    MSP_TELEMETRY_RC,
+    MSP_TELEMETRY_MOTOR_PINS,
+    MSP_TELEMETRY_ATTITUDE,
+    MSP_TELEMETRY_SERVO,
+    MSP_TELEMETRY_COMMAND_COUNT
+} mspTelemetryCommand_e;
+
 void mspInit(serialConfig_t *serialConfig);
 
 void mspProcess(void);
-void sendMspTelemetry(void);
+uint16_t sendMspTelemetry(mspTelemetryCommand_e command);
 void mspSetTelemetryPort(serialPort_t *mspTelemetryPort);
 void mspAllocateSerialPorts(serialConfig_t *serialConfig);
 void mspReleasePortIfAllocated(serialPort_t *serialPort);
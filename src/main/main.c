@@ -220,6 +220,9 @@ void init(void)
 #endif
 
     pwm_params.useOneshot = feature(FEATURE_ONESHOT125);
+#ifdef USE_DSHOT
+    pwm_params.useDshot = feature(FEATURE_DSHOT);
+#endif
     pwm_params.motorPwmRate = masterConfig.motor_pwm_rate;
     pwm_params.idlePulse = PULSE_1MS; // standard PWM for brushless ESC (default, overridden below)
     if (feature(FEATURE_3D))
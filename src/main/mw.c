@@ -36,6 +36,7 @@
 #include "drivers/serial.h"
 #include "drivers/timer.h"
 #include "drivers/pwm_rx.h"
+#include "drivers/pwm_output.h"
 
 #include "sensors/sensors.h"
 #include "sensors/boardalignment.h"
@@ -58,9 +59,13 @@
 #include "io/serial_cli.h"
 #include "io/serial_msp.h"
 #include "io/statusindicator.h"
+#include "io/flashfs.h"
 
 #include "rx/rx.h"
 #include "rx/msp.h"
+#include "rx/rx_latency.h"
+
+#include "io/rc_interpolation.h"
 
 #include "telemetry/telemetry.h"
 #include "blackbox/blackbox.h"
@@ -78,6 +83,7 @@
 #include "config/config.h"
 #include "config/config_profile.h"
 #include "config/config_master.h"
+#include "config/config_transfer.h"
 
 // June 2013     V2.2-dev
 
@@ -87,9 +93,6 @@ enum {
     ALIGN_MAG = 2
 };
 
-/* for VBAT monitoring frequency */
-#define VBATFREQ 6        // to read battery voltage - nth number of loop iterations
-
 int16_t debug[4];
 uint32_t currentTime = 0;
 uint32_t previousTime = 0;
@@ -173,8 +176,9 @@ void annexCode(void)
     int32_t axis, prop1 = 0, prop2;
 
     static batteryState_e batteryState = BATTERY_OK;
-    static uint8_t vbatTimer = 0;
+    static uint32_t batteryUpdateAt = 0;
     static int32_t vbatCycleTime = 0;
+    static uint32_t gyroTemperatureUpdateAt = 0;
 
     // PITCH & ROLL only dynamic PID adjustemnt,  depending on throttle value
     if (rcData[THROTTLE] < currentControlRateProfile->tpa_breakpoint) {
@@ -238,16 +242,18 @@ void annexCode(void)
 
     if (feature(FEATURE_VBAT | FEATURE_CURRENT_METER)) {
         vbatCycleTime += cycleTime;
-        if (!(++vbatTimer % VBATFREQ)) {
+        if ((int32_t)(currentTime - batteryUpdateAt) >= 0) {
+            batteryUpdateAt = currentTime + BATTERY_UPDATE_INTERVAL_US;
+
+            // the current is needed to compensate the voltage for sag
+            if (feature(FEATURE_CURRENT_METER)) {
+                updateCurrentMeter(vbatCycleTime);
+            }
 
             if (feature(FEATURE_VBAT)) {
                 updateBatteryVoltage();
                 batteryState = calculateBatteryState();
             }
-
-            if (feature(FEATURE_CURRENT_METER)) {
-                updateCurrentMeter(vbatCycleTime);
-            }
             vbatCycleTime = 0;
         }
     }
@@ -274,6 +280,11 @@ void annexCode(void)
             DISABLE_ARMING_FLAG(OK_TO_ARM);
         }
 
+        configTransferCheckTimeout();
+        if (configTransferInProgress()) {
+            DISABLE_ARMING_FLAG(OK_TO_ARM);
+        }
+
         if (ARMING_FLAG(OK_TO_ARM)) {
             disableWarningLed();
         } else {
@@ -295,9 +306,12 @@ void annexCode(void)
     }
 #endif
 
-    // Read out gyro temperature. can use it for something somewhere. maybe get MCU temperature instead? lots of fun possibilities.
-    if (gyro.temperature)
+    // Read out gyro temperature, used for telemetry and to compensate the gyro bias. It changes slowly, so
+    // the bus transfer is not repeated every loop.
+    if (gyro.temperature && (int32_t)(currentTime - gyroTemperatureUpdateAt) >= 0) {
+        gyroTemperatureUpdateAt = currentTime + GYRO_TEMPERATURE_UPDATE_INTERVAL_US;
         gyro.temperature(&telemTemperature1);
+    }
 }
 
 void mwDisarm(void)
@@ -305,6 +319,8 @@ void mwDisarm(void)
     if (ARMING_FLAG(ARMED)) {
         DISABLE_ARMING_FLAG(ARMED);
 
+        writeEEPROMIfPending();
+
 #ifdef TELEMETRY
         if (feature(FEATURE_TELEMETRY)) {
             // the telemetry state must be checked immediately so that shared serial ports are released.
@@ -622,36 +638,45 @@ void processRx(void)
     }
 }
 
-void loop(void)
-{
-    static uint32_t loopTime;
 #if defined(BARO) || defined(SONAR)
-    static bool haveProcessedAnnexCodeOnce = false;
+static bool haveProcessedAnnexCodeOnce = false;
 #endif
 
-    updateRx();
+// set when rcData changed, cleared by the next control loop
+static bool rcDataUpdated = false;
 
-    if (shouldProcessRx(currentTime)) {
-        processRx();
+static void processRxAndAltHoldState(void)
+{
+    processRx();
+    rcDataUpdated = true;
 
 #ifdef BARO
-        // the 'annexCode' initialses rcCommand, updateAltHoldState depends on valid rcCommand data.
-        if (haveProcessedAnnexCodeOnce) {
-            if (sensors(SENSOR_BARO)) {
-                updateAltHoldState();
-            }
+    // the 'annexCode' initialses rcCommand, updateAltHoldState depends on valid rcCommand data.
+    if (haveProcessedAnnexCodeOnce) {
+        if (sensors(SENSOR_BARO)) {
+            updateAltHoldState();
         }
+    }
 #endif
 
 #ifdef SONAR
-        // the 'annexCode' initialses rcCommand, updateAltHoldState depends on valid rcCommand data.
-        if (haveProcessedAnnexCodeOnce) {
-            if (sensors(SENSOR_SONAR)) {
-                updateSonarAltHoldState();
-            }
+    // the 'annexCode' initialses rcCommand, updateAltHoldState depends on valid rcCommand data.
+    if (haveProcessedAnnexCodeOnce) {
+        if (sensors(SENSOR_SONAR)) {
+            updateSonarAltHoldState();
         }
+    }
 #endif
+}
+
+void loop(void)
+{
+    static uint32_t loopTime;
 
+    updateRx();
+
+    if (shouldProcessRx(currentTime)) {
+        processRxAndAltHoldState();
     } else {
         // not processing rx this iteration
         executePeriodicTasks();
@@ -670,6 +695,12 @@ void loop(void)
     if (masterConfig.looptime == 0 || (int32_t)(currentTime - loopTime) >= 0) {
         loopTime = currentTime + masterConfig.looptime;
 
+        // A frame that completed while the periodic tasks ran goes into this iteration's rcCommand rather than waiting a whole loop for the next one.
+        updateRx();
+        if (shouldProcessRx(currentTime)) {
+            processRxAndAltHoldState();
+        }
+
         imuUpdate(&currentProfile->accelerometerTrims, masterConfig.mixerMode);
 
         // Measure loop rate just after reading the sensors
@@ -678,6 +709,8 @@ void loop(void)
         previousTime = currentTime;
 
         annexCode();
+        interpolateRcCommand(rcDataUpdated, currentTime);
+        rcDataUpdated = false;
 #if defined(BARO) || defined(SONAR)
         haveProcessedAnnexCodeOnce = true;
 #endif
@@ -730,14 +763,14 @@ void loop(void)
         );
 
         mixTable();
+        writeMotors();
+        rxFrameOutput(micros() + pwmGetMotorPulseStartDelay());
 
 #ifdef USE_SERVOS
         filterServos();
         writeServos();
 #endif
 
-        writeMotors();
-
 #ifdef BLACKBOX
         if (!cliMode && feature(FEATURE_BLACKBOX)) {
             handleBlackbox();
@@ -756,4 +789,8 @@ void loop(void)
         updateLedStrip();
     }
 #endif
+
+#ifdef USE_FLASHFS
+    flashfsEraseUpdate();
+#endif
 }
@@ -29,6 +29,7 @@
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_latency.h"
 #include "rx/msp.h"
 
 static bool rxMspFrameDone = false;
@@ -42,6 +43,7 @@ static uint16_t rxMspReadRawRC(rxRuntimeConfig_t *rxRuntimeConfigPtr, uint8_t ch
 void rxMspFrameRecieve(void)
 {
     rxMspFrameDone = true;
+    rxFrameCompleted(micros());
 }
 
 bool rxMspFrameComplete(void)
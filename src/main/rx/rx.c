@@ -47,16 +47,15 @@
 #include "rx/xbus.h"
 
 #include "rx/rx.h"
+#include "rx/rx_latency.h"
+#include "rx/rx_filter.h"
+#include "rx/rx_frame.h"
+#include "rx/rx_stats.h"
 
 extern int16_t debug[4];
 
 void rxPwmInit(rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
 
-bool sbusInit(rxConfig_t *initialRxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
-bool spektrumInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
-bool sumdInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
-bool sumhInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
-
 bool rxMspInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
 
 const char rcChannelLetters[] = "AERT12345678abcdefgh";
@@ -65,8 +64,6 @@ uint16_t rssi = 0;                  // range: [0;1023]
 
 int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];     // interval [1000;2000]
 
-#define PPM_AND_PWM_SAMPLE_COUNT 4
-
 #define PULSE_MIN   750       // minimum PWM pulse width which is considered valid
 #define PULSE_MAX   2250      // maximum PWM pulse width which is considered valid
 
@@ -145,30 +142,14 @@ void serialRxInit(rxConfig_t *rxConfig)
 
 uint8_t serialRxFrameStatus(rxConfig_t *rxConfig)
 {
+    UNUSED(rxConfig);
+
     /**
-     * FIXME: Each of the xxxxFrameStatus() methods MUST be able to survive being called without the
-     * corresponding xxxInit() method having been called first.
-     *
-     * This situation arises when the cli or the msp changes the value of rxConfig->serialrx_provider
-     *
-     * A solution is for the ___Init() to configure the serialRxFrameStatus function pointer which
-     * should be used instead of the switch statement below.
+     * The serial receivers hand their frames to rx_frame.c which decodes them with the protocol that
+     * the ___Init() method selected. Until a receiver has been initialised no frame is ever complete,
+     * so changing rxConfig->serialrx_provider from the cli or the msp is harmless.
      */
-    switch (rxConfig->serialrx_provider) {
-        case SERIALRX_SPEKTRUM1024:
-        case SERIALRX_SPEKTRUM2048:
-            return spektrumFrameStatus();
-        case SERIALRX_SBUS:
-            return sbusFrameStatus();
-        case SERIALRX_SUMD:
-            return sumdFrameStatus();
-        case SERIALRX_SUMH:
-            return sumhFrameStatus();
-        case SERIALRX_XBUS_MODE_B:
-        case SERIALRX_XBUS_MODE_B_RJ01:
-            return xBusFrameStatus();
-    }
-    return SERIAL_RX_FRAME_PENDING;
+    return rxFrameStatus();
 }
 #endif
 
@@ -195,8 +176,9 @@ void updateRx(void)
 
         if (frameStatus & SERIAL_RX_FRAME_COMPLETE) {
             rcDataReceived = true;
-            if ((frameStatus & SERIAL_RX_FRAME_FAILSAFE) == 0 && feature(FEATURE_FAILSAFE)) {
-                failsafeReset();
+            rxFrameReceived();
+            if (feature(FEATURE_FAILSAFE)) {
+                failsafeOnRxFrame(frameStatus);
             }
         }
     }
@@ -204,6 +186,9 @@ void updateRx(void)
 
     if (feature(FEATURE_RX_MSP)) {
         rcDataReceived = rxMspFrameComplete();
+        if (rcDataReceived) {
+            rxFrameReceived();
+        }
         if (rcDataReceived && feature(FEATURE_FAILSAFE)) {
             failsafeReset();
         }
@@ -219,36 +204,6 @@ static bool isRxDataDriven(void) {
     return !(feature(FEATURE_RX_PARALLEL_PWM | FEATURE_RX_PPM));
 }
 
-static uint8_t rcSampleIndex = 0;
-
-static uint16_t calculateNonDataDrivenChannel(uint8_t chan, uint16_t sample)
-{
-    static int16_t rcSamples[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT][PPM_AND_PWM_SAMPLE_COUNT];
-    static int16_t rcDataMean[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT];
-    static bool rxSamplesCollected = false;
-
-    uint8_t currentSampleIndex = rcSampleIndex % PPM_AND_PWM_SAMPLE_COUNT;
-
-    // update the recent samples and compute the average of them
-    rcSamples[chan][currentSampleIndex] = sample;
-
-    // avoid returning an incorrect average which would otherwise occur before enough samples
-    if (!rxSamplesCollected) {
-        if (rcSampleIndex < PPM_AND_PWM_SAMPLE_COUNT) {
-            return sample;
-        }
-        rxSamplesCollected = true;
-    }
-
-    rcDataMean[chan] = 0;
-
-    uint8_t sampleIndex;
-    for (sampleIndex = 0; sampleIndex < PPM_AND_PWM_SAMPLE_COUNT; sampleIndex++)
-        rcDataMean[chan] += rcSamples[chan][sampleIndex];
-
-    return rcDataMean[chan] / PPM_AND_PWM_SAMPLE_COUNT;
-}
-
 static void processRxChannels(void)
 {
     uint8_t chan;
@@ -291,7 +246,7 @@ static void processRxChannels(void)
         if (isRxDataDriven()) {
             rcData[chan] = sample;
         } else {
-            rcData[chan] = calculateNonDataDrivenChannel(chan, sample);
+            rcData[chan] = rxFilterApply(chan, sample, rxConfig->input_median_channels & (1 << chan));
         }
     }
 }
@@ -303,8 +258,6 @@ static void processDataDrivenRx(void)
 
 static void processNonDataDrivenRx(void)
 {
-    rcSampleIndex++;
-
     processRxChannels();
 }
 
@@ -312,6 +265,8 @@ void calculateRxChannelsAndUpdateFailsafe(uint32_t currentTime)
 {
     rxUpdateAt = currentTime + DELAY_50_HZ;
 
+    rxStatsUpdate(currentTime);
+
     if (feature(FEATURE_FAILSAFE)) {
         failsafeOnRxCycle();
     }
@@ -382,6 +337,11 @@ void updateRSSIADC(uint32_t currentTime)
 #endif
 }
 
+static void updateRSSIFromLinkQuality(void)
+{
+    rssi = rxStats.linkQuality * 1023 / 100;
+}
+
 void updateRSSI(uint32_t currentTime)
 {
 
@@ -389,6 +349,8 @@ void updateRSSI(uint32_t currentTime)
         updateRSSIPWM();
     } else if (feature(FEATURE_RSSI_ADC)) {
         updateRSSIADC(currentTime);
+    } else if (feature(FEATURE_RX_SERIAL)) {
+        updateRSSIFromLinkQuality();
     }
 }
 
@@ -29,7 +29,8 @@
 typedef enum {
     SERIAL_RX_FRAME_PENDING = 0,
     SERIAL_RX_FRAME_COMPLETE = (1 << 0),
-    SERIAL_RX_FRAME_FAILSAFE = (1 << 1)
+    SERIAL_RX_FRAME_FAILSAFE = (1 << 1),
+    SERIAL_RX_FRAME_DROPPED = (1 << 2)     // the receiver lost a frame on the RF link and repeats the last channel data
 } serialrxFrameState_t;
 
 typedef enum {
@@ -79,6 +80,9 @@ typedef struct rxConfig_s {
     uint16_t midrc;                         // Some radios have not a neutral point centered on 1500. can be changed here
     uint16_t mincheck;                      // minimum rc end
     uint16_t maxcheck;                      // maximum rc end
+    uint8_t rc_interpolation;               // smoothing of rcCommand between rx frames, see rcInterpolationMode_e
+    uint8_t rc_interpolation_hz;            // cutoff of the low pass rc_interpolation mode
+    uint16_t input_median_channels;         // PPM/PWM channels that use a median instead of the mean of the last samples, bit 0 is roll
 } rxConfig_t;
 
 #define REMAPPABLE_CHANNEL_COUNT (sizeof(((rxConfig_t *)0)->rcmap) / sizeof(((rxConfig_t *)0)->rcmap[0]))
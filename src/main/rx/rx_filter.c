@@ -0,0 +1,81 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/maths.h"
+
+#include "rx/rx.h"
+#include "rx/rx_filter.h"
+
+/*
+ * Smooths the samples of PPM and parallel PWM channels, which are taken at a fixed rate rather than per frame.
+ *
+ * Every channel keeps its last RX_FILTER_SAMPLE_COUNT samples and their sum, so the running mean costs one add
+ * and one subtract per sample. A single glitch still moves the mean by a quarter of its size, channels that need
+ * to reject those can use the median of the last three samples instead, at the cost of one sample of delay.
+ *
+ * Pulses outside the valid range are already dropped by the capture callbacks in drivers/pwm_rx.c.
+ */
+
+#define RX_FILTER_INDEX_MASK (RX_FILTER_SAMPLE_COUNT - 1)
+
+typedef struct rxFilterChannel_s {
+    uint16_t samples[RX_FILTER_SAMPLE_COUNT];
+    uint32_t sum;
+    uint8_t newestIndex;
+    uint8_t sampleCount;                    // up to RX_FILTER_SAMPLE_COUNT
+} rxFilterChannel_t;
+
+static rxFilterChannel_t rxFilterChannels[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT];
+
+static uint16_t medianOf3(uint16_t a, uint16_t b, uint16_t c)
+{
+    return MAX(MIN(a, b), MIN(MAX(a, b), c));
+}
+
+uint16_t rxFilterApply(uint8_t channel, uint16_t sample, bool useMedian)
+{
+    rxFilterChannel_t *filter = &rxFilterChannels[channel];
+    uint8_t index = (filter->newestIndex + 1) & RX_FILTER_INDEX_MASK;
+
+    filter->sum += sample - filter->samples[index];
+    filter->samples[index] = sample;
+    filter->newestIndex = index;
+
+    if (filter->sampleCount < RX_FILTER_SAMPLE_COUNT) {
+        filter->sampleCount++;
+    }
+
+    // avoid returning an incorrect result which would otherwise occur before enough samples
+    if (useMedian) {
+        if (filter->sampleCount < RX_FILTER_MEDIAN_SAMPLE_COUNT) {
+            return sample;
+        }
+        return medianOf3(
+            sample,
+            filter->samples[(index - 1) & RX_FILTER_INDEX_MASK],
+            filter->samples[(index - 2) & RX_FILTER_INDEX_MASK]
+        );
+    }
+
+    if (filter->sampleCount < RX_FILTER_SAMPLE_COUNT) {
+        return sample;
+    }
+    return filter->sum / RX_FILTER_SAMPLE_COUNT;
+}
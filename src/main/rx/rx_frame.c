@@ -0,0 +1,160 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/crc.h"
+
+#include "drivers/system.h"
+
+#include "rx/rx.h"
+#include "rx/rx_latency.h"
+#include "rx/rx_frame.h"
+#include "rx/rx_stats.h"
+
+/*
+ * Common framing for the serial receivers.
+ *
+ * Each protocol describes its frames with an rxFrameProtocol_t: the sync and end bytes, a fixed length or where to
+ * find it, the pause that separates frames and the check that protects them. The serial receive callback runs the
+ * check a byte at a time, so a frame is verified when its last byte arrives and the main loop only decodes the
+ * channels of frames that are known to be good.
+ *
+ * Every frame the main loop picks up, and every frame that fails its check, is reported to rx_stats.c.
+ *
+ * Only one serial receiver is active at a time.
+ */
+
+static const rxFrameProtocol_t *protocol;
+
+static uint8_t frame[RX_FRAME_MAX_SIZE];
+static uint8_t framePosition;
+static uint8_t frameLength;
+static uint16_t frameCheck;
+static uint32_t lastByteAt;
+static volatile bool frameDone = false;
+static uint32_t frameCompletedAt;
+
+static volatile uint8_t framesRejected;     // only written by the receive callback
+static uint8_t framesRejectedReported;
+
+void rxFrameInit(const rxFrameProtocol_t *protocolToUse)
+{
+    protocol = protocolToUse;
+    framePosition = 0;
+    frameDone = false;
+
+    rxStatsReset();
+}
+
+static uint8_t crc8DallasUpdate(uint8_t crc, uint8_t data)
+{
+    uint8_t bit;
+
+    crc ^= data;
+    for (bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+    }
+    return crc;
+}
+
+// Receive ISR callback
+void rxFrameDataReceive(uint16_t c)
+{
+    uint32_t now = micros();
+    uint8_t data = c;
+
+    if (!protocol) {
+        return;
+    }
+
+    if (now - lastByteAt > protocol->frameGapUs) {
+        framePosition = 0;
+    }
+    lastByteAt = now;
+
+    if (framePosition == 0) {
+        if (protocol->syncByte != RX_FRAME_NO_SYNC_BYTE && data != protocol->syncByte) {
+            return;
+        }
+        // the main loop did not pick up the last frame in time, it is about to be overwritten
+        frameDone = false;
+        frameLength = protocol->length;
+        frameCheck = 0;
+    }
+
+    if (protocol->lengthOffset && framePosition == protocol->lengthOffset) {
+        uint16_t announcedLength = data * protocol->lengthMultiplier + protocol->lengthOverhead;
+        if (announcedLength > protocol->length || announcedLength <= protocol->lengthOffset) {
+            framePosition = 0;
+            return;
+        }
+        frameLength = announcedLength;
+    }
+
+    frame[framePosition++] = data;
+
+    switch (protocol->check) {
+        case RX_FRAME_CHECK_CRC16_CCITT:
+            frameCheck = crc16CcittUpdate(frameCheck, &data, 1);
+            break;
+        case RX_FRAME_CHECK_CRC8_DALLAS:
+            frameCheck = crc8DallasUpdate(frameCheck, data);
+            break;
+    }
+
+    if (framePosition < frameLength) {
+        return;
+    }
+    framePosition = 0;
+
+    // running the check over the frame including its own check bytes leaves 0
+    if (frameCheck != 0 || (protocol->endByte != RX_FRAME_NO_END_BYTE && data != protocol->endByte)) {
+        framesRejected++;
+        return;
+    }
+
+    frameCompletedAt = now;
+    frameDone = true;
+    rxFrameCompleted(now);
+}
+
+uint8_t rxFrameStatus(void)
+{
+    uint8_t rejected = framesRejected;
+    if (rejected != framesRejectedReported) {
+        rxStatsFramesRejected(rejected - framesRejectedReported);
+        framesRejectedReported = rejected;
+    }
+
+    if (!frameDone) {
+        return SERIAL_RX_FRAME_PENDING;
+    }
+    frameDone = false;
+
+    uint8_t frameStatus = protocol->decode(frame, frameLength);
+
+    if (frameStatus & SERIAL_RX_FRAME_COMPLETE) {
+        rxStatsFrameReceived(frameCompletedAt, frameStatus);
+    } else {
+        // the decoder found the content invalid
+        rxStatsFramesRejected(1);
+    }
+
+    return frameStatus;
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define RX_FRAME_MAX_SIZE 37                // SUMD with 16 channels
+
+#define RX_FRAME_NO_SYNC_BYTE -1
+#define RX_FRAME_NO_END_BYTE -1
+
+typedef enum {
+    RX_FRAME_CHECK_NONE = 0,
+    RX_FRAME_CHECK_CRC16_CCITT,             // big endian CRC-16/CCITT in the last two bytes
+    RX_FRAME_CHECK_CRC8_DALLAS              // 1-Wire CRC8 in the last byte
+} rxFrameCheck_e;
+
+// Decodes a complete frame that passed the checks, returns serialrxFrameState_t flags.
+typedef uint8_t (*rxFrameDecodeFnPtr)(const uint8_t *frame, uint8_t length);
+
+typedef struct rxFrameProtocol_s {
+    int16_t syncByte;                       // first byte of every frame, or RX_FRAME_NO_SYNC_BYTE
+    int16_t endByte;                        // last byte of every frame, or RX_FRAME_NO_END_BYTE
+    uint8_t length;                         // frame length, the largest frame accepted when lengthOffset is set
+    uint8_t lengthOffset;                   // if not 0 the byte at this offset gives the length...
+    uint8_t lengthMultiplier;               // ...multiplied by this...
+    uint8_t lengthOverhead;                 // ...plus this
+    uint8_t check;                          // rxFrameCheck_e
+    uint16_t frameGapUs;                    // a longer pause between two bytes starts a new frame
+    rxFrameDecodeFnPtr decode;
+} rxFrameProtocol_t;
+
+void rxFrameInit(const rxFrameProtocol_t *protocolToUse);
+void rxFrameDataReceive(uint16_t c);
+uint8_t rxFrameStatus(void);
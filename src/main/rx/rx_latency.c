@@ -0,0 +1,62 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/maths.h"
+
+#include "rx/rx_latency.h"
+
+/*
+ * Follows a receiver frame from the interrupt that receives its last byte, through the main loop picking it
+ * up into rcData, to the motor output that was calculated from it.
+ */
+
+rxLatency_t rxLatency;
+
+static volatile uint32_t frameCompletedAt;
+
+static uint32_t receivedFrameCompletedAt;
+static bool receivedFrameWaitingForOutput = false;
+
+// Called by the receiver drivers, usually from the serial receive interrupt.
+void rxFrameCompleted(uint32_t completedAt)
+{
+    frameCompletedAt = completedAt;
+}
+
+// The last completed frame is now in rcData.
+void rxFrameReceived(void)
+{
+    receivedFrameCompletedAt = frameCompletedAt;
+    receivedFrameWaitingForOutput = true;
+}
+
+// The motors were just updated, from the last received frame if there is one waiting.
+void rxFrameOutput(uint32_t pulseStartAt)
+{
+    if (!receivedFrameWaitingForOutput) {
+        return;
+    }
+    receivedFrameWaitingForOutput = false;
+
+    uint32_t latency = pulseStartAt - receivedFrameCompletedAt;
+
+    rxLatency.last = MIN(latency, UINT16_MAX);
+    rxLatency.max = MAX(rxLatency.max, rxLatency.last);
+}
@@ -0,0 +1,29 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+typedef struct rxLatency_s {
+    uint16_t last;      // microseconds from the last byte of a frame to the start of the motor pulses using it
+    uint16_t max;
+} rxLatency_t;
+
+extern rxLatency_t rxLatency;
+
+void rxFrameCompleted(uint32_t completedAt);
+void rxFrameReceived(void);
+void rxFrameOutput(uint32_t pulseStartAt);
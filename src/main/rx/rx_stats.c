@@ -0,0 +1,204 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rx/rx.h"
+#include "rx/rx_stats.h"
+
+/*
+ * Keeps the history of the frames a receiver delivers.
+ *
+ * The frame interval is learnt from the received frames, so a gap that spans several intervals counts as that many
+ * lost frames. Lost frames are also accounted while no frames arrive at all, so the link quality falls to 0 when the
+ * link is gone. Everything is O(1) per frame: the link quality is the number of good frames in a ring of the last
+ * RX_STATS_LINK_QUALITY_WINDOW frame slots, kept as a bitmap with a running count.
+ */
+
+#define INTERVAL_SMOOTHING_SHIFT 4
+#define JITTER_FIRST_BUCKET_SHIFT 5         // 32us
+
+rxStats_t rxStats;
+
+static uint32_t lastFrameAt;
+static bool frameSeen = false;
+static uint32_t slotsLostSinceLastFrame;    // already accounted by rxStatsUpdate()
+
+static uint32_t linkQualityWindow[(RX_STATS_LINK_QUALITY_WINDOW + 31) / 32];
+static uint8_t linkQualityIndex;
+static uint8_t linkQualityCount;
+
+static uint32_t secondStartedAt;
+static uint32_t framesReceivedAtSecondStart;
+static uint32_t framesLostAtSecondStart;
+
+void rxStatsReset(void)
+{
+    memset(&rxStats, 0, sizeof(rxStats));
+    memset(linkQualityWindow, 0, sizeof(linkQualityWindow));
+    linkQualityIndex = 0;
+    linkQualityCount = 0;
+    frameSeen = false;
+    slotsLostSinceLastFrame = 0;
+    framesReceivedAtSecondStart = 0;
+    framesLostAtSecondStart = 0;
+}
+
+static void recordSlot(bool good)
+{
+    uint32_t *word = &linkQualityWindow[linkQualityIndex / 32];
+    uint32_t bit = 1 << (linkQualityIndex % 32);
+
+    if (*word & bit) {
+        linkQualityCount--;
+    }
+    if (good) {
+        *word |= bit;
+        linkQualityCount++;
+    } else {
+        *word &= ~bit;
+    }
+
+    linkQualityIndex = (linkQualityIndex + 1) % RX_STATS_LINK_QUALITY_WINDOW;
+    rxStats.linkQuality = linkQualityCount * 100 / RX_STATS_LINK_QUALITY_WINDOW;
+}
+
+static void recordLostSlots(uint32_t count)
+{
+    rxStats.framesLost += count;
+
+    // older slots would be pushed out of the window again anyway
+    if (count > RX_STATS_LINK_QUALITY_WINDOW) {
+        count = RX_STATS_LINK_QUALITY_WINDOW;
+    }
+    while (count--) {
+        recordSlot(false);
+    }
+}
+
+// Frame slots that passed since the last frame, not counting one that may still be on its way.
+static uint32_t slotsLostSince(uint32_t elapsed)
+{
+    if (elapsed < rxStats.frameIntervalUs + rxStats.frameIntervalUs / 2) {
+        return 0;
+    }
+    return (elapsed - rxStats.frameIntervalUs / 2) / rxStats.frameIntervalUs;
+}
+
+static void recordJitter(uint32_t deviation)
+{
+    uint8_t bucket = 0;
+
+    deviation >>= JITTER_FIRST_BUCKET_SHIFT;
+    while (deviation && bucket < RX_STATS_JITTER_BUCKET_COUNT - 1) {
+        deviation >>= 1;
+        bucket++;
+    }
+
+    if (rxStats.jitterHistogram[bucket] == UINT16_MAX) {
+        // keep the shape of the histogram
+        for (uint8_t i = 0; i < RX_STATS_JITTER_BUCKET_COUNT; i++) {
+            rxStats.jitterHistogram[i] /= 2;
+        }
+    }
+    rxStats.jitterHistogram[bucket]++;
+}
+
+static void learnInterval(uint32_t interval, uint32_t lostSlots)
+{
+    if (interval > UINT16_MAX) {
+        return;
+    }
+
+    if (rxStats.frameIntervalUs == 0 || interval < rxStats.frameIntervalUs / 2 + rxStats.frameIntervalUs / 8) {
+        // first interval, or it spanned a lost frame and frames actually come twice as fast
+        rxStats.frameIntervalUs = interval;
+    } else if (lostSlots == 0) {
+        rxStats.frameIntervalUs += ((int32_t)interval - rxStats.frameIntervalUs) >> INTERVAL_SMOOTHING_SHIFT;
+    }
+}
+
+// Called with each frame the receiver delivers, frameStatus are the serialrxFrameState_t flags.
+void rxStatsFrameReceived(uint32_t completedAt, uint8_t frameStatus)
+{
+    rxStats.framesReceived++;
+
+    if (frameSeen) {
+        uint32_t interval = completedAt - lastFrameAt;
+        uint32_t lostSlots = 0;
+
+        if (rxStats.frameIntervalUs) {
+            lostSlots = slotsLostSince(interval);
+
+            int32_t deviation = interval - (lostSlots + 1) * rxStats.frameIntervalUs;
+            recordJitter(deviation < 0 ? -deviation : deviation);
+
+            if (lostSlots > slotsLostSinceLastFrame) {
+                recordLostSlots(lostSlots - slotsLostSinceLastFrame);
+            }
+        }
+
+        learnInterval(interval, lostSlots);
+    }
+
+    if (frameStatus & (SERIAL_RX_FRAME_FAILSAFE | SERIAL_RX_FRAME_DROPPED)) {
+        rxStats.signalLossFrames++;
+        recordSlot(false);
+    } else {
+        recordSlot(true);
+    }
+
+    lastFrameAt = completedAt;
+    frameSeen = true;
+    slotsLostSinceLastFrame = 0;
+}
+
+void rxStatsFramesRejected(uint8_t count)
+{
+    rxStats.crcErrors += count;
+}
+
+// Called regularly, also when no frames arrive. currentTime may be older than the last frame, which the receiver
+// could have completed since the caller read the time.
+void rxStatsUpdate(uint32_t currentTime)
+{
+    int32_t sinceLastFrame = currentTime - lastFrameAt;
+
+    if (frameSeen && rxStats.frameIntervalUs && sinceLastFrame > 0) {
+        uint32_t lostSlots = slotsLostSince(sinceLastFrame);
+        if (lostSlots > slotsLostSinceLastFrame) {
+            recordLostSlots(lostSlots - slotsLostSinceLastFrame);
+            slotsLostSinceLastFrame = lostSlots;
+        }
+    }
+
+    if (currentTime - secondStartedAt < 1000000) {
+        return;
+    }
+    secondStartedAt = currentTime;
+
+    uint32_t received = rxStats.framesReceived - framesReceivedAtSecondStart;
+    uint32_t lost = rxStats.framesLost - framesLostAtSecondStart;
+
+    rxStats.framesPerSecond = received;
+    rxStats.lostFramePercent = (received + lost) ? lost * 100 / (received + lost) : 0;
+
+    framesReceivedAtSecondStart = rxStats.framesReceived;
+    framesLostAtSecondStart = rxStats.framesLost;
+}
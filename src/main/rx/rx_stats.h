@@ -0,0 +1,40 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define RX_STATS_JITTER_BUCKET_COUNT 8      // < 32us, < 64us, ... < 2048us, >= 2048us
+#define RX_STATS_LINK_QUALITY_WINDOW 100    // frames
+
+typedef struct rxStats_s {
+    uint32_t framesReceived;
+    uint32_t framesLost;                    // frames that should have arrived in the gaps between received frames
+    uint32_t crcErrors;                     // frames that failed their CRC or framing check
+    uint32_t signalLossFrames;              // frames the receiver flagged as lost or failsafe
+    uint16_t framesPerSecond;
+    uint16_t frameIntervalUs;               // learnt from the received frames
+    uint8_t lostFramePercent;               // over the last second
+    uint8_t linkQuality;                    // percentage of good frames out of the last RX_STATS_LINK_QUALITY_WINDOW
+    uint16_t jitterHistogram[RX_STATS_JITTER_BUCKET_COUNT]; // deviation of each frame from the learnt interval
+} rxStats_t;
+
+extern rxStats_t rxStats;
+
+void rxStatsReset(void);
+void rxStatsFrameReceived(uint32_t completedAt, uint8_t frameStatus);
+void rxStatsFramesRejected(uint8_t count);
+void rxStatsUpdate(uint32_t currentTime);
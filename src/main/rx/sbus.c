@@ -25,14 +25,13 @@
 
 #include "drivers/system.h"
 
-#include "drivers/gpio.h"
 #include "drivers/inverter.h"
 
 #include "drivers/serial.h"
-#include "drivers/serial_uart.h"
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_frame.h"
 #include "rx/sbus.h"
 
 /*
@@ -47,7 +46,7 @@
  * time to send frame: 3ms.
  */
 
-#define SBUS_TIME_NEEDED_PER_FRAME 3000
+#define SBUS_FRAME_GAP_US 2000                  // at least 3ms between frames, bytes within a frame are 120us apart
 
 #ifndef CJMCU
 //#define DEBUG_SBUS_PACKETS
@@ -72,10 +71,18 @@ static uint16_t sbusStateFlags = 0;
 #define SBUS_DIGITAL_CHANNEL_MIN 173
 #define SBUS_DIGITAL_CHANNEL_MAX 1812
 
-static bool sbusFrameDone = false;
-static void sbusDataReceive(uint16_t c);
+static uint8_t sbusDecodeFrame(const uint8_t *frame, uint8_t length);
 static uint16_t sbusReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
 
+static const rxFrameProtocol_t sbusProtocol = {
+    .syncByte = SBUS_FRAME_BEGIN_BYTE,
+    .endByte = SBUS_FRAME_END_BYTE,
+    .length = SBUS_FRAME_SIZE,
+    .check = RX_FRAME_CHECK_NONE,
+    .frameGapUs = SBUS_FRAME_GAP_US,
+    .decode = sbusDecodeFrame
+};
+
 static uint32_t sbusChannelData[SBUS_MAX_CHANNEL];
 
 bool sbusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback)
@@ -87,12 +94,14 @@ bool sbusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRa
         *callback = sbusReadRawRC;
     rxRuntimeConfig->channelCount = SBUS_MAX_CHANNEL;
 
+    rxFrameInit(&sbusProtocol);
+
     serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
         return false;
     }
 
-    serialPort_t *sBusPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, sbusDataReceive, SBUS_BAUDRATE, (portMode_t)(MODE_RX | MODE_SBUS), SERIAL_INVERTED);
+    serialPort_t *sBusPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, rxFrameDataReceive, SBUS_BAUDRATE, (portMode_t)(MODE_RX | MODE_SBUS), SERIAL_INVERTED);
 
     return sBusPort != NULL;
 }
@@ -125,110 +134,67 @@ struct sbusFrame_s {
     uint8_t endByte;
 } __attribute__ ((__packed__));
 
-typedef union {
-    uint8_t bytes[SBUS_FRAME_SIZE];
-    struct sbusFrame_s frame;
-} sbusFrame_t;
-
-static sbusFrame_t sbusFrame;
-
-// Receive ISR callback
-static void sbusDataReceive(uint16_t c)
-{
-    static uint8_t sbusFramePosition = 0;
-    static uint32_t sbusFrameStartAt = 0;
-    uint32_t now = micros();
-
-    int32_t sbusFrameTime = now - sbusFrameStartAt;
-
-    if (sbusFrameTime > (long)(SBUS_TIME_NEEDED_PER_FRAME + 500)) {
-        sbusFramePosition = 0;
-    }
-
-    sbusFrame.bytes[sbusFramePosition] = (uint8_t)c;
-
-    if (sbusFramePosition == 0) {
-        if (c != SBUS_FRAME_BEGIN_BYTE) {
-            return;
-        }
-        sbusFrameStartAt = now;
-    }
-
-    sbusFramePosition++;
-
-    if (sbusFramePosition == SBUS_FRAME_SIZE) {
-        if (sbusFrame.frame.endByte == SBUS_FRAME_END_BYTE) {
-            sbusFrameDone = true;
-#ifdef DEBUG_SBUS_PACKETS
-            debug[2] = sbusFrameTime;
-#endif
-        }
-    } else {
-        sbusFrameDone = false;
-    }
-}
-
-uint8_t sbusFrameStatus(void)
+static uint8_t sbusDecodeFrame(const uint8_t *frame, uint8_t length)
 {
-    if (!sbusFrameDone) {
-        return SERIAL_RX_FRAME_PENDING;
-    }
-    sbusFrameDone = false;
+    UNUSED(length);
+    const struct sbusFrame_s *sbusFrame = (const struct sbusFrame_s *)frame;
+    uint8_t frameStatus = SERIAL_RX_FRAME_COMPLETE;
 
 #ifdef DEBUG_SBUS_PACKETS
     sbusStateFlags = 0;
-    debug[1] = sbusFrame.frame.flags;
+    debug[1] = sbusFrame->flags;
 #endif
 
-    sbusChannelData[0] = sbusFrame.frame.chan0;
-    sbusChannelData[1] = sbusFrame.frame.chan1;
-    sbusChannelData[2] = sbusFrame.frame.chan2;
-    sbusChannelData[3] = sbusFrame.frame.chan3;
-    sbusChannelData[4] = sbusFrame.frame.chan4;
-    sbusChannelData[5] = sbusFrame.frame.chan5;
-    sbusChannelData[6] = sbusFrame.frame.chan6;
-    sbusChannelData[7] = sbusFrame.frame.chan7;
-    sbusChannelData[8] = sbusFrame.frame.chan8;
-    sbusChannelData[9] = sbusFrame.frame.chan9;
-    sbusChannelData[10] = sbusFrame.frame.chan10;
-    sbusChannelData[11] = sbusFrame.frame.chan11;
-    sbusChannelData[12] = sbusFrame.frame.chan12;
-    sbusChannelData[13] = sbusFrame.frame.chan13;
-    sbusChannelData[14] = sbusFrame.frame.chan14;
-    sbusChannelData[15] = sbusFrame.frame.chan15;
-
-    if (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_17) {
+    sbusChannelData[0] = sbusFrame->chan0;
+    sbusChannelData[1] = sbusFrame->chan1;
+    sbusChannelData[2] = sbusFrame->chan2;
+    sbusChannelData[3] = sbusFrame->chan3;
+    sbusChannelData[4] = sbusFrame->chan4;
+    sbusChannelData[5] = sbusFrame->chan5;
+    sbusChannelData[6] = sbusFrame->chan6;
+    sbusChannelData[7] = sbusFrame->chan7;
+    sbusChannelData[8] = sbusFrame->chan8;
+    sbusChannelData[9] = sbusFrame->chan9;
+    sbusChannelData[10] = sbusFrame->chan10;
+    sbusChannelData[11] = sbusFrame->chan11;
+    sbusChannelData[12] = sbusFrame->chan12;
+    sbusChannelData[13] = sbusFrame->chan13;
+    sbusChannelData[14] = sbusFrame->chan14;
+    sbusChannelData[15] = sbusFrame->chan15;
+
+    if (sbusFrame->flags & SBUS_FLAG_CHANNEL_17) {
         sbusChannelData[16] = SBUS_DIGITAL_CHANNEL_MAX;
     } else {
         sbusChannelData[16] = SBUS_DIGITAL_CHANNEL_MIN;
     }
 
-    if (sbusFrame.frame.flags & SBUS_FLAG_CHANNEL_18) {
+    if (sbusFrame->flags & SBUS_FLAG_CHANNEL_18) {
         sbusChannelData[17] = SBUS_DIGITAL_CHANNEL_MAX;
     } else {
         sbusChannelData[17] = SBUS_DIGITAL_CHANNEL_MIN;
     }
 
-    if (sbusFrame.frame.flags & SBUS_FLAG_SIGNAL_LOSS) {
+    if (sbusFrame->flags & SBUS_FLAG_SIGNAL_LOSS) {
 #ifdef DEBUG_SBUS_PACKETS
         sbusStateFlags |= SBUS_STATE_SIGNALLOSS;
         debug[0] = sbusStateFlags;
 #endif
+        frameStatus |= SERIAL_RX_FRAME_DROPPED;
     }
-    if (sbusFrame.frame.flags & SBUS_FLAG_FAILSAFE_ACTIVE) {
+    if (sbusFrame->flags & SBUS_FLAG_FAILSAFE_ACTIVE) {
         // internal failsafe enabled and rx failsafe flag set
 #ifdef DEBUG_SBUS_PACKETS
         sbusStateFlags |= SBUS_STATE_FAILSAFE;
         debug[0] = sbusStateFlags;
 #endif
         // RX *should* still be sending valid channel data, so use it.
-        return SERIAL_RX_FRAME_COMPLETE | SERIAL_RX_FRAME_FAILSAFE;
+        return frameStatus | SERIAL_RX_FRAME_FAILSAFE;
     }
 
 #ifdef DEBUG_SBUS_PACKETS
     debug[0] = sbusStateFlags;
 #endif
-    return SERIAL_RX_FRAME_COMPLETE;
+    return frameStatus;
 }
 
 static uint16_t sbusReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
@@ -17,4 +17,6 @@
 
 #pragma once
 
-uint8_t sbusFrameStatus(void);
+#include "rx/rx.h"
+
+bool sbusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
@@ -21,18 +21,22 @@
 
 #include "platform.h"
 
-#include "drivers/gpio.h"
-#include "drivers/system.h"
+#include "build_config.h"
 
-#include "drivers/light_led.h"
+#include "drivers/system.h"
 
 #include "drivers/serial.h"
-#include "drivers/serial_uart.h"
 #include "io/serial.h"
 
+#ifdef SPEKTRUM_BIND
+#include "drivers/gpio.h"
+#include "drivers/light_led.h"
+
 #include "config/config.h"
+#endif
 
 #include "rx/rx.h"
+#include "rx/rx_frame.h"
 #include "rx/spektrum.h"
 
 // driver for spektrum satellite receiver / sbus
@@ -42,19 +46,27 @@
 #define SPEKTRUM_1024_CHANNEL_COUNT 7
 
 #define SPEK_FRAME_SIZE 16
+#define SPEK_FRAME_GAP_US 5000
 
 #define SPEKTRUM_BAUDRATE 115200
 
 static uint8_t spek_chan_shift;
 static uint8_t spek_chan_mask;
-static bool rcFrameComplete = false;
 static bool spekHiRes = false;
 
-static volatile uint8_t spekFrame[SPEK_FRAME_SIZE];
-
-static void spektrumDataReceive(uint16_t c);
+static uint8_t spektrumDecodeFrame(const uint8_t *frame, uint8_t length);
 static uint16_t spektrumReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
 
+// Spektrum frames carry neither a sync byte nor a checksum, only the inter-frame gap delimits them
+static const rxFrameProtocol_t spektrumProtocol = {
+    .syncByte = RX_FRAME_NO_SYNC_BYTE,
+    .endByte = RX_FRAME_NO_END_BYTE,
+    .length = SPEK_FRAME_SIZE,
+    .check = RX_FRAME_CHECK_NONE,
+    .frameGapUs = SPEK_FRAME_GAP_US,
+    .decode = spektrumDecodeFrame
+};
+
 static rxRuntimeConfig_t *rxRuntimeConfigPtr;
 
 bool spektrumInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback)
@@ -81,52 +93,29 @@ bool spektrumInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcRe
     if (callback)
         *callback = spektrumReadRawRC;
 
+    rxFrameInit(&spektrumProtocol);
+
     serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
         return false;
     }
 
-    serialPort_t *spektrumPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, spektrumDataReceive, SPEKTRUM_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
+    serialPort_t *spektrumPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, rxFrameDataReceive, SPEKTRUM_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
 
     return spektrumPort != NULL;
 }
 
-// Receive ISR callback
-static void spektrumDataReceive(uint16_t c)
-{
-    uint32_t spekTime;
-    static uint32_t spekTimeLast, spekTimeInterval;
-    static uint8_t spekFramePosition;
-
-    spekTime = micros();
-    spekTimeInterval = spekTime - spekTimeLast;
-    spekTimeLast = spekTime;
-    if (spekTimeInterval > 5000)
-        spekFramePosition = 0;
-    spekFrame[spekFramePosition] = (uint8_t)c;
-    if (spekFramePosition == SPEK_FRAME_SIZE - 1) {
-        rcFrameComplete = true;
-    } else {
-        spekFramePosition++;
-    }
-}
-
 static uint32_t spekChannelData[SPEKTRUM_MAX_SUPPORTED_CHANNEL_COUNT];
 
-uint8_t spektrumFrameStatus(void)
+static uint8_t spektrumDecodeFrame(const uint8_t *frame, uint8_t length)
 {
+    UNUSED(length);
     uint8_t b;
 
-    if (!rcFrameComplete) {
-        return SERIAL_RX_FRAME_PENDING;
-    }
-
-    rcFrameComplete = false;
-
     for (b = 3; b < SPEK_FRAME_SIZE; b += 2) {
-        uint8_t spekChannel = 0x0F & (spekFrame[b - 1] >> spek_chan_shift);
+        uint8_t spekChannel = 0x0F & (frame[b - 1] >> spek_chan_shift);
         if (spekChannel < rxRuntimeConfigPtr->channelCount && spekChannel < SPEKTRUM_MAX_SUPPORTED_CHANNEL_COUNT) {
-            spekChannelData[spekChannel] = ((uint32_t)(spekFrame[b - 1] & spek_chan_mask) << 8) + spekFrame[b];
+            spekChannelData[spekChannel] = ((uint32_t)(frame[b - 1] & spek_chan_mask) << 8) + frame[b];
         }
     }
 
@@ -23,13 +23,11 @@
 
 #include "build_config.h"
 
-#include "drivers/system.h"
-
 #include "drivers/serial.h"
-#include "drivers/serial_uart.h"
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_frame.h"
 #include "rx/sumd.h"
 
 // driver for SUMD receiver using UART2
@@ -40,14 +38,33 @@
 #define SUMD_MAX_CHANNEL 16
 #define SUMD_BUFFSIZE (SUMD_MAX_CHANNEL * 2 + 5) // 6 channels + 5 = 17 bytes for 6 channels
 
+#define SUMD_OFFSET_CHANNEL_COUNT 2
+#define SUMD_OFFSET_CHANNEL_1_HIGH 3
+#define SUMD_OFFSET_CHANNEL_1_LOW 4
+#define SUMD_BYTES_PER_CHANNEL 2
+
+#define SUMD_FRAME_GAP_US 4000
+
 #define SUMD_BAUDRATE 115200
 
-static bool sumdFrameDone = false;
 static uint32_t sumdChannels[SUMD_MAX_CHANNEL];
 
-static void sumdDataReceive(uint16_t c);
+static uint8_t sumdDecodeFrame(const uint8_t *frame, uint8_t length);
 static uint16_t sumdReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
 
+// sync byte, state, channel count, 2 bytes per channel and a CRC-16/CCITT over all of it
+static const rxFrameProtocol_t sumdProtocol = {
+    .syncByte = SUMD_SYNCBYTE,
+    .endByte = RX_FRAME_NO_END_BYTE,
+    .length = SUMD_BUFFSIZE,
+    .lengthOffset = SUMD_OFFSET_CHANNEL_COUNT,
+    .lengthMultiplier = SUMD_BYTES_PER_CHANNEL,
+    .lengthOverhead = 5,
+    .check = RX_FRAME_CHECK_CRC16_CCITT,
+    .frameGapUs = SUMD_FRAME_GAP_US,
+    .decode = sumdDecodeFrame
+};
+
 bool sumdInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback)
 {
     UNUSED(rxConfig);
@@ -57,70 +74,29 @@ bool sumdInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRa
 
     rxRuntimeConfig->channelCount = SUMD_MAX_CHANNEL;
 
+    rxFrameInit(&sumdProtocol);
+
     serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
         return false;
     }
 
-    serialPort_t *sumdPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, sumdDataReceive, SUMD_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
+    serialPort_t *sumdPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, rxFrameDataReceive, SUMD_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
 
     return sumdPort != NULL;
 }
 
-static uint8_t sumd[SUMD_BUFFSIZE] = { 0, };
-static uint8_t sumdChannelCount;
-
-// Receive ISR callback
-static void sumdDataReceive(uint16_t c)
-{
-    uint32_t sumdTime;
-    static uint32_t sumdTimeLast;
-    static uint8_t sumdIndex;
-
-    sumdTime = micros();
-    if ((sumdTime - sumdTimeLast) > 4000)
-        sumdIndex = 0;
-    sumdTimeLast = sumdTime;
-
-    if (sumdIndex == 0) {
-        if (c != SUMD_SYNCBYTE)
-            return;
-        else
-            sumdFrameDone = false; // lazy main loop didnt fetch the stuff
-    }
-    if (sumdIndex == 2)
-        sumdChannelCount = (uint8_t)c;
-    if (sumdIndex < SUMD_BUFFSIZE)
-        sumd[sumdIndex] = (uint8_t)c;
-    sumdIndex++;
-    if (sumdIndex == sumdChannelCount * 2 + 5) {
-        sumdIndex = 0;
-        sumdFrameDone = true;
-    }
-}
-
-#define SUMD_OFFSET_CHANNEL_1_HIGH 3
-#define SUMD_OFFSET_CHANNEL_1_LOW 4
-#define SUMD_BYTES_PER_CHANNEL 2
-
-
 #define SUMD_FRAME_STATE_OK 0x01
 #define SUMD_FRAME_STATE_FAILSAFE 0x81
 
-uint8_t sumdFrameStatus(void)
+static uint8_t sumdDecodeFrame(const uint8_t *frame, uint8_t length)
 {
+    UNUSED(length);
     uint8_t channelIndex;
+    uint8_t channelCount = frame[SUMD_OFFSET_CHANNEL_COUNT];
+    uint8_t frameStatus;
 
-    uint8_t frameStatus = SERIAL_RX_FRAME_PENDING;
-
-    if (!sumdFrameDone) {
-        return frameStatus;
-    }
-
-    sumdFrameDone = false;
-
-
-    switch (sumd[1]) {
+    switch (frame[1]) {
         case SUMD_FRAME_STATE_FAILSAFE:
             frameStatus = SERIAL_RX_FRAME_COMPLETE | SERIAL_RX_FRAME_FAILSAFE;
             break;
@@ -128,16 +104,13 @@ uint8_t sumdFrameStatus(void)
             frameStatus = SERIAL_RX_FRAME_COMPLETE;
             break;
         default:
-            return frameStatus;
+            return SERIAL_RX_FRAME_PENDING;
     }
 
-    if (sumdChannelCount > SUMD_MAX_CHANNEL)
-        sumdChannelCount = SUMD_MAX_CHANNEL;
-
-    for (channelIndex = 0; channelIndex < sumdChannelCount; channelIndex++) {
+    for (channelIndex = 0; channelIndex < channelCount; channelIndex++) {
         sumdChannels[channelIndex] = (
-            (sumd[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_HIGH] << 8) |
-            sumd[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_LOW]
+            (frame[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_HIGH] << 8) |
+            frame[SUMD_BYTES_PER_CHANNEL * channelIndex + SUMD_OFFSET_CHANNEL_1_LOW]
         );
     }
     return frameStatus;
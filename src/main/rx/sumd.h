@@ -17,4 +17,6 @@
 
 #pragma once
 
-uint8_t sumdFrameStatus(void);
+#include "rx/rx.h"
+
+bool sumdInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
@@ -23,13 +23,11 @@
 
 #include "build_config.h"
 
-#include "drivers/system.h"
-
 #include "drivers/serial.h"
-#include "drivers/serial_uart.h"
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_frame.h"
 #include "rx/sumh.h"
 
 // driver for SUMH receiver using UART2
@@ -38,22 +36,24 @@
 
 #define SUMH_MAX_CHANNEL_COUNT 8
 #define SUMH_FRAME_SIZE 21
+#define SUMH_SYNC_BYTE 0xA8
+#define SUMH_FRAME_GAP_US 5000
 
-static bool sumhFrameDone = false;
-
-static uint8_t sumhFrame[SUMH_FRAME_SIZE];
 static uint32_t sumhChannels[SUMH_MAX_CHANNEL_COUNT];
 
-static void sumhDataReceive(uint16_t c);
-static uint16_t sumhReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
-
-static serialPort_t *sumhPort;
-
-
-static void sumhDataReceive(uint16_t c);
+static uint8_t sumhDecodeFrame(const uint8_t *frame, uint8_t length);
 static uint16_t sumhReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
 
+static const rxFrameProtocol_t sumhProtocol = {
+    .syncByte = SUMH_SYNC_BYTE,
+    .endByte = RX_FRAME_NO_END_BYTE,
+    .length = SUMH_FRAME_SIZE,
+    .check = RX_FRAME_CHECK_NONE,
+    .frameGapUs = SUMH_FRAME_GAP_US,
+    .decode = sumhDecodeFrame
+};
 
+static serialPort_t *sumhPort;
 
 bool sumhInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback)
 {
@@ -64,57 +64,32 @@ bool sumhInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRa
 
     rxRuntimeConfig->channelCount = SUMH_MAX_CHANNEL_COUNT;
 
+    rxFrameInit(&sumhProtocol);
+
     serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
         return false;
     }
 
-    sumhPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, sumhDataReceive, SUMH_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
+    sumhPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, rxFrameDataReceive, SUMH_BAUDRATE, MODE_RX, SERIAL_NOT_INVERTED);
 
     return sumhPort != NULL;
 }
 
-// Receive ISR callback
-static void sumhDataReceive(uint16_t c)
-{
-    uint32_t sumhTime;
-    static uint32_t sumhTimeLast, sumhTimeInterval;
-    static uint8_t sumhFramePosition;
-
-    sumhTime = micros();
-    sumhTimeInterval = sumhTime - sumhTimeLast;
-    sumhTimeLast = sumhTime;
-    if (sumhTimeInterval > 5000) {
-        sumhFramePosition = 0;
-    }
-
-    sumhFrame[sumhFramePosition] = (uint8_t) c;
-    if (sumhFramePosition == SUMH_FRAME_SIZE - 1) {
-        // FIXME at this point the value of 'c' is unused and un tested, what should it be, is it important?
-        sumhFrameDone = true;
-    } else {
-        sumhFramePosition++;
-    }
-}
-
-uint8_t sumhFrameStatus(void)
+static uint8_t sumhDecodeFrame(const uint8_t *frame, uint8_t length)
 {
+    UNUSED(length);
     uint8_t channelIndex;
 
-    if (!sumhFrameDone) {
-        return SERIAL_RX_FRAME_PENDING;
-    }
-
-    sumhFrameDone = false;
-
-    if (!((sumhFrame[0] == 0xA8) && (sumhFrame[SUMH_FRAME_SIZE - 2] == 0))) {
+    // FIXME the last byte is unused and untested, what should it be, is it important?
+    if (frame[SUMH_FRAME_SIZE - 2] != 0) {
         return SERIAL_RX_FRAME_PENDING;
     }
 
     for (channelIndex = 0; channelIndex < SUMH_MAX_CHANNEL_COUNT; channelIndex++) {
 
-        sumhChannels[channelIndex] = (((uint32_t)(sumhFrame[(channelIndex << 1) + 3]) << 8)
-                + sumhFrame[(channelIndex << 1) + 4]) / 6.4 - 375;
+        sumhChannels[channelIndex] = (((uint32_t)(frame[(channelIndex << 1) + 3]) << 8)
+                + frame[(channelIndex << 1) + 4]) / 6.4 - 375;
     }
     return SERIAL_RX_FRAME_COMPLETE;
 }
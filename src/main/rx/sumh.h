@@ -17,4 +17,6 @@
 
 #pragma once
 
-uint8_t sumhFrameStatus(void);
+#include "rx/rx.h"
+
+bool sumhInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
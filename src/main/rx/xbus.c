@@ -21,13 +21,15 @@
 
 #include "platform.h"
 
-#include "drivers/system.h"
+#include "build_config.h"
+
+#include "common/crc.h"
 
 #include "drivers/serial.h"
-#include "drivers/serial_uart.h"
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_frame.h"
 #include "rx/xbus.h"
 
 //
@@ -44,9 +46,6 @@
 #define XBUS_RJ01_MESSAGE_LENGTH 30
 #define XBUS_RJ01_OFFSET_BYTES 3
 
-#define XBUS_CRC_AND_VALUE 0x8000
-#define XBUS_CRC_POLY 0x1021
-
 #define XBUS_BAUDRATE 115200
 #define XBUS_RJ01_BAUDRATE 250000
 #define XBUS_MAX_FRAME_TIME 8000
@@ -69,21 +68,34 @@
 // Use formula: 800 + value * 1400 / 4096 (i.e. a shift by 12)
 #define XBUS_CONVERT_TO_USEC(V)	(800 + ((V * 1400) >> 12))
 
-static bool xBusFrameReceived = false;
-static bool xBusDataIncoming = false;
-static uint8_t xBusFramePosition;
-static uint8_t xBusFrameLength;
 static uint8_t xBusChannelCount;
-static uint8_t xBusProvider;
-
 
-// Use max values for ram areas
-static volatile uint8_t xBusFrame[XBUS_RJ01_FRAME_SIZE];
 static uint16_t xBusChannelData[XBUS_RJ01_CHANNEL_COUNT];
 
-static void xBusDataReceive(uint16_t c);
+static uint8_t xBusDecodeModeBFrame(const uint8_t *frame, uint8_t length);
+static uint8_t xBusDecodeRJ01Frame(const uint8_t *frame, uint8_t length);
 static uint16_t xBusReadRawRC(rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan);
 
+// The mode B CRC is a CRC-16/CCITT over the whole frame
+static const rxFrameProtocol_t xBusModeBProtocol = {
+    .syncByte = XBUS_START_OF_FRAME_BYTE,
+    .endByte = RX_FRAME_NO_END_BYTE,
+    .length = XBUS_FRAME_SIZE,
+    .check = RX_FRAME_CHECK_CRC16_CCITT,
+    .frameGapUs = XBUS_MAX_FRAME_TIME,
+    .decode = xBusDecodeModeBFrame
+};
+
+// The last byte of an RJ01 message is a Dallas One-Wire CRC8 over the whole message
+static const rxFrameProtocol_t xBusRJ01Protocol = {
+    .syncByte = XBUS_START_OF_FRAME_BYTE,
+    .endByte = RX_FRAME_NO_END_BYTE,
+    .length = XBUS_RJ01_FRAME_SIZE,
+    .check = RX_FRAME_CHECK_CRC8_DALLAS,
+    .frameGapUs = XBUS_MAX_FRAME_TIME,
+    .decode = xBusDecodeRJ01Frame
+};
+
 bool xBusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback)
 {
     uint32_t baudRate;
@@ -91,23 +103,15 @@ bool xBusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRa
     switch (rxConfig->serialrx_provider) {
         case SERIALRX_XBUS_MODE_B:
             rxRuntimeConfig->channelCount = XBUS_CHANNEL_COUNT;
-            xBusFrameReceived = false;
-            xBusDataIncoming = false;
-            xBusFramePosition = 0;
             baudRate = XBUS_BAUDRATE;
-            xBusFrameLength = XBUS_FRAME_SIZE;
             xBusChannelCount = XBUS_CHANNEL_COUNT;
-            xBusProvider = SERIALRX_XBUS_MODE_B;
+            rxFrameInit(&xBusModeBProtocol);
             break;
         case SERIALRX_XBUS_MODE_B_RJ01:
             rxRuntimeConfig->channelCount = XBUS_RJ01_CHANNEL_COUNT;
-            xBusFrameReceived = false;
-            xBusDataIncoming = false;
-            xBusFramePosition = 0;
             baudRate = XBUS_RJ01_BAUDRATE;
-            xBusFrameLength = XBUS_RJ01_FRAME_SIZE;
             xBusChannelCount = XBUS_RJ01_CHANNEL_COUNT;
-            xBusProvider = SERIALRX_XBUS_MODE_B_RJ01;
+            rxFrameInit(&xBusRJ01Protocol);
             break;
         default:
             return false;
@@ -123,94 +127,42 @@ bool xBusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRa
         return false;
     }
 
-    serialPort_t *xBusPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, xBusDataReceive, baudRate, MODE_RX, SERIAL_NOT_INVERTED);
+    serialPort_t *xBusPort = openSerialPort(portConfig->identifier, FUNCTION_RX_SERIAL, rxFrameDataReceive, baudRate, MODE_RX, SERIAL_NOT_INVERTED);
 
     return xBusPort != NULL;
 }
 
-// The xbus mode B CRC calculations
-static uint16_t xBusCRC16(uint16_t crc, uint8_t value)
+static void xBusUnpackModeBFrame(const uint8_t *frame)
 {
     uint8_t i;
-    
-    crc = crc ^ (int16_t)value << 8;
-
-    for (i = 0; i < 8; i++) {
-        if (crc & XBUS_CRC_AND_VALUE) {
-            crc = crc << 1 ^ XBUS_CRC_POLY;
-        } else {
-            crc = crc << 1;
-        }
-    }
-    return crc;
-}
-
-// Full RJ01 message CRC calculations
-uint8_t xBusRj01CRC8(uint8_t inData, uint8_t seed)
-{
-    uint8_t bitsLeft;
-    uint8_t temp;
+    uint16_t value;
+    uint8_t frameAddr;
 
-    for (bitsLeft = 8; bitsLeft > 0; bitsLeft--) {
-        temp = ((seed ^ inData) & 0x01);
+    for (i = 0; i < xBusChannelCount; i++) {
 
-        if (temp == 0) {
-            seed >>= 1;
-        } else {
-            seed ^= 0x18;
-            seed >>= 1;
-            seed |= 0x80;
-        }
+        frameAddr = 1 + i * 2;
+        value = ((uint16_t)frame[frameAddr]) << 8;
+        value = value + ((uint16_t)frame[frameAddr + 1]);
 
-        inData >>= 1;
+        // Convert to internal format
+        xBusChannelData[i] = XBUS_CONVERT_TO_USEC(value);
     }
-
-    return seed;    
 }
 
-
-static void xBusUnpackModeBFrame(uint8_t offsetBytes)
+static uint8_t xBusDecodeModeBFrame(const uint8_t *frame, uint8_t length)
 {
-    // Calculate the CRC of the incoming frame
-    uint16_t crc = 0;
-    uint16_t inCrc = 0;
-    uint8_t i = 0;
-    uint16_t value;
-    uint8_t frameAddr;
-
-    // Calculate on all bytes except the final two CRC bytes
-    for (i = 0; i < XBUS_FRAME_SIZE - 2; i++) {
-        inCrc = xBusCRC16(inCrc, xBusFrame[i+offsetBytes]);
-    }
-
-    // Get the received CRC
-    crc = ((uint16_t)xBusFrame[offsetBytes + XBUS_FRAME_SIZE - 2]) << 8;
-    crc = crc + ((uint16_t)xBusFrame[offsetBytes + XBUS_FRAME_SIZE - 1]);
-
-    if (crc == inCrc) {
-        // Unpack the data, we have a valid frame
-        for (i = 0; i < xBusChannelCount; i++) {
-
-            frameAddr = offsetBytes + 1 + i * 2;
-            value = ((uint16_t)xBusFrame[frameAddr]) << 8;
-            value = value + ((uint16_t)xBusFrame[frameAddr + 1]);
+    UNUSED(length);
 
-            // Convert to internal format
-            xBusChannelData[i] = XBUS_CONVERT_TO_USEC(value);
-        }
-
-        xBusFrameReceived = true;
-    }
+    xBusUnpackModeBFrame(frame);
 
+    return SERIAL_RX_FRAME_COMPLETE;
 }
 
-static void xBusUnpackRJ01Frame(void)
+static uint8_t xBusDecodeRJ01Frame(const uint8_t *frame, uint8_t length)
 {
-    // Calculate the CRC of the incoming frame
-    uint8_t outerCrc = 0;
-    uint8_t i = 0;
+    UNUSED(length);
 
-    // When using the Align RJ01 receiver with 
+    // When using the Align RJ01 receiver with
     // a MODE B setting in the radio (XG14 tested)
     // the MODE_B -frame is packed within some
     // at the moment unknown bytes before and after:
@@ -218,87 +170,21 @@ static void xBusUnpackRJ01Frame(void)
     // Compared to a standard MODE B frame that only
     // contains the "middle" package.
     // Hence, at the moment, the unknown header and footer
-    // of the RJ01 MODEB packages are discarded. 
-    // However, the LAST byte (CRC_OUTER) is infact an 8-bit
-    // CRC for the whole package, using the Dallas-One-Wire CRC
-    // method.
-    // So, we check both these values as well as the provided length
-    // of the outer/full message (LEN)
-    
-    //
-    // Check we have correct length of message
-    //
-    if (xBusFrame[1] != XBUS_RJ01_MESSAGE_LENGTH)
-    {
-        // Unknown package as length is not ok
-        return;
-    }
-    
-    //
-    // CRC calculation & check for full message
-    //
-    for (i = 0; i < xBusFrameLength - 1; i++) {
-        outerCrc = xBusRj01CRC8(outerCrc, xBusFrame[i]);
-    }
-    
-    if (outerCrc != xBusFrame[xBusFrameLength - 1])
-    {
-        // CRC does not match, skip this frame
-        return;
-    }
-
-    // Now unpack the "embedded MODE B frame"
-    xBusUnpackModeBFrame(XBUS_RJ01_OFFSET_BYTES);
-}
+    // of the RJ01 MODEB packages are discarded.
+    // The outer CRC has already been checked, so we check
+    // the provided length of the outer/full message (LEN)
+    // and the CRC of the embedded MODE B frame.
 
-// Receive ISR callback
-static void xBusDataReceive(uint16_t c)
-{
-    uint32_t now;
-    static uint32_t xBusTimeLast, xBusTimeInterval;
-
-    // Check if we shall reset frame position due to time
-    now = micros();
-    xBusTimeInterval = now - xBusTimeLast;
-    xBusTimeLast = now;
-    if (xBusTimeInterval > XBUS_MAX_FRAME_TIME) {
-        xBusFramePosition = 0;
-        xBusDataIncoming = false;
-    }
-    
-    // Check if we shall start a frame?
-    if ((xBusFramePosition == 0) && (c == XBUS_START_OF_FRAME_BYTE)) {
-        xBusDataIncoming = true;
-    }
-
-    // Only do this if we are receiving to a frame
-    if (xBusDataIncoming == true) {
-        // Store in frame copy
-        xBusFrame[xBusFramePosition] = (uint8_t)c;
-        xBusFramePosition++;
-    }
-    
-    // Done?
-    if (xBusFramePosition == xBusFrameLength) {
-        switch (xBusProvider) {
-            case SERIALRX_XBUS_MODE_B:
-                xBusUnpackModeBFrame(0);
-            case SERIALRX_XBUS_MODE_B_RJ01:
-                xBusUnpackRJ01Frame();
-        }
-        xBusDataIncoming = false;
-        xBusFramePosition = 0;
+    if (frame[1] != XBUS_RJ01_MESSAGE_LENGTH) {
+        // Unknown package as length is not ok
+        return SERIAL_RX_FRAME_PENDING;
     }
-}
 
-// Indicate time to read a frame from the data...
-uint8_t xBusFrameStatus(void)
-{
-    if (!xBusFrameReceived) {
+    if (crc16CcittUpdate(0, frame + XBUS_RJ01_OFFSET_BYTES, XBUS_FRAME_SIZE) != 0) {
         return SERIAL_RX_FRAME_PENDING;
     }
 
-    xBusFrameReceived = false;
+    xBusUnpackModeBFrame(frame + XBUS_RJ01_OFFSET_BYTES);
 
     return SERIAL_RX_FRAME_COMPLETE;
 }
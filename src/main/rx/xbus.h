@@ -20,4 +20,3 @@
 #include "rx/rx.h"
 
 bool xBusInit(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
-uint8_t xBusFrameStatus(void);
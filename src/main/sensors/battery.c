@@ -23,7 +23,6 @@
 #include "config/runtime_config.h"
 
 #include "drivers/adc.h"
-#include "drivers/system.h"
 
 #include "rx/rx.h"
 #include "io/rc_controls.h"
@@ -37,6 +36,7 @@ uint16_t batteryCriticalVoltage;
 
 uint8_t vbat = 0;                   // battery voltage in 0.1V steps
 uint16_t vbatLatestADC = 0;         // most recent unsmoothed raw reading from vbat ADC
+uint16_t batteryCellVoltage = 0;    // estimated cell voltage without sag in 0.01V steps
 uint16_t amperageLatestADC = 0;     // most recent raw reading from current ADC
 
 int32_t amperage = 0;               // amperage read by current sensor in centiampere (1/100th A)
@@ -51,31 +51,68 @@ uint16_t batteryAdcToVoltage(uint16_t src)
     return ((uint32_t)src * batteryConfig->vbatscale * 33 + (0xFFF * 5)) / (0xFFF * 10);
 }
 
-#define BATTERY_SAMPLE_COUNT 8
+static uint16_t batteryAdcToCentivolts(uint16_t src)
+{
+    // same as batteryAdcToVoltage() with 0.01V steps
+    return ((uint32_t)src * batteryConfig->vbatscale * 330 + (0xFFF * 5)) / (0xFFF * 10);
+}
 
-void updateBatteryVoltage(void)
+// Readings are low pass filtered with a time constant of 2^BATTERY_FILTER_SHIFT updates (160ms at 50Hz),
+// the filter keeps BATTERY_FILTER_FRACTION_BITS more bits than the readings.
+#define BATTERY_FILTER_SHIFT 3
+#define BATTERY_FILTER_FRACTION_BITS 4
+
+static int32_t batteryFilterApply(int32_t state, uint16_t reading)
 {
-    static uint16_t vbatSamples[BATTERY_SAMPLE_COUNT];
-    static uint8_t currentSampleIndex = 0;
-    uint8_t index;
-    uint16_t vbatSampleTotal = 0;
+    int32_t input = (int32_t)reading << BATTERY_FILTER_FRACTION_BITS;
+    return state + ((input - state + (1 << (BATTERY_FILTER_SHIFT - 1))) >> BATTERY_FILTER_SHIFT);
+}
 
-    // store the battery voltage with some other recent battery voltage readings
-    vbatSamples[(currentSampleIndex++) % BATTERY_SAMPLE_COUNT] = vbatLatestADC = adcGetChannel(ADC_BATTERY);
+static uint16_t batteryFilterOutput(int32_t state)
+{
+    return (state + (1 << (BATTERY_FILTER_FRACTION_BITS - 1))) >> BATTERY_FILTER_FRACTION_BITS;
+}
+
+static int32_t vbatFilterState = -1;    // negative until seeded with the first reading
+static int32_t amperageFilterState = 0;
+
+// 1mAh = 3.6As = 360000000 * 0.01A * 1us
+#define CENTIAMP_MICROSECONDS_PER_MAH (3600LL * 100 * 1000)
 
-    // calculate vbat based on the average of recent readings
-    for (index = 0; index < BATTERY_SAMPLE_COUNT; index++) {
-        vbatSampleTotal += vbatSamples[index];
+static int64_t mAhDrawnRaw = 0;         // in 0.01A * 1us
+
+static void updateBatteryCellVoltage(void)
+{
+    uint16_t filteredCentivolts = batteryFilterOutput(vbatFilterState);
+
+    // the pack's internal resistance drops the voltage under load, add it back to estimate the voltage at rest
+    int32_t sagCentivolts = MAX(amperage, 0) * batteryConfig->batteryResistance / 1000; // 0.01A * 1mOhm = 0.00001V
+    batteryCellVoltage = (filteredCentivolts + sagCentivolts) / batteryCellCount;
+}
+
+void updateBatteryVoltage(void)
+{
+    vbatLatestADC = adcGetChannel(ADC_BATTERY);
+
+    uint16_t centivolts = batteryAdcToCentivolts(vbatLatestADC);
+    if (vbatFilterState < 0) {
+        vbatFilterState = (int32_t)centivolts << BATTERY_FILTER_FRACTION_BITS;
+    } else {
+        vbatFilterState = batteryFilterApply(vbatFilterState, centivolts);
     }
-    vbat = batteryAdcToVoltage(vbatSampleTotal / BATTERY_SAMPLE_COUNT);
+
+    vbat = (batteryFilterOutput(vbatFilterState) + 5) / 10;
+
+    updateBatteryCellVoltage();
 }
 
 batteryState_e calculateBatteryState(void)
 {
-    if (vbat <= batteryCriticalVoltage) {
+    // thresholds are per cell in 0.1V steps, the cell voltage is compensated for sag
+    if (batteryCellVoltage <= batteryConfig->vbatmincellvoltage * 10) {
         return BATTERY_CRITICAL;
     }
-    if (vbat <= batteryWarningVoltage) {
+    if (batteryCellVoltage <= batteryConfig->vbatwarningcellvoltage * 10) {
         return BATTERY_WARNING;
     }
     return BATTERY_OK;
@@ -85,12 +122,14 @@ void batteryInit(batteryConfig_t *initialBatteryConfig)
 {
     batteryConfig = initialBatteryConfig;
 
-    uint32_t i;
+    amperageFilterState = 0;
+    mAhDrawnRaw = 0;
+    amperage = 0;
+    mAhDrawn = 0;
 
-    for (i = 0; i < BATTERY_SAMPLE_COUNT; i++) {
-        updateBatteryVoltage();
-        delay((32 / BATTERY_SAMPLE_COUNT) * 10);
-    }
+    // the ADC readings are already averaged, one is enough to start the filter
+    vbatFilterState = -1;
+    updateBatteryVoltage();
 
     unsigned cells = (vbat / batteryConfig->vbatmaxcellvoltage) + 1;
     if(cells > 8)            // something is wrong, we expect 8 cells maximum (and autodetection will be problematic at 6+ cells)
@@ -98,6 +137,8 @@ void batteryInit(batteryConfig_t *initialBatteryConfig)
     batteryCellCount = cells;
     batteryWarningVoltage = batteryCellCount * batteryConfig->vbatwarningcellvoltage;
     batteryCriticalVoltage = batteryCellCount * batteryConfig->vbatmincellvoltage;
+
+    updateBatteryCellVoltage();
 }
 
 #define ADCVREF 3300   // in mV
@@ -113,16 +154,14 @@ int32_t currentSensorToCentiamps(uint16_t src)
 
 void updateCurrentMeter(int32_t lastUpdateAt)
 {
-    static int32_t amperageRaw = 0;
-    static int64_t mAhdrawnRaw = 0;
     int32_t throttleOffset = (int32_t)rcCommand[THROTTLE] - 1000;
     int32_t throttleFactor = 0;
 
     switch(batteryConfig->currentMeterType) {
         case CURRENT_SENSOR_ADC:
-            amperageRaw -= amperageRaw / 8;
-            amperageRaw += (amperageLatestADC = adcGetChannel(ADC_CURRENT));
-            amperage = currentSensorToCentiamps(amperageRaw / 8);
+            amperageLatestADC = adcGetChannel(ADC_CURRENT);
+            amperageFilterState = batteryFilterApply(amperageFilterState, amperageLatestADC);
+            amperage = currentSensorToCentiamps(batteryFilterOutput(amperageFilterState));
             break;
         case CURRENT_SENSOR_VIRTUAL:
             amperage = (int32_t)batteryConfig->currentMeterOffset;
@@ -136,8 +175,9 @@ void updateCurrentMeter(int32_t lastUpdateAt)
             break;
     }
 
-    mAhdrawnRaw += (amperage * lastUpdateAt) / 1000;
-    mAhDrawn = mAhdrawnRaw / (3600 * 100);
+    // integrate without dividing each step so nothing is lost to rounding between updates
+    mAhDrawnRaw += (int64_t)amperage * lastUpdateAt;
+    mAhDrawn = mAhDrawnRaw / CENTIAMP_MICROSECONDS_PER_MAH;
 }
 
 uint8_t calculateBatteryPercentage(void)
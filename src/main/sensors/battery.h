@@ -21,6 +21,8 @@
 #define VBAT_SCALE_MIN 0
 #define VBAT_SCALE_MAX 255
 
+#define BATTERY_UPDATE_INTERVAL_US (1000000 / 50)
+
 typedef enum {
     CURRENT_SENSOR_NONE = 0,
     CURRENT_SENSOR_ADC,
@@ -40,6 +42,7 @@ typedef struct batteryConfig_s {
 
     // FIXME this doesn't belong in here since it's a concern of MSP, not of the battery code.
     uint8_t multiwiiCurrentMeterOutput;     // if set to 1 output the amperage in milliamp steps instead of 0.01A steps via msp
+    uint8_t batteryResistance;              // internal resistance of the whole pack in milliohm, used to estimate the cell voltage without sag under load
     uint16_t batteryCapacity;               // mAh
 } batteryConfig_t;
 
@@ -53,6 +56,7 @@ extern uint8_t vbat;
 extern uint16_t vbatLatestADC;
 extern uint8_t batteryCellCount;
 extern uint16_t batteryWarningVoltage;
+extern uint16_t batteryCellVoltage;
 extern uint16_t amperageLatestADC;
 extern int32_t amperage;
 extern int32_t mAhDrawn;
@@ -18,7 +18,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <math.h>
-#include <string.h>
 
 #include "common/maths.h"
 #include "common/axis.h"
@@ -27,26 +26,33 @@
 
 #include "boardalignment.h"
 
-static bool standardBoardAlignment = true;     // board orientation correction
-static float boardRotation[3][3];              // matrix
+// dest = sensorRotations[rotation] * src, for each sensor_align_e
+static const int8_t sensorRotations[CW270_DEG_FLIP + 1][3][3] = {
+    [ALIGN_DEFAULT]  = { {  1,  0,  0 }, {  0,  1,  0 }, {  0,  0,  1 } },
+    [CW0_DEG]        = { {  1,  0,  0 }, {  0,  1,  0 }, {  0,  0,  1 } },
+    [CW90_DEG]       = { {  0,  1,  0 }, { -1,  0,  0 }, {  0,  0,  1 } },
+    [CW180_DEG]      = { { -1,  0,  0 }, {  0, -1,  0 }, {  0,  0,  1 } },
+    [CW270_DEG]      = { {  0, -1,  0 }, {  1,  0,  0 }, {  0,  0,  1 } },
+    [CW0_DEG_FLIP]   = { { -1,  0,  0 }, {  0,  1,  0 }, {  0,  0, -1 } },
+    [CW90_DEG_FLIP]  = { {  0,  1,  0 }, {  1,  0,  0 }, {  0,  0, -1 } },
+    [CW180_DEG_FLIP] = { {  1,  0,  0 }, {  0, -1,  0 }, {  0,  0, -1 } },
+    [CW270_DEG_FLIP] = { {  0, -1,  0 }, { -1,  0,  0 }, {  0,  0, -1 } },
+};
+
+// sensor rotation followed by the board rotation, one matrix per sensor_align_e, BOARD_ALIGNMENT_FRACTION_BITS
+static int16_t alignmentMatrix[CW270_DEG_FLIP + 1][3][3];
 
 static bool isBoardAlignmentStandard(boardAlignment_t *boardAlignment)
 {
     return !boardAlignment->rollDegrees && !boardAlignment->pitchDegrees && !boardAlignment->yawDegrees;
 }
 
-void initBoardAlignment(boardAlignment_t *boardAlignment)
+static void calculateBoardRotation(boardAlignment_t *boardAlignment, float boardRotation[3][3])
 {
     float roll, pitch, yaw;
     float cosx, sinx, cosy, siny, cosz, sinz;
     float coszcosx, coszcosy, sinzcosx, coszsinx, sinzsinx;
 
-    if (isBoardAlignmentStandard(boardAlignment)) {
-        return;
-    }
-
-    standardBoardAlignment = false;
-
     roll = degreesToRadians(boardAlignment->rollDegrees);
     pitch = degreesToRadians(boardAlignment->pitchDegrees);
     yaw = degreesToRadians(boardAlignment->yawDegrees);
@@ -78,67 +84,45 @@ void initBoardAlignment(boardAlignment_t *boardAlignment)
     boardRotation[2][2] = cosy * cosx;
 }
 
-static void alignBoard(int16_t *vec)
+/*
+ * The board rotation is applied transposed, i.e. vec[X] = boardRotation[0][0] * x + boardRotation[1][0] * y + ...
+ * so each fused matrix is transpose(boardRotation) * sensorRotations[rotation].
+ */
+void initBoardAlignment(boardAlignment_t *boardAlignment)
 {
-    int16_t x = vec[X];
-    int16_t y = vec[Y];
-    int16_t z = vec[Z];
+    float boardRotation[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    uint8_t rotation;
+    uint8_t row, column, k;
 
-    vec[X] = lrintf(boardRotation[0][0] * x + boardRotation[1][0] * y + boardRotation[2][0] * z);
-    vec[Y] = lrintf(boardRotation[0][1] * x + boardRotation[1][1] * y + boardRotation[2][1] * z);
-    vec[Z] = lrintf(boardRotation[0][2] * x + boardRotation[1][2] * y + boardRotation[2][2] * z);
+    if (!isBoardAlignmentStandard(boardAlignment)) {
+        calculateBoardRotation(boardAlignment, boardRotation);
+    }
+
+    for (rotation = 0; rotation <= CW270_DEG_FLIP; rotation++) {
+        for (row = 0; row < 3; row++) {
+            for (column = 0; column < 3; column++) {
+                float element = 0;
+                for (k = 0; k < 3; k++) {
+                    element += boardRotation[k][row] * sensorRotations[rotation][k][column];
+                }
+                alignmentMatrix[rotation][row][column] = lrintf(element * (1 << BOARD_ALIGNMENT_FRACTION_BITS));
+            }
+        }
+    }
 }
 
+/*
+ * rotation must be a sensor_align_e, reconfigureAlignment() only accepts those.
+ */
 void alignSensors(int16_t *src, int16_t *dest, uint8_t rotation)
 {
-    static uint16_t swap[3];
-    memcpy(swap, src, sizeof(swap));
-
-    switch (rotation) {
-        case CW0_DEG:
-            dest[X] = swap[X];
-            dest[Y] = swap[Y];
-            dest[Z] = swap[Z];
-            break;
-        case CW90_DEG:
-            dest[X] = swap[Y];
-            dest[Y] = -swap[X];
-            dest[Z] = swap[Z];
-            break;
-        case CW180_DEG:
-            dest[X] = -swap[X];
-            dest[Y] = -swap[Y];
-            dest[Z] = swap[Z];
-            break;
-        case CW270_DEG:
-            dest[X] = -swap[Y];
-            dest[Y] = swap[X];
-            dest[Z] = swap[Z];
-            break;
-        case CW0_DEG_FLIP:
-            dest[X] = -swap[X];
-            dest[Y] = swap[Y];
-            dest[Z] = -swap[Z];
-            break;
-        case CW90_DEG_FLIP:
-            dest[X] = swap[Y];
-            dest[Y] = swap[X];
-            dest[Z] = -swap[Z];
-            break;
-        case CW180_DEG_FLIP:
-            dest[X] = swap[X];
-            dest[Y] = -swap[Y];
-            dest[Z] = -swap[Z];
-            break;
-        case CW270_DEG_FLIP:
-            dest[X] = -swap[Y];
-            dest[Y] = -swap[X];
-            dest[Z] = -swap[Z];
-            break;
-        default:
-            break;
-    }
-
-    if (!standardBoardAlignment)
-        alignBoard(dest);
+    int16_t (*matrix)[3] = alignmentMatrix[rotation];
+    int32_t x = src[X];
+    int32_t y = src[Y];
+    int32_t z = src[Z];
+
+    // round to nearest, the products of a full scale reading and 1.0 still fit comfortably
+    dest[X] = (matrix[0][0] * x + matrix[0][1] * y + matrix[0][2] * z + (1 << (BOARD_ALIGNMENT_FRACTION_BITS - 1))) >> BOARD_ALIGNMENT_FRACTION_BITS;
+    dest[Y] = (matrix[1][0] * x + matrix[1][1] * y + matrix[1][2] * z + (1 << (BOARD_ALIGNMENT_FRACTION_BITS - 1))) >> BOARD_ALIGNMENT_FRACTION_BITS;
+    dest[Z] = (matrix[2][0] * x + matrix[2][1] * y + matrix[2][2] * z + (1 << (BOARD_ALIGNMENT_FRACTION_BITS - 1))) >> BOARD_ALIGNMENT_FRACTION_BITS;
 }
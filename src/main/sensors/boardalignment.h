@@ -17,6 +17,8 @@
 
 #pragma once
 
+#define BOARD_ALIGNMENT_FRACTION_BITS 14            // alignment matrices are Q14, 1.0 = 16384
+
 typedef struct boardAlignment_s {
     int16_t rollDegrees;
     int16_t pitchDegrees;
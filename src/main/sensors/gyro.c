@@ -28,77 +28,137 @@
 #include "sensors/sensors.h"
 #include "io/statusindicator.h"
 #include "sensors/boardalignment.h"
+#include "config/runtime_config.h"
+#include "config/config.h"
+#include "config/config_transfer.h"
 
 #include "sensors/gyro.h"
+#include "sensors/gyro_calibration.h"
 
-uint16_t calibratingG = 0;
 int16_t gyroADC[XYZ_AXIS_COUNT];
 int16_t gyroZero[FLIGHT_DYNAMICS_INDEX_COUNT] = { 0, 0, 0 };
 
+extern int16_t telemTemperature1; // FIXME dependency on mw.c
+
 static gyroConfig_t *gyroConfig;
+static gyroTempCompensation_t *gyroTempCompensation;
+static gyroBiasEstimator_t gyroBiasEstimator;
+
+static int16_t gyroZeroTemperature;             // temperature when the estimator last updated its bias
+static int16_t gyroTempCorrectionTemperature;   // temperature gyroTempCorrection was looked up for
+static int16_t gyroTempCorrection[XYZ_AXIS_COUNT];
 
 gyro_t gyro;                      // gyro access functions
 sensor_align_e gyroAlign = 0;
 
-void useGyroConfig(gyroConfig_t *gyroConfigToUse)
+void useGyroConfig(gyroConfig_t *gyroConfigToUse, gyroTempCompensation_t *gyroTempCompensationToUse)
 {
     gyroConfig = gyroConfigToUse;
+    gyroTempCompensation = gyroTempCompensationToUse;
 }
 
 void gyroSetCalibrationCycles(uint16_t calibrationCyclesRequired)
 {
-    calibratingG = calibrationCyclesRequired;
+    gyroBiasEstimatorInit(&gyroBiasEstimator, calibrationCyclesRequired);
 }
 
 bool isGyroCalibrationComplete(void)
 {
-    return calibratingG == 0;
+    return gyroBiasEstimator.biasValid;
 }
 
-bool isOnFinalGyroCalibrationCycle(void)
+int16_t gyroGetTemperatureCorrection(uint8_t axis)
 {
-    return calibratingG == 1;
+    return gyroTempCorrection[axis];
 }
 
-bool isOnFirstGyroCalibrationCycle(void)
+static bool isGyroTempCompensationActive(void)
 {
-    return calibratingG == CALIBRATING_GYRO_CYCLES;
+    return gyro.temperature && feature(FEATURE_GYRO_TEMP_COMP);
 }
 
-static void performAcclerationCalibration(uint8_t gyroMovementCalibrationThreshold)
+static void updateGyroZero(void)
 {
     int8_t axis;
-    static int32_t g[3];
-    static stdev_t var[3];
-
     for (axis = 0; axis < 3; axis++) {
+        gyroZero[axis] = gyroBiasEstimatorGetBias(&gyroBiasEstimator, axis) + gyroTempCorrection[axis];
+    }
+}
+
+/*
+ * The estimator's bias belongs to gyroZeroTemperature, the table supplies how much it has moved since.
+ * Only called when the temperature changes, so the read path just adds gyroZero as before.
+ */
+static void updateGyroTempCorrection(void)
+{
+    int16_t biasNow[XYZ_AXIS_COUNT];
+    int16_t biasAtZero[XYZ_AXIS_COUNT];
+    int8_t axis;
+
+    gyroTempCorrectionTemperature = telemTemperature1;
 
-        // Reset g[axis] at start of calibration
-        if (isOnFirstGyroCalibrationCycle()) {
-            g[axis] = 0;
-            devClear(&var[axis]);
+    if (isGyroTempCompensationActive()
+            && gyroTempCompensationLookup(gyroTempCompensation, telemTemperature1, biasNow)
+            && gyroTempCompensationLookup(gyroTempCompensation, gyroZeroTemperature, biasAtZero)) {
+        for (axis = 0; axis < 3; axis++) {
+            int16_t difference = biasNow[axis] - biasAtZero[axis];
+            gyroTempCorrection[axis] = (difference + (difference >= 0 ? 1 : -1) * (1 << (GYRO_TEMP_COMP_FRACTION_BITS - 1))) / (1 << GYRO_TEMP_COMP_FRACTION_BITS);
+        }
+    } else {
+        for (axis = 0; axis < 3; axis++) {
+            gyroTempCorrection[axis] = 0;
         }
+    }
+
+    updateGyroZero();
+}
+
+static void onStillGyroWindow(void)
+{
+    gyroZeroTemperature = telemTemperature1;
+
+    // The table is part of the config image, it must not change under a bulk transfer of it
+    if (isGyroTempCompensationActive() && !configTransferInProgress()) {
+        gyroTempCompensationLearn(gyroTempCompensation, telemTemperature1, gyroBiasEstimator.windowMean);
+        scheduleConfigSaveOnDisarm();
+    }
+
+    updateGyroTempCorrection();
+}
 
-        // Sum up CALIBRATING_GYRO_CYCLES readings
-        g[axis] += gyroADC[axis];
-        devPush(&var[axis], gyroADC[axis]);
+static void performGyroCalibration(uint8_t gyroMovementCalibrationThreshold)
+{
+    int8_t axis;
 
-        // Reset global variables to prevent other code from using un-calibrated data
+    // a window during which the model was moved is thrown away and calibration starts over
+    if (gyroBiasEstimatorPush(&gyroBiasEstimator, gyroADC, gyroMovementCalibrationThreshold, telemTemperature1)) {
+        onStillGyroWindow();
+        blinkLedAndSoundBeeper(10, 15, 1);
+        return;
+    }
+
+    // Reset global variables to prevent other code from using un-calibrated data
+    for (axis = 0; axis < 3; axis++) {
         gyroADC[axis] = 0;
         gyroZero[axis] = 0;
+    }
+}
 
-        if (isOnFinalGyroCalibrationCycle()) {
-            float dev = devStandardDeviation(&var[axis]);
-            // check deviation and startover in case the model was moved
-            if (gyroMovementCalibrationThreshold && dev > gyroMovementCalibrationThreshold) {
-                gyroSetCalibrationCycles(CALIBRATING_GYRO_CYCLES);
-                return;
-            }
-            gyroZero[axis] = (g[axis] + (CALIBRATING_GYRO_CYCLES / 2)) / CALIBRATING_GYRO_CYCLES;
-            blinkLedAndSoundBeeper(10, 15, 1);
-        }
+/*
+ * Keeps gyroZero following the bias while the model sits disarmed and still,
+ * e.g. while the sensor warms up after power on.
+ */
+static void trackGyroBias(uint8_t gyroMovementCalibrationThreshold)
+{
+    if (ARMING_FLAG(ARMED) || !gyroMovementCalibrationThreshold) {
+        // without stillness detection any rotation would end up in the bias
+        gyroBiasEstimatorRestartWindow(&gyroBiasEstimator);
+        return;
+    }
+
+    if (gyroBiasEstimatorPush(&gyroBiasEstimator, gyroADC, gyroMovementCalibrationThreshold, telemTemperature1)) {
+        onStillGyroWindow();
     }
-    calibratingG--;
 }
 
 static void applyGyroZero(void)
@@ -118,7 +178,13 @@ void gyroUpdate(void)
     alignSensors(gyroADC, gyroADC, gyroAlign);
 
     if (!isGyroCalibrationComplete()) {
-        performAcclerationCalibration(gyroConfig->gyroMovementCalibrationThreshold);
+        performGyroCalibration(gyroConfig->gyroMovementCalibrationThreshold);
+    } else {
+        trackGyroBias(gyroConfig->gyroMovementCalibrationThreshold);
+
+        if (telemTemperature1 != gyroTempCorrectionTemperature) {
+            updateGyroTempCorrection();
+        }
     }
 
     applyGyroZero();
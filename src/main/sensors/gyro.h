@@ -39,8 +39,22 @@ typedef struct gyroConfig_s {
     uint8_t gyroMovementCalibrationThreshold; // people keep forgetting that moving model while init results in wrong gyro offsets. and then they never reset gyro. so this is now on by default.
 } gyroConfig_t;
 
-void useGyroConfig(gyroConfig_t *gyroConfigToUse);
+#define GYRO_TEMPERATURE_UPDATE_INTERVAL_US (1000000 / 10)
+
+#define GYRO_TEMP_COMP_POINT_COUNT      8
+#define GYRO_TEMP_COMP_MIN_TEMPERATURE  (-10)       // degrees C of the first point
+#define GYRO_TEMP_COMP_POINT_SPACING    10          // degrees C between points, the table covers -10..60 C
+#define GYRO_TEMP_COMP_FRACTION_BITS    4           // table entries are in 1/16 gyro LSB
+
+// Gyro bias against temperature, learnt while the model sits disarmed and still.
+typedef struct gyroTempCompensation_s {
+    int16_t bias[GYRO_TEMP_COMP_POINT_COUNT][XYZ_AXIS_COUNT];
+    uint8_t windowCount[GYRO_TEMP_COMP_POINT_COUNT];              // still windows learnt into each point, 0 while unknown
+} gyroTempCompensation_t;
+
+void useGyroConfig(gyroConfig_t *gyroConfigToUse, gyroTempCompensation_t *gyroTempCompensationToUse);
 void gyroSetCalibrationCycles(uint16_t calibrationCyclesRequired);
 void gyroUpdate(void);
 bool isGyroCalibrationComplete(void);
+int16_t gyroGetTemperatureCorrection(uint8_t axis);
 
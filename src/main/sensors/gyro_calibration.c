@@ -0,0 +1,248 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "common/axis.h"
+#include "common/maths.h"
+
+#include "drivers/sensor.h"
+#include "drivers/accgyro.h"
+
+#include "sensors/sensors.h"
+#include "sensors/gyro.h"
+#include "sensors/gyro_calibration.h"
+
+void gyroBiasEstimatorRestartWindow(gyroBiasEstimator_t *estimator)
+{
+    estimator->count = 0;
+}
+
+/*
+ * Forgets the bias, the next still window provides a new one.
+ */
+void gyroBiasEstimatorInit(gyroBiasEstimator_t *estimator, uint16_t windowLength)
+{
+    uint8_t axis;
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        estimator->bias[axis] = 0;
+    }
+    estimator->windowLength = constrain(windowLength, 2, GYRO_CALIBRATION_MAX_WINDOW);
+    estimator->biasValid = false;
+    gyroBiasEstimatorRestartWindow(estimator);
+}
+
+static bool isWindowStill(const gyroBiasEstimator_t *estimator, uint8_t movementThreshold)
+{
+    uint8_t axis;
+    int64_t n = estimator->count;
+    int64_t limit;
+
+    if (!movementThreshold) {
+        return true;
+    }
+
+    // variance = (n * sumOfSquares - sum * sum) / (n * (n - 1)), compared against the squared threshold
+    limit = (int64_t)movementThreshold * movementThreshold * n * (n - 1);
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        int64_t sum = estimator->sum[axis];
+        if (n * estimator->sumOfSquares[axis] - sum * sum > limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int32_t windowMean(const gyroBiasEstimator_t *estimator, uint8_t axis)
+{
+    int64_t n = estimator->count;
+    int64_t sum = (int64_t)estimator->sum[axis] * (1 << GYRO_BIAS_FRACTION_BITS);
+
+    // round to nearest
+    sum += (sum >= 0) ? n / 2 : -n / 2;
+    return estimator->windowStart[axis] * (1 << GYRO_BIAS_FRACTION_BITS) + (int32_t)(sum / n);
+}
+
+/*
+ * Adds one sample, must be called with aligned raw gyro data.
+ * A movementThreshold of 0 accepts every window.
+ * Returns true when a window has ended still and the bias was updated.
+ */
+bool gyroBiasEstimatorPush(gyroBiasEstimator_t *estimator, const int16_t *sample, uint8_t movementThreshold, int16_t temperature)
+{
+    uint8_t axis;
+    uint8_t shift;
+
+    if (estimator->count == 0) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            estimator->windowStart[axis] = sample[axis];
+            estimator->sum[axis] = 0;
+            estimator->sumOfSquares[axis] = 0;
+        }
+    }
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        int32_t deviation = sample[axis] - estimator->windowStart[axis];
+        estimator->sum[axis] += deviation;
+        estimator->sumOfSquares[axis] += (int64_t)deviation * deviation;
+    }
+
+    if (++estimator->count < estimator->windowLength) {
+        return false;
+    }
+
+    if (!isWindowStill(estimator, movementThreshold)) {
+        // the craft was moved, throw the window away
+        gyroBiasEstimatorRestartWindow(estimator);
+        return false;
+    }
+
+    if (!estimator->biasValid) {
+        shift = 0;                      // take the first still window as it is
+        estimator->biasTemperature = temperature;
+        estimator->biasValid = true;
+    } else if (ABS(temperature - estimator->biasTemperature) >= GYRO_BIAS_TEMPERATURE_STEP) {
+        shift = GYRO_BIAS_TEMPERATURE_SHIFT;
+        estimator->biasTemperature = temperature;
+    } else {
+        shift = GYRO_BIAS_TRACKING_SHIFT;
+    }
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        estimator->windowMean[axis] = windowMean(estimator, axis);
+        estimator->bias[axis] += (estimator->windowMean[axis] - estimator->bias[axis]) / (1 << shift);
+    }
+
+    gyroBiasEstimatorRestartWindow(estimator);
+    return true;
+}
+
+int16_t gyroBiasEstimatorGetBias(const gyroBiasEstimator_t *estimator, uint8_t axis)
+{
+    int32_t bias = estimator->bias[axis];
+
+    return (bias + (bias >= 0 ? 1 : -1) * (1 << (GYRO_BIAS_FRACTION_BITS - 1))) / (1 << GYRO_BIAS_FRACTION_BITS);
+}
+
+static int32_t divideRounded(int32_t dividend, int32_t divisor)
+{
+    return (dividend + (dividend >= 0 ? divisor / 2 : -divisor / 2)) / divisor;
+}
+
+void gyroTempCompensationReset(gyroTempCompensation_t *table)
+{
+    uint8_t point;
+    uint8_t axis;
+
+    for (point = 0; point < GYRO_TEMP_COMP_POINT_COUNT; point++) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            table->bias[point][axis] = 0;
+        }
+        table->windowCount[point] = 0;
+    }
+}
+
+/*
+ * Finds the pair of points around the temperature, temperatures outside the table use its first or last point.
+ * upperWeight is the weight of the upper point, 0..GYRO_TEMP_COMP_POINT_SPACING.
+ */
+static uint8_t findPoints(int16_t temperature, uint8_t *upperWeight)
+{
+    int16_t offset = constrain(temperature - GYRO_TEMP_COMP_MIN_TEMPERATURE, 0, (GYRO_TEMP_COMP_POINT_COUNT - 1) * GYRO_TEMP_COMP_POINT_SPACING);
+    uint8_t lower = MIN(offset / GYRO_TEMP_COMP_POINT_SPACING, GYRO_TEMP_COMP_POINT_COUNT - 2);
+
+    *upperWeight = offset - lower * GYRO_TEMP_COMP_POINT_SPACING;
+    return lower;
+}
+
+static int32_t interpolate(const gyroTempCompensation_t *table, uint8_t lower, uint8_t upperWeight, uint8_t axis)
+{
+    int32_t weighted = (int32_t)table->bias[lower][axis] * (GYRO_TEMP_COMP_POINT_SPACING - upperWeight)
+        + (int32_t)table->bias[lower + 1][axis] * upperWeight;
+
+    return divideRounded(weighted, GYRO_TEMP_COMP_POINT_SPACING);
+}
+
+/*
+ * Fits the table to the bias measured at the given temperature, bias has GYRO_BIAS_FRACTION_BITS fractional bits.
+ * The error is shared between the two points around the temperature by their interpolation weights, so the
+ * table converges on a piecewise linear fit of the measurements. A point learns its first window as it is.
+ */
+void gyroTempCompensationLearn(gyroTempCompensation_t *table, int16_t temperature, const int32_t *bias)
+{
+    int32_t measured[XYZ_AXIS_COUNT];
+    uint8_t weights[2];
+    uint8_t lower;
+    uint8_t point;
+    uint8_t axis;
+
+    lower = findPoints(temperature, &weights[1]);
+    weights[0] = GYRO_TEMP_COMP_POINT_SPACING - weights[1];
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        measured[axis] = divideRounded(bias[axis], 1 << (GYRO_BIAS_FRACTION_BITS - GYRO_TEMP_COMP_FRACTION_BITS));
+    }
+
+    for (point = 0; point < 2; point++) {
+        if (weights[point] && !table->windowCount[lower + point]) {
+            for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                table->bias[lower + point][axis] = constrain(measured[axis], INT16_MIN, INT16_MAX);
+            }
+        }
+    }
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        int32_t error = measured[axis] - interpolate(table, lower, weights[1], axis);
+
+        for (point = 0; point < 2; point++) {
+            int32_t correction = divideRounded(error * weights[point], GYRO_TEMP_COMP_POINT_SPACING << GYRO_TEMP_COMP_LEARNING_SHIFT);
+            table->bias[lower + point][axis] = constrain(table->bias[lower + point][axis] + correction, INT16_MIN, INT16_MAX);
+        }
+    }
+
+    for (point = 0; point < 2; point++) {
+        if (weights[point] && table->windowCount[lower + point] < UINT8_MAX) {
+            table->windowCount[lower + point]++;
+        }
+    }
+}
+
+/*
+ * Interpolates the bias at the given temperature into bias[], in GYRO_TEMP_COMP_FRACTION_BITS.
+ * Returns false when a point needed for it has not been learnt yet.
+ */
+bool gyroTempCompensationLookup(const gyroTempCompensation_t *table, int16_t temperature, int16_t *bias)
+{
+    uint8_t upperWeight;
+    uint8_t lower = findPoints(temperature, &upperWeight);
+    uint8_t axis;
+
+    if ((upperWeight < GYRO_TEMP_COMP_POINT_SPACING && !table->windowCount[lower])
+            || (upperWeight > 0 && !table->windowCount[lower + 1])) {
+        return false;
+    }
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        bias[axis] = interpolate(table, lower, upperWeight, axis);
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define GYRO_BIAS_FRACTION_BITS             8           // gyro bias is kept with 8 fractional bits
+#define GYRO_CALIBRATION_MAX_WINDOW         4096        // keeps the window sums inside 64 bits
+#define GYRO_BIAS_TRACKING_SHIFT            3           // a still window moves the bias 1/8 of the way
+#define GYRO_BIAS_TEMPERATURE_SHIFT         1           // ... or 1/2 of the way after a temperature change
+#define GYRO_BIAS_TEMPERATURE_STEP          1           // in gyro.temperature() units (degrees C)
+#define GYRO_TEMP_COMP_LEARNING_SHIFT       2           // a still window moves the table 1/4 of the way
+
+// Estimates the gyro bias from windows of samples taken while the craft is still.
+// The first still window provides the initial bias, later still windows pull it along so that
+// drift, e.g. from the sensor warming up, is followed while the craft sits disarmed.
+typedef struct gyroBiasEstimator_s {
+    int16_t windowStart[XYZ_AXIS_COUNT];        // first sample of the window, sums are relative to it
+    int32_t sum[XYZ_AXIS_COUNT];
+    int64_t sumOfSquares[XYZ_AXIS_COUNT];
+    uint16_t count;
+    uint16_t windowLength;
+    int32_t bias[XYZ_AXIS_COUNT];               // GYRO_BIAS_FRACTION_BITS fractional bits
+    int32_t windowMean[XYZ_AXIS_COUNT];         // of the last still window, GYRO_BIAS_FRACTION_BITS fractional bits
+    bool biasValid;
+    int16_t biasTemperature;                    // temperature when the bias was last updated quickly
+} gyroBiasEstimator_t;
+
+void gyroBiasEstimatorInit(gyroBiasEstimator_t *estimator, uint16_t windowLength);
+void gyroBiasEstimatorRestartWindow(gyroBiasEstimator_t *estimator);
+bool gyroBiasEstimatorPush(gyroBiasEstimator_t *estimator, const int16_t *sample, uint8_t movementThreshold, int16_t temperature);
+int16_t gyroBiasEstimatorGetBias(const gyroBiasEstimator_t *estimator, uint8_t axis);
+
+void gyroTempCompensationReset(gyroTempCompensation_t *table);
+void gyroTempCompensationLearn(gyroTempCompensation_t *table, int16_t temperature, const int32_t *bias);
+bool gyroTempCompensationLookup(const gyroTempCompensation_t *table, int16_t temperature, int16_t *bias);
@@ -542,13 +542,13 @@ retry:
 
 void reconfigureAlignment(sensorAlignmentConfig_t *sensorAlignmentConfig)
 {
-    if (sensorAlignmentConfig->gyro_align != ALIGN_DEFAULT) {
+    if (sensorAlignmentConfig->gyro_align != ALIGN_DEFAULT && sensorAlignmentConfig->gyro_align <= CW270_DEG_FLIP) {
         gyroAlign = sensorAlignmentConfig->gyro_align;
     }
-    if (sensorAlignmentConfig->acc_align != ALIGN_DEFAULT) {
+    if (sensorAlignmentConfig->acc_align != ALIGN_DEFAULT && sensorAlignmentConfig->acc_align <= CW270_DEG_FLIP) {
         accAlign = sensorAlignmentConfig->acc_align;
     }
-    if (sensorAlignmentConfig->mag_align != ALIGN_DEFAULT) {
+    if (sensorAlignmentConfig->mag_align != ALIGN_DEFAULT && sensorAlignmentConfig->mag_align <= CW270_DEG_FLIP) {
         magAlign = sensorAlignmentConfig->mag_align;
     }
 }
@@ -107,6 +107,7 @@
 #define GPS
 #define LED_STRIP
 #define LED_STRIP_TIMER TIM3
+#define USE_LED_STRIP_PACKED_DMA
 
 #define BLACKBOX
 #define TELEMETRY
@@ -22,6 +22,7 @@
 
 #define FLASH_PAGE_COUNT 64
 #define FLASH_PAGE_SIZE ((uint16_t)0x400)
+#define FLASH_TO_RESERVE_FOR_CONFIG 0x1800
 
 #define LED0_GPIO GPIOC
 #define LED0_PIN Pin_14 // PC14 (LED)
@@ -148,12 +148,14 @@
 
 #define LED_STRIP
 #define LED_STRIP_TIMER TIM3
+#define USE_LED_STRIP_PACKED_DMA
 
 #define BLACKBOX
 #define TELEMETRY
 #define SERIAL_RX
 #define AUTOTUNE
 #define USE_SERVOS
+#define USE_DSHOT
 
 #define SPEKTRUM_BIND
 // USART2, PA3
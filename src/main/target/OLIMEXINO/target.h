@@ -106,6 +106,7 @@
 #define GPS
 #define LED_STRIP
 #define LED_STRIP_TIMER TIM3
+#define USE_LED_STRIP_PACKED_DMA
 
 #define TELEMETRY
 #define SERIAL_RX
@@ -33,8 +33,6 @@
 #include "drivers/system.h"
 #include "drivers/sensor.h"
 #include "drivers/accgyro.h"
-#include "drivers/gpio.h"
-#include "drivers/timer.h"
 #include "drivers/serial.h"
 
 
@@ -59,6 +57,7 @@
 #include "config/config.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/scheduler.h"
 #include "telemetry/frsky.h"
 
 static serialPort_t *frskyPort = NULL;
@@ -76,7 +75,10 @@ extern batteryConfig_t *batteryConfig;
 
 extern int16_t telemTemperature1; // FIXME dependency on mw.c
 
-#define CYCLETIME             125
+// the hub link is slower than the serial port, this is about what the previous fixed 125ms cycle sent on average
+#define FRSKY_LINK_BYTES_PER_SECOND 240
+#define FRSKY_FRAME_SIZE            48
+#define FRSKY_FRAME_MAX_SENSORS     8
 
 #define PROTOCOL_HEADER       0x5E
 #define PROTOCOL_TAIL         0x5E
@@ -125,30 +127,37 @@ extern int16_t telemTemperature1; // FIXME dependency on mw.c
 #define DELAY_FOR_BARO_INITIALISATION (5 * 1000) //5s
 #define BLADE_NUMBER_DIVIDER  5 // should set 12 blades in Taranis
 
-static uint32_t lastCycleTime = 0;
-static uint8_t cycleNum = 0;
+static telemetryScheduler_t frskyScheduler;
+static uint16_t frskyBytesWritten;
+
+static void frskyWrite(uint8_t data)
+{
+    serialWrite(frskyPort, data);
+    frskyBytesWritten++;
+}
+
 static void sendDataHead(uint8_t id)
 {
-    serialWrite(frskyPort, PROTOCOL_HEADER);
-    serialWrite(frskyPort, id);
+    frskyWrite(PROTOCOL_HEADER);
+    frskyWrite(id);
 }
 
 static void sendTelemetryTail(void)
 {
-    serialWrite(frskyPort, PROTOCOL_TAIL);
+    frskyWrite(PROTOCOL_TAIL);
 }
 
 static void serializeFrsky(uint8_t data)
 {
     // take care of byte stuffing
     if (data == 0x5e) {
-        serialWrite(frskyPort, 0x5d);
-        serialWrite(frskyPort, 0x3e);
+        frskyWrite(0x5d);
+        frskyWrite(0x3e);
     } else if (data == 0x5d) {
-        serialWrite(frskyPort, 0x5d);
-        serialWrite(frskyPort, 0x3d);
+        frskyWrite(0x5d);
+        frskyWrite(0x3d);
     } else
-        serialWrite(frskyPort, data);
+        frskyWrite(data);
 }
 
 static void serialize16(int16_t a)
@@ -218,7 +227,7 @@ static void sendTemperature1(void)
 static void sendSatalliteSignalQualityAsTemperature2(void)
 {
     uint16_t satellite = GPS_numSat;
-    if (GPS_hdop > GPS_BAD_QUALITY && ( (cycleNum % 16 ) < 8)) {//Every 1s
+    if (GPS_hdop > GPS_BAD_QUALITY && ((millis() / 1000) % 2) == 0) {//Every 1s
         satellite = constrain(GPS_hdop, 0, GPS_MAX_HDOP_VAL);
     }
     sendDataHead(ID_TEMPRATURE2);
@@ -235,9 +244,6 @@ static void sendSatalliteSignalQualityAsTemperature2(void)
 
 static void sendSpeed(void)
 {
-    if (!STATE(GPS_FIX)) {
-        return;
-    }
     //Speed should be sent in m/s (GPS speed is in cm/s)
     sendDataHead(ID_GPS_SPEED_BP);
     serialize16((GPS_speed * 0.01 + 0.5));
@@ -413,6 +419,131 @@ static void sendHeading(void)
     serialize16(0);
 }
 
+static bool isBaroInitialised(void)
+{
+    return millis() > DELAY_FOR_BARO_INITIALISATION; //Allow 5s to boot correctly
+}
+
+static bool isVbatEnabled(void)
+{
+    return feature(FEATURE_VBAT);
+}
+
+#ifdef GPS
+static bool isGpsPresent(void)
+{
+    return sensors(SENSOR_GPS);
+}
+
+static bool hasGpsFix(void)
+{
+    return sensors(SENSOR_GPS) && STATE(GPS_FIX);
+}
+#endif
+
+//  Send GPS information to display compass information
+static bool hasGpsPosition(void)
+{
+    return sensors(SENSOR_GPS) || (telemetryConfig->gpsNoFixLatitude != 0 && telemetryConfig->gpsNoFixLongitude != 0);
+}
+
+typedef enum {
+    FRSKY_SENSOR_ACCEL = 0,
+    FRSKY_SENSOR_VARIO,
+    FRSKY_SENSOR_BARO,
+    FRSKY_SENSOR_HEADING,
+    FRSKY_SENSOR_TEMPERATURE1,
+    FRSKY_SENSOR_RPM,
+    FRSKY_SENSOR_VOLTAGE,
+    FRSKY_SENSOR_VOLTAGE_AMP,
+    FRSKY_SENSOR_AMPERAGE,
+    FRSKY_SENSOR_FUEL_LEVEL,
+#ifdef GPS
+    FRSKY_SENSOR_SPEED,
+    FRSKY_SENSOR_GPS_ALTITUDE,
+    FRSKY_SENSOR_SATELLITES,
+    FRSKY_SENSOR_GPS,
+#endif
+    FRSKY_SENSOR_TIME,
+    FRSKY_SENSOR_COUNT
+} frskySensor_e;
+
+// sizes are without byte stuffing, each value is a 2 byte head and 2 data bytes
+static const telemetrySensor_t frskySensors[FRSKY_SENSOR_COUNT] = {
+    [FRSKY_SENSOR_ACCEL]        = { 0,  12, 125,  NULL },
+    [FRSKY_SENSOR_VARIO]        = { 0,  4,  125,  NULL },
+    [FRSKY_SENSOR_BARO]         = { 1,  8,  500,  isBaroInitialised },
+    [FRSKY_SENSOR_HEADING]      = { 1,  8,  500,  NULL },
+    [FRSKY_SENSOR_TEMPERATURE1] = { 3,  4,  1000, NULL },
+    [FRSKY_SENSOR_RPM]          = { 2,  4,  1000, NULL },
+    [FRSKY_SENSOR_VOLTAGE]      = { 1,  4,  1000, isVbatEnabled },
+    [FRSKY_SENSOR_VOLTAGE_AMP]  = { 1,  8,  1000, isVbatEnabled },
+    [FRSKY_SENSOR_AMPERAGE]     = { 1,  4,  1000, isVbatEnabled },
+    [FRSKY_SENSOR_FUEL_LEVEL]   = { 2,  4,  1000, isVbatEnabled },
+#ifdef GPS
+    [FRSKY_SENSOR_SPEED]        = { 2,  8,  1000, hasGpsFix },
+    [FRSKY_SENSOR_GPS_ALTITUDE] = { 2,  8,  1000, isGpsPresent },
+    [FRSKY_SENSOR_SATELLITES]   = { 3,  4,  1000, isGpsPresent },
+    [FRSKY_SENSOR_GPS]          = { 2,  24, 1000, hasGpsPosition },
+#endif
+    [FRSKY_SENSOR_TIME]         = { 3,  8,  5000, NULL },
+};
+
+static void sendSensor(frskySensor_e sensor)
+{
+    switch (sensor) {
+        case FRSKY_SENSOR_ACCEL:
+            sendAccel();
+            break;
+        case FRSKY_SENSOR_VARIO:
+            sendVario();
+            break;
+        case FRSKY_SENSOR_BARO:
+            sendBaro();
+            break;
+        case FRSKY_SENSOR_HEADING:
+            sendHeading();
+            break;
+        case FRSKY_SENSOR_TEMPERATURE1:
+            sendTemperature1();
+            break;
+        case FRSKY_SENSOR_RPM:
+            sendThrottleOrBatterySizeAsRpm();
+            break;
+        case FRSKY_SENSOR_VOLTAGE:
+            sendVoltage();
+            break;
+        case FRSKY_SENSOR_VOLTAGE_AMP:
+            sendVoltageAmp();
+            break;
+        case FRSKY_SENSOR_AMPERAGE:
+            sendAmperage();
+            break;
+        case FRSKY_SENSOR_FUEL_LEVEL:
+            sendFuelLevel();
+            break;
+#ifdef GPS
+        case FRSKY_SENSOR_SPEED:
+            sendSpeed();
+            break;
+        case FRSKY_SENSOR_GPS_ALTITUDE:
+            sendGpsAltitude();
+            break;
+        case FRSKY_SENSOR_SATELLITES:
+            sendSatalliteSignalQualityAsTemperature2();
+            break;
+        case FRSKY_SENSOR_GPS:
+            sendGPS();
+            break;
+#endif
+        case FRSKY_SENSOR_TIME:
+            sendTime();
+            break;
+        default:
+            break;
+    }
+}
+
 void initFrSkyTelemetry(telemetryConfig_t *initialTelemetryConfig)
 {
     telemetryConfig = initialTelemetryConfig;
@@ -438,12 +569,9 @@ void configureFrSkyTelemetryPort(void)
         return;
     }
 
-    frskyTelemetryEnabled = true;
-}
+    telemetrySchedulerInit(&frskyScheduler, frskySensors, FRSKY_SENSOR_COUNT, FRSKY_LINK_BYTES_PER_SECOND, micros());
 
-bool hasEnoughTimeLapsedSinceLastTelemetryTransmission(uint32_t currentMillis)
-{
-    return currentMillis - lastCycleTime >= CYCLETIME;
+    frskyTelemetryEnabled = true;
 }
 
 void checkFrSkyTelemetryState(void)
@@ -460,66 +588,35 @@ void checkFrSkyTelemetryState(void)
         freeFrSkyTelemetryPort();
 }
 
-void handleFrSkyTelemetry(void)
+/*
+ * Sends a frame of the most urgent due values once the previous frame had time to go out.
+ * Returns the time at which a frame may next be sent.
+ */
+uint32_t handleFrSkyTelemetry(uint32_t currentMicros)
 {
     if (!frskyTelemetryEnabled) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
-    uint32_t now = millis();
-
-    if (!hasEnoughTimeLapsedSinceLastTelemetryTransmission(now)) {
-        return;
+    if (!telemetrySchedulerIsSlotOpen(&frskyScheduler, currentMicros)) {
+        return frskyScheduler.nextSlotAt;
     }
 
-    lastCycleTime = now;
+    uint8_t frame[FRSKY_FRAME_MAX_SENSORS];
+    uint8_t sensorCount = telemetrySchedulerFillFrame(&frskyScheduler, currentMicros, FRSKY_FRAME_SIZE, frame, FRSKY_FRAME_MAX_SENSORS);
 
-    cycleNum++;
+    frskyBytesWritten = 0;
 
-    // Sent every 125ms
-    sendAccel();
-    sendVario();
-    sendTelemetryTail();
-
-    if ((cycleNum % 4) == 0) {      // Sent every 500ms
-        if (lastCycleTime > DELAY_FOR_BARO_INITIALISATION) { //Allow 5s to boot correctly
-            sendBaro();
-        }
-        sendHeading();
-        sendTelemetryTail();
+    for (uint8_t index = 0; index < sensorCount; index++) {
+        sendSensor(frame[index]);
     }
-
-    if ((cycleNum % 8) == 0) {      // Sent every 1s
-        sendTemperature1();
-        sendThrottleOrBatterySizeAsRpm();
-
-        if (feature(FEATURE_VBAT)) {
-            sendVoltage();
-            sendVoltageAmp();
-            sendAmperage();
-            sendFuelLevel();
-        }
-
-#ifdef GPS
-        if (sensors(SENSOR_GPS)) {
-            sendSpeed();
-            sendGpsAltitude();
-            sendSatalliteSignalQualityAsTemperature2();
-        }
-#endif
-
-        //  Send GPS information to display compass information
-        if (sensors(SENSOR_GPS) || (telemetryConfig->gpsNoFixLatitude != 0 && telemetryConfig->gpsNoFixLongitude != 0)) {
-            sendGPS();
-        }
+    if (sensorCount) {
         sendTelemetryTail();
     }
 
-    if (cycleNum == 40) {     //Frame 3: Sent every 5s
-        cycleNum = 0;
-        sendTime();
-        sendTelemetryTail();
-    }
+    telemetrySchedulerFrameSent(&frskyScheduler, currentMicros, frskyBytesWritten);
+
+    return frskyScheduler.nextSlotAt;
 }
 
 #endif
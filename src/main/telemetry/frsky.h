@@ -23,7 +23,7 @@ typedef enum {
     FRSKY_VFAS_PRECISION_HIGH
 } frskyVFasPrecision_e;
 
-void handleFrSkyTelemetry(void);
+uint32_t handleFrSkyTelemetry(uint32_t currentMicros);
 void checkFrSkyTelemetryState(void);
 
 void initFrSkyTelemetry(telemetryConfig_t *telemetryConfig);
@@ -63,6 +63,7 @@
 #ifdef TELEMETRY
 
 #include "common/axis.h"
+#include "common/maths.h"
 
 #include "drivers/system.h"
 
@@ -79,26 +80,39 @@
 #include "io/gps.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/scheduler.h"
 #include "telemetry/hott.h"
 
 extern int16_t debug[4];
 
 //#define HOTT_DEBUG
 
-#define HOTT_MESSAGE_PREPARATION_FREQUENCY_5_HZ ((1000 * 1000) / 5)
+#define HOTT_MESSAGE_PREPARATION_INTERVAL_MS (1000 / 5)
 #define HOTT_RX_SCHEDULE 4000
-#define HOTT_TX_DELAY_US 3000
+#define HOTT_TX_DELAY_MS 3 // gap between bytes, counted in systicks
+#define HOTT_TX_DELAY_US (HOTT_TX_DELAY_MS * 1000)
 
 static uint32_t lastHoTTRequestCheckAt = 0;
-static uint32_t lastMessagesPreparedAt = 0;
 
 static bool hottIsSending = false;
 
-static uint8_t *hottMsg = NULL;
-static uint8_t hottMsgRemainingBytesToSendCount;
-static uint8_t hottMsgCrc;
+#define HOTT_CRC_SIZE 1
 
-#define HOTT_CRC_SIZE (sizeof(hottMsgCrc))
+#define HOTT_TX_BUFFER_SIZE (MAX(sizeof(HOTT_EAM_MSG_t), sizeof(HOTT_GPS_MSG_t)) + HOTT_CRC_SIZE)
+
+typedef struct hottTxBuffer_s {
+    uint8_t data[HOTT_TX_BUFFER_SIZE];
+    uint8_t length;
+} hottTxBuffer_t;
+
+// the systick handler sends one byte per gap from the front buffer, the main loop only ever fills the other one
+static hottTxBuffer_t hottTxBuffers[2];
+static uint8_t hottTxBackBufferIndex = 0;
+
+static hottTxBuffer_t * volatile hottTxFrontBuffer = NULL;
+static volatile uint8_t hottTxPosition;
+static volatile uint8_t hottTxTicks;
+static volatile bool hottTxComplete;
 
 #define HOTT_BAUDRATE 19200
 #define HOTT_INITIAL_PORT_MODE MODE_RX
@@ -113,6 +127,24 @@ static portSharing_e hottPortSharing;
 static HOTT_GPS_MSG_t hottGPSMessage;
 static HOTT_EAM_MSG_t hottEAMMessage;
 
+typedef enum {
+    HOTT_SENSOR_EAM = 0,
+#ifdef GPS
+    HOTT_SENSOR_GPS,
+#endif
+    HOTT_SENSOR_COUNT
+} hottSensor_e;
+
+// the receiver asks for one whole message at a time, a message is only prepared when it is requested and stale
+static const telemetrySensor_t hottSensors[HOTT_SENSOR_COUNT] = {
+    [HOTT_SENSOR_EAM] = { 0, sizeof(HOTT_EAM_MSG_t), HOTT_MESSAGE_PREPARATION_INTERVAL_MS, NULL },
+#ifdef GPS
+    [HOTT_SENSOR_GPS] = { 0, sizeof(HOTT_GPS_MSG_t), HOTT_MESSAGE_PREPARATION_INTERVAL_MS, NULL },
+#endif
+};
+
+static telemetryScheduler_t hottScheduler;
+
 static void initialiseEAMMessage(HOTT_EAM_MSG_t *msg, size_t size)
 {
     memset(msg, 0, size);
@@ -130,8 +162,13 @@ typedef enum {
     GPS_FIX_CHAR_DGPS = 'D',
 } gpsFixChar_e;
 
+static bool hottGPSCoordinatesConverted;
+static int32_t hottGPSConvertedCoordinates[2];
+
 static void initialiseGPSMessage(HOTT_GPS_MSG_t *msg, size_t size)
 {
+    hottGPSCoordinatesConverted = false;
+
     memset(msg, 0, size);
     msg->start_byte = 0x7C;
     msg->gps_sensor_id = HOTT_TELEMETRY_GPS_SENSOR_ID;
@@ -176,13 +213,16 @@ void addGPSCoordinates(HOTT_GPS_MSG_t *hottGPSMessage, int32_t latitude, int32_t
     hottGPSMessage->pos_EW_sec_H = sec >> 8;
 }
 
-void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
+/*
+ * Updates everything but the coordinates, returns false if there is no fix and nothing more to update.
+ */
+static bool hottPrepareGPSFields(HOTT_GPS_MSG_t *hottGPSMessage)
 {
     hottGPSMessage->gps_satelites = GPS_numSat;
 
     if (!STATE(GPS_FIX)) {
         hottGPSMessage->gps_fix_char = GPS_FIX_CHAR_NONE;
-        return;
+        return false;
     }
 
     if (GPS_numSat >= 5) {
@@ -191,8 +231,6 @@ void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
         hottGPSMessage->gps_fix_char = GPS_FIX_CHAR_2D;
     }
 
-    addGPSCoordinates(hottGPSMessage, GPS_coord[LAT], GPS_coord[LON]);
-
     // GPS Speed in km/h
     uint16_t speed = (GPS_speed * 36) / 100; // 0->1m/s * 0->36 = km/h
     hottGPSMessage->gps_speed_L = speed & 0x00FF;
@@ -207,6 +245,36 @@ void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
     hottGPSMessage->altitude_H = hottGpsAltitude >> 8;
 
     hottGPSMessage->home_direction = GPS_directionToHome;
+
+    return true;
+}
+
+void hottPrepareGPSResponse(HOTT_GPS_MSG_t *hottGPSMessage)
+{
+    if (hottPrepareGPSFields(hottGPSMessage)) {
+        addGPSCoordinates(hottGPSMessage, GPS_coord[LAT], GPS_coord[LON]);
+    }
+}
+
+/*
+ * The coordinate conversion is the expensive part, it is skipped while the position doesn't change.
+ */
+static void hottUpdateGPSMessage(void)
+{
+    if (!hottPrepareGPSFields(&hottGPSMessage)) {
+        return;
+    }
+
+    if (hottGPSCoordinatesConverted &&
+            hottGPSConvertedCoordinates[LAT] == GPS_coord[LAT] &&
+            hottGPSConvertedCoordinates[LON] == GPS_coord[LON]) {
+        return;
+    }
+
+    addGPSCoordinates(&hottGPSMessage, GPS_coord[LAT], GPS_coord[LON]);
+    hottGPSConvertedCoordinates[LAT] = GPS_coord[LAT];
+    hottGPSConvertedCoordinates[LON] = GPS_coord[LON];
+    hottGPSCoordinatesConverted = true;
 }
 #endif
 
@@ -243,15 +311,37 @@ void hottPrepareEAMResponse(HOTT_EAM_MSG_t *hottEAMMessage)
     hottEAMUpdateBatteryDrawnCapacity(hottEAMMessage);
 }
 
-static void hottSerialWrite(uint8_t c)
+/*
+ * Called from the systick interrupt every millisecond, sends the next byte once the gap has passed.
+ * One more gap is left after the last byte before the main loop switches the port back to receive.
+ */
+static void hottTransmitterTick(void)
 {
-    static uint8_t serialWrites = 0;
-    serialWrites++;
-    serialWrite(hottPort, c);
+    hottTxBuffer_t *buffer = hottTxFrontBuffer;
+
+    if (!buffer || hottTxComplete) {
+        return;
+    }
+
+    if (++hottTxTicks < HOTT_TX_DELAY_MS) {
+        return;
+    }
+    hottTxTicks = 0;
+
+    if (hottTxPosition >= buffer->length) {
+        hottTxComplete = true;
+        return;
+    }
+
+    serialWrite(hottPort, buffer->data[hottTxPosition++]);
 }
 
 void freeHoTTTelemetryPort(void)
 {
+    setSysTickCallback(NULL);
+    hottTxFrontBuffer = NULL;
+    hottIsSending = false;
+
     closeSerialPort(hottPort);
     hottPort = NULL;
     hottTelemetryEnabled = false;
@@ -264,6 +354,7 @@ void initHoTTTelemetry(telemetryConfig_t *initialTelemetryConfig)
     hottPortSharing = determinePortSharing(portConfig, FUNCTION_TELEMETRY_HOTT);
 
     initialiseMessages();
+    telemetrySchedulerInit(&hottScheduler, hottSensors, HOTT_SENSOR_COUNT, 0, micros());
 }
 
 void configureHoTTTelemetryPort(void)
@@ -278,37 +369,54 @@ void configureHoTTTelemetryPort(void)
         return;
     }
 
+    setSysTickCallback(hottTransmitterTick);
+
     hottTelemetryEnabled = true;
 }
 
-static void hottSendResponse(uint8_t *buffer, int length)
+static void hottSendResponse(uint8_t *message, int length)
 {
     if(hottIsSending) {
         return;
     }
 
-    hottMsg = buffer;
-    hottMsgRemainingBytesToSendCount = length + HOTT_CRC_SIZE;
+    hottTxBuffer_t *buffer = &hottTxBuffers[hottTxBackBufferIndex];
+    uint8_t crc = 0;
+
+    for (int index = 0; index < length; index++) {
+        buffer->data[index] = message[index];
+        crc += message[index];
+    }
+    buffer->data[length] = crc;
+    buffer->length = length + HOTT_CRC_SIZE;
+
+    hottIsSending = true;
+    serialSetMode(hottPort, MODE_TX);
+
+    hottTxPosition = 0;
+    hottTxTicks = 0;
+    hottTxComplete = false;
+    hottTxFrontBuffer = buffer;
+    hottTxBackBufferIndex ^= 1;
 }
 
-static inline void hottSendGPSResponse(void)
+static inline void hottSendGPSResponse(uint32_t currentMicros)
 {
+    if (telemetrySchedulerTakeSensor(&hottScheduler, HOTT_SENSOR_GPS, currentMicros)) {
+        hottUpdateGPSMessage();
+    }
     hottSendResponse((uint8_t *)&hottGPSMessage, sizeof(hottGPSMessage));
 }
 
-static inline void hottSendEAMResponse(void)
+static inline void hottSendEAMResponse(uint32_t currentMicros)
 {
+    if (telemetrySchedulerTakeSensor(&hottScheduler, HOTT_SENSOR_EAM, currentMicros)) {
+        hottPrepareEAMResponse(&hottEAMMessage);
+    }
     hottSendResponse((uint8_t *)&hottEAMMessage, sizeof(hottEAMMessage));
 }
 
-static void hottPrepareMessages(void) {
-    hottPrepareEAMResponse(&hottEAMMessage);
-#ifdef GPS
-    hottPrepareGPSResponse(&hottGPSMessage);
-#endif
-}
-
-static void processBinaryModeRequest(uint8_t address) {
+static void processBinaryModeRequest(uint8_t address, uint32_t currentMicros) {
 
 #ifdef HOTT_DEBUG
     static uint8_t hottBinaryRequests = 0;
@@ -323,7 +431,7 @@ static void processBinaryModeRequest(uint8_t address) {
             hottGPSRequests++;
 #endif
             if (sensors(SENSOR_GPS)) {
-                hottSendGPSResponse();
+                hottSendGPSResponse(currentMicros);
             }
             break;
 #endif
@@ -331,7 +439,7 @@ static void processBinaryModeRequest(uint8_t address) {
 #ifdef HOTT_DEBUG
             hottEAMRequests++;
 #endif
-            hottSendEAMResponse();
+            hottSendEAMResponse(currentMicros);
             break;
     }
 
@@ -387,48 +495,8 @@ static void hottCheckSerialData(uint32_t currentMicros)
     uint8_t address = serialRead(hottPort);
 
     if ((requestId == 0) || (requestId == HOTT_BINARY_MODE_REQUEST_ID) || (address == HOTT_TELEMETRY_NO_SENSOR_ID)) {
-        processBinaryModeRequest(address);
-    }
-}
-
-static void hottSendTelemetryData(void) {
-    if (!hottIsSending) {
-        hottIsSending = true;
-        serialSetMode(hottPort, MODE_TX);
-        hottMsgCrc = 0;
-        return;
-    }
-
-    if (hottMsgRemainingBytesToSendCount == 0) {
-        hottMsg = NULL;
-        hottIsSending = false;
-
-        serialSetMode(hottPort, MODE_RX);
-        flushHottRxBuffer();
-        return;
-    }
-
-    --hottMsgRemainingBytesToSendCount;
-    if(hottMsgRemainingBytesToSendCount == 0) {
-        hottSerialWrite(hottMsgCrc++);
-        return;
-    }
-
-    hottMsgCrc += *hottMsg;
-    hottSerialWrite(*hottMsg++);
-}
-
-static inline bool shouldPrepareHoTTMessages(uint32_t currentMicros)
-{
-    return currentMicros - lastMessagesPreparedAt >= HOTT_MESSAGE_PREPARATION_FREQUENCY_5_HZ;
-}
-
-static inline bool shouldCheckForHoTTRequest()
-{
-    if (hottIsSending) {
-        return false;
+        processBinaryModeRequest(address, currentMicros);
     }
-    return true;
 }
 
 void checkHoTTTelemetryState(void)
@@ -445,35 +513,31 @@ void checkHoTTTelemetryState(void)
         freeHoTTTelemetryPort();
 }
 
-void handleHoTTTelemetry(void)
+/*
+ * Responses are sent from the systick interrupt, the main loop only detects requests and turns the port around.
+ */
+uint32_t handleHoTTTelemetry(uint32_t currentMicros)
 {
-    static uint32_t serialTimer;
-
     if (!hottTelemetryEnabled) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
-    uint32_t now = micros();
+    if (hottIsSending) {
+        if (!hottTxComplete) {
+            hottTxBuffer_t *buffer = hottTxFrontBuffer;
+            return currentMicros + (buffer->length - hottTxPosition + 1) * HOTT_TX_DELAY_US;
+        }
 
-    if (shouldPrepareHoTTMessages(now)) {
-        hottPrepareMessages();
-        lastMessagesPreparedAt = now;
-    }
+        hottTxFrontBuffer = NULL;
+        hottIsSending = false;
 
-    if (shouldCheckForHoTTRequest()) {
-        hottCheckSerialData(now);
+        serialSetMode(hottPort, MODE_RX);
+        flushHottRxBuffer();
     }
 
-    if (!hottMsg)
-        return;
+    hottCheckSerialData(currentMicros);
 
-    if (hottIsSending) {
-        if(now - serialTimer < HOTT_TX_DELAY_US) {
-            return;
-        }
-    }
-    hottSendTelemetryData();
-    serialTimer = now;
+    return currentMicros;
 }
 
 #endif
@@ -35,7 +35,10 @@
 #include "io/serial.h"
 #include "io/serial_msp.h"
 
+#include "drivers/system.h"
+
 #include "telemetry/telemetry.h"
+#include "telemetry/scheduler.h"
 #include "telemetry/msp.h"
 
 static telemetryConfig_t *telemetryConfig;
@@ -48,6 +51,24 @@ static portSharing_e mspPortSharing;
 
 static serialPort_t *mspTelemetryPort = NULL;
 
+// one reply is sent per slot, sizes are only estimates, the slots are spaced by the bytes actually sent
+#define TELEMETRY_MSP_FRAME_SIZE 255
+
+static const telemetrySensor_t mspTelemetrySensors[MSP_TELEMETRY_COMMAND_COUNT] = {
+    [MSP_TELEMETRY_BOXNAMES]   = { 3, 200, 5000, NULL },
+    [MSP_TELEMETRY_STATUS]     = { 0, 17,  250,  NULL },
+    [MSP_TELEMETRY_IDENT]      = { 3, 13,  5000, NULL },
+    [MSP_TELEMETRY_RAW_IMU]    = { 2, 24,  250,  NULL },
+    [MSP_TELEMETRY_ALTITUDE]   = { 1, 12,  200,  NULL },
+    [MSP_TELEMETRY_RAW_GPS]    = { 1, 22,  500,  NULL },
+    [MSP_TELEMETRY_RC]         = { 1, 42,  200,  NULL },
+    [MSP_TELEMETRY_MOTOR_PINS] = { 3, 14,  5000, NULL },
+    [MSP_TELEMETRY_ATTITUDE]   = { 0, 12,  100,  NULL },
+    [MSP_TELEMETRY_SERVO]      = { 2, 22,  500,  NULL },
+};
+
+static telemetryScheduler_t mspTelemetryScheduler;
+
 void initMSPTelemetry(telemetryConfig_t *initialTelemetryConfig)
 {
     telemetryConfig = initialTelemetryConfig;
@@ -69,17 +90,33 @@ void checkMSPTelemetryState(void)
         freeMSPTelemetryPort();
 }
 
-void handleMSPTelemetry(void)
+/*
+ * Sends the most urgent due reply once the previous one had time to go out at the port's baud rate.
+ */
+uint32_t handleMSPTelemetry(uint32_t currentMicros)
 {
     if (!mspTelemetryEnabled) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
     if (!mspTelemetryPort) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
-    sendMspTelemetry();
+    if (!telemetrySchedulerIsSlotOpen(&mspTelemetryScheduler, currentMicros)) {
+        return mspTelemetryScheduler.nextSlotAt;
+    }
+
+    uint8_t command;
+    uint16_t bytesSent = 0;
+
+    if (telemetrySchedulerFillFrame(&mspTelemetryScheduler, currentMicros, TELEMETRY_MSP_FRAME_SIZE, &command, 1)) {
+        bytesSent = sendMspTelemetry(command);
+    }
+
+    telemetrySchedulerFrameSent(&mspTelemetryScheduler, currentMicros, bytesSent);
+
+    return mspTelemetryScheduler.nextSlotAt;
 }
 
 void freeMSPTelemetryPort(void)
@@ -108,6 +145,8 @@ void configureMSPTelemetryPort(void)
     }
     mspSetTelemetryPort(mspTelemetryPort);
 
+    telemetrySchedulerInit(&mspTelemetryScheduler, mspTelemetrySensors, MSP_TELEMETRY_COMMAND_COUNT, baudRates[baudRateIndex] / 10, micros());
+
     mspTelemetryEnabled = true;
 }
 
@@ -26,7 +26,7 @@
 #define TELEMETRY_MSP_H_
 
 void initMSPTelemetry(telemetryConfig_t *initialTelemetryConfig);
-void handleMSPTelemetry(void);
+uint32_t handleMSPTelemetry(uint32_t currentMicros);
 void checkMSPTelemetryState(void);
 
 void freeMSPTelemetryPort(void);
@@ -0,0 +1,209 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Decides which telemetry values go out next, shared by the telemetry backends.
+ *
+ * Each sensor has a priority and an interval.  Frames are packed with the due sensors, most important first, up to the
+ * frame size, and the next slot is opened once the link had time to send the previous frame and something is due.
+ * Backends that answer a receiver's polls instead take one sensor per poll.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef TELEMETRY
+
+#include "common/maths.h"
+
+#include "telemetry/scheduler.h"
+
+static bool isTimeReached(uint32_t time, uint32_t currentMicros)
+{
+    return (int32_t)(currentMicros - time) >= 0;
+}
+
+/*
+ * A sensor that has not been sent for a long time may look far in the future once micros() wraps, so a due time
+ * beyond one interval from now is taken as due too.
+ */
+static bool isSensorDue(const telemetryScheduler_t *scheduler, uint8_t sensorIndex, uint32_t currentMicros)
+{
+    int32_t timeUntilDue = scheduler->dueAt[sensorIndex] - currentMicros;
+
+    return timeUntilDue <= 0 || timeUntilDue > (int32_t)(scheduler->sensors[sensorIndex].intervalMs * 1000);
+}
+
+static bool isSensorAvailable(const telemetrySensor_t *sensor)
+{
+    return !sensor->isAvailable || sensor->isAvailable();
+}
+
+static void sensorSent(telemetryScheduler_t *scheduler, uint8_t sensorIndex, uint32_t currentMicros)
+{
+    uint32_t interval = scheduler->sensors[sensorIndex].intervalMs * 1000;
+
+    // keep the average rate if a slot came a little late, but don't try to catch up after a long gap
+    scheduler->dueAt[sensorIndex] += interval;
+    if (isSensorDue(scheduler, sensorIndex, currentMicros)) {
+        scheduler->dueAt[sensorIndex] = currentMicros + interval;
+    }
+}
+
+// lower priority value first, then the one that has been due the longest
+static bool isMoreUrgent(const telemetryScheduler_t *scheduler, uint8_t candidate, int8_t best)
+{
+    if (best < 0) {
+        return true;
+    }
+
+    uint8_t candidatePriority = scheduler->sensors[candidate].priority;
+    uint8_t bestPriority = scheduler->sensors[best].priority;
+
+    if (candidatePriority != bestPriority) {
+        return candidatePriority < bestPriority;
+    }
+
+    return (int32_t)(scheduler->dueAt[candidate] - scheduler->dueAt[best]) < 0;
+}
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, uint8_t sensorCount, uint16_t bytesPerSecond, uint32_t currentMicros)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+
+    scheduler->sensors = sensors;
+    scheduler->sensorCount = MIN(sensorCount, TELEMETRY_SCHEDULER_MAX_SENSORS);
+    scheduler->bytesPerSecond = bytesPerSecond;
+    scheduler->nextSlotAt = currentMicros;
+
+    for (uint8_t index = 0; index < scheduler->sensorCount; index++) {
+        scheduler->dueAt[index] = currentMicros;
+    }
+}
+
+bool telemetrySchedulerIsSlotOpen(const telemetryScheduler_t *scheduler, uint32_t currentMicros)
+{
+    return isTimeReached(scheduler->nextSlotAt, currentMicros);
+}
+
+/*
+ * Picks the due sensors for the next frame, most urgent first, skipping any that don't fit in the space left.
+ * Due sensors that are unavailable are skipped for one interval.  Returns the number of sensor indexes written.
+ */
+uint8_t telemetrySchedulerFillFrame(telemetryScheduler_t *scheduler, uint32_t currentMicros, uint8_t frameSize, uint8_t *sensorIndexes, uint8_t maxSensors)
+{
+    uint8_t count = 0;
+    uint8_t bytesLeft = frameSize;
+
+    while (count < maxSensors) {
+        int8_t best = -1;
+
+        for (uint8_t index = 0; index < scheduler->sensorCount; index++) {
+            const telemetrySensor_t *sensor = &scheduler->sensors[index];
+
+            if (!isSensorDue(scheduler, index, currentMicros) || sensor->size > bytesLeft) {
+                continue;
+            }
+            if (!isSensorAvailable(sensor)) {
+                sensorSent(scheduler, index, currentMicros);
+                continue;
+            }
+            if (isMoreUrgent(scheduler, index, best)) {
+                best = index;
+            }
+        }
+
+        if (best < 0) {
+            break;
+        }
+
+        sensorIndexes[count++] = best;
+        bytesLeft -= scheduler->sensors[best].size;
+        sensorSent(scheduler, best, currentMicros);
+    }
+
+    return count;
+}
+
+/*
+ * Opens the next slot once the link had time to send the bytes just written and a sensor is due.
+ */
+void telemetrySchedulerFrameSent(telemetryScheduler_t *scheduler, uint32_t currentMicros, uint16_t bytesSent)
+{
+    uint32_t linkFreeAt = currentMicros;
+    if (scheduler->bytesPerSecond) {
+        linkFreeAt += (uint32_t)bytesSent * 1000000 / scheduler->bytesPerSecond;
+    }
+
+    uint32_t nextDueAt = 0;
+    for (uint8_t index = 0; index < scheduler->sensorCount; index++) {
+        if (index == 0 || (int32_t)(scheduler->dueAt[index] - nextDueAt) < 0) {
+            nextDueAt = scheduler->dueAt[index];
+        }
+    }
+
+    scheduler->nextSlotAt = isTimeReached(nextDueAt, linkFreeAt) ? linkFreeAt : nextDueAt;
+}
+
+/*
+ * For links where the receiver polls for one value at a time.  A poll that is left unanswered is wasted, so if no
+ * sensor is due the one that will be due first is sent early.  Returns -1 if no sensor is available.
+ */
+int8_t telemetrySchedulerNextSensor(telemetryScheduler_t *scheduler, uint32_t currentMicros)
+{
+    int8_t best = -1;
+    int8_t earliest = -1;
+
+    for (uint8_t index = 0; index < scheduler->sensorCount; index++) {
+        if (!isSensorAvailable(&scheduler->sensors[index])) {
+            continue;
+        }
+
+        if (isSensorDue(scheduler, index, currentMicros) && isMoreUrgent(scheduler, index, best)) {
+            best = index;
+        }
+        if (earliest < 0 || (int32_t)(scheduler->dueAt[index] - scheduler->dueAt[earliest]) < 0) {
+            earliest = index;
+        }
+    }
+
+    if (best < 0) {
+        best = earliest;
+    }
+    if (best >= 0) {
+        sensorSent(scheduler, best, currentMicros);
+    }
+
+    return best;
+}
+
+/*
+ * For backends that send a sensor on request, returns true and reschedules the sensor if it is due.
+ */
+bool telemetrySchedulerTakeSensor(telemetryScheduler_t *scheduler, uint8_t sensorIndex, uint32_t currentMicros)
+{
+    if (!isSensorDue(scheduler, sensorIndex, currentMicros)) {
+        return false;
+    }
+
+    sensorSent(scheduler, sensorIndex, currentMicros);
+    return true;
+}
+
+#endif
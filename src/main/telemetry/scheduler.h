@@ -0,0 +1,50 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TELEMETRY_SCHEDULER_H_
+#define TELEMETRY_SCHEDULER_H_
+
+#define TELEMETRY_SCHEDULER_MAX_SENSORS 24
+
+/*
+ * A value a telemetry backend can send.  Backends keep a table of these, indexed by their own sensor enum.
+ */
+typedef struct telemetrySensor_s {
+    uint8_t priority;               // 0 is the most important
+    uint8_t size;                   // bytes the value takes in a frame
+    uint16_t intervalMs;            // how often the value should be sent
+    bool (*isAvailable)(void);      // NULL if the value can always be sent
+} telemetrySensor_t;
+
+typedef struct telemetryScheduler_s {
+    const telemetrySensor_t *sensors;
+    uint8_t sensorCount;
+    uint16_t bytesPerSecond;        // link budget, 0 if the link is paced by the receiver's requests
+    uint32_t nextSlotAt;            // micros
+    uint32_t dueAt[TELEMETRY_SCHEDULER_MAX_SENSORS];
+} telemetryScheduler_t;
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, uint8_t sensorCount, uint16_t bytesPerSecond, uint32_t currentMicros);
+
+bool telemetrySchedulerIsSlotOpen(const telemetryScheduler_t *scheduler, uint32_t currentMicros);
+uint8_t telemetrySchedulerFillFrame(telemetryScheduler_t *scheduler, uint32_t currentMicros, uint8_t frameSize, uint8_t *sensorIndexes, uint8_t maxSensors);
+void telemetrySchedulerFrameSent(telemetryScheduler_t *scheduler, uint32_t currentMicros, uint16_t bytesSent);
+
+int8_t telemetrySchedulerNextSensor(telemetryScheduler_t *scheduler, uint32_t currentMicros);
+bool telemetrySchedulerTakeSensor(telemetryScheduler_t *scheduler, uint8_t sensorIndex, uint32_t currentMicros);
+
+#endif /* TELEMETRY_SCHEDULER_H_ */
@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "platform.h"
@@ -12,53 +13,36 @@
 #ifdef TELEMETRY
 
 #include "common/axis.h"
-#include "common/color.h"
 #include "common/maths.h"
 
 #include "drivers/system.h"
 #include "drivers/sensor.h"
 #include "drivers/accgyro.h"
-#include "drivers/compass.h"
 #include "drivers/serial.h"
-#include "drivers/bus_i2c.h"
-#include "drivers/gpio.h"
-#include "drivers/timer.h"
-#include "drivers/pwm_rx.h"
-#include "drivers/adc.h"
-#include "drivers/light_led.h"
 
 #include "rx/rx.h"
-#include "rx/msp.h"
 
-#include "io/escservo.h"
 #include "io/rc_controls.h"
 #include "io/gps.h"
-#include "io/gimbal.h"
 #include "io/serial.h"
-#include "io/ledstrip.h"
 
-#include "sensors/boardalignment.h"
 #include "sensors/sensors.h"
 #include "sensors/battery.h"
 #include "sensors/acceleration.h"
 #include "sensors/barometer.h"
-#include "sensors/compass.h"
 #include "sensors/gyro.h"
 
 #include "flight/pid.h"
 #include "flight/imu.h"
 #include "flight/mixer.h"
-#include "flight/failsafe.h"
-#include "flight/navigation.h"
 #include "flight/altitudehold.h"
 
 #include "telemetry/telemetry.h"
+#include "telemetry/scheduler.h"
 #include "telemetry/smartport.h"
 
 #include "config/runtime_config.h"
 #include "config/config.h"
-#include "config/config_profile.h"
-#include "config/config_master.h"
 
 enum
 {
@@ -107,37 +91,88 @@ enum
     FSSP_DATAID_GPS_ALT    = 0x0820 ,
 };
 
-const uint16_t frSkyDataIdTable[] = {
-    FSSP_DATAID_SPEED     ,
-    FSSP_DATAID_VFAS      ,
-    FSSP_DATAID_CURRENT   ,
-    //FSSP_DATAID_RPM       ,
-    FSSP_DATAID_ALTITUDE  ,
-    FSSP_DATAID_FUEL      ,
-    //FSSP_DATAID_ADC1      ,
-    //FSSP_DATAID_ADC2      ,
-    FSSP_DATAID_LATLONG   ,
-    FSSP_DATAID_LATLONG   , // twice
-    //FSSP_DATAID_CAP_USED  ,
-    FSSP_DATAID_VARIO     ,
-    //FSSP_DATAID_CELLS     ,
-    //FSSP_DATAID_CELLS_LAST,
-    FSSP_DATAID_HEADING   ,
-    FSSP_DATAID_ACCX      ,
-    FSSP_DATAID_ACCY      ,
-    FSSP_DATAID_ACCZ      ,
-    FSSP_DATAID_T1        ,
-    FSSP_DATAID_T2        ,
-    FSSP_DATAID_GPS_ALT   ,
-    0
+typedef enum {
+    SMARTPORT_SENSOR_VFAS = 0,
+    SMARTPORT_SENSOR_CURRENT,
+    SMARTPORT_SENSOR_ALTITUDE,
+    SMARTPORT_SENSOR_FUEL,
+    SMARTPORT_SENSOR_VARIO,
+    SMARTPORT_SENSOR_HEADING,
+    SMARTPORT_SENSOR_ACCX,
+    SMARTPORT_SENSOR_ACCY,
+    SMARTPORT_SENSOR_ACCZ,
+    SMARTPORT_SENSOR_T1,
+    SMARTPORT_SENSOR_T2,
+#ifdef GPS
+    SMARTPORT_SENSOR_SPEED,
+    SMARTPORT_SENSOR_LATITUDE,
+    SMARTPORT_SENSOR_LONGITUDE,
+    SMARTPORT_SENSOR_GPS_ALT,
+#endif
+    SMARTPORT_SENSOR_COUNT
+} smartPortSensor_e;
+
+static const uint16_t smartPortDataIds[SMARTPORT_SENSOR_COUNT] = {
+    [SMARTPORT_SENSOR_VFAS]      = FSSP_DATAID_VFAS,
+    [SMARTPORT_SENSOR_CURRENT]   = FSSP_DATAID_CURRENT,
+    [SMARTPORT_SENSOR_ALTITUDE]  = FSSP_DATAID_ALTITUDE,
+    [SMARTPORT_SENSOR_FUEL]      = FSSP_DATAID_FUEL,
+    [SMARTPORT_SENSOR_VARIO]     = FSSP_DATAID_VARIO,
+    [SMARTPORT_SENSOR_HEADING]   = FSSP_DATAID_HEADING,
+    [SMARTPORT_SENSOR_ACCX]      = FSSP_DATAID_ACCX,
+    [SMARTPORT_SENSOR_ACCY]      = FSSP_DATAID_ACCY,
+    [SMARTPORT_SENSOR_ACCZ]      = FSSP_DATAID_ACCZ,
+    [SMARTPORT_SENSOR_T1]        = FSSP_DATAID_T1,
+    [SMARTPORT_SENSOR_T2]        = FSSP_DATAID_T2,
+#ifdef GPS
+    [SMARTPORT_SENSOR_SPEED]     = FSSP_DATAID_SPEED,
+    [SMARTPORT_SENSOR_LATITUDE]  = FSSP_DATAID_LATLONG,
+    [SMARTPORT_SENSOR_LONGITUDE] = FSSP_DATAID_LATLONG,
+    [SMARTPORT_SENSOR_GPS_ALT]   = FSSP_DATAID_GPS_ALT,
+#endif
 };
 
+#ifdef GPS
+static bool smartPortHasGpsFix(void)
+{
+    return sensors(SENSOR_GPS) && STATE(GPS_FIX);
+}
+#endif
+
+#define SMARTPORT_PACKAGE_SIZE 8
+
+// one value is sent per request, so only priorities and intervals matter
+static const telemetrySensor_t smartPortSensors[SMARTPORT_SENSOR_COUNT] = {
+    [SMARTPORT_SENSOR_VFAS]      = { 0, SMARTPORT_PACKAGE_SIZE, 500,  NULL },
+    [SMARTPORT_SENSOR_CURRENT]   = { 0, SMARTPORT_PACKAGE_SIZE, 500,  NULL },
+    [SMARTPORT_SENSOR_ALTITUDE]  = { 0, SMARTPORT_PACKAGE_SIZE, 200,  NULL },
+    [SMARTPORT_SENSOR_FUEL]      = { 1, SMARTPORT_PACKAGE_SIZE, 1000, NULL },
+    [SMARTPORT_SENSOR_VARIO]     = { 0, SMARTPORT_PACKAGE_SIZE, 100,  NULL },
+    [SMARTPORT_SENSOR_HEADING]   = { 1, SMARTPORT_PACKAGE_SIZE, 200,  NULL },
+    [SMARTPORT_SENSOR_ACCX]      = { 2, SMARTPORT_PACKAGE_SIZE, 200,  NULL },
+    [SMARTPORT_SENSOR_ACCY]      = { 2, SMARTPORT_PACKAGE_SIZE, 200,  NULL },
+    [SMARTPORT_SENSOR_ACCZ]      = { 2, SMARTPORT_PACKAGE_SIZE, 200,  NULL },
+    [SMARTPORT_SENSOR_T1]        = { 1, SMARTPORT_PACKAGE_SIZE, 500,  NULL },
+    [SMARTPORT_SENSOR_T2]        = { 2, SMARTPORT_PACKAGE_SIZE, 1000, NULL },
+#ifdef GPS
+    [SMARTPORT_SENSOR_SPEED]     = { 1, SMARTPORT_PACKAGE_SIZE, 500,  smartPortHasGpsFix },
+    [SMARTPORT_SENSOR_LATITUDE]  = { 1, SMARTPORT_PACKAGE_SIZE, 1000, smartPortHasGpsFix },
+    [SMARTPORT_SENSOR_LONGITUDE] = { 1, SMARTPORT_PACKAGE_SIZE, 1000, smartPortHasGpsFix },
+    [SMARTPORT_SENSOR_GPS_ALT]   = { 2, SMARTPORT_PACKAGE_SIZE, 1000, smartPortHasGpsFix },
+#endif
+};
+
+static telemetryScheduler_t smartPortScheduler;
+
 #define __USE_C99_MATH // for roundf()
 #define SMARTPORT_BAUD 57600
 #define SMARTPORT_UART_MODE MODE_BIDIR
 #define SMARTPORT_SERVICE_DELAY_MS 5 // telemetry requests comes in at roughly 12 ms intervals, keep this under that
 #define SMARTPORT_NOT_CONNECTED_TIMEOUT_MS 7000
 
+// every byte of a package may need escaping
+#define SMARTPORT_FRAME_MAX_SIZE (SMARTPORT_PACKAGE_SIZE * 2)
+
 static serialPort_t *smartPortSerialPort = NULL; // The 'SmartPort'(tm) Port.
 static serialPortConfig_t *portConfig;
 
@@ -145,28 +180,56 @@ static telemetryConfig_t *telemetryConfig;
 static bool smartPortTelemetryEnabled =  false;
 static portSharing_e smartPortPortSharing;
 
-extern void serialInit(serialConfig_t *); // from main.c // FIXME remove this dependency
+typedef struct smartPortFrame_s {
+    uint8_t data[SMARTPORT_FRAME_MAX_SIZE];
+    uint8_t length;
+} smartPortFrame_t;
+
+// prepared by the main loop, sent from the receive callback as soon as one of our IDs is polled
+static volatile smartPortFrame_t smartPortPreparedFrame;
+static volatile bool smartPortFrameReady = false;
+
+// ports that receive with DMA don't call back, requests are then read by the main loop
+static volatile bool smartPortRxCallbackActive = false;
+
+static smartPortStats_t smartPortStats;
 
-char smartPortState = SPSTATE_UNINITIALIZED;
-static uint8_t smartPortHasRequest = 0;
-static uint8_t smartPortIdCnt = 0;
-static uint32_t smartPortLastRequestTime = 0;
-static uint32_t smartPortLastServiceTime = 0;
+volatile char smartPortState = SPSTATE_UNINITIALIZED;
+static volatile uint32_t smartPortLastRequestTime = 0;
+
+static void smartPortRespond(void)
+{
+    smartPortStats.polls++;
+
+    if (!smartPortFrameReady) {
+        smartPortStats.droppedPolls++;
+        return;
+    }
+
+    for (uint8_t index = 0; index < smartPortPreparedFrame.length; index++) {
+        serialWrite(smartPortSerialPort, smartPortPreparedFrame.data[index]);
+    }
+
+    smartPortFrameReady = false;
+    smartPortStats.responses++;
+}
 
 static void smartPortDataReceive(uint16_t c)
 {
-    uint32_t now = millis();
+    if (smartPortState == SPSTATE_TIMEDOUT) {
+        return;
+    }
 
     // look for a valid request sequence
     static uint8_t lastChar;
     if (lastChar == FSSP_START_STOP) {
         smartPortState = SPSTATE_WORKING;
-        smartPortLastRequestTime = now;
+        smartPortLastRequestTime = millis();
         if ((c == FSSP_SENSOR_ID1) ||
             (c == FSSP_SENSOR_ID2) ||
             (c == FSSP_SENSOR_ID3) ||
             (c == FSSP_SENSOR_ID4)) {
-            smartPortHasRequest = 1;
+            smartPortRespond();
             // we only responde to these IDs
             // the X4R-SB does send other IDs, we ignore them, but take note of the time
         }
@@ -174,15 +237,21 @@ static void smartPortDataReceive(uint16_t c)
     lastChar = c;
 }
 
-static void smartPortSendByte(uint8_t c, uint16_t *crcp)
+static void smartPortRxCallback(uint16_t c)
+{
+    smartPortRxCallbackActive = true;
+    smartPortDataReceive(c);
+}
+
+static void smartPortPrepareByte(uint8_t c, uint16_t *crcp)
 {
     // smart port escape sequence
     if (c == 0x7D || c == 0x7E) {
-        serialWrite(smartPortSerialPort, 0x7D);
+        smartPortPreparedFrame.data[smartPortPreparedFrame.length++] = 0x7D;
         c ^= 0x20;
     }
 
-    serialWrite(smartPortSerialPort, c);
+    smartPortPreparedFrame.data[smartPortPreparedFrame.length++] = c;
 
     if (crcp == NULL)
         return;
@@ -194,21 +263,25 @@ static void smartPortSendByte(uint8_t c, uint16_t *crcp)
     *crcp = crc;
 }
 
-static void smartPortSendPackage(uint16_t id, uint32_t val)
+static void smartPortPreparePackage(uint16_t id, uint32_t val)
 {
     uint16_t crc = 0;
-    smartPortSendByte(FSSP_DATA_FRAME, &crc);
+    smartPortPreparedFrame.length = 0;
+    smartPortPrepareByte(FSSP_DATA_FRAME, &crc);
     uint8_t *u8p = (uint8_t*)&id;
-    smartPortSendByte(u8p[0], &crc);
-    smartPortSendByte(u8p[1], &crc);
+    smartPortPrepareByte(u8p[0], &crc);
+    smartPortPrepareByte(u8p[1], &crc);
     u8p = (uint8_t*)&val;
-    smartPortSendByte(u8p[0], &crc);
-    smartPortSendByte(u8p[1], &crc);
-    smartPortSendByte(u8p[2], &crc);
-    smartPortSendByte(u8p[3], &crc);
-    smartPortSendByte(0xFF - (uint8_t)crc, NULL);
+    smartPortPrepareByte(u8p[0], &crc);
+    smartPortPrepareByte(u8p[1], &crc);
+    smartPortPrepareByte(u8p[2], &crc);
+    smartPortPrepareByte(u8p[3], &crc);
+    smartPortPrepareByte(0xFF - (uint8_t)crc, NULL);
+}
 
-    smartPortLastServiceTime = millis();
+const smartPortStats_t *getSmartPortStats(void)
+{
+    return &smartPortStats;
 }
 
 void initSmartPortTelemetry(telemetryConfig_t *initialTelemetryConfig)
@@ -224,6 +297,8 @@ void freeSmartPortTelemetryPort(void)
     smartPortSerialPort = NULL;
 
     smartPortState = SPSTATE_UNINITIALIZED;
+    smartPortFrameReady = false;
+    smartPortRxCallbackActive = false;
     smartPortTelemetryEnabled = false;
 }
 
@@ -233,12 +308,16 @@ void configureSmartPortTelemetryPort(void)
         return;
     }
 
-    smartPortSerialPort = openSerialPort(portConfig->identifier, FUNCTION_TELEMETRY_SMARTPORT, NULL, SMARTPORT_BAUD, SMARTPORT_UART_MODE, telemetryConfig->telemetry_inversion);
+    smartPortSerialPort = openSerialPort(portConfig->identifier, FUNCTION_TELEMETRY_SMARTPORT, smartPortRxCallback, SMARTPORT_BAUD, SMARTPORT_UART_MODE, telemetryConfig->telemetry_inversion);
 
     if (!smartPortSerialPort) {
         return;
     }
 
+    telemetrySchedulerInit(&smartPortScheduler, smartPortSensors, SMARTPORT_SENSOR_COUNT, 0, micros());
+    memset(&smartPortStats, 0, sizeof(smartPortStats));
+    smartPortLastRequestTime = millis();
+
     smartPortState = SPSTATE_INITIALIZED;
     smartPortTelemetryEnabled = true;
 }
@@ -267,14 +346,146 @@ void checkSmartPortTelemetryState(void)
         freeSmartPortTelemetryPort();
 }
 
-void handleSmartPortTelemetry(void)
+static uint32_t smartPortGpsCoordinate(int32_t coordinate)
+{
+    // the same ID is sent twice, one for longitude, one for latitude
+    // the MSB of the sent uint32_t helps FrSky keep track
+    uint32_t tmpui = coordinate;
+    if (coordinate < 0) {
+        tmpui = -coordinate;
+        tmpui |= 0x40000000;
+    }
+    return tmpui;
+}
+
+static uint32_t smartPortFlightModeFlags(void)
+{
+    static uint8_t t1Cnt = 0;
+    int32_t tmpi;
+
+    // we send all the flags as decimal digits for easy reading
+
+    // the t1Cnt simply allows the telemetry view to show at least some changes
+    t1Cnt++;
+    if (t1Cnt >= 4) {
+        t1Cnt = 1;
+    }
+    tmpi = t1Cnt * 10000; // start off with at least one digit so the most significant 0 won't be cut off
+    // the Taranis seems to be able to fit 5 digits on the screen
+    // the Taranis seems to consider this number a signed 16 bit integer
+
+    if (ARMING_FLAG(OK_TO_ARM))
+        tmpi += 1;
+    if (ARMING_FLAG(PREVENT_ARMING))
+        tmpi += 2;
+    if (ARMING_FLAG(ARMED))
+        tmpi += 4;
+
+    if (FLIGHT_MODE(ANGLE_MODE))
+        tmpi += 10;
+    if (FLIGHT_MODE(HORIZON_MODE))
+        tmpi += 20;
+    if (FLIGHT_MODE(AUTOTUNE_MODE))
+        tmpi += 40;
+    if (FLIGHT_MODE(PASSTHRU_MODE))
+        tmpi += 40;
+
+    if (FLIGHT_MODE(MAG_MODE))
+        tmpi += 100;
+    if (FLIGHT_MODE(BARO_MODE))
+        tmpi += 200;
+    if (FLIGHT_MODE(SONAR_MODE))
+        tmpi += 400;
+
+    if (FLIGHT_MODE(GPS_HOLD_MODE))
+        tmpi += 1000;
+    if (FLIGHT_MODE(GPS_HOME_MODE))
+        tmpi += 2000;
+    if (FLIGHT_MODE(HEADFREE_MODE))
+        tmpi += 4000;
+
+    return tmpi;
+}
+
+static void smartPortPrepareSensor(smartPortSensor_e sensor)
+{
+    uint16_t id = smartPortDataIds[sensor];
+
+    switch (sensor) {
+        case SMARTPORT_SENSOR_VFAS:
+            smartPortPreparePackage(id, vbat * 83); // supposedly given in 0.1V, unknown requested unit
+            // multiplying by 83 seems to make Taranis read correctly
+            break;
+        case SMARTPORT_SENSOR_CURRENT:
+            smartPortPreparePackage(id, amperage); // given in 10mA steps, unknown requested unit
+            break;
+        case SMARTPORT_SENSOR_ALTITUDE:
+            smartPortPreparePackage(id, BaroAlt); // unknown given unit, requested 100 = 1 meter
+            break;
+        case SMARTPORT_SENSOR_FUEL:
+            smartPortPreparePackage(id, mAhDrawn); // given in mAh, unknown requested unit
+            break;
+        case SMARTPORT_SENSOR_VARIO:
+            smartPortPreparePackage(id, vario); // unknown given unit but requested in 100 = 1m/s
+            break;
+        case SMARTPORT_SENSOR_HEADING:
+            smartPortPreparePackage(id, heading * 100); // given in deg, requested in 10000 = 100 deg
+            break;
+        case SMARTPORT_SENSOR_ACCX:
+            smartPortPreparePackage(id, accSmooth[X] / 44);
+            // unknown input and unknown output unit
+            // we can only show 00.00 format, another digit won't display right on Taranis
+            // dividing by roughly 44 will give acceleration in G units
+            break;
+        case SMARTPORT_SENSOR_ACCY:
+            smartPortPreparePackage(id, accSmooth[Y] / 44);
+            break;
+        case SMARTPORT_SENSOR_ACCZ:
+            smartPortPreparePackage(id, accSmooth[Z] / 44);
+            break;
+        case SMARTPORT_SENSOR_T1:
+            smartPortPreparePackage(id, smartPortFlightModeFlags());
+            break;
+        case SMARTPORT_SENSOR_T2:
+#ifdef GPS
+            if (sensors(SENSOR_GPS)) {
+                // provide GPS lock status
+                smartPortPreparePackage(id, (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + GPS_numSat);
+                break;
+            }
+#endif
+            smartPortPreparePackage(id, 0);
+            break;
+#ifdef GPS
+        case SMARTPORT_SENSOR_SPEED:
+            smartPortPreparePackage(id, (GPS_speed * 36 + 36 / 2) / 100); // given in 0.1 m/s, provide in KM/H
+            break;
+        case SMARTPORT_SENSOR_LATITUDE:
+            smartPortPreparePackage(id, smartPortGpsCoordinate(GPS_coord[LAT]));
+            break;
+        case SMARTPORT_SENSOR_LONGITUDE:
+            smartPortPreparePackage(id, smartPortGpsCoordinate(GPS_coord[LON]) | 0x80000000);
+            break;
+        case SMARTPORT_SENSOR_GPS_ALT:
+            smartPortPreparePackage(id, GPS_altitude * 1000); // given in 0.1m , requested in 100 = 1m
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/*
+ * Keeps the next value ready for the receive callback, which answers a poll without waiting for this.
+ */
+uint32_t handleSmartPortTelemetry(uint32_t currentMicros)
 {
     if (!smartPortTelemetryEnabled) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
     if (!canSendSmartPortTelemetry()) {
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
     while (serialTotalBytesWaiting(smartPortSerialPort) > 0) {
@@ -287,177 +498,23 @@ void handleSmartPortTelemetry(void)
     // if timed out, reconfigure the UART back to normal so the GUI or CLI works
     if ((now - smartPortLastRequestTime) > SMARTPORT_NOT_CONNECTED_TIMEOUT_MS) {
         smartPortState = SPSTATE_TIMEDOUT;
-        return;
+        return currentMicros + TELEMETRY_MAX_SERVICE_INTERVAL_US;
     }
 
-    // limit the rate at which we send responses, we don't want to affect flight characteristics
-    if ((now - smartPortLastServiceTime) < SMARTPORT_SERVICE_DELAY_MS)
-        return;
-
-    if (smartPortHasRequest) {
-        // we can send back any data we want, our table keeps track of the order and frequency of each data type we send
-        uint16_t id = frSkyDataIdTable[smartPortIdCnt];
-        if (id == 0) { // end of table reached, loop back
-            smartPortIdCnt = 0;
-            id = frSkyDataIdTable[smartPortIdCnt];
+    if (!smartPortFrameReady) {
+        // the scheduler keeps track of the order and frequency of each value we send
+        int8_t sensor = telemetrySchedulerNextSensor(&smartPortScheduler, currentMicros);
+        if (sensor >= 0) {
+            smartPortPrepareSensor(sensor);
+            smartPortFrameReady = true;
         }
-        smartPortIdCnt++;
-
-        int32_t tmpi;
-        static uint8_t t1Cnt = 0;
+    }
 
-        switch(id) {
-#ifdef GPS
-            case FSSP_DATAID_SPEED      :
-                if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
-                    uint32_t tmpui = (GPS_speed * 36 + 36 / 2) / 100;
-                    smartPortSendPackage(id, tmpui); // given in 0.1 m/s, provide in KM/H
-                    smartPortHasRequest = 0;
-                }
-                break;
-#endif
-            case FSSP_DATAID_VFAS       :
-                smartPortSendPackage(id, vbat * 83); // supposedly given in 0.1V, unknown requested unit
-                // multiplying by 83 seems to make Taranis read correctly
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_CURRENT    :
-                smartPortSendPackage(id, amperage); // given in 10mA steps, unknown requested unit
-                smartPortHasRequest = 0;
-                break;
-            //case FSSP_DATAID_RPM        :
-            case FSSP_DATAID_ALTITUDE   :
-                smartPortSendPackage(id, BaroAlt); // unknown given unit, requested 100 = 1 meter
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_FUEL       :
-                smartPortSendPackage(id, mAhDrawn); // given in mAh, unknown requested unit
-                smartPortHasRequest = 0;
-                break;
-            //case FSSP_DATAID_ADC1       :
-            //case FSSP_DATAID_ADC2       :
-#ifdef GPS
-            case FSSP_DATAID_LATLONG    :
-                if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
-                    uint32_t tmpui = 0;
-                    // the same ID is sent twice, one for longitude, one for latitude
-                    // the MSB of the sent uint32_t helps FrSky keep track
-                    // the even/odd bit of our counter helps us keep track
-                    if (smartPortIdCnt & 1) {
-                        tmpui = tmpi = GPS_coord[LON];
-                        if (tmpi < 0) {
-                            tmpui = -tmpi;
-                            tmpui |= 0x40000000;
-                        }
-                        tmpui |= 0x80000000;
-                    }
-                    else {
-                        tmpui = tmpi = GPS_coord[LAT];
-                        if (tmpi < 0) {
-                            tmpui = -tmpi;
-                            tmpui |= 0x40000000;
-                        }
-                    }
-                    smartPortSendPackage(id, tmpui);
-                    smartPortHasRequest = 0;
-                }
-                break;
-#endif
-            //case FSSP_DATAID_CAP_USED   :
-            case FSSP_DATAID_VARIO      :
-                smartPortSendPackage(id, vario); // unknown given unit but requested in 100 = 1m/s
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_HEADING    :
-                smartPortSendPackage(id, heading * 100); // given in deg, requested in 10000 = 100 deg
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_ACCX       :
-                smartPortSendPackage(id, accSmooth[X] / 44);
-                // unknown input and unknown output unit
-                // we can only show 00.00 format, another digit won't display right on Taranis
-                // dividing by roughly 44 will give acceleration in G units
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_ACCY       :
-                smartPortSendPackage(id, accSmooth[Y] / 44);
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_ACCZ       :
-                smartPortSendPackage(id, accSmooth[Z] / 44);
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_T1         :
-                // we send all the flags as decimal digits for easy reading
-
-                // the t1Cnt simply allows the telemetry view to show at least some changes
-                t1Cnt++;
-                if (t1Cnt >= 4) {
-                    t1Cnt = 1;
-                }
-                tmpi = t1Cnt * 10000; // start off with at least one digit so the most significant 0 won't be cut off
-                // the Taranis seems to be able to fit 5 digits on the screen
-                // the Taranis seems to consider this number a signed 16 bit integer
-
-                if (ARMING_FLAG(OK_TO_ARM))
-                    tmpi += 1;
-                if (ARMING_FLAG(PREVENT_ARMING))
-                    tmpi += 2;
-                if (ARMING_FLAG(ARMED))
-                    tmpi += 4;
-
-                if (FLIGHT_MODE(ANGLE_MODE))
-                    tmpi += 10;
-                if (FLIGHT_MODE(HORIZON_MODE))
-                    tmpi += 20;
-                if (FLIGHT_MODE(AUTOTUNE_MODE))
-                    tmpi += 40;
-                if (FLIGHT_MODE(PASSTHRU_MODE))
-                    tmpi += 40;
-
-                if (FLIGHT_MODE(MAG_MODE))
-                    tmpi += 100;
-                if (FLIGHT_MODE(BARO_MODE))
-                    tmpi += 200;
-                if (FLIGHT_MODE(SONAR_MODE))
-                    tmpi += 400;
-
-                if (FLIGHT_MODE(GPS_HOLD_MODE))
-                    tmpi += 1000;
-                if (FLIGHT_MODE(GPS_HOME_MODE))
-                    tmpi += 2000;
-                if (FLIGHT_MODE(HEADFREE_MODE))
-                    tmpi += 4000;
-
-                smartPortSendPackage(id, (uint32_t)tmpi);
-                smartPortHasRequest = 0;
-                break;
-            case FSSP_DATAID_T2         :
-                if (sensors(SENSOR_GPS)) {
-#ifdef GPS
-                    // provide GPS lock status
-                    smartPortSendPackage(id, (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + GPS_numSat);
-                    smartPortHasRequest = 0;
-#endif
-                }
-                else {
-                    smartPortSendPackage(id, 0);
-                    smartPortHasRequest = 0;
-                }
-                break;
-#ifdef GPS
-            case FSSP_DATAID_GPS_ALT    :
-                if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
-                    smartPortSendPackage(id, GPS_altitude * 1000); // given in 0.1m , requested in 100 = 1m
-                    smartPortHasRequest = 0;
-                }
-                break;
-#endif
-            default:
-                break;
-                // if nothing is sent, smartPortHasRequest isn't cleared, we already incremented the counter, just wait for the next loop
-        }
+    if (!smartPortRxCallbackActive) {
+        return currentMicros;
     }
+
+    return currentMicros + SMARTPORT_SERVICE_DELAY_MS * 1000;
 }
 
 #endif
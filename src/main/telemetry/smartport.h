@@ -8,9 +8,15 @@
 #ifndef TELEMETRY_SMARTPORT_H_
 #define TELEMETRY_SMARTPORT_H_
 
+typedef struct smartPortStats_s {
+    uint32_t polls;         // requests for one of our sensor IDs
+    uint32_t responses;
+    uint32_t droppedPolls;  // requests that came before the next value was ready
+} smartPortStats_t;
+
 void initSmartPortTelemetry(telemetryConfig_t *);
 
-void handleSmartPortTelemetry(void);
+uint32_t handleSmartPortTelemetry(uint32_t currentMicros);
 void checkSmartPortTelemetryState(void);
 
 void configureSmartPortTelemetryPort(void);
@@ -18,4 +24,6 @@ void freeSmartPortTelemetryPort(void);
 
 bool isSmartPortTimedOut(void);
 
+const smartPortStats_t *getSmartPortStats(void);
+
 #endif /* TELEMETRY_SMARTPORT_H_ */
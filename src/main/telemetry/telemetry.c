@@ -23,6 +23,7 @@
 
 #ifdef TELEMETRY
 
+#include "drivers/system.h"
 #include "drivers/gpio.h"
 #include "drivers/timer.h"
 #include "drivers/serial.h"
@@ -43,6 +44,8 @@
 
 static telemetryConfig_t *telemetryConfig;
 
+static uint32_t telemetryNextServiceAt = 0;
+
 void useTelemetryConfig(telemetryConfig_t *telemetryConfigToUse)
 {
     telemetryConfig = telemetryConfigToUse;
@@ -80,12 +83,28 @@ void checkTelemetryState(void)
     checkSmartPortTelemetryState();
 }
 
+static uint32_t earliestOf(uint32_t time, uint32_t otherTime)
+{
+    return (int32_t)(otherTime - time) < 0 ? otherTime : time;
+}
+
+/*
+ * Each backend returns the time it next needs to be serviced, nothing runs until the earliest of them.
+ */
 void handleTelemetry(void)
 {
-    handleFrSkyTelemetry();
-    handleHoTTTelemetry();
-    handleMSPTelemetry();
-    handleSmartPortTelemetry();
+    uint32_t now = micros();
+
+    if ((int32_t)(now - telemetryNextServiceAt) < 0) {
+        return;
+    }
+
+    uint32_t nextServiceAt = handleFrSkyTelemetry(now);
+    nextServiceAt = earliestOf(nextServiceAt, handleHoTTTelemetry(now));
+    nextServiceAt = earliestOf(nextServiceAt, handleMSPTelemetry(now));
+    nextServiceAt = earliestOf(nextServiceAt, handleSmartPortTelemetry(now));
+
+    telemetryNextServiceAt = nextServiceAt;
 }
 
 #endif
@@ -45,6 +45,9 @@ typedef struct telemetryConfig_s {
     uint8_t frsky_vfas_precision;
 } telemetryConfig_t;
 
+// how long a backend may go without being serviced while it has nothing to do
+#define TELEMETRY_MAX_SERVICE_INTERVAL_US (50 * 1000)
+
 void checkTelemetryState(void);
 void handleTelemetry(void);
 
@@ -17,10 +17,14 @@
 #include <stdint.h>
 
 #include <limits.h>
+#include <string.h>
 
 //#define DEBUG_BATTERY
 
 extern "C" {
+    #include "common/maths.h"
+
+    #include "drivers/adc.h"
     #include "sensors/battery.h"
 }
 
@@ -47,6 +51,7 @@ TEST(BatteryTest, BatteryADCToVoltage)
         .currentMeterOffset = 0,
         .currentMeterType = CURRENT_SENSOR_NONE,
         .multiwiiCurrentMeterOutput = 0,
+        .batteryResistance = 0,
         .batteryCapacity = 2200,
     };
 
@@ -81,6 +86,120 @@ TEST(BatteryTest, BatteryADCToVoltage)
     }
 }
 
+static uint16_t adcChannelValues[ADC_CHANNEL_COUNT];
+
+static batteryConfig_t testBatteryConfig;
+
+static void resetBattery(uint16_t batteryAdcReading, currentSensor_e currentMeterType, uint16_t currentMeterOffset)
+{
+    batteryConfig_t batteryConfig = {
+        .vbatscale = VBAT_SCALE_DEFAULT,
+        .vbatmaxcellvoltage = 43,
+        .vbatmincellvoltage = 33,
+        .vbatwarningcellvoltage = 35,
+        .currentMeterScale = 400,
+        .currentMeterOffset = currentMeterOffset,
+        .currentMeterType = currentMeterType,
+        .multiwiiCurrentMeterOutput = 0,
+        .batteryResistance = 0,
+        .batteryCapacity = 2200,
+    };
+    testBatteryConfig = batteryConfig;
+
+    memset(adcChannelValues, 0, sizeof(adcChannelValues));
+    adcChannelValues[ADC_BATTERY] = batteryAdcReading;
+
+    batteryInit(&testBatteryConfig);
+}
+
+TEST(BatteryTest, VoltageFilterRejectsNoise)
+{
+    // given
+    resetBattery(1890, CURRENT_SENSOR_NONE, 0);
+    uint8_t expectedVoltage = batteryAdcToVoltage(1890);
+
+    // when, the readings jump around the real value
+    uint8_t minimumVoltage = UINT8_MAX;
+    uint8_t maximumVoltage = 0;
+    for (int update = 0; update < 200; update++) {
+        adcChannelValues[ADC_BATTERY] = 1890 + ((update % 2) ? 40 : -40);
+        updateBatteryVoltage();
+        minimumVoltage = MIN(minimumVoltage, vbat);
+        maximumVoltage = MAX(maximumVoltage, vbat);
+    }
+
+    // then, +-3.5 0.1V steps of noise are reduced to a single step
+    EXPECT_GE(minimumVoltage, expectedVoltage - 1);
+    EXPECT_LE(maximumVoltage, expectedVoltage + 1);
+    EXPECT_EQ(4, batteryCellCount);
+}
+
+TEST(BatteryTest, VoltageFilterFollowsAStep)
+{
+    // given
+    resetBattery(1420, CURRENT_SENSOR_NONE, 0);
+    EXPECT_EQ(126, vbat);
+
+    // when, one time constant after the step
+    adcChannelValues[ADC_BATTERY] = 1890;
+    for (int update = 0; update < 8; update++) {
+        updateBatteryVoltage();
+    }
+
+    // then, about 63% of the way there
+    EXPECT_NEAR(126 + (168 - 126) * 63 / 100, vbat, 2);
+
+    // when
+    for (int update = 0; update < 64; update++) {
+        updateBatteryVoltage();
+    }
+
+    // then
+    EXPECT_EQ(168, vbat);
+}
+
+TEST(BatteryTest, CapacityIsIntegratedWithoutRoundingLosses)
+{
+    // given, a constant 12.34A with irregular update intervals
+    resetBattery(1890, CURRENT_SENSOR_VIRTUAL, 1234);
+
+    // when, for one hour
+    int64_t elapsed = 0;
+    for (int update = 0; elapsed < 3600LL * 1000000; update++) {
+        int32_t interval = BATTERY_UPDATE_INTERVAL_US + (update % 7) * 333 - 999;
+        updateCurrentMeter(interval);
+        elapsed += interval;
+    }
+
+    // then
+    EXPECT_EQ(1234, amperage);
+    EXPECT_NEAR(12340, mAhDrawn, 1);
+}
+
+TEST(BatteryTest, CellVoltageIsCompensatedForSag)
+{
+    // given, a 4S pack at 3.3V per cell with 50 milliohm drawing 20A
+    resetBattery(1489, CURRENT_SENSOR_VIRTUAL, 2000);
+    EXPECT_EQ(4, batteryCellCount);
+    EXPECT_EQ(132, vbat);
+
+    updateCurrentMeter(BATTERY_UPDATE_INTERVAL_US);
+    updateBatteryVoltage();
+
+    // then, without compensation that's a critical battery
+    EXPECT_EQ(330, batteryCellVoltage);
+    EXPECT_EQ(BATTERY_CRITICAL, calculateBatteryState());
+
+    // when
+    testBatteryConfig.batteryResistance = 50;
+    updateBatteryVoltage();
+
+    // then, the 1V dropped over the pack's resistance is added back
+    EXPECT_EQ(132, vbat);
+    EXPECT_EQ(355, batteryCellVoltage);
+    EXPECT_EQ(BATTERY_OK, calculateBatteryState());
+}
+
 // STUBS
 
 extern "C" {
@@ -90,8 +209,7 @@ int16_t rcCommand[4] = {0,0,0,0};
 
 uint16_t adcGetChannel(uint8_t channel)
 {
-    UNUSED(channel);
-    return 0;
+    return adcChannelValues[channel];
 }
 
 void delay(uint32_t ms)
@@ -0,0 +1,184 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/boardalignment.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static uint32_t randomSeed;
+
+static int16_t randomReading(void)
+{
+    randomSeed = randomSeed * 1664525 + 1013904223;
+    return (int16_t)(randomSeed >> 16) / 2;             // +/- 16384, e.g. +/- 1000 deg/s on a 2000 deg/s gyro
+}
+
+// the float implementation that was used before the fixed point matrices, kept as the reference
+static float referenceBoardRotation[3][3];
+
+static void referenceInitBoardAlignment(const boardAlignment_t *boardAlignment)
+{
+    float roll = degreesToRadians(boardAlignment->rollDegrees);
+    float pitch = degreesToRadians(boardAlignment->pitchDegrees);
+    float yaw = degreesToRadians(boardAlignment->yawDegrees);
+    float cosx = cosf(roll), sinx = sinf(roll);
+    float cosy = cosf(pitch), siny = sinf(pitch);
+    float cosz = cosf(yaw), sinz = sinf(yaw);
+
+    referenceBoardRotation[0][0] = cosz * cosy;
+    referenceBoardRotation[0][1] = -cosy * sinz;
+    referenceBoardRotation[0][2] = siny;
+    referenceBoardRotation[1][0] = sinz * cosx + (sinx * cosz * siny);
+    referenceBoardRotation[1][1] = cosz * cosx - (sinx * sinz * siny);
+    referenceBoardRotation[1][2] = -sinx * cosy;
+    referenceBoardRotation[2][0] = (sinx * sinz) - (cosz * cosx * siny);
+    referenceBoardRotation[2][1] = (sinx * cosz) + (sinz * cosx * siny);
+    referenceBoardRotation[2][2] = cosy * cosx;
+}
+
+static void referenceAlignSensors(const int16_t *src, int16_t *dest, uint8_t rotation, bool standardBoardAlignment)
+{
+    int16_t x = src[X], y = src[Y], z = src[Z];
+
+    switch (rotation) {
+        case CW90_DEG:       dest[X] = y;  dest[Y] = -x; dest[Z] = z;  break;
+        case CW180_DEG:      dest[X] = -x; dest[Y] = -y; dest[Z] = z;  break;
+        case CW270_DEG:      dest[X] = -y; dest[Y] = x;  dest[Z] = z;  break;
+        case CW0_DEG_FLIP:   dest[X] = -x; dest[Y] = y;  dest[Z] = -z; break;
+        case CW90_DEG_FLIP:  dest[X] = y;  dest[Y] = x;  dest[Z] = -z; break;
+        case CW180_DEG_FLIP: dest[X] = x;  dest[Y] = -y; dest[Z] = -z; break;
+        case CW270_DEG_FLIP: dest[X] = -y; dest[Y] = -x; dest[Z] = -z; break;
+        default:             dest[X] = x;  dest[Y] = y;  dest[Z] = z;  break;
+    }
+
+    if (standardBoardAlignment) {
+        return;
+    }
+
+    x = dest[X];
+    y = dest[Y];
+    z = dest[Z];
+    dest[X] = lrintf(referenceBoardRotation[0][0] * x + referenceBoardRotation[1][0] * y + referenceBoardRotation[2][0] * z);
+    dest[Y] = lrintf(referenceBoardRotation[0][1] * x + referenceBoardRotation[1][1] * y + referenceBoardRotation[2][1] * z);
+    dest[Z] = lrintf(referenceBoardRotation[0][2] * x + referenceBoardRotation[1][2] * y + referenceBoardRotation[2][2] * z);
+}
+
+TEST(BoardAlignmentTest, SensorRotationsAreExactOnStandardBoard)
+{
+    // given
+    boardAlignment_t boardAlignment = { 0, 0, 0 };
+    int16_t src[XYZ_AXIS_COUNT];
+    int16_t expected[XYZ_AXIS_COUNT];
+    int16_t actual[XYZ_AXIS_COUNT];
+    uint8_t rotation;
+    int i;
+
+    initBoardAlignment(&boardAlignment);
+    randomSeed = 1;
+
+    for (rotation = ALIGN_DEFAULT; rotation <= CW270_DEG_FLIP; rotation++) {
+        for (i = 0; i < 1000; i++) {
+            src[X] = randomReading() * 2;
+            src[Y] = randomReading() * 2;
+            src[Z] = randomReading() * 2;
+
+            // when
+            referenceAlignSensors(src, expected, rotation, true);
+            alignSensors(src, actual, rotation);
+
+            // then
+            ASSERT_EQ(expected[X], actual[X]);
+            ASSERT_EQ(expected[Y], actual[Y]);
+            ASSERT_EQ(expected[Z], actual[Z]);
+        }
+    }
+}
+
+TEST(BoardAlignmentTest, AlignsInPlace)
+{
+    // given
+    boardAlignment_t boardAlignment = { 0, 0, 0 };
+    int16_t vec[XYZ_AXIS_COUNT] = { 100, -200, 300 };
+    initBoardAlignment(&boardAlignment);
+
+    // when
+    alignSensors(vec, vec, CW90_DEG);
+
+    // then
+    EXPECT_EQ(-200, vec[X]);
+    EXPECT_EQ(-100, vec[Y]);
+    EXPECT_EQ(300, vec[Z]);
+}
+
+TEST(BoardAlignmentTest, FixedPointMatchesFloatWithinOneUnit)
+{
+    // given
+    const boardAlignment_t alignments[] = {
+        { 0, 0, 45 }, { 0, 0, 90 }, { 180, 0, 0 }, { 0, 180, 0 }, { 3, -2, 0 },
+        { -7, 11, 135 }, { 30, 60, -90 }, { 90, 45, 270 }, { -180, -180, 360 }, { 1, 1, 1 },
+    };
+    int16_t src[XYZ_AXIS_COUNT];
+    int16_t expected[XYZ_AXIS_COUNT];
+    int16_t actual[XYZ_AXIS_COUNT];
+    int maxError = 0;
+    uint8_t alignment;
+    uint8_t rotation;
+    uint8_t axis;
+    int i;
+
+    randomSeed = 1;
+
+    for (alignment = 0; alignment < ARRAYLEN(alignments); alignment++) {
+        initBoardAlignment((boardAlignment_t *)&alignments[alignment]);
+        referenceInitBoardAlignment(&alignments[alignment]);
+
+        for (rotation = ALIGN_DEFAULT; rotation <= CW270_DEG_FLIP; rotation++) {
+            for (i = 0; i < 1000; i++) {
+                src[X] = randomReading();
+                src[Y] = randomReading();
+                src[Z] = randomReading();
+
+                // when
+                referenceAlignSensors(src, expected, rotation, false);
+                alignSensors(src, actual, rotation);
+
+                // then
+                for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                    maxError = MAX(maxError, ABS(expected[axis] - actual[axis]));
+                }
+            }
+        }
+    }
+
+    // Q14 coefficients are off by at most 1/32768, i.e. 1.5 units over three terms of 16384
+    EXPECT_LE(maxError, 2);
+}
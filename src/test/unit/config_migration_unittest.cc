@@ -0,0 +1,543 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Built with -fshort-enums so that master_t is laid out like on the ARM targets, which wrote the migrated images.
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/color.h"
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/crc.h"
+
+    #include "drivers/sensor.h"
+    #include "drivers/accgyro.h"
+    #include "drivers/compass.h"
+    #include "drivers/serial.h"
+    #include "drivers/input_filtering.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/gyro.h"
+    #include "sensors/compass.h"
+    #include "sensors/acceleration.h"
+    #include "sensors/barometer.h"
+    #include "sensors/boardalignment.h"
+    #include "sensors/battery.h"
+
+    #include "io/serial.h"
+    #include "io/gimbal.h"
+    #include "io/escservo.h"
+    #include "io/rc_controls.h"
+    #include "io/rc_curves.h"
+    #include "io/ledstrip.h"
+    #include "io/gps.h"
+
+    #include "rx/rx.h"
+
+    #include "telemetry/telemetry.h"
+
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+    #include "flight/imu.h"
+    #include "flight/failsafe.h"
+    #include "flight/navigation.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
+
+    #include "config/config_profile.h"
+    #include "config/config_master.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// offsets of versions 94 and 95 on the ARM targets
+#define V94_BATTERY_CONFIG_OFFSET 262
+#define V94_CURRENT_METER_TYPE_OFFSET 270
+#define V94_BATTERY_CAPACITY_OFFSET 272
+#define V94_RX_CONFIG_OFFSET 274
+#define V94_MIDRC_OFFSET 286
+#define V94_INPUT_FILTERING_MODE_OFFSET 292
+#define V94_SMALL_ANGLE_OFFSET 296
+
+// these depend on the features of the target, the values are the ones of the unit test platform
+#define V94_SERIAL_CONFIG_OFFSET 312
+#define V94_TELEMETRY_CONFIG_OFFSET 348
+#define V94_MAGIC_EF_OFFSET 1920
+#define V94_SIZE 1924
+#define V95_SIZE 1928
+
+// version 96 after batteryConfig.batteryResistance was added, everything from batteryCapacity to serialConfig moved up
+#define V96_BATTERY_RESISTANCE_OFFSET 272
+#define V96_BATTERY_SHIFT 2
+#define V96_SIZE 1928
+
+// version 97 after the rc_interpolation settings were added to rxConfig, what follows rxConfig moved up
+#define V97_RC_INTERPOLATION_OFFSET 294
+#define V97_RX_SHIFT 2
+#define V97_TELEMETRY_CONFIG_OFFSET 352
+#define V97_SIZE 1932
+
+// version 98 after rxConfig.input_median_channels was added, it ended before gyroTempCompensation
+#define V98_MAGIC_EF_OFFSET 1924
+#define V98_SIZE 1932
+
+static uint8_t storedImage[sizeof(master_t) + 64];
+static uint32_t storedImageSize;
+
+// the flash reserved for config, firmware before the config storage kept its raw image in the last 0x800 bytes
+#define CONFIG_FLASH_SIZE 0x2000
+#define LEGACY_CONFIG_FLASH_SIZE 0x800
+
+static uint8_t configFlash[CONFIG_FLASH_SIZE];
+
+static master_t *storedConfig(void)
+{
+    return (master_t *)storedImage;
+}
+
+static void resetConfigAndStorage(void)
+{
+    memset(storedImage, 0, sizeof(storedImage));
+    storedImageSize = 0;
+    memset(configFlash, 0xFF, sizeof(configFlash));
+
+    resetEEPROM();
+    readEEPROM();
+}
+
+static void setOldLayoutValues(void)
+{
+    for (uint8_t i = 0; i < MAX_MAPPABLE_RX_INPUTS; i++) {
+        masterConfig.rxConfig.rcmap[i] = (i + 1) % MAX_MAPPABLE_RX_INPUTS;
+    }
+    masterConfig.looptime = 1234;
+    masterConfig.batteryConfig.vbatscale = 99;
+    masterConfig.batteryConfig.currentMeterType = CURRENT_SENSOR_VIRTUAL;
+    masterConfig.batteryConfig.batteryCapacity = 2200;
+    masterConfig.batteryConfig.batteryResistance = 45;
+    masterConfig.rxConfig.midrc = 1520;
+    masterConfig.rxConfig.rc_interpolation_hz = 35;
+    masterConfig.inputFilteringMode = INPUT_FILTERING_ENABLED;
+    masterConfig.small_angle = 33;
+    masterConfig.serialConfig.reboot_character = 'X';
+    masterConfig.profile[1].pidProfile.P8[ROLL] = 77;
+    masterConfig.controlRateProfiles[MAX_CONTROL_RATE_PROFILE_COUNT - 1].rcRate8 = 66;
+}
+
+static void clearOldLayoutValues(void)
+{
+    memset(masterConfig.rxConfig.rcmap, 0, sizeof(masterConfig.rxConfig.rcmap));
+    masterConfig.looptime = 0;
+    masterConfig.batteryConfig.vbatscale = 0;
+    masterConfig.batteryConfig.currentMeterType = CURRENT_SENSOR_NONE;
+    masterConfig.batteryConfig.batteryCapacity = 0;
+    masterConfig.batteryConfig.batteryResistance = 0;
+    masterConfig.rxConfig.midrc = 0;
+    masterConfig.rxConfig.rc_interpolation_hz = 0;
+    masterConfig.inputFilteringMode = INPUT_FILTERING_DISABLED;
+    masterConfig.small_angle = 0;
+    masterConfig.serialConfig.reboot_character = 0;
+    masterConfig.profile[1].pidProfile.P8[ROLL] = 0;
+    masterConfig.controlRateProfiles[MAX_CONTROL_RATE_PROFILE_COUNT - 1].rcRate8 = 0;
+}
+
+static void expectOldLayoutValues(void)
+{
+    for (uint8_t i = 0; i < MAX_MAPPABLE_RX_INPUTS; i++) {
+        EXPECT_EQ((i + 1) % MAX_MAPPABLE_RX_INPUTS, masterConfig.rxConfig.rcmap[i]);
+    }
+    EXPECT_EQ(1234, masterConfig.looptime);
+    EXPECT_EQ(99, masterConfig.batteryConfig.vbatscale);
+    EXPECT_EQ(CURRENT_SENSOR_VIRTUAL, masterConfig.batteryConfig.currentMeterType);
+    EXPECT_EQ(2200, masterConfig.batteryConfig.batteryCapacity);
+    EXPECT_EQ(1520, masterConfig.rxConfig.midrc);
+    EXPECT_EQ(INPUT_FILTERING_ENABLED, masterConfig.inputFilteringMode);
+    EXPECT_EQ(33, masterConfig.small_angle);
+    EXPECT_EQ('X', masterConfig.serialConfig.reboot_character);
+    EXPECT_EQ(77, masterConfig.profile[1].pidProfile.P8[ROLL]);
+    EXPECT_EQ(66, masterConfig.controlRateProfiles[MAX_CONTROL_RATE_PROFILE_COUNT - 1].rcRate8);
+}
+
+// Stores the values of masterConfig at the offsets that versions 94 to 97 used, batteryShift is 0 for the layouts
+// without batteryResistance and rxShift is 0 for the layouts without the rc_interpolation settings.
+static void storeOldLayoutImage(uint8_t *image, uint8_t version, uint16_t size, uint8_t batteryShift, uint8_t rxShift)
+{
+    uint8_t shift = batteryShift + rxShift;
+    uint16_t telemetryShift = rxShift ? V97_TELEMETRY_CONFIG_OFFSET - V94_TELEMETRY_CONFIG_OFFSET : 0;
+
+    memset(image, 0, size);
+    memcpy(image, &masterConfig, V94_BATTERY_CONFIG_OFFSET);
+    memcpy(image + V94_BATTERY_CONFIG_OFFSET, &masterConfig.batteryConfig, V94_CURRENT_METER_TYPE_OFFSET - V94_BATTERY_CONFIG_OFFSET);
+    image[V94_CURRENT_METER_TYPE_OFFSET] = masterConfig.batteryConfig.currentMeterType;
+    if (batteryShift) {
+        image[V96_BATTERY_RESISTANCE_OFFSET] = masterConfig.batteryConfig.batteryResistance;
+    }
+    memcpy(image + V94_BATTERY_CAPACITY_OFFSET + batteryShift, &masterConfig.batteryConfig.batteryCapacity, sizeof(uint16_t));
+    memcpy(image + V94_RX_CONFIG_OFFSET + batteryShift, masterConfig.rxConfig.rcmap, sizeof(masterConfig.rxConfig.rcmap));
+    memcpy(image + V94_MIDRC_OFFSET + batteryShift, &masterConfig.rxConfig.midrc, sizeof(uint16_t));
+    if (rxShift) {
+        image[V97_RC_INTERPOLATION_OFFSET] = masterConfig.rxConfig.rc_interpolation;
+        image[V97_RC_INTERPOLATION_OFFSET + 1] = masterConfig.rxConfig.rc_interpolation_hz;
+    }
+    image[V94_INPUT_FILTERING_MODE_OFFSET + shift] = masterConfig.inputFilteringMode;
+    image[V94_SMALL_ANGLE_OFFSET + shift] = masterConfig.small_angle;
+    memcpy(image + V94_SERIAL_CONFIG_OFFSET + shift, &masterConfig.serialConfig, sizeof(serialConfig_t));
+    memcpy(
+        image + V94_TELEMETRY_CONFIG_OFFSET + telemetryShift,
+        &masterConfig.telemetryConfig,
+        V94_MAGIC_EF_OFFSET - V94_TELEMETRY_CONFIG_OFFSET
+    );
+    image[offsetof(master_t, version)] = version;
+    memcpy(image + offsetof(master_t, size), &size, sizeof(size));
+    image[offsetof(master_t, magic_be)] = 0xBE;
+    image[V94_MAGIC_EF_OFFSET + telemetryShift] = 0xEF;
+}
+
+static void buildVersion94Image(uint8_t *image)
+{
+    // version 94 ended with an XOR checksum instead of the CRC
+    uint8_t checksum = 0;
+
+    storeOldLayoutImage(image, 94, V94_SIZE, 0, 0);
+    for (uint32_t i = 0; i < V94_SIZE; i++) {
+        checksum ^= image[i];
+    }
+    image[V94_MAGIC_EF_OFFSET + 1] = checksum;
+}
+
+static void storeVersion94Image(void)
+{
+    buildVersion94Image(storedImage);
+    storedImageSize = V94_SIZE;
+}
+
+// versions after 94 end with a CRC32
+static void storeCrcImage(uint8_t version, uint16_t size, uint8_t batteryShift, uint8_t rxShift)
+{
+    storeOldLayoutImage(storedImage, version, size, batteryShift, rxShift);
+    uint32_t crc = crc32Update(0, storedImage, size - sizeof(crc));
+    memcpy(storedImage + size - sizeof(crc), &crc, sizeof(crc));
+    storedImageSize = size;
+}
+
+TEST(ConfigMigrationTest, LayoutIsTheOneOfTheArmTargets)
+{
+    EXPECT_EQ(1u, sizeof(inputFilteringMode_e));
+    EXPECT_EQ(256u, offsetof(master_t, magZero));
+    EXPECT_EQ(262u, offsetof(master_t, batteryConfig));
+    EXPECT_EQ(272u, offsetof(master_t, batteryConfig.batteryResistance));
+    EXPECT_EQ(274u, offsetof(master_t, batteryConfig.batteryCapacity));
+    EXPECT_EQ(276u, offsetof(master_t, rxConfig));
+    EXPECT_EQ(294u, offsetof(master_t, rxConfig.rc_interpolation));
+    EXPECT_EQ(296u, offsetof(master_t, rxConfig.input_median_channels));
+    EXPECT_EQ(298u, offsetof(master_t, inputFilteringMode));
+}
+
+TEST(ConfigMigrationTest, Version94IsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    uint8_t defaultBatteryResistance = masterConfig.batteryConfig.batteryResistance;
+    uint8_t defaultRcInterpolation = masterConfig.rxConfig.rc_interpolation;
+    setOldLayoutValues();
+    storeVersion94Image();
+    clearOldLayoutValues();
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(defaultBatteryResistance, masterConfig.batteryConfig.batteryResistance);
+    EXPECT_EQ(defaultRcInterpolation, masterConfig.rxConfig.rc_interpolation);
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+TEST(ConfigMigrationTest, Version94InTheLegacyFlashAreaIsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    setOldLayoutValues();
+    buildVersion94Image(configFlash + CONFIG_FLASH_SIZE - LEGACY_CONFIG_FLASH_SIZE);
+    clearOldLayoutValues();
+
+    // and the storage holds nothing yet, as on the first boot after the upgrade
+    storedImageSize = 0;
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+}
+
+TEST(ConfigMigrationTest, CorruptedVersion94IsReset)
+{
+    // given
+    resetConfigAndStorage();
+    uint16_t defaultLooptime = masterConfig.looptime;
+    masterConfig.looptime = 1234;
+    storeVersion94Image();
+    storedImage[offsetof(master_t, looptime)] ^= 0x01;
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    EXPECT_EQ(defaultLooptime, masterConfig.looptime);
+    EXPECT_EQ(99, storedConfig()->version);
+}
+
+TEST(ConfigMigrationTest, Version95IsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    setOldLayoutValues();
+    storeCrcImage(95, V95_SIZE, 0, 0);
+    clearOldLayoutValues();
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+TEST(ConfigMigrationTest, CorruptedVersion95IsReset)
+{
+    // given
+    resetConfigAndStorage();
+    uint16_t defaultLooptime = masterConfig.looptime;
+    masterConfig.looptime = 1234;
+    storeCrcImage(95, V95_SIZE, 0, 0);
+    storedImage[offsetof(master_t, looptime)] ^= 0x01;
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    EXPECT_EQ(defaultLooptime, masterConfig.looptime);
+    EXPECT_EQ(99, storedConfig()->version);
+}
+
+TEST(ConfigMigrationTest, Version96IsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    uint8_t defaultRcInterpolation = masterConfig.rxConfig.rc_interpolation;
+    setOldLayoutValues();
+    storeCrcImage(96, V96_SIZE, V96_BATTERY_SHIFT, 0);
+    clearOldLayoutValues();
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(45, masterConfig.batteryConfig.batteryResistance);
+    EXPECT_EQ(defaultRcInterpolation, masterConfig.rxConfig.rc_interpolation);
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+TEST(ConfigMigrationTest, Version97IsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    setOldLayoutValues();
+    masterConfig.rxConfig.input_median_channels = 0x0F;
+    storeCrcImage(97, V97_SIZE, V96_BATTERY_SHIFT, V97_RX_SHIFT);
+    clearOldLayoutValues();
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(45, masterConfig.batteryConfig.batteryResistance);
+    EXPECT_EQ(35, masterConfig.rxConfig.rc_interpolation_hz);
+    EXPECT_EQ(0, masterConfig.rxConfig.input_median_channels);
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+static void storeVersion98Image(void)
+{
+    // nothing before gyroTempCompensation moved since version 98
+    uint16_t size = V98_SIZE;
+
+    memset(storedImage, 0, size);
+    memcpy(storedImage, &masterConfig, V98_MAGIC_EF_OFFSET);
+    storedImage[offsetof(master_t, version)] = 98;
+    memcpy(storedImage + offsetof(master_t, size), &size, sizeof(size));
+    storedImage[V98_MAGIC_EF_OFFSET] = 0xEF;
+
+    uint32_t crc = crc32Update(0, storedImage, size - sizeof(crc));
+    memcpy(storedImage + size - sizeof(crc), &crc, sizeof(crc));
+    storedImageSize = size;
+}
+
+TEST(ConfigMigrationTest, Version98IsMigrated)
+{
+    // given
+    resetConfigAndStorage();
+    setOldLayoutValues();
+    masterConfig.rxConfig.input_median_channels = 0x0F;
+    storeVersion98Image();
+    clearOldLayoutValues();
+    masterConfig.rxConfig.input_median_channels = 0;
+    masterConfig.gyroTempCompensation.windowCount[0] = 3;
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    expectOldLayoutValues();
+    EXPECT_EQ(45, masterConfig.batteryConfig.batteryResistance);
+    EXPECT_EQ(35, masterConfig.rxConfig.rc_interpolation_hz);
+    EXPECT_EQ(0x0F, masterConfig.rxConfig.input_median_channels);
+    EXPECT_EQ(0, masterConfig.gyroTempCompensation.windowCount[0]);
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+    EXPECT_EQ(99, storedConfig()->version);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+TEST(ConfigMigrationTest, UnknownVersionIsReset)
+{
+    // given
+    resetConfigAndStorage();
+    uint16_t defaultLooptime = masterConfig.looptime;
+    masterConfig.looptime = 1234;
+    storeVersion94Image();
+    storedImage[offsetof(master_t, version)] = 93;
+    storedImage[V94_MAGIC_EF_OFFSET + 1] ^= 94 ^ 93;
+
+    // when
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    EXPECT_EQ(defaultLooptime, masterConfig.looptime);
+    EXPECT_EQ(99, storedConfig()->version);
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t armingFlags;
+
+void configStorageInit(void) {}
+
+bool configStorageIsValid(void)
+{
+    return storedImageSize > 0;
+}
+
+uint32_t configStorageGetImageSize(void)
+{
+    return storedImageSize;
+}
+
+bool configStorageRead(uint32_t offset, void *dest, uint32_t length)
+{
+    if (offset + length > storedImageSize) {
+        return false;
+    }
+    memcpy(dest, storedImage + offset, length);
+    return true;
+}
+
+bool configStorageWrite(const void *image, uint32_t size)
+{
+    if (size > sizeof(storedImage)) {
+        return false;
+    }
+    memcpy(storedImage, image, size);
+    storedImageSize = size;
+    return true;
+}
+
+uint32_t configFlashGetSize(void)
+{
+    return sizeof(configFlash);
+}
+
+const uint8_t *configFlashGetAddress(uint32_t offset)
+{
+    return configFlash + offset;
+}
+
+void failureMode(uint8_t)
+{
+    FAIL();
+}
+
+void blinkLedAndSoundBeeper(uint8_t, uint8_t, uint8_t) {}
+void queueConfirmationBeep(uint8_t) {}
+void generatePitchRollCurve(controlRateConfig_t *) {}
+void generateThrottleCurve(controlRateConfig_t *, escAndServoConfig_t *) {}
+void resetAdjustmentStates(void) {}
+void useRcControlsConfig(modeActivationCondition_t *, escAndServoConfig_t *, pidProfile_t *) {}
+void useGyroConfig(gyroConfig_t *, gyroTempCompensation_t *) {}
+void useTelemetryConfig(telemetryConfig_t *) {}
+void pidSetController(int) {}
+void gpsUseProfile(gpsProfile_t *) {}
+void gpsUsePIDs(pidProfile_t *) {}
+void useFailsafeConfig(failsafeConfig_t *) {}
+void setAccelerationTrims(flightDynamicsTrims_t *) {}
+void mixerUseConfigs(servoParam_t *, gimbalConfig_t *, flight3DConfig_t *, escAndServoConfig_t *, mixerConfig_t *, airplaneConfig_t *, rxConfig_t *) {}
+void imuConfigure(imuRuntimeConfig_t *, pidProfile_t *, accDeadband_t *, float, uint16_t) {}
+void configureAltitudeHold(pidProfile_t *, barometerConfig_t *, rcControlsConfig_t *, escAndServoConfig_t *) {}
+void useBarometerConfig(barometerConfig_t *) {}
+void useRxConfig(rxConfig_t *) {}
+void useRcInterpolationConfig(rxConfig_t *) {}
+void parseRcChannels(const char *, rxConfig_t *) {}
+void resetRollAndPitchTrims(rollAndPitchTrims_t *) {}
+void applyDefaultColors(hsvColor_t *, uint8_t) {}
+void applyDefaultLedStripConfig(ledConfig_t *) {}
+
+bool isSerialConfigValid(serialConfig_t *)
+{
+    return true;
+}
+
+}
@@ -0,0 +1,421 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "config/config_storage.h"
+    #include "drivers/config_flash.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_FLASH_PAGE_SIZE 0x400
+#define TEST_FLASH_SIZE 0x2000
+#define TEST_IMAGE_SIZE 2480
+
+// RAM backed flash, programming can only clear bits like the real thing
+static uint8_t testFlash[TEST_FLASH_SIZE];
+
+static uint32_t pageEraseCount;
+static uint32_t programCount;
+static uint32_t flashLookupCount;
+static int32_t programsUntilPowerLoss;
+
+static uint8_t image[TEST_IMAGE_SIZE];
+static uint8_t readBack[TEST_IMAGE_SIZE];
+
+static void resetTestFlash(void)
+{
+    memset(testFlash, 0xFF, sizeof(testFlash));
+    pageEraseCount = 0;
+    programCount = 0;
+    programsUntilPowerLoss = -1;
+}
+
+static void fillImage(uint8_t seed)
+{
+    for (uint32_t i = 0; i < sizeof(image); i++) {
+        image[i] = (uint8_t)(i * 7 + seed);
+    }
+}
+
+static bool readBackMatchesImage(void)
+{
+    memset(readBack, 0, sizeof(readBack));
+    return configStorageRead(0, readBack, sizeof(readBack)) && memcmp(readBack, image, sizeof(image)) == 0;
+}
+
+TEST(ConfigStorageTest, EmptyFlashIsNotValid)
+{
+    // given
+    resetTestFlash();
+
+    // when
+    configStorageInit();
+
+    // then
+    EXPECT_FALSE(configStorageIsValid());
+    EXPECT_FALSE(configStorageRead(0, readBack, 1));
+}
+
+TEST(ConfigStorageTest, WriteAndRemount)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+
+    // when
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+
+    // then
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_EQ(TEST_IMAGE_SIZE, configStorageGetImageSize());
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, SmallChangeAppendsWithoutErase)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    uint32_t erasesAfterFirstWrite = pageEraseCount;
+
+    // when
+    image[100] ^= 0x55;
+    programCount = 0;
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+
+    // then only one record was written: header, data words and commit
+    EXPECT_EQ(erasesAfterFirstWrite, pageEraseCount);
+    EXPECT_EQ(2 + CONFIG_STORAGE_BLOCK_SIZE / 4, programCount);
+
+    // and
+    configStorageInit();
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, UnchangedImageWritesNothing)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(3);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+
+    // when
+    programCount = 0;
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+
+    // then
+    EXPECT_EQ(0, programCount);
+}
+
+TEST(ConfigStorageTest, FullBankIsCompactedIntoOtherBank)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+
+    // when
+    for (int i = 0; i < 200; i++) {
+        image[(i * 97) % TEST_IMAGE_SIZE]++;
+        EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+    }
+
+    // then
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and far fewer erases than rewriting the whole image every time
+    EXPECT_LT(pageEraseCount, 200u);
+}
+
+TEST(ConfigStorageTest, PowerLossDuringAppendKeepsPreviousImage)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    uint8_t previous[TEST_IMAGE_SIZE];
+    memcpy(previous, image, sizeof(image));
+
+    // when power is lost half way through the record data
+    image[0] ^= 0xFF;
+    programsUntilPowerLoss = 3;
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    programsUntilPowerLoss = -1;
+
+    // then
+    memcpy(image, previous, sizeof(image));
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and the log keeps working after the torn record
+    image[0] ^= 0x0F;
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+    configStorageInit();
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, PowerLossDuringCompactionKeepsPreviousBank)
+{
+    // given a bank with only a few free records left
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    for (int i = 0; i < 500; i++) {
+        image[i % TEST_IMAGE_SIZE]++;
+        uint32_t erasesBefore = pageEraseCount;
+        configStorageWrite(image, TEST_IMAGE_SIZE);
+        if (pageEraseCount != erasesBefore) {
+            break;
+        }
+    }
+    uint8_t previous[TEST_IMAGE_SIZE];
+    memcpy(previous, image, sizeof(image));
+
+    // when power is lost during the compaction triggered by a large change
+    fillImage(42);
+    programsUntilPowerLoss = 100;
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    programsUntilPowerLoss = -1;
+
+    // then
+    memcpy(image, previous, sizeof(image));
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, RetryAfterFailedCompactionKeepsPreviousBank)
+{
+    // given a bank with only a few free records left
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    for (int i = 0; i < 500; i++) {
+        image[i % TEST_IMAGE_SIZE]++;
+        uint32_t erasesBefore = pageEraseCount;
+        configStorageWrite(image, TEST_IMAGE_SIZE);
+        if (pageEraseCount != erasesBefore) {
+            break;
+        }
+    }
+    uint8_t previous[TEST_IMAGE_SIZE];
+    memcpy(previous, image, sizeof(image));
+
+    // when the compaction triggered by a large change fails and so does the retry
+    fillImage(42);
+    programsUntilPowerLoss = 100;
+    EXPECT_FALSE(configStorageWrite(image, TEST_IMAGE_SIZE));
+    programsUntilPowerLoss = 100;
+    EXPECT_FALSE(configStorageWrite(image, TEST_IMAGE_SIZE));
+    programsUntilPowerLoss = -1;
+
+    // then
+    memcpy(image, previous, sizeof(image));
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, ImageSizeChangeIsCompactedIntoOtherBank)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    uint32_t erasesAfterFirstWrite = pageEraseCount;
+
+    // when
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE - 4));
+
+    // then
+    EXPECT_GT(pageEraseCount, erasesAfterFirstWrite);
+
+    // and
+    configStorageInit();
+    EXPECT_TRUE(configStorageIsValid());
+    EXPECT_EQ(TEST_IMAGE_SIZE - 4, configStorageGetImageSize());
+    EXPECT_FALSE(configStorageRead(0, readBack, TEST_IMAGE_SIZE));
+    EXPECT_TRUE(configStorageRead(0, readBack, TEST_IMAGE_SIZE - 4));
+    EXPECT_EQ(0, memcmp(readBack, image, TEST_IMAGE_SIZE - 4));
+}
+
+TEST(ConfigStorageTest, BootTimeMountBenchmark)
+{
+    // given a bank that is almost full
+    const uint32_t blockCount = (TEST_IMAGE_SIZE + CONFIG_STORAGE_BLOCK_SIZE - 1) / CONFIG_STORAGE_BLOCK_SIZE;
+    const uint32_t appendCount = 20;
+
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    for (uint32_t i = 0; i < appendCount; i++) {
+        image[i * 31]++;
+        configStorageWrite(image, TEST_IMAGE_SIZE);
+    }
+
+    // when
+    flashLookupCount = 0;
+    configStorageInit();
+    uint32_t mountLookups = flashLookupCount;
+
+    flashLookupCount = 0;
+    configStorageRead(0, readBack, sizeof(readBack));
+    uint32_t rebuildLookups = flashLookupCount;
+
+    // then the log is walked once, the bank headers and the first erased slot aside
+    EXPECT_LE(mountLookups, 2 + 1 + blockCount + appendCount + 1);
+
+    // and the image is rebuilt from the latest record of each block, without walking the log again
+    EXPECT_EQ(blockCount, rebuildLookups);
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, StagedImageLeavesTheActiveBankAlone)
+{
+    // given
+    uint8_t staged[TEST_IMAGE_SIZE];
+    uint32_t offset;
+    uint32_t length;
+
+    resetTestFlash();
+    configStorageInit();
+    fillImage(0);
+    configStorageWrite(image, TEST_IMAGE_SIZE);
+    for (uint32_t i = 0; i < sizeof(staged); i++) {
+        staged[i] = (uint8_t)(i * 5 + 1);
+    }
+
+    // when it arrives in pieces which don't line up with flash words
+    EXPECT_TRUE(configStorageStageBegin(TEST_IMAGE_SIZE));
+    for (offset = 0; offset < TEST_IMAGE_SIZE; offset += length) {
+        length = TEST_IMAGE_SIZE - offset < 61 ? TEST_IMAGE_SIZE - offset : 61;
+        EXPECT_TRUE(configStorageStageWrite(staged + offset, length));
+    }
+
+    // then
+    EXPECT_EQ(0, memcmp(configStorageGetStagedImage(), staged, TEST_IMAGE_SIZE));
+    EXPECT_FALSE(configStorageStageWrite(staged, 1));
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and the bank holding it is never mounted
+    configStorageInit();
+    EXPECT_TRUE(readBackMatchesImage());
+
+    // and it is reused by the next compaction
+    fillImage(9);
+    EXPECT_TRUE(configStorageWrite(image, TEST_IMAGE_SIZE));
+    configStorageInit();
+    EXPECT_TRUE(readBackMatchesImage());
+}
+
+TEST(ConfigStorageTest, StagedImageLargerThanABankIsRejected)
+{
+    // given
+    resetTestFlash();
+    configStorageInit();
+
+    // then
+    EXPECT_FALSE(configStorageStageBegin(TEST_FLASH_SIZE / 2));
+    EXPECT_FALSE(configStorageStageWrite(image, 1));
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t configFlashGetSize(void)
+{
+    return TEST_FLASH_SIZE;
+}
+
+uint16_t configFlashGetPageSize(void)
+{
+    return TEST_FLASH_PAGE_SIZE;
+}
+
+const uint8_t *configFlashGetAddress(uint32_t offset)
+{
+    flashLookupCount++;
+    return &testFlash[offset];
+}
+
+void configFlashUnlock(void) {}
+void configFlashLock(void) {}
+
+bool configFlashErasePage(uint32_t offset)
+{
+    if (programsUntilPowerLoss == 0) {
+        return false;
+    }
+    memset(&testFlash[offset], 0xFF, TEST_FLASH_PAGE_SIZE);
+    pageEraseCount++;
+    return true;
+}
+
+static bool programBytes(uint32_t offset, const uint8_t *data, uint8_t length)
+{
+    if (programsUntilPowerLoss == 0) {
+        return false;
+    }
+    if (programsUntilPowerLoss > 0) {
+        programsUntilPowerLoss--;
+    }
+
+    for (uint8_t i = 0; i < length; i++) {
+        testFlash[offset + i] &= data[i];
+    }
+    programCount++;
+    return true;
+}
+
+bool configFlashProgramHalfWord(uint32_t offset, uint16_t value)
+{
+    return programBytes(offset, (const uint8_t *) &value, sizeof(value));
+}
+
+bool configFlashProgramWord(uint32_t offset, uint32_t value)
+{
+    return programBytes(offset, (const uint8_t *) &value, sizeof(value));
+}
+
+}
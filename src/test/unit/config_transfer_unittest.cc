@@ -0,0 +1,402 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/color.h"
+    #include "common/crc.h"
+
+    #include "drivers/sensor.h"
+    #include "drivers/accgyro.h"
+    #include "drivers/compass.h"
+    #include "drivers/serial.h"
+    #include "drivers/input_filtering.h"
+
+    #include "io/escservo.h"
+    #include "io/gps.h"
+    #include "io/gimbal.h"
+    #include "io/rc_controls.h"
+    #include "io/serial.h"
+    #include "io/ledstrip.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/battery.h"
+    #include "sensors/boardalignment.h"
+    #include "sensors/sensors.h"
+    #include "sensors/acceleration.h"
+    #include "sensors/gyro.h"
+    #include "sensors/compass.h"
+    #include "sensors/barometer.h"
+
+    #include "flight/pid.h"
+    #include "flight/imu.h"
+    #include "flight/mixer.h"
+    #include "flight/navigation.h"
+    #include "flight/failsafe.h"
+
+    #include "telemetry/telemetry.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
+    #include "config/config_profile.h"
+    #include "config/config_master.h"
+    #include "config/config_storage.h"
+
+    #include "config/config_transfer.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// payload sizes of MSP_CONFIG_READ replies and MSP_SET_CONFIG_CHUNK requests
+#define READ_CHUNK_SIZE 128
+#define WRITE_CHUNK_SIZE 62
+// $ M < size cmd ... checksum
+#define MSP_FRAME_OVERHEAD 6
+
+static master_t storedConfig;
+static uint32_t writeEEPROMCount;
+static uint32_t readEEPROMCount;
+static uint32_t testMillis;
+
+// the inactive config storage bank that uploads are staged in
+static uint8_t stagedImage[sizeof(master_t)];
+static uint32_t stagedLength;
+static uint32_t stagedSize;
+
+/*
+ * The serial link between configurator and flight controller is a loopback buffer, every chunk is copied through
+ * it and the bytes that would be on the wire are counted.
+ */
+static uint8_t loopbackBuffer[READ_CHUNK_SIZE];
+static uint32_t loopbackByteCount;
+static uint32_t loopbackFrameCount;
+
+static uint8_t *loopback(const uint8_t *data, uint16_t length, uint16_t headerLength)
+{
+    memcpy(loopbackBuffer, data, length);
+    loopbackByteCount += MSP_FRAME_OVERHEAD + headerLength + length;
+    loopbackFrameCount++;
+    return loopbackBuffer;
+}
+
+static void resetConfigAndStorage(void)
+{
+    memset(&masterConfig, 0, sizeof(masterConfig));
+    masterConfig.version = 95;
+    masterConfig.size = sizeof(master_t);
+    masterConfig.magic_be = 0xBE;
+    masterConfig.magic_ef = 0xEF;
+    masterConfig.looptime = 3500;
+    memcpy(&storedConfig, &masterConfig, sizeof(master_t));
+
+    armingFlags = 0;
+    writeEEPROMCount = 0;
+    readEEPROMCount = 0;
+    loopbackByteCount = 0;
+    loopbackFrameCount = 0;
+    configTransferAbort();
+}
+
+static void readImage(master_t *image)
+{
+    uint16_t offset = 0;
+    uint16_t length;
+    uint8_t chunk[READ_CHUNK_SIZE];
+
+    while ((length = configTransferRead(offset, chunk, sizeof(chunk))) > 0) {
+        memcpy((uint8_t *)image + offset, loopback(chunk, length, 2), length);
+        offset += length;
+    }
+}
+
+static bool writeImage(const master_t *image)
+{
+    uint16_t offset;
+    uint16_t length;
+
+    for (offset = 0; offset < sizeof(master_t); offset += length) {
+        length = MIN(WRITE_CHUNK_SIZE, sizeof(master_t) - offset);
+        if (!configTransferWriteChunk(offset, loopback((const uint8_t *)image + offset, length, 2), length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(ConfigTransferTest, SchemaDescribesImage)
+{
+    // given
+    resetConfigAndStorage();
+    configTransferSchema_t schema;
+
+    // when
+    configTransferGetSchema(&schema);
+
+    // then
+    EXPECT_EQ(CONFIG_TRANSFER_SCHEMA_VERSION, schema.schemaVersion);
+    EXPECT_EQ(95, schema.configVersion);
+    EXPECT_EQ(sizeof(master_t), schema.size);
+    EXPECT_EQ(offsetof(master_t, profile), schema.profileOffset);
+    EXPECT_EQ(sizeof(profile_t), schema.profileSize);
+    EXPECT_EQ(MAX_PROFILE_COUNT, schema.profileCount);
+    EXPECT_EQ(offsetof(master_t, controlRateProfiles), schema.controlRateProfileOffset);
+    EXPECT_EQ(sizeof(controlRateConfig_t), schema.controlRateProfileSize);
+    EXPECT_EQ(MAX_CONTROL_RATE_PROFILE_COUNT, schema.controlRateProfileCount);
+    EXPECT_EQ(crc32Update(0, &masterConfig, sizeof(master_t)), schema.crc);
+}
+
+TEST(ConfigTransferTest, ReadIsClippedAtEndOfImage)
+{
+    // given
+    resetConfigAndStorage();
+    uint8_t chunk[READ_CHUNK_SIZE];
+
+    // expect
+    EXPECT_EQ(10, configTransferRead(sizeof(master_t) - 10, chunk, sizeof(chunk)));
+    EXPECT_EQ(0, configTransferRead(sizeof(master_t), chunk, sizeof(chunk)));
+}
+
+TEST(ConfigTransferTest, ReadModifyWriteRoundTrip)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    configTransferSchema_t schema;
+
+    // when a configurator reads the image
+    configTransferGetSchema(&schema);
+    readImage(&image);
+
+    // then
+    EXPECT_EQ(schema.crc, crc32Update(0, &image, sizeof(image)));
+
+    // when it changes a setting and writes the image back
+    image.looptime = 2000;
+    image.profile[1].pidProfile.P8[ROLL] = 55;
+    EXPECT_TRUE(writeImage(&image));
+    EXPECT_TRUE(configTransferInProgress());
+    EXPECT_TRUE(configTransferCommit(crc32Update(0, &image, sizeof(image))));
+
+    // then the new config is saved and activated once
+    EXPECT_FALSE(configTransferInProgress());
+    EXPECT_EQ(1u, writeEEPROMCount);
+    EXPECT_EQ(1u, readEEPROMCount);
+    EXPECT_EQ(2000, storedConfig.looptime);
+    EXPECT_EQ(55, storedConfig.profile[1].pidProfile.P8[ROLL]);
+
+    // and the sync costs one frame per chunk and the image twice on the wire, each frame with its 2 byte offset
+    uint32_t expectedFrameCount = (sizeof(master_t) + READ_CHUNK_SIZE - 1) / READ_CHUNK_SIZE
+            + (sizeof(master_t) + WRITE_CHUNK_SIZE - 1) / WRITE_CHUNK_SIZE;
+    EXPECT_EQ(expectedFrameCount, loopbackFrameCount);
+    EXPECT_EQ(expectedFrameCount * (MSP_FRAME_OVERHEAD + 2) + 2 * sizeof(master_t), loopbackByteCount);
+}
+
+TEST(ConfigTransferTest, CorruptedImageIsRejected)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    image.looptime = 2000;
+    uint32_t crc = crc32Update(0, &image, sizeof(image));
+
+    // when a byte is corrupted on the way
+    image.looptime = 2001;
+    EXPECT_TRUE(writeImage(&image));
+
+    // then
+    EXPECT_FALSE(configTransferCommit(crc));
+    EXPECT_FALSE(configTransferInProgress());
+    EXPECT_EQ(0u, writeEEPROMCount);
+    EXPECT_EQ(3500, masterConfig.looptime);
+    EXPECT_EQ(3500, storedConfig.looptime);
+}
+
+TEST(ConfigTransferTest, ImageWithWrongVersionIsRejected)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    image.version = 94;
+
+    // when
+    EXPECT_TRUE(writeImage(&image));
+
+    // then
+    EXPECT_FALSE(configTransferCommit(crc32Update(0, &image, sizeof(image))));
+    EXPECT_EQ(0u, writeEEPROMCount);
+    EXPECT_EQ(95, masterConfig.version);
+}
+
+TEST(ConfigTransferTest, OutOfOrderChunkAbortsTransfer)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    image.looptime = 2000;
+    EXPECT_TRUE(configTransferWriteChunk(0, (uint8_t *)&image, WRITE_CHUNK_SIZE));
+
+    // when
+    EXPECT_FALSE(configTransferWriteChunk(2 * WRITE_CHUNK_SIZE, (uint8_t *)&image + 2 * WRITE_CHUNK_SIZE, WRITE_CHUNK_SIZE));
+
+    // then
+    EXPECT_FALSE(configTransferInProgress());
+    EXPECT_EQ(3500, masterConfig.looptime);
+    EXPECT_FALSE(configTransferCommit(crc32Update(0, &image, sizeof(image))));
+}
+
+TEST(ConfigTransferTest, RunningConfigIsUntouchedUntilCommit)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    image.looptime = 2000;
+
+    // when only the first chunk arrives, e.g. because the configurator was disconnected
+    EXPECT_TRUE(configTransferWriteChunk(0, (uint8_t *)&image, WRITE_CHUNK_SIZE));
+
+    // then
+    EXPECT_TRUE(configTransferInProgress());
+    EXPECT_EQ(3500, masterConfig.looptime);
+    EXPECT_EQ(0u, readEEPROMCount);
+}
+
+TEST(ConfigTransferTest, IdleTransferIsAborted)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    EXPECT_TRUE(configTransferWriteChunk(0, (uint8_t *)&image, WRITE_CHUNK_SIZE));
+
+    // when
+    testMillis += CONFIG_TRANSFER_IDLE_TIMEOUT_MS - 1;
+    configTransferCheckTimeout();
+
+    // then
+    EXPECT_TRUE(configTransferInProgress());
+
+    // when
+    testMillis += 1;
+    configTransferCheckTimeout();
+
+    // then
+    EXPECT_FALSE(configTransferInProgress());
+    EXPECT_FALSE(configTransferCommit(crc32Update(0, &image, sizeof(image))));
+}
+
+TEST(ConfigTransferTest, IncompleteImageIsRejected)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    EXPECT_TRUE(configTransferWriteChunk(0, (uint8_t *)&image, WRITE_CHUNK_SIZE));
+
+    // expect
+    EXPECT_FALSE(configTransferCommit(crc32Update(0, &image, sizeof(image))));
+    EXPECT_EQ(0u, writeEEPROMCount);
+}
+
+TEST(ConfigTransferTest, ChunkPastEndOfImageIsRejected)
+{
+    // given
+    resetConfigAndStorage();
+    uint8_t chunk[WRITE_CHUNK_SIZE] = { 0 };
+
+    // expect
+    EXPECT_TRUE(configTransferWriteChunk(0, chunk, sizeof(chunk)));
+    EXPECT_FALSE(configTransferWriteChunk(sizeof(chunk), chunk, sizeof(master_t)));
+    EXPECT_FALSE(configTransferInProgress());
+}
+
+TEST(ConfigTransferTest, WriteIsRejectedWhenArmed)
+{
+    // given
+    resetConfigAndStorage();
+    master_t image;
+    readImage(&image);
+    ENABLE_ARMING_FLAG(ARMED);
+
+    // expect
+    EXPECT_FALSE(writeImage(&image));
+    EXPECT_FALSE(configTransferInProgress());
+}
+
+// STUBS
+
+extern "C" {
+
+master_t masterConfig;
+uint8_t armingFlags;
+
+void writeEEPROM(void)
+{
+    memcpy(&storedConfig, &masterConfig, sizeof(master_t));
+    writeEEPROMCount++;
+}
+
+void readEEPROM(void)
+{
+    memcpy(&masterConfig, &storedConfig, sizeof(master_t));
+    readEEPROMCount++;
+}
+
+uint32_t millis(void)
+{
+    return testMillis;
+}
+
+bool configStorageStageBegin(uint32_t size)
+{
+    if (size > sizeof(stagedImage)) {
+        return false;
+    }
+    memset(stagedImage, 0xFF, sizeof(stagedImage));
+    stagedLength = 0;
+    stagedSize = size;
+    return true;
+}
+
+bool configStorageStageWrite(const void *data, uint32_t length)
+{
+    if (length > stagedSize - stagedLength) {
+        return false;
+    }
+    memcpy(stagedImage + stagedLength, data, length);
+    stagedLength += length;
+    return true;
+}
+
+const void *configStorageGetStagedImage(void)
+{
+    return stagedImage;
+}
+
+}
@@ -0,0 +1,314 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/color.h"
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/crc.h"
+
+    #include "drivers/sensor.h"
+    #include "drivers/accgyro.h"
+    #include "drivers/compass.h"
+    #include "drivers/serial.h"
+    #include "drivers/input_filtering.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/gyro.h"
+    #include "sensors/compass.h"
+    #include "sensors/acceleration.h"
+    #include "sensors/barometer.h"
+    #include "sensors/boardalignment.h"
+    #include "sensors/battery.h"
+
+    #include "io/serial.h"
+    #include "io/gimbal.h"
+    #include "io/escservo.h"
+    #include "io/rc_controls.h"
+    #include "io/rc_curves.h"
+    #include "io/ledstrip.h"
+    #include "io/gps.h"
+
+    #include "rx/rx.h"
+
+    #include "telemetry/telemetry.h"
+
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+    #include "flight/imu.h"
+    #include "flight/failsafe.h"
+    #include "flight/navigation.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
+
+    #include "config/config_profile.h"
+    #include "config/config_master.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static uint8_t storedImage[sizeof(master_t) + 64];
+static uint32_t storedImageSize;
+static uint32_t configStorageWriteCount;
+static uint32_t configStorageReadCount;
+static uint32_t pitchRollCurveGenerationCount;
+
+static master_t *storedConfig(void)
+{
+    return (master_t *)storedImage;
+}
+
+static void resetConfigAndStorage(void)
+{
+    memset(storedImage, 0, sizeof(storedImage));
+    storedImageSize = 0;
+    armingFlags = 0;
+
+    resetEEPROM();
+    readEEPROM();
+
+    configStorageWriteCount = 0;
+    pitchRollCurveGenerationCount = 0;
+}
+
+TEST(ConfigTest, ChangeProfileWhenDisarmedWritesImmediately)
+{
+    // given
+    resetConfigAndStorage();
+
+    // when
+    changeProfile(1);
+
+    // then
+    EXPECT_EQ(1, getCurrentProfile());
+    EXPECT_EQ(&masterConfig.profile[1], currentProfile);
+    EXPECT_EQ(1u, configStorageWriteCount);
+    EXPECT_EQ(1, storedConfig()->current_profile_index);
+}
+
+TEST(ConfigTest, ChangeProfileWhenArmedDefersWriteUntilDisarm)
+{
+    // given
+    resetConfigAndStorage();
+    ENABLE_ARMING_FLAG(ARMED);
+
+    // when
+    changeProfile(2);
+
+    // then the profile is active but the flash was not touched
+    EXPECT_EQ(2, getCurrentProfile());
+    EXPECT_EQ(&masterConfig.profile[2], currentProfile);
+    EXPECT_EQ(&masterConfig.controlRateProfiles[masterConfig.profile[2].defaultRateProfileIndex], currentControlRateProfile);
+    EXPECT_EQ(1u, pitchRollCurveGenerationCount);
+    EXPECT_EQ(0u, configStorageWriteCount);
+    EXPECT_EQ(0, storedConfig()->current_profile_index);
+
+    // when
+    DISABLE_ARMING_FLAG(ARMED);
+    writeEEPROMIfPending();
+
+    // then
+    EXPECT_EQ(1u, configStorageWriteCount);
+    EXPECT_EQ(2, storedConfig()->current_profile_index);
+
+    // and nothing is written a second time
+    writeEEPROMIfPending();
+    EXPECT_EQ(1u, configStorageWriteCount);
+}
+
+TEST(ConfigTest, NoPendingWriteWithoutProfileChange)
+{
+    // given
+    resetConfigAndStorage();
+
+    // when
+    writeEEPROMIfPending();
+
+    // then
+    EXPECT_EQ(0u, configStorageWriteCount);
+}
+
+TEST(ConfigTest, ScheduledSaveIsWrittenOnDisarm)
+{
+    // given
+    resetConfigAndStorage();
+
+    // when
+    masterConfig.gyroTempCompensation.windowCount[4] = 1;
+    scheduleConfigSaveOnDisarm();
+
+    // then
+    EXPECT_EQ(0u, configStorageWriteCount);
+
+    // when
+    writeEEPROMIfPending();
+
+    // then
+    EXPECT_EQ(1u, configStorageWriteCount);
+    EXPECT_EQ(1, storedConfig()->gyroTempCompensation.windowCount[4]);
+}
+
+TEST(ConfigTest, ArmedProfileSwitchLatency)
+{
+    // given
+    resetConfigAndStorage();
+    ENABLE_ARMING_FLAG(ARMED);
+
+    // when
+    const uint32_t switchCount = 100;
+    configStorageReadCount = 0;
+    for (uint32_t i = 1; i <= switchCount; i++) {
+        changeProfile(i % MAX_PROFILE_COUNT);
+    }
+
+    // then each switch only regenerates the rate curves, the flash is neither written nor read back
+    EXPECT_EQ(0u, configStorageWriteCount);
+    EXPECT_EQ(0u, configStorageReadCount);
+    EXPECT_EQ(switchCount, pitchRollCurveGenerationCount);
+}
+
+TEST(ConfigTest, ValidConfigIsKept)
+{
+    // given
+    resetConfigAndStorage();
+    masterConfig.looptime = 1234;
+    writeEEPROM();
+
+    // when
+    masterConfig.looptime = 0;
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then
+    EXPECT_EQ(1234, masterConfig.looptime);
+    EXPECT_EQ(sizeof(master_t), storedImageSize);
+}
+
+TEST(ConfigTest, CorruptedCRCIsDetected)
+{
+    // given
+    resetConfigAndStorage();
+    uint16_t defaultLooptime = masterConfig.looptime;
+    masterConfig.looptime = 1234;
+    writeEEPROM();
+
+    // when a single bit flips
+    storedImage[offsetof(master_t, looptime)] ^= 0x10;
+    ensureEEPROMContainsValidData();
+    readEEPROM();
+
+    // then defaults are restored
+    EXPECT_EQ(defaultLooptime, masterConfig.looptime);
+    EXPECT_EQ(crc32Update(0, storedImage, offsetof(master_t, crc)), storedConfig()->crc);
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t armingFlags;
+
+void configStorageInit(void) {}
+
+bool configStorageIsValid(void)
+{
+    return storedImageSize > 0;
+}
+
+uint32_t configStorageGetImageSize(void)
+{
+    return storedImageSize;
+}
+
+bool configStorageRead(uint32_t offset, void *dest, uint32_t length)
+{
+    configStorageReadCount++;
+    if (offset + length > storedImageSize) {
+        return false;
+    }
+    memcpy(dest, storedImage + offset, length);
+    return true;
+}
+
+bool configStorageWrite(const void *image, uint32_t size)
+{
+    if (size > sizeof(storedImage)) {
+        return false;
+    }
+    memcpy(storedImage, image, size);
+    storedImageSize = size;
+    configStorageWriteCount++;
+    return true;
+}
+
+uint32_t configFlashGetSize(void)
+{
+    return 0;
+}
+
+const uint8_t *configFlashGetAddress(uint32_t)
+{
+    return NULL;
+}
+
+void failureMode(uint8_t)
+{
+    FAIL();
+}
+
+void blinkLedAndSoundBeeper(uint8_t, uint8_t, uint8_t) {}
+void queueConfirmationBeep(uint8_t) {}
+
+void generatePitchRollCurve(controlRateConfig_t *)
+{
+    pitchRollCurveGenerationCount++;
+}
+
+void generateThrottleCurve(controlRateConfig_t *, escAndServoConfig_t *) {}
+void resetAdjustmentStates(void) {}
+void useRcControlsConfig(modeActivationCondition_t *, escAndServoConfig_t *, pidProfile_t *) {}
+void useGyroConfig(gyroConfig_t *, gyroTempCompensation_t *) {}
+void useRcInterpolationConfig(rxConfig_t *) {}
+void useTelemetryConfig(telemetryConfig_t *) {}
+void pidSetController(int) {}
+void gpsUseProfile(gpsProfile_t *) {}
+void gpsUsePIDs(pidProfile_t *) {}
+void useFailsafeConfig(failsafeConfig_t *) {}
+void setAccelerationTrims(flightDynamicsTrims_t *) {}
+void mixerUseConfigs(servoParam_t *, gimbalConfig_t *, flight3DConfig_t *, escAndServoConfig_t *, mixerConfig_t *, airplaneConfig_t *, rxConfig_t *) {}
+void imuConfigure(imuRuntimeConfig_t *, pidProfile_t *, accDeadband_t *, float, uint16_t) {}
+void configureAltitudeHold(pidProfile_t *, barometerConfig_t *, rcControlsConfig_t *, escAndServoConfig_t *) {}
+void useBarometerConfig(barometerConfig_t *) {}
+void useRxConfig(rxConfig_t *) {}
+void parseRcChannels(const char *, rxConfig_t *) {}
+void resetRollAndPitchTrims(rollAndPitchTrims_t *) {}
+void applyDefaultColors(hsvColor_t *, uint8_t) {}
+void applyDefaultLedStripConfig(ledConfig_t *) {}
+
+bool isSerialConfigValid(serialConfig_t *)
+{
+    return true;
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "common/crc.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static const char checkString[] = "123456789";
+
+TEST(CRCTest, Crc32CheckValue)
+{
+    // when
+    uint32_t crc = crc32Update(0, checkString, strlen(checkString));
+
+    // then
+    EXPECT_EQ(0xCBF43926u, crc);
+}
+
+TEST(CRCTest, Crc32EmptyInput)
+{
+    // expect
+    EXPECT_EQ(0u, crc32Update(0, checkString, 0));
+}
+
+TEST(CRCTest, Crc32CanBeCalculatedInChunks)
+{
+    // given
+    uint32_t crc = 0;
+
+    // when
+    crc = crc32Update(crc, checkString, 2);
+    crc = crc32Update(crc, checkString + 2, 5);
+    crc = crc32Update(crc, checkString + 7, 2);
+
+    // then
+    EXPECT_EQ(0xCBF43926u, crc);
+}
+
+TEST(CRCTest, Crc32MatchesBitwiseCalculation)
+{
+    // given
+    uint8_t data[256];
+    uint32_t expected = 0xFFFFFFFF;
+
+    for (uint16_t i = 0; i < sizeof(data); i++) {
+        data[i] = 255 - i;
+        expected ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            expected = (expected >> 1) ^ (expected & 1 ? 0xEDB88320 : 0);
+        }
+    }
+    expected = ~expected;
+
+    // expect
+    EXPECT_EQ(expected, crc32Update(0, data, sizeof(data)));
+}
+
+TEST(CRCTest, Crc32DetectsSingleBitFlip)
+{
+    // given
+    uint8_t data[64];
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+    uint32_t expected = crc32Update(0, data, sizeof(data));
+
+    // when
+    data[17] ^= 0x04;
+
+    // then
+    EXPECT_NE(expected, crc32Update(0, data, sizeof(data)));
+}
+
+TEST(CRCTest, Crc16CcittCheckValue)
+{
+    // when
+    uint16_t crc = crc16CcittUpdate(0, checkString, strlen(checkString));
+
+    // then
+    EXPECT_EQ(0x31C3, crc);
+}
+
+TEST(CRCTest, Crc16CcittOverDataAndCrcIsZero)
+{
+    // given
+    uint8_t data[11];
+    memcpy(data, checkString, 9);
+    uint16_t crc = crc16CcittUpdate(0, data, 9);
+    data[9] = crc >> 8;
+    data[10] = crc & 0xFF;
+
+    // expect
+    EXPECT_EQ(0, crc16CcittUpdate(0, data, sizeof(data)));
+}
@@ -0,0 +1,1015 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "drivers/flash.h"
+    #include "drivers/flash_m25p16.h"
+    #include "drivers/serial.h"
+
+    #include "io/flashfs.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_FLASH_SECTORS 32
+#define TEST_FLASH_PAGE_SIZE 256
+#define TEST_FLASH_PAGES_PER_SECTOR 256
+#define TEST_FLASH_SECTOR_SIZE (TEST_FLASH_PAGE_SIZE * TEST_FLASH_PAGES_PER_SECTOR)
+#define TEST_FLASH_SIZE (TEST_FLASH_SECTOR_SIZE * TEST_FLASH_SECTORS)
+
+/*
+ * A RAM backed flash chip with the same programming rules as the real thing: programming can only clear bits, and
+ * writes wrap around within the page they started in.
+ *
+ * It also has the typical timing of an M25P16. Commands which arrive while it is busy are ignored, and the driver's
+ * waits for it to become ready advance the simulated clock.
+ */
+#define TEST_FLASH_SECTOR_ERASE_MICROS 600000
+#define TEST_FLASH_BULK_ERASE_MICROS 17000000
+#define TEST_FLASH_PROGRAM_MICROS_PER_BYTE 3
+
+// The timeouts the driver waits for the flash with
+#define TEST_FLASH_DEFAULT_TIMEOUT_MILLIS 6
+#define TEST_FLASH_SECTOR_ERASE_TIMEOUT_MILLIS 5000
+#define TEST_FLASH_BULK_ERASE_TIMEOUT_MILLIS 21000
+
+static uint8_t testFlash[TEST_FLASH_SIZE];
+static const flashGeometry_t testFlashGeometry = {
+    TEST_FLASH_SECTORS, TEST_FLASH_PAGES_PER_SECTOR, TEST_FLASH_PAGE_SIZE, TEST_FLASH_SECTOR_SIZE, TEST_FLASH_SIZE
+};
+static uint32_t testFlashProgramAddress;
+static bool testFlashProgramEnabled;
+static uint32_t testFlashReadCount;
+static uint32_t testFlashSectorEraseCount;
+static uint32_t testFlashIgnoredCommandCount;
+
+static uint64_t testMicros;
+static uint64_t testFlashBusyUntil;
+
+static void resetFlash(void)
+{
+    memset(testFlash, 0xFF, sizeof(testFlash));
+    testFlashReadCount = 0;
+    testFlashSectorEraseCount = 0;
+    testFlashIgnoredCommandCount = 0;
+    testFlashBusyUntil = testMicros;
+}
+
+static bool testFlashIsReady(void)
+{
+    return testMicros >= testFlashBusyUntil;
+}
+
+static bool testFlashWaitForReady(uint32_t timeoutMillis)
+{
+    if (!testFlashIsReady()) {
+        testMicros = MIN(testFlashBusyUntil, testMicros + timeoutMillis * 1000);
+    }
+
+    return testFlashIsReady();
+}
+
+static void runBackgroundErase(void)
+{
+    while (!flashfsIsReady()) {
+        testMicros += 1000;
+        flashfsEraseUpdate();
+    }
+}
+
+static void writeLog(uint32_t timestamp, uint32_t length)
+{
+    uint8_t data[100];
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+
+    EXPECT_TRUE(flashfsLogBegin(timestamp));
+
+    while (length > 0) {
+        uint32_t chunk = length < sizeof(data) ? length : sizeof(data);
+
+        flashfsWrite(data, chunk, true);
+        length -= chunk;
+    }
+
+    flashfsLogEnd();
+}
+
+// Any operation in progress is abandoned, then the volume is mounted again
+static void powerCycle(void)
+{
+    testFlashBusyUntil = testMicros;
+    flashfsInit();
+}
+
+static void formatFlash(void)
+{
+    resetFlash();
+    flashfsEraseCompletely();
+    runBackgroundErase();
+    flashfsInit();
+}
+
+TEST(FlashfsTest, ErasedVolumeIsIndexed)
+{
+    // given
+    resetFlash();
+
+    // when
+    flashfsInit();
+
+    // then
+    EXPECT_TRUE(flashfsIsIndexed());
+    EXPECT_EQ(0, flashfsGetLogCount());
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, LogsAreAppendedWithByteGranularity)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+
+    // when
+    writeLog(1000, 1234);
+    writeLog(2000, 300);
+
+    // and
+    flashfsInit();
+
+    // then
+    EXPECT_EQ(2, flashfsGetLogCount());
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 1234 + 300, flashfsGetOffset());
+
+    EXPECT_TRUE(flashfsGetLog(0, &log));
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE, log.start);
+    EXPECT_EQ(1234, log.length);
+    EXPECT_EQ(1000, log.timestamp);
+    EXPECT_EQ(0, log.flags);
+
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 1234, log.start);
+    EXPECT_EQ(300, log.length);
+    EXPECT_EQ(2000, log.timestamp);
+
+    EXPECT_FALSE(flashfsGetLog(2, &log));
+}
+
+TEST(FlashfsTest, OpenLogReportsCurrentLength)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+    uint8_t data[10] = {0};
+
+    // when
+    flashfsLogBegin(500);
+    flashfsWrite(data, sizeof(data), false);
+
+    // then
+    EXPECT_TRUE(flashfsGetLog(0, &log));
+    EXPECT_EQ(sizeof(data), log.length);
+    EXPECT_EQ(FLASHFS_LOG_FLAG_OPEN, log.flags);
+    EXPECT_FALSE(flashfsEraseLog(0));
+
+    // cleanup
+    flashfsLogEnd();
+}
+
+TEST(FlashfsTest, LogInterruptedByPowerLossIsRecovered)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+    uint8_t data[777];
+
+    memset(data, 0x5A, sizeof(data));
+    writeLog(1000, 4000);
+
+    // when
+    flashfsLogBegin(2000);
+    flashfsWrite(data, sizeof(data), true);
+    flashfsFlushSync();
+
+    // and the power is lost before flashfsLogEnd(), so the next boot mounts the volume again
+    flashfsInit();
+
+    // then
+    EXPECT_EQ(2, flashfsGetLogCount());
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 4000, log.start);
+    EXPECT_EQ(sizeof(data), log.length);
+    EXPECT_EQ(0, log.flags);
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 4000 + sizeof(data), flashfsGetOffset());
+}
+
+TEST(FlashfsTest, EmptyLogInterruptedByPowerLossIsRecovered)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+
+    writeLog(1000, 300);
+
+    // when
+    flashfsLogBegin(2000);
+    flashfsInit();
+
+    // then
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(0, log.length);
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 300, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, PartiallyWrittenEntryIsSkipped)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+    uint8_t partialEntry[4] = {0x00, 0x10, 0x01, 0x00};
+
+    writeLog(1000, 300);
+
+    // when the power is lost while the start address of the next entry is being programmed
+    m25p16_pageProgram(2 * 16, partialEntry, sizeof(partialEntry));
+    flashfsInit();
+
+    // and
+    writeLog(3000, 200);
+
+    // then
+    EXPECT_EQ(3, flashfsGetLogCount());
+    EXPECT_FALSE(flashfsGetLog(1, &log));
+    EXPECT_TRUE(flashfsGetLog(2, &log));
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 300, log.start);
+    EXPECT_EQ(200, log.length);
+}
+
+TEST(FlashfsTest, ErasingLogsReclaimsTheirSectors)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+    uint8_t byte;
+
+    writeLog(1000, 100000);
+    writeLog(2000, 150000);
+    writeLog(3000, 100000);
+    testFlashSectorEraseCount = 0;
+
+    // when
+    EXPECT_TRUE(flashfsEraseLog(1));
+    runBackgroundErase();
+
+    // then only the sectors which lie wholly inside the log are erased
+    EXPECT_EQ(1, testFlashSectorEraseCount);
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(FLASHFS_LOG_FLAG_DELETED, log.flags);
+    EXPECT_FALSE(flashfsEraseLog(1));
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 350000, flashfsGetOffset());
+
+    // when
+    EXPECT_TRUE(flashfsEraseLog(2));
+    runBackgroundErase();
+
+    // then the free space begins at the first sector after the remaining log
+    EXPECT_EQ(3 * TEST_FLASH_SECTOR_SIZE, flashfsGetOffset());
+    for (uint32_t address = 3 * TEST_FLASH_SECTOR_SIZE; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+
+    // and the remaining log is intact
+    flashfsReadAbs(TEST_FLASH_SECTOR_SIZE + 100000 - 1, &byte, 1);
+    EXPECT_EQ((100000 - 1) % 100, byte);
+
+    // when
+    flashfsInit();
+    writeLog(4000, 10);
+
+    // then
+    EXPECT_TRUE(flashfsGetLog(3, &log));
+    EXPECT_EQ(3 * TEST_FLASH_SECTOR_SIZE, log.start);
+}
+
+TEST(FlashfsTest, ErasingAllLogsReclaimsTheWholeVolume)
+{
+    // given
+    formatFlash();
+
+    writeLog(1000, 10);
+    writeLog(2000, 70000);
+    writeLog(3000, 10);
+
+    // when
+    EXPECT_TRUE(flashfsEraseLog(2));
+    runBackgroundErase();
+    EXPECT_TRUE(flashfsEraseLog(0));
+    runBackgroundErase();
+    EXPECT_TRUE(flashfsEraseLog(1));
+    runBackgroundErase();
+
+    // then
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE, flashfsGetOffset());
+    for (uint32_t address = TEST_FLASH_SECTOR_SIZE; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+}
+
+TEST(FlashfsTest, ErasingALogNeverWaitsForTheFlash)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+
+    writeLog(1000, 10);
+    writeLog(2000, 200000);
+    testFlashSectorEraseCount = 0;
+
+    // when
+    uint64_t before = testMicros;
+    EXPECT_TRUE(flashfsEraseLog(1));
+
+    // then it waits for the last page program at most, never for a sector erase
+    EXPECT_LT(testMicros - before, 1000u);
+    EXPECT_FALSE(flashfsIsReady());
+    EXPECT_FALSE(flashfsEraseLog(0));
+
+    while (flashfsGetEraseProgress() < 100) {
+        testMicros += 1000;
+        before = testMicros;
+        flashfsEraseUpdate();
+        EXPECT_LT(testMicros - before, 1000u);
+    }
+
+    EXPECT_EQ(0, testFlashIgnoredCommandCount);
+    EXPECT_EQ(3, testFlashSectorEraseCount);
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(FLASHFS_LOG_FLAG_DELETED, log.flags);
+    EXPECT_EQ(2 * TEST_FLASH_SECTOR_SIZE, flashfsGetOffset());
+    for (uint32_t address = 2 * TEST_FLASH_SECTOR_SIZE; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+}
+
+TEST(FlashfsTest, LogWhoseEraseIsInterruptedStaysListed)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+
+    writeLog(1000, 10);
+    writeLog(2000, 200000);
+    EXPECT_TRUE(flashfsEraseLog(1));
+    while (flashfsGetEraseProgress() < 50) {
+        testMicros += 1000;
+        flashfsEraseUpdate();
+    }
+
+    // when
+    powerCycle();
+
+    // then
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(0, log.flags);
+    EXPECT_EQ(TEST_FLASH_SECTOR_SIZE + 200010, flashfsGetOffset());
+
+    // and it can be erased again
+    EXPECT_TRUE(flashfsEraseLog(1));
+    runBackgroundErase();
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(FLASHFS_LOG_FLAG_DELETED, log.flags);
+    EXPECT_EQ(2 * TEST_FLASH_SECTOR_SIZE, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, LogBegunDuringTheEraseOfALogIsKept)
+{
+    // given
+    formatFlash();
+    flashfsLog_t log;
+
+    writeLog(1000, 10);
+    writeLog(2000, 100000);
+    EXPECT_TRUE(flashfsEraseLog(1));
+
+    // when
+    writeLog(3000, 1000);
+    runBackgroundErase();
+
+    // then the new log starts after the erased sectors, and survives their erase
+    EXPECT_TRUE(flashfsGetLog(1, &log));
+    EXPECT_EQ(FLASHFS_LOG_FLAG_DELETED, log.flags);
+    EXPECT_TRUE(flashfsGetLog(2, &log));
+    EXPECT_EQ(0, log.flags);
+    EXPECT_EQ(3 * TEST_FLASH_SECTOR_SIZE, log.start);
+    for (uint32_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(i % 100, testFlash[log.start + i]);
+    }
+    EXPECT_EQ(log.start + log.length, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, VolumeWithoutIndexIsAppendedTo)
+{
+    // given
+    const char *header = "H Product:Blackbox flight data recorder by Nicholas Sherlock\n";
+
+    resetFlash();
+    memcpy(testFlash, header, strlen(header));
+
+    // when
+    flashfsInit();
+
+    // then
+    EXPECT_FALSE(flashfsIsIndexed());
+    EXPECT_EQ(0, flashfsGetLogCount());
+    EXPECT_TRUE(flashfsLogBegin(1000));
+    EXPECT_EQ(65536, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, ManyLogsAreIndexedOnMount)
+{
+    // given
+    const int logCount = 500;
+
+    formatFlash();
+    for (int i = 0; i < logCount; i++) {
+        writeLog(i * 1000, 1000 + (i * 37) % 2000);
+    }
+    uint32_t expectedOffset = flashfsGetOffset();
+
+    // when
+    testFlashReadCount = 0;
+    flashfsInit();
+
+    // then
+    EXPECT_EQ(logCount, flashfsGetLogCount());
+    EXPECT_EQ(expectedOffset, flashfsGetOffset());
+
+    // and the used entries are found with a binary search, not by reading them all
+    EXPECT_LE(testFlashReadCount, 15u);
+}
+
+TEST(FlashfsTest, BackgroundEraseNeverWaitsForTheFlash)
+{
+    // given
+    resetFlash();
+    memset(testFlash, 0x00, sizeof(testFlash));
+    uint64_t start = testMicros;
+    uint8_t lastProgress = 0;
+
+    // when
+    flashfsEraseCompletely();
+
+    // then
+    EXPECT_FALSE(flashfsIsReady());
+
+    while (!flashfsIsReady()) {
+        testMicros += 1000;
+
+        uint64_t before = testMicros;
+        flashfsEraseUpdate();
+
+        EXPECT_EQ(before, testMicros);
+        EXPECT_GE(flashfsGetEraseProgress(), lastProgress);
+        lastProgress = flashfsGetEraseProgress();
+    }
+
+    EXPECT_EQ(100, flashfsGetEraseProgress());
+    EXPECT_EQ(0, testFlashIgnoredCommandCount);
+    EXPECT_EQ(TEST_FLASH_SECTORS, testFlashSectorEraseCount);
+    EXPECT_LE(testMicros - start, (uint64_t)TEST_FLASH_SECTORS * TEST_FLASH_SECTOR_ERASE_MICROS + TEST_FLASH_SECTORS * 1000);
+    for (uint32_t address = 0; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+}
+
+TEST(FlashfsTest, LoggingContinuesDuringBackgroundErase)
+{
+    // given a flash full of old data
+    resetFlash();
+    memset(testFlash, 0x00, sizeof(testFlash));
+    flashfsLog_t log;
+    uint32_t bytesLogged = 0;
+    uint8_t data[7];
+
+    // when a log is written at 7KB/s, like the blackbox does, while the erase runs
+    flashfsEraseCompletely();
+    EXPECT_TRUE(flashfsLogBegin(1000));
+
+    for (int millis = 0; millis < 30000; millis++) {
+        for (uint32_t i = 0; i < sizeof(data); i++) {
+            data[i] = (bytesLogged + i) % 254 + 1;
+        }
+        flashfsWrite(data, sizeof(data), false);
+        bytesLogged += sizeof(data);
+
+        testMicros += 1000;
+        flashfsEraseUpdate();
+    }
+    flashfsLogEnd();
+    runBackgroundErase();
+
+    // then
+    EXPECT_EQ(0, testFlashIgnoredCommandCount);
+    EXPECT_TRUE(flashfsGetLog(0, &log));
+
+    // nothing was written on top of old data
+    for (uint32_t address = log.start; address < log.start + log.length; address++) {
+        ASSERT_NE(0x00, testFlash[address]);
+    }
+    for (uint32_t address = log.start + log.length; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+
+    // and most of the log made it to the flash
+    EXPECT_GT(log.length, bytesLogged * 9 / 10);
+}
+
+TEST(FlashfsTest, LogBegunDuringBackgroundEraseNeverWaitsForTheFlash)
+{
+    // given
+    resetFlash();
+    memset(testFlash, 0x00, sizeof(testFlash));
+    flashfsLog_t log;
+    uint8_t data[7];
+
+    memset(data, 0x5A, sizeof(data));
+
+    flashfsEraseCompletely();
+    testMicros += 1000;
+    flashfsEraseUpdate();
+
+    // when a log is begun and written to while the flash is busy, like the blackbox does at arming
+    uint64_t before = testMicros;
+    EXPECT_TRUE(flashfsLogBegin(1000));
+
+    // then
+    EXPECT_EQ(before, testMicros);
+
+    // when
+    while (!flashfsIsReady()) {
+        testMicros += 1000;
+
+        before = testMicros;
+        flashfsWrite(data, sizeof(data), false);
+        flashfsEraseUpdate();
+
+        EXPECT_EQ(before, testMicros);
+    }
+    flashfsLogEnd();
+
+    // then
+    EXPECT_EQ(0, testFlashIgnoredCommandCount);
+
+    // when
+    powerCycle();
+
+    // then
+    EXPECT_TRUE(flashfsIsReady());
+    EXPECT_EQ(1, flashfsGetLogCount());
+    EXPECT_TRUE(flashfsGetLog(0, &log));
+    EXPECT_EQ(1000, log.timestamp);
+    EXPECT_GT(log.length, 0);
+    EXPECT_EQ(log.start + log.length, flashfsGetOffset());
+    for (uint32_t address = log.start; address < log.start + log.length; address++) {
+        ASSERT_EQ(0x5A, testFlash[address]);
+    }
+}
+
+TEST(FlashfsTest, LogOnUnresponsiveFlashIsDropped)
+{
+    // given
+    resetFlash();
+    uint8_t data[100];
+
+    memset(data, 0x5A, sizeof(data));
+
+    flashfsEraseCompletely();
+    testMicros += 1000;
+    flashfsEraseUpdate();
+
+    // when the flash never finishes the sector erase
+    testFlashBusyUntil = UINT64_MAX;
+
+    EXPECT_TRUE(flashfsLogBegin(1000));
+    flashfsWrite(data, sizeof(data), false);
+
+    uint64_t before = testMicros;
+    flashfsLogEnd();
+
+    // then the log is given up on once the flash times out
+    EXPECT_LE(testMicros - before, (uint64_t)TEST_FLASH_SECTOR_ERASE_TIMEOUT_MILLIS * 1000);
+    EXPECT_EQ(0, flashfsGetLogCount());
+
+    // when
+    testFlashBusyUntil = testMicros;
+    runBackgroundErase();
+    powerCycle();
+
+    // then
+    EXPECT_EQ(0, flashfsGetLogCount());
+    EXPECT_EQ(0, testFlashIgnoredCommandCount);
+}
+
+TEST(FlashfsTest, InterruptedEraseIsResumed)
+{
+    // given
+    resetFlash();
+    memset(testFlash, 0x00, sizeof(testFlash));
+    flashfsLog_t log;
+    uint8_t data[100];
+
+    memset(data, 0x5A, sizeof(data));
+
+    flashfsEraseCompletely();
+    while (flashfsGetEraseProgress() < 25) {
+        testMicros += 1000;
+        flashfsEraseUpdate();
+    }
+
+    flashfsLogBegin(1000);
+    for (int i = 0; i < 1000; i++) {
+        flashfsWrite(data, sizeof(data), true);
+    }
+    flashfsFlushSync();
+
+    // when the power is lost, and the volume is mounted again
+    powerCycle();
+
+    // then
+    EXPECT_FALSE(flashfsIsReady());
+    EXPECT_TRUE(flashfsGetLog(0, &log));
+    EXPECT_EQ(100000, log.length);
+
+    // when
+    runBackgroundErase();
+
+    // then
+    for (uint32_t address = log.start + log.length; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+    for (uint32_t address = log.start; address < log.start + log.length; address++) {
+        ASSERT_EQ(0x5A, testFlash[address]);
+    }
+
+    // when
+    flashfsInit();
+
+    // then the erase is recorded as complete
+    EXPECT_TRUE(flashfsIsReady());
+}
+
+TEST(FlashfsTest, InterruptedEraseOfEmptyVolumeIsResumed)
+{
+    // given
+    resetFlash();
+    memset(testFlash, 0x00, sizeof(testFlash));
+
+    flashfsEraseCompletely();
+    while (flashfsGetEraseProgress() < 50) {
+        testMicros += 1000;
+        flashfsEraseUpdate();
+    }
+
+    // when
+    powerCycle();
+
+    // then
+    EXPECT_FALSE(flashfsIsReady());
+
+    // when
+    runBackgroundErase();
+
+    // then
+    for (uint32_t address = 0; address < TEST_FLASH_SIZE; address++) {
+        ASSERT_EQ(0xFF, testFlash[address]);
+    }
+}
+
+TEST(FlashfsTest, SequentialSmallReadsAreServedFromReadAhead)
+{
+    // given
+    formatFlash();
+    uint8_t buffer[64];
+
+    for (int i = 0; i < 1000; i++) {
+        testFlash[TEST_FLASH_SECTOR_SIZE + i] = i;
+    }
+    testFlashReadCount = 0;
+
+    // when
+    for (uint32_t offset = 0; offset < FLASHFS_READ_AHEAD_SIZE; offset += sizeof(buffer)) {
+        EXPECT_EQ(sizeof(buffer), flashfsReadAbs(TEST_FLASH_SECTOR_SIZE + offset, buffer, sizeof(buffer)));
+        EXPECT_EQ((uint8_t)offset, buffer[0]);
+        EXPECT_EQ((uint8_t)(offset + sizeof(buffer) - 1), buffer[sizeof(buffer) - 1]);
+    }
+
+    // then
+    EXPECT_EQ(1, testFlashReadCount);
+}
+
+TEST(FlashfsTest, ReadAheadIsDiscardedByWrites)
+{
+    // given
+    formatFlash();
+    uint8_t byte = 0;
+    uint8_t data = 0x42;
+
+    flashfsReadAbs(TEST_FLASH_SECTOR_SIZE, &byte, 1);
+    EXPECT_EQ(0xFF, byte);
+
+    // when
+    flashfsWrite(&data, 1, true);
+    flashfsReadAbs(TEST_FLASH_SECTOR_SIZE, &byte, 1);
+
+    // then
+    EXPECT_EQ(0x42, byte);
+}
+
+TEST(FlashfsTest, ReadAtEndOfVolumeIsTruncated)
+{
+    // given
+    formatFlash();
+    uint8_t buffer[16];
+
+    // when
+    int bytesRead = flashfsReadAbs(TEST_FLASH_SIZE - 4, buffer, sizeof(buffer));
+
+    // then
+    EXPECT_EQ(4, bytesRead);
+}
+
+static unsigned int decodeErasedRuns(const uint8_t *data, unsigned int length, uint8_t *dest)
+{
+    unsigned int decoded = 0;
+
+    for (unsigned int i = 0; i < length; i++) {
+        if (data[i] == 0xFF) {
+            i++;
+            memset(dest + decoded, 0xFF, data[i]);
+            decoded += data[i];
+        } else {
+            dest[decoded++] = data[i];
+        }
+    }
+
+    return decoded;
+}
+
+TEST(FlashfsTest, CompressedReadRoundTrip)
+{
+    // given
+    formatFlash();
+    const uint32_t length = 3000;
+    uint8_t buffer[248];
+    uint8_t decoded[length];
+    unsigned int bytesRead;
+    uint32_t offset = 0;
+
+    // a log with some short runs of 0xFF in it, followed by free space
+    for (uint32_t i = 0; i < 1000; i++) {
+        testFlash[TEST_FLASH_SECTOR_SIZE + i] = (i % 50) < 3 ? 0xFF : i;
+    }
+
+    // when
+    while (offset < length) {
+        int bytesWritten = flashfsReadAbsCompressed(TEST_FLASH_SECTOR_SIZE + offset, length - offset, buffer, sizeof(buffer), &bytesRead);
+
+        ASSERT_GT(bytesRead, 0);
+        ASSERT_LE(bytesWritten, sizeof(buffer));
+        EXPECT_EQ(bytesRead, decodeErasedRuns(buffer, bytesWritten, decoded + offset));
+
+        offset += bytesRead;
+    }
+
+    // then
+    EXPECT_EQ(length, offset);
+    EXPECT_EQ(0, memcmp(testFlash + TEST_FLASH_SECTOR_SIZE, decoded, length));
+}
+
+TEST(FlashfsTest, CompressedRunIsNotSplitAtEndOfBuffer)
+{
+    // given
+    formatFlash();
+    uint8_t buffer[4];
+    unsigned int bytesRead;
+
+    testFlash[TEST_FLASH_SECTOR_SIZE + 0] = 1;
+    testFlash[TEST_FLASH_SECTOR_SIZE + 1] = 2;
+    testFlash[TEST_FLASH_SECTOR_SIZE + 2] = 3;
+
+    // when
+    int bytesWritten = flashfsReadAbsCompressed(TEST_FLASH_SECTOR_SIZE, 100, buffer, sizeof(buffer), &bytesRead);
+
+    // then
+    EXPECT_EQ(3, bytesWritten);
+    EXPECT_EQ(3, bytesRead);
+}
+
+/*
+ * The serial link between flight controller and configurator is a loopback port. Replies are framed as MSP replies
+ * and the configurator side decodes them straight out of the loopback buffer.
+ */
+#define MSP_FRAME_OVERHEAD 6        // $M> + size + command + checksum
+#define MSP_READ_REQUEST_SIZE (MSP_FRAME_OVERHEAD + 4 + 2 + 1)
+
+static uint8_t loopbackBuffer[512];
+static uint32_t loopbackLength;
+static uint32_t loopbackWriteCount;
+
+static void loopbackWrite(serialPort_t *instance, uint8_t ch)
+{
+    UNUSED(instance);
+    loopbackBuffer[loopbackLength++] = ch;
+    loopbackWriteCount++;
+}
+
+static void loopbackWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    UNUSED(instance);
+    memcpy(loopbackBuffer + loopbackLength, data, count);
+    loopbackLength += count;
+    loopbackWriteCount++;
+}
+
+static const struct serialPortVTable loopbackVTable = {
+    loopbackWrite, NULL, NULL, NULL, NULL, NULL, loopbackWriteBuf
+};
+
+TEST(FlashfsTest, CompressedDownloadReproducesTheVolume)
+{
+    // given
+    serialPort_t loopbackPort;
+    uint8_t *image = (uint8_t *) malloc(TEST_FLASH_SIZE);
+    uint8_t payload[242];
+    unsigned int bytesRead;
+    uint32_t linkBytes = 0, frames = 0;
+
+    memset(&loopbackPort, 0, sizeof(loopbackPort));
+    loopbackPort.vTable = &loopbackVTable;
+
+    formatFlash();
+    writeLog(1000, 500000);
+    loopbackWriteCount = 0;
+
+    // when the configurator downloads the whole volume
+    for (uint32_t address = 0; address < TEST_FLASH_SIZE; address += bytesRead) {
+        uint8_t header[] = {'$', 'M', '>', 0, 71, 0, 0, 0, 0, 0, 0, 0};
+        int payloadSize = flashfsReadAbsCompressed(address, 0xFFFF, payload, sizeof(payload), &bytesRead);
+
+        header[3] = 7 + payloadSize;
+        memcpy(header + 5, &address, 4);
+        memcpy(header + 9, &bytesRead, 2);
+        header[11] = FLASHFS_COMPRESSION_RLE_ERASED;
+
+        loopbackLength = 0;
+        serialWriteBuf(&loopbackPort, header, sizeof(header));
+        serialWriteBuf(&loopbackPort, payload, payloadSize);
+        serialWrite(&loopbackPort, 0); // checksum
+
+        decodeErasedRuns(loopbackBuffer + sizeof(header), payloadSize, image + address);
+
+        linkBytes += MSP_READ_REQUEST_SIZE + loopbackLength;
+        frames++;
+    }
+
+    // then
+    EXPECT_EQ(0, memcmp(testFlash, image, TEST_FLASH_SIZE));
+    EXPECT_EQ(frames * 3, loopbackWriteCount);
+
+
+    // and the erased free space takes a fraction of the frames and link bytes of 128 byte reads
+    uint32_t uncompressedFrames = TEST_FLASH_SIZE / 128;
+    uint32_t uncompressedLinkBytes = uncompressedFrames * (MSP_FRAME_OVERHEAD + 4 + MSP_FRAME_OVERHEAD + 4 + 128);
+
+    EXPECT_LT(frames, uncompressedFrames / 4);
+    EXPECT_LT(linkBytes, uncompressedLinkBytes / 4);
+
+    free(image);
+}
+
+// STUBS
+
+extern "C" {
+
+bool m25p16_init()
+{
+    return true;
+}
+
+void m25p16_eraseSector(uint32_t address)
+{
+    if (!testFlashWaitForReady(TEST_FLASH_SECTOR_ERASE_TIMEOUT_MILLIS)) {
+        testFlashIgnoredCommandCount++;
+        return;
+    }
+
+    address -= address % TEST_FLASH_SECTOR_SIZE;
+
+    memset(testFlash + address, 0xFF, TEST_FLASH_SECTOR_SIZE);
+    testFlashSectorEraseCount++;
+    testFlashBusyUntil = testMicros + TEST_FLASH_SECTOR_ERASE_MICROS;
+}
+
+void m25p16_eraseCompletely()
+{
+    if (!testFlashWaitForReady(TEST_FLASH_BULK_ERASE_TIMEOUT_MILLIS)) {
+        testFlashIgnoredCommandCount++;
+        return;
+    }
+
+    memset(testFlash, 0xFF, sizeof(testFlash));
+    testFlashBusyUntil = testMicros + TEST_FLASH_BULK_ERASE_MICROS;
+}
+
+void m25p16_pageProgramBegin(uint32_t address)
+{
+    testFlashProgramAddress = address;
+    testFlashProgramEnabled = testFlashWaitForReady(TEST_FLASH_DEFAULT_TIMEOUT_MILLIS);
+
+    if (!testFlashProgramEnabled) {
+        testFlashIgnoredCommandCount++;
+    }
+}
+
+void m25p16_pageProgramContinue(const uint8_t *data, int length)
+{
+    uint32_t pageStart = testFlashProgramAddress - testFlashProgramAddress % TEST_FLASH_PAGE_SIZE;
+
+    if (!testFlashProgramEnabled) {
+        return;
+    }
+
+    for (int i = 0; i < length; i++) {
+        testFlash[testFlashProgramAddress] &= data[i];
+
+        testFlashProgramAddress = pageStart + (testFlashProgramAddress + 1 - pageStart) % TEST_FLASH_PAGE_SIZE;
+    }
+
+    testFlashBusyUntil = testMicros + length * TEST_FLASH_PROGRAM_MICROS_PER_BYTE;
+}
+
+void m25p16_pageProgramFinish()
+{
+}
+
+void m25p16_pageProgram(uint32_t address, const uint8_t *data, int length)
+{
+    m25p16_pageProgramBegin(address);
+    m25p16_pageProgramContinue(data, length);
+    m25p16_pageProgramFinish();
+}
+
+int m25p16_readBytes(uint32_t address, uint8_t *buffer, int length)
+{
+    if (!testFlashWaitForReady(TEST_FLASH_DEFAULT_TIMEOUT_MILLIS)) {
+        return 0;
+    }
+
+    memcpy(buffer, testFlash + address, length);
+    testFlashReadCount++;
+
+    return length;
+}
+
+bool m25p16_isReady()
+{
+    return testFlashIsReady();
+}
+
+bool m25p16_waitForReady(uint32_t timeoutMillis)
+{
+    return testFlashWaitForReady(timeoutMillis);
+}
+
+const flashGeometry_t* m25p16_getGeometry()
+{
+    return &testFlashGeometry;
+}
+
+}
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include <limits.h>
 
@@ -28,6 +29,7 @@ extern "C" {
 
     #include "drivers/sensor.h"
     #include "drivers/accgyro.h"
+    #include "drivers/pwm_mapping.h"
 
     #include "sensors/sensors.h"
     #include "sensors/acceleration.h"
@@ -39,10 +41,27 @@ extern "C" {
     #include "flight/lowpass.h"
 
     #include "io/rc_controls.h"
+    #include "io/gimbal.h"
+    #include "io/escservo.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
 
     extern uint8_t servoCount;
+    extern uint8_t motorCount;
     void forwardAuxChannelsToServos(void);
 
+    void mixerInit(mixerMode_e mixerMode, motorMixer_t *customMixers);
+    void mixerUsePWMOutputConfiguration(pwmOutputConfiguration_t *pwmOutputConfiguration);
+    void mixerUseConfigs(
+        servoParam_t *servoConfToUse,
+        gimbalConfig_t *gimbalConfigToUse,
+        flight3DConfig_t *flight3DConfigToUse,
+        escAndServoConfig_t *escAndServoConfigToUse,
+        mixerConfig_t *mixerConfigToUse,
+        airplaneConfig_t *airplaneConfigToUse,
+        rxConfig_t *rxConfigToUse);
+
 }
 
 #include "unittest_macros.h"
@@ -61,6 +80,67 @@ servo_t servos[MAX_SUPPORTED_SERVOS];
 
 uint8_t lastOneShotUpdateMotorCount;
 
+uint32_t testMicros;
+uint16_t testMotorPulseStartDelay;
+
+uint32_t testFeatureMask;
+
+static servoParam_t servoConf[MAX_SUPPORTED_SERVOS];
+static gimbalConfig_t gimbalConfig;
+static flight3DConfig_t flight3DConfig;
+static escAndServoConfig_t escAndServoConfig;
+static mixerConfig_t mixerConfig;
+static airplaneConfig_t airplaneConfig;
+static rxConfig_t rxConfig;
+static motorMixer_t floatMixer[MAX_SUPPORTED_MOTORS];
+
+static void setupMixer(mixerMode_e mixerMode, uint32_t features)
+{
+    pwmOutputConfiguration_t pwmOutputConfiguration = { 0, 0 };
+
+    memset(servoConf, 0, sizeof(servoConf));
+    memset(&gimbalConfig, 0, sizeof(gimbalConfig));
+    memset(&flight3DConfig, 0, sizeof(flight3DConfig));
+    memset(&mixerConfig, 0, sizeof(mixerConfig));
+    memset(&airplaneConfig, 0, sizeof(airplaneConfig));
+    memset(&rxConfig, 0, sizeof(rxConfig));
+
+    escAndServoConfig.minthrottle = 1150;
+    escAndServoConfig.maxthrottle = 1850;
+    escAndServoConfig.mincommand = 1000;
+    mixerConfig.yaw_direction = 1;
+    mixerConfig.pid_at_min_throttle = 1;
+    rxConfig.mincheck = 1100;
+    rxConfig.midrc = 1500;
+
+    testFeatureMask = features;
+    armingFlags = 0;
+    ENABLE_ARMING_FLAG(ARMED);
+
+    memset(rcCommand, 0, sizeof(rcCommand));
+    memset(axisPID, 0, sizeof(axisPID));
+    rcCommand[YAW] = 500; // keep the "yaw jump" limit out of the way
+    for (int i = 0; i < MAX_SUPPORTED_RC_CHANNEL_COUNT; i++) {
+        rcData[i] = 1500;
+    }
+
+    motorCount = 0;
+    mixerUseConfigs(servoConf, &gimbalConfig, &flight3DConfig, &escAndServoConfig, &mixerConfig, &airplaneConfig, &rxConfig);
+    mixerInit(mixerMode, floatMixer);
+    mixerUsePWMOutputConfiguration(&pwmOutputConfiguration);
+
+    // the float coefficients of the builtin mixer, as used before the fixed point mixer
+    mixerLoadMix(mixerMode - 1, floatMixer);
+}
+
+static int16_t floatMix(uint8_t motorIndex)
+{
+    return rcCommand[THROTTLE] * floatMixer[motorIndex].throttle +
+        axisPID[PITCH] * floatMixer[motorIndex].pitch +
+        axisPID[ROLL] * floatMixer[motorIndex].roll +
+        -mixerConfig.yaw_direction * axisPID[YAW] * floatMixer[motorIndex].yaw;
+}
+
 
 TEST(FlightMixerTest, TestForwardAuxChannelsToServosWithNoServos)
 {
@@ -83,6 +163,200 @@ TEST(FlightMixerTest, TestForwardAuxChannelsToServosWithNoServos)
     }
 }
 
+TEST(FlightMixerTest, FixedPointMixMatchesFloatMix)
+{
+    static const mixerMode_e mixerModes[] = {
+        MIXER_QUADX, MIXER_QUADP, MIXER_Y6, MIXER_HEX6, MIXER_HEX6X, MIXER_Y4, MIXER_OCTOX8, MIXER_OCTOFLATP,
+        MIXER_OCTOFLATX, MIXER_VTAIL4, MIXER_ATAIL4, MIXER_HEX6H
+    };
+
+    srand(1);
+
+    for (uint8_t m = 0; m < sizeof(mixerModes) / sizeof(mixerModes[0]); m++) {
+        // given
+        setupMixer(mixerModes[m], 0);
+
+        for (int iteration = 0; iteration < 1000; iteration++) {
+            rcCommand[THROTTLE] = 1450 + rand() % 100;
+            axisPID[ROLL] = rand() % 160 - 80;
+            axisPID[PITCH] = rand() % 160 - 80;
+            axisPID[YAW] = rand() % 160 - 80;
+
+            // when
+            mixTable();
+
+            // then
+            for (uint8_t i = 0; i < motorCount; i++) {
+                EXPECT_NEAR(floatMix(i), motor[i], 1) << "mixer " << mixerModes[m] << " motor " << (int)i;
+            }
+        }
+    }
+}
+
+TEST(FlightMixerTest, SaturatedMotorsAreClippedWithoutAirmode)
+{
+    // given
+    setupMixer(MIXER_QUADX, 0);
+    rcCommand[THROTTLE] = 1200;
+    axisPID[ROLL] = 200;
+
+    // when
+    mixTable();
+
+    // then the right motors would need to go below minthrottle, half of the roll correction is lost
+    EXPECT_EQ(1150, motor[0]);
+    EXPECT_EQ(1150, motor[1]);
+    EXPECT_EQ(1400, motor[2]);
+    EXPECT_EQ(1400, motor[3]);
+}
+
+TEST(FlightMixerTest, AirmodeRaisesThrottleToKeepDifferential)
+{
+    // given
+    setupMixer(MIXER_QUADX, FEATURE_AIRMODE);
+    rcCommand[THROTTLE] = 1200;
+    axisPID[ROLL] = 200;
+
+    // when
+    mixTable();
+
+    // then
+    EXPECT_EQ(1150, motor[0]);
+    EXPECT_EQ(1150, motor[1]);
+    EXPECT_EQ(1550, motor[2]);
+    EXPECT_EQ(1550, motor[3]);
+}
+
+TEST(FlightMixerTest, AirmodeLowersThrottleToKeepDifferential)
+{
+    // given
+    setupMixer(MIXER_QUADX, FEATURE_AIRMODE);
+    rcCommand[THROTTLE] = 1800;
+    axisPID[PITCH] = 100;
+
+    // when
+    mixTable();
+
+    // then
+    EXPECT_EQ(1850, motor[0]);
+    EXPECT_EQ(1650, motor[1]);
+    EXPECT_EQ(1850, motor[2]);
+    EXPECT_EQ(1650, motor[3]);
+}
+
+TEST(FlightMixerTest, AirmodeScalesCorrectionsThatExceedThrottleRange)
+{
+    // given
+    setupMixer(MIXER_QUADX, FEATURE_AIRMODE);
+    rcCommand[THROTTLE] = 1500;
+    axisPID[ROLL] = 500;
+    axisPID[YAW] = 200;
+
+    // when
+    mixTable();
+
+    // then roll and yaw are halved to fit the 700us between minthrottle and maxthrottle
+    EXPECT_EQ(1350, motor[0]);
+    EXPECT_EQ(1150, motor[1]);
+    EXPECT_EQ(1650, motor[2]);
+    EXPECT_EQ(1850, motor[3]);
+}
+
+TEST(FlightMixerTest, AirmodeKeepsPidActiveAtMinimumThrottle)
+{
+    // given
+    setupMixer(MIXER_QUADX, FEATURE_AIRMODE);
+    mixerConfig.pid_at_min_throttle = 0;
+    rcData[THROTTLE] = 1000;
+    rcCommand[THROTTLE] = 1150;
+    axisPID[ROLL] = 50;
+
+    // when
+    mixTable();
+
+    // then
+    EXPECT_EQ(1150, motor[0]);
+    EXPECT_EQ(1150, motor[1]);
+    EXPECT_EQ(1250, motor[2]);
+    EXPECT_EQ(1250, motor[3]);
+}
+
+TEST(FlightMixerTest, MotorOutputLatencyIsMeasuredFromMixToPulse)
+{
+    // given
+    setupMixer(MIXER_QUADX, FEATURE_ONESHOT125);
+    memset(&motorOutputLatency, 0, sizeof(motorOutputLatency));
+    memset(motors, 0, sizeof(motors));
+    rcCommand[THROTTLE] = 1400;
+    testMotorPulseStartDelay = 0;
+
+    // when
+    testMicros = 1000;
+    mixTable();
+    testMicros = 1012;
+    writeMotors();
+
+    // then every motor was staged before the oneshot pulses were started together
+    for (uint8_t i = 0; i < motorCount; i++) {
+        EXPECT_EQ(motor[i], motors[i].value);
+    }
+    EXPECT_EQ(4, lastOneShotUpdateMotorCount);
+
+    // and
+    EXPECT_EQ(12, motorOutputLatency.last);
+    EXPECT_EQ(12, motorOutputLatency.max);
+}
+
+TEST(FlightMixerTest, MotorOutputLatencyIncludesWaitForFreeRunningTimer)
+{
+    // given
+    setupMixer(MIXER_QUADX, 0);
+    memset(&motorOutputLatency, 0, sizeof(motorOutputLatency));
+    rcCommand[THROTTLE] = 1400;
+
+    // when the timers are 300us away from their next period
+    testMotorPulseStartDelay = 300;
+    testMicros = 2000;
+    mixTable();
+    testMicros = 2010;
+    writeMotors();
+
+    // then
+    EXPECT_EQ(310, motorOutputLatency.last);
+
+    // when the next loop catches the timers right before their period
+    testMotorPulseStartDelay = 5;
+    testMicros = 5000;
+    mixTable();
+    testMicros = 5010;
+    writeMotors();
+
+    // then the peak is kept
+    EXPECT_EQ(15, motorOutputLatency.last);
+    EXPECT_EQ(310, motorOutputLatency.max);
+}
+
+TEST(FlightMixerTest, MotorWritesWithoutMixDoNotUpdateLatency)
+{
+    // given
+    setupMixer(MIXER_QUADX, 0);
+    memset(&motorOutputLatency, 0, sizeof(motorOutputLatency));
+    testMotorPulseStartDelay = 0;
+
+    // and
+    testMicros = 1000;
+    mixTable();
+    writeMotors();
+
+    // when the motors are written directly, for example when stopping them, long after the last mix
+    testMicros = 90000;
+    writeAllMotors(1000);
+
+    // then
+    EXPECT_EQ(0, motorOutputLatency.last);
+    EXPECT_EQ(0, motorOutputLatency.max);
+}
+
 // STUBS
 
 extern "C" {
@@ -102,8 +376,8 @@ uint8_t armingFlags;
 
 void delay(uint32_t) {}
 
-bool feature(uint32_t) {
-    return true;
+bool feature(uint32_t mask) {
+    return testFeatureMask & mask;
 }
 
 int32_t lowpassFixed(lowpass_t *, int32_t, int16_t) {
@@ -118,6 +392,14 @@ void pwmCompleteOneshotMotorUpdate(uint8_t motorCount) {
     lastOneShotUpdateMotorCount = motorCount;
 }
 
+uint16_t pwmGetMotorPulseStartDelay(void) {
+    return testMotorPulseStartDelay;
+}
+
+uint32_t micros(void) {
+    return testMicros;
+}
+
 void pwmWriteServo(uint8_t index, uint16_t value) {
     servos[index].value = value;
 }
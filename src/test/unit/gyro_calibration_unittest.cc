@@ -0,0 +1,421 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "drivers/sensor.h"
+    #include "drivers/accgyro.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/gyro.h"
+    #include "sensors/gyro_calibration.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_WINDOW_LENGTH 256
+#define TEST_THRESHOLD 32               // default moron_threshold
+#define TEST_NOISE 12                   // peak noise amplitude, well below the threshold
+
+static gyroBiasEstimator_t estimator;
+static uint32_t noiseSeed;
+
+// triangular noise in -amplitude..amplitude, deterministic between runs
+static int16_t noise(int16_t amplitude)
+{
+    int32_t a, b;
+
+    noiseSeed = noiseSeed * 1664525 + 1013904223;
+    a = (noiseSeed >> 16) % (amplitude + 1);
+    noiseSeed = noiseSeed * 1664525 + 1013904223;
+    b = (noiseSeed >> 16) % (amplitude + 1);
+    return a - b;
+}
+
+// pushes one window of noisy samples around the given bias, returns the result of the last push
+static bool pushStillWindow(const float *bias, int16_t temperature)
+{
+    int16_t sample[XYZ_AXIS_COUNT];
+    bool updated = false;
+    uint8_t axis;
+    int i;
+
+    for (i = 0; i < TEST_WINDOW_LENGTH; i++) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = lrintf(bias[axis]) + noise(TEST_NOISE);
+        }
+        updated = gyroBiasEstimatorPush(&estimator, sample, TEST_THRESHOLD, temperature);
+    }
+    return updated;
+}
+
+static void resetEstimator(void)
+{
+    noiseSeed = 1;
+    gyroBiasEstimatorInit(&estimator, TEST_WINDOW_LENGTH);
+}
+
+static void pushMovingWindow(int16_t temperature)
+{
+    int16_t sample[XYZ_AXIS_COUNT];
+    uint8_t axis;
+    int i;
+
+    // a slow yaw turn started halfway through the window, the other axes stay still
+    for (i = 0; i < TEST_WINDOW_LENGTH; i++) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = noise(TEST_NOISE);
+        }
+        if (i >= TEST_WINDOW_LENGTH / 2) {
+            sample[Z] += 200;
+        }
+        EXPECT_FALSE(gyroBiasEstimatorPush(&estimator, sample, TEST_THRESHOLD, temperature));
+    }
+}
+
+static void expectBiasNear(const float *bias, float tolerance)
+{
+    uint8_t axis;
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(bias[axis], gyroBiasEstimatorGetBias(&estimator, axis), tolerance);
+    }
+}
+
+TEST(GyroCalibrationTest, FirstStillWindowCalibrates)
+{
+    // given
+    resetEstimator();
+    float bias[XYZ_AXIS_COUNT] = { 23, -57, 4 };
+    int16_t sample[XYZ_AXIS_COUNT];
+    uint8_t axis;
+    int i;
+
+    // when
+    for (i = 0; i < TEST_WINDOW_LENGTH - 1; i++) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = bias[axis] + noise(TEST_NOISE);
+        }
+        EXPECT_FALSE(gyroBiasEstimatorPush(&estimator, sample, TEST_THRESHOLD, 0));
+    }
+
+    // then
+    EXPECT_FALSE(estimator.biasValid);
+
+    // when
+    EXPECT_TRUE(gyroBiasEstimatorPush(&estimator, sample, TEST_THRESHOLD, 0));
+
+    // then
+    EXPECT_TRUE(estimator.biasValid);
+    expectBiasNear(bias, 1);
+}
+
+TEST(GyroCalibrationTest, MovementRestartsCalibration)
+{
+    // given
+    resetEstimator();
+    float bias[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+
+    // when
+    pushMovingWindow(0);
+
+    // then
+    EXPECT_FALSE(estimator.biasValid);
+
+    // when
+    EXPECT_TRUE(pushStillWindow(bias, 0));
+
+    // then
+    EXPECT_TRUE(estimator.biasValid);
+    expectBiasNear(bias, 1);
+}
+
+TEST(GyroCalibrationTest, ZeroThresholdAcceptsMovement)
+{
+    // given
+    resetEstimator();
+    int16_t sample[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+    int i;
+
+    // when
+    for (i = 0; i < TEST_WINDOW_LENGTH; i++) {
+        sample[X] = (i < TEST_WINDOW_LENGTH / 2) ? -500 : 500;
+        gyroBiasEstimatorPush(&estimator, sample, 0, 0);
+    }
+
+    // then
+    EXPECT_TRUE(estimator.biasValid);
+    EXPECT_EQ(0, gyroBiasEstimatorGetBias(&estimator, X));
+}
+
+TEST(GyroCalibrationTest, MovementDoesNotDisturbBias)
+{
+    // given
+    resetEstimator();
+    float bias[XYZ_AXIS_COUNT] = { -10, 15, 30 };
+    pushStillWindow(bias, 0);
+
+    // when
+    pushMovingWindow(0);
+    pushMovingWindow(0);
+
+    // then
+    expectBiasNear(bias, 1);
+}
+
+TEST(GyroCalibrationTest, SlowDriftIsTracked)
+{
+    // given
+    resetEstimator();
+    float bias[XYZ_AXIS_COUNT] = { 10, -20, 5 };
+    uint8_t axis;
+    int window;
+    pushStillWindow(bias, 0);
+
+    // when
+    // the bias of a warming sensor drifts by 0.1 LSB per window, i.e. 30 LSB over 300 windows
+    for (window = 0; window < 300; window++) {
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            bias[axis] += (axis == Y) ? -0.1f : 0.1f;
+        }
+        EXPECT_TRUE(pushStillWindow(bias, 0));
+    }
+
+    // then
+    // a 1/8 step per window lags a ramp by 7 windows worth of drift
+    expectBiasNear(bias, 1.5f);
+}
+
+TEST(GyroCalibrationTest, TemperatureChangeSpeedsUpTracking)
+{
+    // given
+    float bias[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+    float shifted[XYZ_AXIS_COUNT] = { 40, 40, 40 };
+    int16_t steadyTemperatureBias, changingTemperatureBias;
+
+    resetEstimator();
+    pushStillWindow(bias, 25);
+
+    // when
+    pushStillWindow(shifted, 25);
+
+    // then
+    steadyTemperatureBias = gyroBiasEstimatorGetBias(&estimator, X);
+    EXPECT_NEAR(40 / 8, steadyTemperatureBias, 1);
+
+    // given
+    resetEstimator();
+    pushStillWindow(bias, 25);
+
+    // when
+    pushStillWindow(shifted, 25 + GYRO_BIAS_TEMPERATURE_STEP);
+
+    // then
+    changingTemperatureBias = gyroBiasEstimatorGetBias(&estimator, X);
+    EXPECT_NEAR(40 / 2, changingTemperatureBias, 1);
+
+    // when
+    // the temperature has settled, the next window is a normal tracking step again
+    pushStillWindow(shifted, 25 + GYRO_BIAS_TEMPERATURE_STEP);
+
+    // then
+    EXPECT_NEAR(20 + 20 / 8, gyroBiasEstimatorGetBias(&estimator, X), 1);
+}
+
+TEST(GyroCalibrationTest, WindowLengthIsConstrained)
+{
+    // when
+    gyroBiasEstimatorInit(&estimator, 0);
+
+    // then
+    EXPECT_EQ(2, estimator.windowLength);
+
+    // when
+    gyroBiasEstimatorInit(&estimator, 60000);
+
+    // then
+    EXPECT_EQ(GYRO_CALIBRATION_MAX_WINDOW, estimator.windowLength);
+}
+
+static gyroTempCompensation_t table;
+
+// a sensor whose bias changes by slopes[] LSB per degree around 25 degrees C, with a bend at 40 degrees C
+static float biasAtTemperature(uint8_t axis, float temperature)
+{
+    const float biasAt25[XYZ_AXIS_COUNT] = { 12, -30, 4 };
+    const float slopes[XYZ_AXIS_COUNT] = { 0.8f, -1.5f, 0.25f };
+    float bias = biasAt25[axis] + slopes[axis] * (temperature - 25);
+
+    if (temperature > 40) {
+        bias += slopes[axis] * (temperature - 40);
+    }
+    return bias;
+}
+
+// learns one still window's mean, measured with noise, at the given temperature
+static void learnAt(int16_t temperature)
+{
+    int32_t bias[XYZ_AXIS_COUNT];
+    uint8_t axis;
+
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        float measured = biasAtTemperature(axis, temperature) + noise(16) / 32.0f;
+        bias[axis] = lrintf(measured * (1 << GYRO_BIAS_FRACTION_BITS));
+    }
+    gyroTempCompensationLearn(&table, temperature, bias);
+}
+
+TEST(GyroCalibrationTest, TempCompensationUnknownUntilLearnt)
+{
+    // given
+    int16_t bias[XYZ_AXIS_COUNT];
+    gyroTempCompensationReset(&table);
+
+    // then
+    EXPECT_FALSE(gyroTempCompensationLookup(&table, 25, bias));
+
+    // when
+    noiseSeed = 1;
+    learnAt(25);
+
+    // then
+    // 25 C lies between the 20 C and 30 C points, both take the first window as it is
+    EXPECT_EQ(1, table.windowCount[3]);
+    EXPECT_EQ(1, table.windowCount[4]);
+    EXPECT_TRUE(gyroTempCompensationLookup(&table, 21, bias));
+    EXPECT_NEAR(biasAtTemperature(Y, 25) * 16, bias[Y], 16);
+    EXPECT_FALSE(gyroTempCompensationLookup(&table, 31, bias));
+    EXPECT_FALSE(gyroTempCompensationLookup(&table, 19, bias));
+
+    // and
+    // exactly on a point only that point is needed
+    EXPECT_TRUE(gyroTempCompensationLookup(&table, 30, bias));
+    EXPECT_TRUE(gyroTempCompensationLookup(&table, 20, bias));
+}
+
+TEST(GyroCalibrationTest, TempCompensationFitsWarmUpSweep)
+{
+    // given
+    int16_t bias[XYZ_AXIS_COUNT];
+    int16_t temperature;
+    uint8_t axis;
+    int sweep;
+
+    gyroTempCompensationReset(&table);
+    noiseSeed = 1;
+
+    // when
+    // several power cycles, each warming the sensor from 10 to 50 C with a few still windows per degree
+    for (sweep = 0; sweep < 8; sweep++) {
+        for (temperature = 10; temperature <= 50; temperature++) {
+            learnAt(temperature);
+            learnAt(temperature);
+            learnAt(temperature);
+        }
+    }
+
+    // then
+    for (temperature = 10; temperature <= 50; temperature++) {
+        ASSERT_TRUE(gyroTempCompensationLookup(&table, temperature, bias));
+        for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            EXPECT_NEAR(biasAtTemperature(axis, temperature), bias[axis] / 16.0f, 0.75f);
+        }
+    }
+
+    // and
+    // nothing was learnt outside the sweep
+    EXPECT_FALSE(gyroTempCompensationLookup(&table, -5, bias));
+    EXPECT_FALSE(gyroTempCompensationLookup(&table, 55, bias));
+}
+
+TEST(GyroCalibrationTest, TempCompensationInterpolatesLinearly)
+{
+    // given
+    int16_t bias[XYZ_AXIS_COUNT];
+    int16_t temperature;
+
+    gyroTempCompensationReset(&table);
+    table.bias[2][X] = 100;            // 10 C
+    table.bias[3][X] = 260;            // 20 C
+    table.windowCount[2] = 1;
+    table.windowCount[3] = 1;
+
+    // then
+    for (temperature = 10; temperature <= 20; temperature++) {
+        ASSERT_TRUE(gyroTempCompensationLookup(&table, temperature, bias));
+        EXPECT_EQ(100 + 16 * (temperature - 10), bias[X]);
+    }
+}
+
+TEST(GyroCalibrationTest, TempCompensationClampsToTableEnds)
+{
+    // given
+    int16_t bias[XYZ_AXIS_COUNT];
+
+    gyroTempCompensationReset(&table);
+    table.bias[0][Z] = -50;
+    table.windowCount[0] = 1;
+    table.bias[GYRO_TEMP_COMP_POINT_COUNT - 1][Z] = 70;
+    table.windowCount[GYRO_TEMP_COMP_POINT_COUNT - 1] = 1;
+
+    // then
+    ASSERT_TRUE(gyroTempCompensationLookup(&table, GYRO_TEMP_COMP_MIN_TEMPERATURE - 30, bias));
+    EXPECT_EQ(-50, bias[Z]);
+    ASSERT_TRUE(gyroTempCompensationLookup(&table, 120, bias));
+    EXPECT_EQ(70, bias[Z]);
+
+    // when
+    // learning beyond the last point only moves the last point
+    int32_t measured[XYZ_AXIS_COUNT] = { 0, 0, 90 << GYRO_BIAS_FRACTION_BITS };
+    gyroTempCompensationLearn(&table, 120, measured);
+
+    // then
+    EXPECT_EQ(0, table.windowCount[GYRO_TEMP_COMP_POINT_COUNT - 2]);
+    EXPECT_EQ(2, table.windowCount[GYRO_TEMP_COMP_POINT_COUNT - 1]);
+    EXPECT_NEAR(70 + (90 * 16 - 70) / 4, table.bias[GYRO_TEMP_COMP_POINT_COUNT - 1][Z], 1);
+}
+
+TEST(GyroCalibrationTest, StillWindowMeanIsKeptForLearning)
+{
+    // given
+    resetEstimator();
+    float bias[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+    float shifted[XYZ_AXIS_COUNT] = { 40, -40, 8 };
+    uint8_t axis;
+    pushStillWindow(bias, 25);
+
+    // when
+    pushStillWindow(shifted, 25);
+
+    // then
+    // the bias only moved 1/8 of the way, the window mean is what was measured
+    for (axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(shifted[axis], estimator.windowMean[axis] / (float)(1 << GYRO_BIAS_FRACTION_BITS), 1);
+    }
+}
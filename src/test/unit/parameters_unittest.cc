@@ -0,0 +1,220 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/color.h"
+
+    #include "drivers/sensor.h"
+    #include "drivers/accgyro.h"
+    #include "drivers/compass.h"
+    #include "drivers/serial.h"
+    #include "drivers/input_filtering.h"
+
+    #include "io/escservo.h"
+    #include "io/gps.h"
+    #include "io/gimbal.h"
+    #include "io/rc_controls.h"
+    #include "io/serial.h"
+    #include "io/ledstrip.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/battery.h"
+    #include "sensors/boardalignment.h"
+    #include "sensors/sensors.h"
+    #include "sensors/acceleration.h"
+    #include "sensors/gyro.h"
+    #include "sensors/compass.h"
+    #include "sensors/barometer.h"
+
+    #include "flight/pid.h"
+    #include "flight/imu.h"
+    #include "flight/mixer.h"
+    #include "flight/navigation.h"
+    #include "flight/failsafe.h"
+
+    #include "telemetry/telemetry.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
+    #include "config/config_profile.h"
+    #include "config/config_master.h"
+
+    #include "config/parameters.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static uint8_t currentControlRateProfileIndex;
+
+TEST(ParametersTest, TableIsSortedByName)
+{
+    for (uint16_t i = 1; i < parameterCount; i++) {
+        EXPECT_LT(strcasecmp(parameterTable[i - 1].name, parameterTable[i].name), 0) << parameterTable[i].name;
+    }
+}
+
+TEST(ParametersTest, EveryParameterCanBeFound)
+{
+    for (uint16_t i = 0; i < parameterCount; i++) {
+        const char *name = parameterTable[i].name;
+        EXPECT_EQ(&parameterTable[i], parameterFind(name, strlen(name)));
+    }
+}
+
+TEST(ParametersTest, FindRequiresExactMatch)
+{
+    // expect
+    EXPECT_TRUE(parameterFind("looptime", 8) != NULL);
+    EXPECT_TRUE(parameterFind("LOOPTIME", 8) != NULL);
+    EXPECT_TRUE(parameterFind("loop", 4) == NULL);
+    EXPECT_TRUE(parameterFind("looptimes", 9) == NULL);
+    EXPECT_TRUE(parameterFind("zzz", 3) == NULL);
+    EXPECT_TRUE(parameterFind("", 0) == NULL);
+}
+
+TEST(ParametersTest, EveryParameterHasOneTypeAndSection)
+{
+    for (uint16_t i = 0; i < parameterCount; i++) {
+        uint16_t type = parameterTable[i].type & VALUE_TYPE_MASK;
+        uint16_t section = parameterTable[i].type & SECTION_MASK;
+        EXPECT_TRUE(type != 0 && (type & (type - 1)) == 0) << parameterTable[i].name;
+        EXPECT_TRUE(section != 0 && (section & (section - 1)) == 0) << parameterTable[i].name;
+        EXPECT_LE(parameterTable[i].min, parameterTable[i].max) << parameterTable[i].name;
+    }
+}
+
+TEST(ParametersTest, MasterValueIsSetAndGet)
+{
+    // given
+    memset(&masterConfig, 0, sizeof(masterConfig));
+    const parameter_t *parameter = parameterFind("looptime", 8);
+    int_float_value_t value;
+    value.int_value = 3500;
+
+    // when
+    parameterSetValue(parameter, value);
+
+    // then
+    EXPECT_EQ(3500, masterConfig.looptime);
+    EXPECT_EQ(3500, parameterGetValue(parameter).int_value);
+}
+
+TEST(ParametersTest, ProfileValueUsesCurrentProfile)
+{
+    // given
+    memset(&masterConfig, 0, sizeof(masterConfig));
+    masterConfig.current_profile_index = 2;
+    const parameter_t *parameter = parameterFind("p_roll", 6);
+    int_float_value_t value;
+    value.int_value = 45;
+
+    // when
+    parameterSetValue(parameter, value);
+
+    // then
+    EXPECT_EQ(0, masterConfig.profile[0].pidProfile.P8[ROLL]);
+    EXPECT_EQ(45, masterConfig.profile[2].pidProfile.P8[ROLL]);
+}
+
+TEST(ParametersTest, ControlRateValueUsesCurrentControlRateProfile)
+{
+    // given
+    memset(&masterConfig, 0, sizeof(masterConfig));
+    currentControlRateProfileIndex = 1;
+    const parameter_t *parameter = parameterFind("rc_expo", 7);
+    int_float_value_t value;
+    value.int_value = 65;
+
+    // when
+    parameterSetValue(parameter, value);
+
+    // then
+    EXPECT_EQ(0, masterConfig.controlRateProfiles[0].rcExpo8);
+    EXPECT_EQ(65, masterConfig.controlRateProfiles[1].rcExpo8);
+}
+
+TEST(ParametersTest, SignedAndFloatValues)
+{
+    // given
+    memset(&masterConfig, 0, sizeof(masterConfig));
+    const parameter_t *yawDirection = parameterFind("yaw_direction", 13);
+    const parameter_t *levelAngle = parameterFind("level_angle", 11);
+    int_float_value_t value;
+
+    // when
+    value.int_value = -1;
+    parameterSetValue(yawDirection, value);
+    value.float_value = 5.5f;
+    parameterSetValue(levelAngle, value);
+
+    // then
+    EXPECT_EQ(-1, masterConfig.mixerConfig.yaw_direction);
+    EXPECT_EQ(-1, parameterGetValue(yawDirection).int_value);
+    EXPECT_FLOAT_EQ(5.5f, masterConfig.profile[0].pidProfile.A_level);
+    EXPECT_FLOAT_EQ(5.5f, parameterGetValue(levelAngle).float_value);
+}
+
+TEST(ParametersTest, RangeCheck)
+{
+    // given
+    const parameter_t *yawDirection = parameterFind("yaw_direction", 13);
+    const parameter_t *levelAngle = parameterFind("level_angle", 11);
+    int_float_value_t value;
+
+    // expect
+    value.int_value = -1;
+    EXPECT_TRUE(parameterIsValueInRange(yawDirection, value));
+    value.int_value = 2;
+    EXPECT_FALSE(parameterIsValueInRange(yawDirection, value));
+    value.float_value = 10.0f;
+    EXPECT_TRUE(parameterIsValueInRange(levelAngle, value));
+    value.float_value = 10.5f;
+    EXPECT_FALSE(parameterIsValueInRange(levelAngle, value));
+}
+
+TEST(ParametersTest, EveryParameterIsFound)
+{
+    // expect
+    for (uint16_t i = 0; i < parameterCount; i++) {
+        const char *name = parameterTable[i].name;
+        EXPECT_EQ(&parameterTable[i], parameterFind(name, strlen(name))) << name;
+    }
+}
+
+// STUBS
+
+extern "C" {
+
+master_t masterConfig;
+
+uint8_t getCurrentControlRateProfile(void)
+{
+    return currentControlRateProfileIndex;
+}
+
+}
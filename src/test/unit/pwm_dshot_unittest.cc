@@ -0,0 +1,138 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "drivers/pwm_mapping.h"
+    #include "drivers/pwm_dshot.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define BURST_CHANNELS 4
+
+TEST(DshotTest, TestEncodeFrame)
+{
+    // expect
+    EXPECT_EQ(0x82C6, dshotEncodeFrame(1046, false));
+    EXPECT_EQ(0x0606, dshotEncodeFrame(DSHOT_MIN_THROTTLE, false));
+    EXPECT_EQ(0xFFFF, dshotEncodeFrame(DSHOT_MAX_THROTTLE, true));
+    EXPECT_EQ(0x0000, dshotEncodeFrame(DSHOT_MOTOR_STOP, false));
+}
+
+TEST(DshotTest, TestChecksumCoversEveryValue)
+{
+    for (uint16_t throttle = 0; throttle <= DSHOT_MAX_THROTTLE; throttle++) {
+        for (int telemetry = 0; telemetry < 2; telemetry++) {
+            // when
+            uint16_t frame = dshotEncodeFrame(throttle, telemetry);
+
+            // then
+            EXPECT_EQ(throttle, frame >> 5);
+            EXPECT_EQ(telemetry, (frame >> 4) & 1);
+
+            // and the four nibbles xor to zero, which is how the ESC validates the frame
+            EXPECT_EQ(0, (frame ^ (frame >> 4) ^ (frame >> 8) ^ (frame >> 12)) & 0x0F);
+        }
+    }
+}
+
+TEST(DshotTest, TestSingleBitErrorsAreDetected)
+{
+    // given
+    uint16_t frame = dshotEncodeFrame(1234, false);
+
+    for (int bit = 0; bit < DSHOT_FRAME_BITS; bit++) {
+        // when
+        uint16_t corrupted = frame ^ (1 << bit);
+
+        // then
+        EXPECT_NE(0, (corrupted ^ (corrupted >> 4) ^ (corrupted >> 8) ^ (corrupted >> 12)) & 0x0F);
+    }
+}
+
+TEST(DshotTest, TestConvertFromPulse)
+{
+    // expect
+    EXPECT_EQ(DSHOT_MOTOR_STOP, dshotConvertFromPulse(0));
+    EXPECT_EQ(DSHOT_MOTOR_STOP, dshotConvertFromPulse(999));
+    EXPECT_EQ(DSHOT_MOTOR_STOP, dshotConvertFromPulse(PULSE_1MS));
+    EXPECT_EQ(DSHOT_MIN_THROTTLE + 1, dshotConvertFromPulse(1001));
+    EXPECT_EQ(1047, dshotConvertFromPulse(1500));
+    EXPECT_EQ(DSHOT_MAX_THROTTLE, dshotConvertFromPulse(2000));
+    EXPECT_EQ(DSHOT_MAX_THROTTLE, dshotConvertFromPulse(2100));
+}
+
+TEST(DshotTest, TestConvertFromPulseIsMonotonic)
+{
+    uint16_t previous = dshotConvertFromPulse(PULSE_1MS);
+
+    for (uint16_t pulse = PULSE_1MS + 1; pulse <= 2 * PULSE_1MS; pulse++) {
+        uint16_t throttle = dshotConvertFromPulse(pulse);
+
+        EXPECT_GT(throttle, previous);
+        EXPECT_GE(throttle, DSHOT_MIN_THROTTLE);
+        previous = throttle;
+    }
+}
+
+TEST(DshotTest, TestLoadFrameIntoBurstBuffer)
+{
+    // given
+    uint16_t bitBuffer[DSHOT_BIT_SLOTS * BURST_CHANNELS];
+    memset(bitBuffer, 0xAA, sizeof(bitBuffer));
+
+    // and
+    uint16_t frame = dshotEncodeFrame(1046, false);
+
+    // when
+    dshotLoadFrame(&bitBuffer[2], BURST_CHANNELS, frame);
+
+    // then
+    for (int bitIndex = 0; bitIndex < DSHOT_FRAME_BITS; bitIndex++) {
+        bool bit = frame & (0x8000 >> bitIndex);
+        EXPECT_EQ(bit ? DSHOT_BIT_COMPARE_1 : DSHOT_BIT_COMPARE_0, bitBuffer[bitIndex * BURST_CHANNELS + 2]);
+    }
+
+    // and the line is held low after the frame
+    for (int bitIndex = DSHOT_FRAME_BITS; bitIndex < DSHOT_BIT_SLOTS; bitIndex++) {
+        EXPECT_EQ(0, bitBuffer[bitIndex * BURST_CHANNELS + 2]);
+    }
+
+    // and the compare values of the other channels on the timer are untouched
+    for (int bitIndex = 0; bitIndex < DSHOT_BIT_SLOTS; bitIndex++) {
+        for (int channel = 0; channel < BURST_CHANNELS; channel++) {
+            if (channel != 2) {
+                EXPECT_EQ(0xAAAA, bitBuffer[bitIndex * BURST_CHANNELS + channel]);
+            }
+        }
+    }
+}
+
+TEST(DshotTest, TestBitTiming)
+{
+    // expect a 600kbit/s bit rate
+    EXPECT_EQ(600, DSHOT_TIMER_MHZ * 1000 / DSHOT_BIT_PERIOD);
+
+    // and pulses of 3/4 and 3/8 of the bit period
+    EXPECT_EQ(DSHOT_BIT_PERIOD * 3 / 4, DSHOT_BIT_COMPARE_1);
+    EXPECT_EQ(DSHOT_BIT_PERIOD * 3 / 8, DSHOT_BIT_COMPARE_0);
+}
@@ -0,0 +1,247 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "rx/rx.h"
+    #include "io/rc_controls.h"
+    #include "io/rc_interpolation.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOPTIME_US 1000
+#define LOOPS_PER_FRAME 18              // 18ms PPM frames at a 1kHz loop
+
+static rxConfig_t rxConfig;
+static uint32_t loopTime;
+
+static void resetInterpolation(rcInterpolationMode_e mode)
+{
+    memset(&rxConfig, 0, sizeof(rxConfig));
+    rxConfig.rc_interpolation = mode;
+    rxConfig.rc_interpolation_hz = 20;
+    useRcInterpolationConfig(&rxConfig);
+
+    // a frame after a long gap is applied directly, this also clears the state left by the previous test
+    loopTime += 1000000;
+}
+
+// one control loop, annexCode() has just set rcCommand from the last frame
+static void runLoop(const int16_t *command, bool newFrame)
+{
+    memcpy(rcCommand, command, sizeof(rcCommand));
+    interpolateRcCommand(newFrame, loopTime);
+    loopTime += LOOPTIME_US;
+}
+
+static void runFrame(const int16_t *command, uint8_t loops)
+{
+    uint8_t loop;
+
+    for (loop = 0; loop < loops; loop++) {
+        runLoop(command, loop == 0);
+    }
+}
+
+TEST(RcInterpolationTest, OffPassesCommandsThrough)
+{
+    // given
+    int16_t command[4] = { 100, -200, 50, 1500 };
+
+    resetInterpolation(RC_INTERPOLATION_OFF);
+    runFrame(command, LOOPS_PER_FRAME);
+    runFrame(command, LOOPS_PER_FRAME);
+
+    // when
+    command[ROLL] = 400;
+    runLoop(command, true);
+
+    // then
+    EXPECT_EQ(400, rcCommand[ROLL]);
+    EXPECT_EQ(-200, rcCommand[PITCH]);
+    EXPECT_EQ(1500, rcCommand[THROTTLE]);
+}
+
+TEST(RcInterpolationTest, LinearRampsStepOverOneFrameInterval)
+{
+    // given
+    int16_t command[4] = { 0, 0, 0, 1100 };
+    int16_t start[4];
+    int16_t expected;
+    uint8_t loop;
+    uint8_t axis;
+
+    resetInterpolation(RC_INTERPOLATION_LINEAR);
+    runFrame(command, LOOPS_PER_FRAME);
+    runFrame(command, LOOPS_PER_FRAME);
+    EXPECT_EQ(0, rcCommand[ROLL]);
+
+    // when
+    command[ROLL] = 450;
+    command[PITCH] = -300;
+    command[THROTTLE] = 1700;
+    memcpy(start, rcCommand, sizeof(start));
+
+    for (loop = 0; loop < LOOPS_PER_FRAME; loop++) {
+        runLoop(command, loop == 0);
+
+        // then
+        // a straight line from the last output to the new command
+        for (axis = 0; axis < 4; axis++) {
+            expected = start[axis] + (command[axis] - start[axis]) * (loop + 1) / LOOPS_PER_FRAME;
+            EXPECT_LE(abs(rcCommand[axis] - expected), 1);
+        }
+    }
+
+    // and
+    EXPECT_EQ(450, rcCommand[ROLL]);
+    EXPECT_EQ(-300, rcCommand[PITCH]);
+    EXPECT_EQ(1700, rcCommand[THROTTLE]);
+
+    runLoop(command, false);
+    EXPECT_EQ(450, rcCommand[ROLL]);
+}
+
+TEST(RcInterpolationTest, LinearIsContinuousWithJitteringFrames)
+{
+    // given
+    int16_t command[4] = { 0, 0, 0, 1000 };
+    int16_t previous;
+    int16_t maxChange = 0;
+    uint8_t loopsInFrame[] = { 17, 19, 18, 16, 20, 18 };
+    uint16_t frame;
+    uint8_t loop;
+    uint8_t loops;
+
+    resetInterpolation(RC_INTERPOLATION_LINEAR);
+    runFrame(command, LOOPS_PER_FRAME);
+    previous = rcCommand[ROLL];
+
+    // when
+    srand(42);
+    for (frame = 0; frame < 500; frame++) {
+        // square wave with a random amplitude, frames arrive early and late
+        command[ROLL] = (frame & 1) ? rand() % 500 : -(rand() % 500);
+        loops = loopsInFrame[frame % sizeof(loopsInFrame)];
+
+        for (loop = 0; loop < loops; loop++) {
+            runLoop(command, loop == 0);
+
+            maxChange = MAX(maxChange, abs(rcCommand[ROLL] - previous));
+            previous = rcCommand[ROLL];
+        }
+    }
+
+    // then
+    // a full 1000 step spread over the shortest frame, plus rounding and a frame that comes before the ramp ended
+    EXPECT_LE(maxChange, 1000 / 16 + 2);
+}
+
+TEST(RcInterpolationTest, LinearPassesChangesBetweenFramesThrough)
+{
+    // given
+    int16_t command[4] = { 0, 0, 0, 1000 };
+    uint8_t loop;
+
+    resetInterpolation(RC_INTERPOLATION_LINEAR);
+    runFrame(command, LOOPS_PER_FRAME);
+    runFrame(command, LOOPS_PER_FRAME);
+
+    // when
+    // e.g. headfree mode rotates the sticks as the heading changes, without a new frame
+    for (loop = 0; loop < LOOPS_PER_FRAME; loop++) {
+        command[PITCH] = loop * 5;
+        runLoop(command, false);
+
+        // then
+        EXPECT_EQ(loop * 5, rcCommand[PITCH]);
+    }
+}
+
+TEST(RcInterpolationTest, FrameAfterLongGapIsAppliedDirectly)
+{
+    // given
+    int16_t command[4] = { 0, 0, 0, 1000 };
+
+    resetInterpolation(RC_INTERPOLATION_LINEAR);
+    runFrame(command, LOOPS_PER_FRAME);
+    runFrame(command, LOOPS_PER_FRAME);
+
+    // when
+    runFrame(command, (RC_INTERPOLATION_MAX_FRAME_INTERVAL_US / LOOPTIME_US) + 10);
+    command[ROLL] = 300;
+    runLoop(command, true);
+
+    // then
+    EXPECT_EQ(300, rcCommand[ROLL]);
+}
+
+TEST(RcInterpolationTest, LowpassStepResponse)
+{
+    // given
+    int16_t command[4] = { 0, 0, 0, 1000 };
+    int16_t previous;
+    int16_t maxChange = 0;
+    uint16_t loop;
+    uint16_t loopsToHalf = 0;
+
+    resetInterpolation(RC_INTERPOLATION_LOWPASS);
+    runFrame(command, LOOPS_PER_FRAME);
+    runFrame(command, LOOPS_PER_FRAME);
+    previous = rcCommand[ROLL];
+
+    // when
+    command[ROLL] = 500;
+    for (loop = 0; loop < 20 * LOOPS_PER_FRAME; loop++) {
+        runLoop(command, loop % LOOPS_PER_FRAME == 0);
+
+        // then
+        EXPECT_GE(rcCommand[ROLL], previous);
+        maxChange = MAX(maxChange, rcCommand[ROLL] - previous);
+        previous = rcCommand[ROLL];
+
+        if (!loopsToHalf && rcCommand[ROLL] >= 250) {
+            loopsToHalf = loop + 1;
+        }
+    }
+
+    // 20Hz at 1kHz, a gain of about 0.11 per loop and a time constant of 8ms
+    EXPECT_LE(maxChange, 60);
+    EXPECT_GE(loopsToHalf, 5);
+    EXPECT_LE(loopsToHalf, 7);
+
+    // and
+    EXPECT_EQ(500, rcCommand[ROLL]);
+    EXPECT_EQ(1000, rcCommand[THROTTLE]);
+}
+
+// STUBS
+
+extern "C" {
+int16_t rcCommand[4];
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "rx/rx.h"
+    #include "rx/rx_filter.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * The filter keeps its state per channel, every test uses a channel of its own.
+ */
+
+#define STEADY 1500
+#define GLITCH 1950
+
+static void fill(uint8_t channel, uint16_t value, bool useMedian)
+{
+    uint8_t i;
+
+    for (i = 0; i < RX_FILTER_SAMPLE_COUNT; i++) {
+        rxFilterApply(channel, value, useMedian);
+    }
+}
+
+TEST(RxFilterTest, FirstSamplesPassThrough)
+{
+    // when
+    uint16_t first = rxFilterApply(0, 1200, false);
+    uint16_t second = rxFilterApply(0, 1300, false);
+
+    // then
+    EXPECT_EQ(1200, first);
+    EXPECT_EQ(1300, second);
+}
+
+TEST(RxFilterTest, RunningMeanMatchesFullSum)
+{
+    // given
+    uint16_t history[RX_FILTER_SAMPLE_COUNT] = { 0 };
+    uint32_t sum;
+    uint16_t sample;
+    uint16_t filtered;
+    uint32_t i;
+    uint8_t j;
+
+    srand(1);
+
+    for (i = 0; i < 10000; i++) {
+        // when
+        sample = 1000 + rand() % 1001;
+        filtered = rxFilterApply(1, sample, false);
+
+        // then
+        memmove(history, history + 1, sizeof(history) - sizeof(history[0]));
+        history[RX_FILTER_SAMPLE_COUNT - 1] = sample;
+
+        if (i >= RX_FILTER_SAMPLE_COUNT - 1) {
+            sum = 0;
+            for (j = 0; j < RX_FILTER_SAMPLE_COUNT; j++) {
+                sum += history[j];
+            }
+            EXPECT_EQ(sum / RX_FILTER_SAMPLE_COUNT, filtered);
+        }
+    }
+}
+
+TEST(RxFilterTest, SingleGlitchBleedsIntoMean)
+{
+    // given
+    uint16_t maxError;
+    uint16_t filtered;
+    uint8_t i;
+
+    fill(2, STEADY, false);
+
+    // when
+    maxError = rxFilterApply(2, GLITCH, false) - STEADY;
+    for (i = 0; i < RX_FILTER_SAMPLE_COUNT - 1; i++) {
+        filtered = rxFilterApply(2, STEADY, false);
+        maxError = MAX(maxError, filtered - STEADY);
+    }
+
+    // then
+    EXPECT_EQ((GLITCH - STEADY) / RX_FILTER_SAMPLE_COUNT, maxError);
+    EXPECT_EQ(STEADY, rxFilterApply(2, STEADY, false));
+}
+
+TEST(RxFilterTest, MedianRejectsSingleGlitches)
+{
+    // given
+    uint16_t pattern[] = { STEADY, GLITCH, STEADY, STEADY, 1000, STEADY, GLITCH, STEADY, 1000, STEADY };
+    uint8_t i;
+
+    fill(3, STEADY, true);
+
+    // when
+    for (i = 0; i < ARRAYLEN(pattern); i++) {
+        // then
+        EXPECT_EQ(STEADY, rxFilterApply(3, pattern[i], true));
+    }
+}
+
+TEST(RxFilterTest, MedianFollowsStepWithOneSampleDelay)
+{
+    // given
+    fill(4, 1100, true);
+
+    // when
+    uint16_t first = rxFilterApply(4, 1900, true);
+    uint16_t second = rxFilterApply(4, 1900, true);
+
+    // then
+    EXPECT_EQ(1100, first);
+    EXPECT_EQ(1900, second);
+}
+
+TEST(RxFilterTest, MedianPassesTwoSampleGlitch)
+{
+    // given
+    // a glitch as long as the window is half the window, it is no longer an outlier
+    fill(5, STEADY, true);
+
+    // when
+    uint16_t first = rxFilterApply(5, GLITCH, true);
+    uint16_t second = rxFilterApply(5, GLITCH, true);
+    uint16_t third = rxFilterApply(5, STEADY, true);
+    uint16_t fourth = rxFilterApply(5, STEADY, true);
+
+    // then
+    EXPECT_EQ(STEADY, first);
+    EXPECT_EQ(GLITCH, second);
+    EXPECT_EQ(GLITCH, third);
+    EXPECT_EQ(STEADY, fourth);
+}
+
+TEST(RxFilterTest, ModeCanChangeWithoutLosingHistory)
+{
+    // given
+    fill(6, STEADY, false);
+
+    // when
+    rxFilterApply(6, GLITCH, true);
+    uint16_t median = rxFilterApply(6, STEADY, true);
+    uint16_t mean = rxFilterApply(6, STEADY, false);
+
+    // then
+    EXPECT_EQ(STEADY, median);
+    EXPECT_EQ(STEADY + (GLITCH - STEADY) / RX_FILTER_SAMPLE_COUNT, mean);
+}
@@ -0,0 +1,542 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "build_config.h"
+
+    #include "common/crc.h"
+    #include "common/utils.h"
+
+    #include "drivers/serial.h"
+    #include "io/serial.h"
+
+    #include "rx/rx.h"
+    #include "rx/rx_frame.h"
+    #include "rx/sbus.h"
+    #include "rx/spektrum.h"
+    #include "rx/sumd.h"
+    #include "rx/sumh.h"
+    #include "rx/xbus.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * Fuzz harness for the serial receiver framing.
+ *
+ * Each protocol has a generator that builds a valid frame from random channel values together with the values the
+ * driver must report for it. The frames are fed byte by byte into the receive callback the driver registered, with
+ * the timing of the real link, then corrupted, truncated and mixed with garbage.
+ */
+
+#define MAX_TEST_CHANNELS 18
+#define FRAME_GAP_US 10000                  // longer than the frame gap of every protocol
+
+static uint32_t testMicros;
+static serialReceiveCallbackPtr rxCallback;
+static uint32_t framesCompleted;
+
+static uint32_t randomSeed;
+
+static uint32_t nextRandom(void)
+{
+    randomSeed = randomSeed * 1103515245 + 12345;
+    return randomSeed >> 16;
+}
+
+typedef struct testFrame_s {
+    uint8_t data[RX_FRAME_MAX_SIZE];
+    uint8_t length;
+    uint16_t expected[MAX_TEST_CHANNELS];
+    uint8_t channelCount;                   // channels carried by the frame
+} testFrame_t;
+
+static uint8_t testCrc8Dallas(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static void appendCrc16(testFrame_t *frame)
+{
+    uint16_t crc = crc16CcittUpdate(0, frame->data, frame->length);
+    frame->data[frame->length++] = crc >> 8;
+    frame->data[frame->length++] = crc & 0xFF;
+}
+
+static void buildSbusFrame(testFrame_t *frame)
+{
+    memset(frame->data, 0, sizeof(frame->data));
+    frame->data[0] = 0x0F;
+
+    for (uint8_t channel = 0; channel < 16; channel++) {
+        uint16_t value = 173 + nextRandom() % (1812 - 173 + 1);
+        for (uint8_t bit = 0; bit < 11; bit++) {
+            uint16_t position = channel * 11 + bit;
+            if (value & (1 << bit)) {
+                frame->data[1 + position / 8] |= 1 << (position % 8);
+            }
+        }
+        frame->expected[channel] = (0.625f * value) + 880;
+    }
+
+    uint8_t flags = nextRandom() & 0x03;
+    frame->data[23] = flags;
+    frame->expected[16] = (0.625f * ((flags & 0x01) ? 1812 : 173)) + 880;
+    frame->expected[17] = (0.625f * ((flags & 0x02) ? 1812 : 173)) + 880;
+    frame->data[24] = 0x00;
+
+    frame->length = 25;
+    frame->channelCount = 18;
+}
+
+static void buildSpektrumFrame(testFrame_t *frame)
+{
+    frame->data[0] = nextRandom();          // fades
+    frame->data[1] = nextRandom();          // system
+
+    for (uint8_t channel = 0; channel < 7; channel++) {
+        uint16_t value = nextRandom() & 0x07FF;
+        uint16_t word = (channel << 11) | value;
+        frame->data[2 + channel * 2] = word >> 8;
+        frame->data[3 + channel * 2] = word & 0xFF;
+        frame->expected[channel] = 988 + (value >> 1);
+    }
+
+    frame->length = 16;
+    frame->channelCount = 7;
+}
+
+static void buildSumdFrame(testFrame_t *frame)
+{
+    uint8_t channelCount = 1 + nextRandom() % 16;
+
+    frame->data[0] = 0xA8;
+    frame->data[1] = 0x01;
+    frame->data[2] = channelCount;
+
+    for (uint8_t channel = 0; channel < channelCount; channel++) {
+        uint16_t value = (1000 + nextRandom() % 1001) * 8 + nextRandom() % 8;
+        frame->data[3 + channel * 2] = value >> 8;
+        frame->data[4 + channel * 2] = value & 0xFF;
+        frame->expected[channel] = value / 8;
+    }
+
+    frame->length = 3 + channelCount * 2;
+    appendCrc16(frame);
+    frame->channelCount = channelCount;
+}
+
+static void buildSumhFrame(testFrame_t *frame)
+{
+    frame->data[0] = 0xA8;
+    frame->data[1] = nextRandom();
+    frame->data[2] = nextRandom();
+
+    for (uint8_t channel = 0; channel < 8; channel++) {
+        uint16_t value = 8800 + nextRandom() % 6400;
+        frame->data[3 + channel * 2] = value >> 8;
+        frame->data[4 + channel * 2] = value & 0xFF;
+        frame->expected[channel] = (uint32_t)(value / 6.4 - 375);
+    }
+
+    frame->data[19] = 0;
+    frame->data[20] = nextRandom();
+
+    frame->length = 21;
+    frame->channelCount = 8;
+}
+
+static void buildXBusModeBFrame(uint8_t *data, uint16_t *expected)
+{
+    testFrame_t modeB;
+
+    modeB.data[0] = 0xA1;
+    for (uint8_t channel = 0; channel < 12; channel++) {
+        uint16_t value = nextRandom() & 0xFFFF;
+        modeB.data[1 + channel * 2] = value >> 8;
+        modeB.data[2 + channel * 2] = value & 0xFF;
+        expected[channel] = 800 + ((value * 1400) >> 12);
+    }
+    modeB.length = 25;
+    appendCrc16(&modeB);
+
+    memcpy(data, modeB.data, modeB.length);
+}
+
+static void buildXBusFrame(testFrame_t *frame)
+{
+    buildXBusModeBFrame(frame->data, frame->expected);
+
+    frame->length = 27;
+    frame->channelCount = 12;
+}
+
+static void buildXBusRJ01Frame(testFrame_t *frame)
+{
+    frame->data[0] = 0xA1;
+    frame->data[1] = 30;
+    frame->data[2] = nextRandom();
+    buildXBusModeBFrame(&frame->data[3], frame->expected);
+    frame->data[30] = nextRandom();
+    frame->data[31] = nextRandom();
+    frame->data[32] = testCrc8Dallas(frame->data, 32);
+
+    frame->length = 33;
+    frame->channelCount = 12;
+}
+
+typedef bool (*rxInitFnPtr)(rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, rcReadRawDataPtr *callback);
+
+typedef struct protocolUnderTest_s {
+    const char *name;
+    uint8_t provider;
+    rxInitFnPtr init;
+    void (*build)(testFrame_t *frame);
+    uint16_t byteUs;
+    bool checked;                           // frames carry a CRC, any corruption must be rejected
+    bool synced;                            // frames start with a sync byte
+} protocolUnderTest_t;
+
+static const protocolUnderTest_t protocols[] = {
+    { "SBUS",         SERIALRX_SBUS,             sbusInit,     buildSbusFrame,     120, false, true },
+    { "SPEKTRUM2048", SERIALRX_SPEKTRUM2048,     spektrumInit, buildSpektrumFrame,  87, false, false },
+    { "SUMD",         SERIALRX_SUMD,             sumdInit,     buildSumdFrame,      87, true,  true },
+    { "SUMH",         SERIALRX_SUMH,             sumhInit,     buildSumhFrame,      87, false, true },
+    { "XBUS_MODE_B",  SERIALRX_XBUS_MODE_B,      xBusInit,     buildXBusFrame,      87, true,  true },
+    { "XBUS_RJ01",    SERIALRX_XBUS_MODE_B_RJ01, xBusInit,     buildXBusRJ01Frame,  40, true,  true },
+};
+
+static rxRuntimeConfig_t testRxRuntimeConfig;
+static rcReadRawDataPtr readRawRC;
+
+static void initProtocol(const protocolUnderTest_t *protocol)
+{
+    rxConfig_t rxConfig;
+
+    memset(&rxConfig, 0, sizeof(rxConfig));
+    rxConfig.serialrx_provider = protocol->provider;
+    rxConfig.midrc = 1500;
+
+    rxCallback = NULL;
+    readRawRC = NULL;
+    EXPECT_TRUE(protocol->init(&rxConfig, &testRxRuntimeConfig, &readRawRC));
+    EXPECT_TRUE(rxCallback != NULL);
+    EXPECT_TRUE(readRawRC != NULL);
+
+    testMicros += FRAME_GAP_US;
+    framesCompleted = 0;
+}
+
+static void feedBytes(const protocolUnderTest_t *protocol, const uint8_t *data, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; i++) {
+        testMicros += protocol->byteUs;
+        rxCallback(data[i]);
+    }
+}
+
+static void waitUs(uint32_t us)
+{
+    testMicros += us;
+}
+
+static bool channelsMatch(const testFrame_t *frame)
+{
+    for (uint8_t channel = 0; channel < frame->channelCount; channel++) {
+        if (readRawRC(&testRxRuntimeConfig, channel) != frame->expected[channel]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(RxFrameTest, ValidFramesAreDecoded)
+{
+    for (uint8_t p = 0; p < ARRAYLEN(protocols); p++) {
+        const protocolUnderTest_t *protocol = &protocols[p];
+        SCOPED_TRACE(protocol->name);
+        testFrame_t frame;
+
+        // given
+        randomSeed = p;
+        initProtocol(protocol);
+
+        for (int i = 0; i < 100; i++) {
+            protocol->build(&frame);
+
+            // when
+            waitUs(FRAME_GAP_US);
+            feedBytes(protocol, frame.data, frame.length);
+
+            // then
+            EXPECT_EQ((uint32_t)i + 1, framesCompleted);
+            EXPECT_TRUE(rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE);
+            EXPECT_TRUE(channelsMatch(&frame));
+
+            // and the frame is only reported once
+            EXPECT_EQ(SERIAL_RX_FRAME_PENDING, rxFrameStatus());
+        }
+    }
+}
+
+TEST(RxFrameTest, SingleBitErrorsAreRejected)
+{
+    for (uint8_t p = 0; p < ARRAYLEN(protocols); p++) {
+        const protocolUnderTest_t *protocol = &protocols[p];
+        if (!protocol->checked) {
+            continue;
+        }
+        SCOPED_TRACE(protocol->name);
+        testFrame_t frame;
+        testFrame_t corrupted;
+
+        // given
+        randomSeed = p;
+        initProtocol(protocol);
+        protocol->build(&frame);
+
+        for (uint16_t bit = 0; bit < frame.length * 8; bit++) {
+            corrupted = frame;
+            corrupted.data[bit / 8] ^= 1 << (bit % 8);
+
+            // when
+            waitUs(FRAME_GAP_US);
+            feedBytes(protocol, corrupted.data, corrupted.length);
+
+            // then
+            EXPECT_EQ(0u, framesCompleted);
+            EXPECT_EQ(SERIAL_RX_FRAME_PENDING, rxFrameStatus());
+        }
+
+        // and an intact frame still gets through
+        waitUs(FRAME_GAP_US);
+        feedBytes(protocol, frame.data, frame.length);
+        EXPECT_TRUE(rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE);
+        EXPECT_TRUE(channelsMatch(&frame));
+    }
+}
+
+TEST(RxFrameTest, FramingErrorsAreRejected)
+{
+    for (uint8_t p = 0; p < ARRAYLEN(protocols); p++) {
+        const protocolUnderTest_t *protocol = &protocols[p];
+        if (!protocol->synced) {
+            continue;
+        }
+        SCOPED_TRACE(protocol->name);
+        testFrame_t frame;
+
+        // given
+        randomSeed = p;
+        initProtocol(protocol);
+        protocol->build(&frame);
+
+        // when the sync byte is wrong
+        frame.data[0] ^= 0x01;
+        waitUs(FRAME_GAP_US);
+        feedBytes(protocol, frame.data, frame.length);
+        frame.data[0] ^= 0x01;
+
+        // then
+        EXPECT_EQ(SERIAL_RX_FRAME_PENDING, rxFrameStatus());
+
+        // when a valid frame follows after a pause
+        waitUs(FRAME_GAP_US);
+        feedBytes(protocol, frame.data, frame.length);
+
+        // then it is accepted
+        EXPECT_EQ(1u, framesCompleted);
+        EXPECT_TRUE(rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE);
+        EXPECT_TRUE(channelsMatch(&frame));
+    }
+}
+
+TEST(RxFrameTest, TruncatedFramesAreRejected)
+{
+    for (uint8_t p = 0; p < ARRAYLEN(protocols); p++) {
+        const protocolUnderTest_t *protocol = &protocols[p];
+        SCOPED_TRACE(protocol->name);
+        testFrame_t frame;
+
+        // given
+        randomSeed = p;
+        initProtocol(protocol);
+
+        for (uint8_t length = 1; length < RX_FRAME_MAX_SIZE; length++) {
+            protocol->build(&frame);
+            if (length >= frame.length) {
+                continue;
+            }
+
+            // when
+            waitUs(FRAME_GAP_US);
+            feedBytes(protocol, frame.data, length);
+
+            // then
+            EXPECT_EQ(0u, framesCompleted);
+            EXPECT_EQ(SERIAL_RX_FRAME_PENDING, rxFrameStatus());
+        }
+
+        // and the next complete frame is accepted
+        protocol->build(&frame);
+        waitUs(FRAME_GAP_US);
+        feedBytes(protocol, frame.data, frame.length);
+        EXPECT_TRUE(rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE);
+        EXPECT_TRUE(channelsMatch(&frame));
+    }
+}
+
+typedef enum {
+    SLOT_VALID_FRAME = 0,
+    SLOT_CORRUPTED_FRAME,
+    SLOT_TRUNCATED_FRAME,
+    SLOT_GARBAGE,
+    SLOT_TYPE_COUNT
+} slotType_e;
+
+TEST(RxFrameTest, FuzzedStreamsNeverYieldInvalidFrames)
+{
+    for (uint8_t p = 0; p < ARRAYLEN(protocols); p++) {
+        const protocolUnderTest_t *protocol = &protocols[p];
+        SCOPED_TRACE(protocol->name);
+        testFrame_t frame;
+        uint32_t validFramesAfterGap = 0;
+        uint32_t validFramesAccepted = 0;
+        uint32_t invalidFramesAccepted = 0;
+
+        // given
+        randomSeed = 0xC0FFEE + p;
+        initProtocol(protocol);
+
+        for (int slot = 0; slot < 20000; slot++) {
+            slotType_e type = (slotType_e)(nextRandom() % SLOT_TYPE_COUNT);
+            bool afterGap = nextRandom() & 1;
+
+            protocol->build(&frame);
+
+            // when
+            waitUs(afterGap ? FRAME_GAP_US : protocol->byteUs);
+
+            switch (type) {
+                case SLOT_VALID_FRAME:
+                    feedBytes(protocol, frame.data, frame.length);
+                    break;
+                case SLOT_CORRUPTED_FRAME: {
+                    uint8_t errors = 1 + nextRandom() % 4;
+                    while (errors--) {
+                        frame.data[nextRandom() % frame.length] ^= 1 + nextRandom() % 255;
+                    }
+                    feedBytes(protocol, frame.data, frame.length);
+                    break;
+                }
+                case SLOT_TRUNCATED_FRAME:
+                    feedBytes(protocol, frame.data, nextRandom() % frame.length);
+                    break;
+                case SLOT_GARBAGE: {
+                    uint8_t garbage[64];
+                    uint8_t length = 1 + nextRandom() % sizeof(garbage);
+                    for (uint8_t i = 0; i < length; i++) {
+                        garbage[i] = nextRandom();
+                    }
+                    feedBytes(protocol, garbage, length);
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            // then
+            bool accepted = rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE;
+
+            if (type == SLOT_VALID_FRAME && afterGap) {
+                validFramesAfterGap++;
+            }
+
+            if (!accepted) {
+                continue;
+            }
+
+            if (type == SLOT_VALID_FRAME && channelsMatch(&frame)) {
+                validFramesAccepted++;
+            } else if (type != SLOT_VALID_FRAME) {
+                invalidFramesAccepted++;
+            }
+        }
+
+        // every valid frame that follows a pause is accepted
+        EXPECT_GE(validFramesAccepted, validFramesAfterGap);
+
+        // and nothing else gets through a protocol that is protected by a CRC
+        if (protocol->checked) {
+            EXPECT_EQ(0u, invalidFramesAccepted);
+        }
+    }
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t micros(void)
+{
+    return testMicros;
+}
+
+void rxFrameCompleted(uint32_t completedAt)
+{
+    UNUSED(completedAt);
+    framesCompleted++;
+}
+
+static serialPortConfig_t testPortConfig;
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return &testPortConfig;
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e functionMask, serialReceiveCallbackPtr callback, uint32_t baudRate, portMode_t mode, serialInversion_e inversion)
+{
+    UNUSED(identifier);
+    UNUSED(functionMask);
+    UNUSED(baudRate);
+    UNUSED(mode);
+    UNUSED(inversion);
+
+    static serialPort_t port;
+    rxCallback = callback;
+    return &port;
+}
+
+}
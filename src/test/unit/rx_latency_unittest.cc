@@ -0,0 +1,282 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "build_config.h"
+
+    #include "drivers/serial.h"
+    #include "io/serial.h"
+
+    #include "rx/rx.h"
+    #include "rx/rx_latency.h"
+    #include "rx/rx_frame.h"
+    #include "rx/sbus.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * Feeds SBUS frames byte by byte into the receive callback of the SBUS driver, and runs a model of the main
+ * loop: one periodic task per loop() call when no frame is waiting, and a control iteration every looptime.
+ */
+
+#define SBUS_FRAME_SIZE 25
+#define SBUS_BYTE_US 120                // start, 8 data, even parity and 2 stop bits at 100000 baud
+#define SBUS_FRAME_INTERVAL_US 9000
+
+#define LOOPTIME_US 3500
+#define CONTROL_US 700                  // imu, pid, mixer and motor output
+#define RX_PROCESS_US 60
+#define LOOP_OVERHEAD_US 10
+#define MAX_PERIODIC_TASK_US 1500
+
+#define SIMULATION_US (5 * 1000000)
+
+static uint32_t testMicros;
+static serialReceiveCallbackPtr rxCallback;
+
+typedef struct frameSource_s {
+    uint32_t frameStartAt;
+    uint8_t nextByte;
+    uint32_t lastCompletedAt;           // last byte time of the most recent complete frame
+    uint32_t frameCount;
+} frameSource_t;
+
+static void deliverBytesUntil(frameSource_t *source, uint32_t until)
+{
+    while (true) {
+        uint32_t byteAt = source->frameStartAt + source->nextByte * SBUS_BYTE_US;
+        if ((int32_t)(byteAt - until) > 0) {
+            break;
+        }
+
+        uint8_t c = 0x40 + source->nextByte; // channel data, only the framing matters here
+        if (source->nextByte == 0) {
+            c = 0x0F;
+        } else if (source->nextByte >= SBUS_FRAME_SIZE - 2) {
+            c = 0x00;                   // flags and end byte
+        }
+
+        testMicros = byteAt;            // the interrupt runs as the byte arrives
+        rxCallback(c);
+
+        source->nextByte++;
+        if (source->nextByte == SBUS_FRAME_SIZE) {
+            source->lastCompletedAt = byteAt;
+            source->frameCount++;
+            source->nextByte = 0;
+            source->frameStartAt += SBUS_FRAME_INTERVAL_US;
+        }
+    }
+}
+
+// what updateRx() does for a serial receiver
+static bool pollRx(void)
+{
+    if (rxFrameStatus() & SERIAL_RX_FRAME_COMPLETE) {
+        rxFrameReceived();
+        return true;
+    }
+    return false;
+}
+
+static uint32_t periodicTaskDuration(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) % (MAX_PERIODIC_TASK_US + 1);
+}
+
+typedef struct loopResult_s {
+    uint32_t framesOutput;
+    uint32_t framesOutputLate;          // not used by the first control iteration after they completed
+    uint64_t latencySum;
+} loopResult_t;
+
+static void simulateLoop(bool pollBeforeControl, loopResult_t *result)
+{
+    rxConfig_t rxConfig;
+    rxRuntimeConfig_t rxRuntimeConfig;
+    frameSource_t source;
+    uint32_t seed = 42;
+
+    memset(&rxConfig, 0, sizeof(rxConfig));
+    rxConfig.midrc = 1500;
+    sbusInit(&rxConfig, &rxRuntimeConfig, NULL);
+
+    memset(result, 0, sizeof(*result));
+    memset(&rxLatency, 0, sizeof(rxLatency));
+
+    // continue from the previous simulation so the driver sees a gap between frames
+    uint32_t t = testMicros + 100000;
+    uint32_t end = t + SIMULATION_US;
+
+    memset(&source, 0, sizeof(source));
+    source.frameStartAt = t + 1234;
+    source.lastCompletedAt = t;
+
+    uint32_t loopTime = t;
+    uint32_t lastFrameUsedAt = source.lastCompletedAt;
+
+    while ((int32_t)(end - t) > 0) {
+        deliverBytesUntil(&source, t);
+        if (pollRx()) {
+            t += RX_PROCESS_US;
+        } else {
+            t += periodicTaskDuration(&seed);
+        }
+        t += LOOP_OVERHEAD_US;
+
+        deliverBytesUntil(&source, t);
+        if ((int32_t)(t - loopTime) < 0) {
+            continue;
+        }
+        loopTime = t + LOOPTIME_US;
+
+        if (pollBeforeControl && pollRx()) {
+            t += RX_PROCESS_US;
+        }
+        uint32_t newestFrameAt = source.lastCompletedAt;
+
+        t += CONTROL_US;
+        deliverBytesUntil(&source, t);
+
+        uint16_t previousLast = rxLatency.last;
+        uint16_t previousMax = rxLatency.max;
+        rxFrameOutput(t);
+
+        if (newestFrameAt != lastFrameUsedAt) {
+            // a frame completed before this control iteration started
+            if (t - rxLatency.last == newestFrameAt) {
+                result->framesOutput++;
+                result->latencySum += rxLatency.last;
+                lastFrameUsedAt = newestFrameAt;
+            } else {
+                result->framesOutputLate++;
+                rxLatency.last = previousLast;
+                rxLatency.max = previousMax;
+            }
+        }
+    }
+}
+
+TEST(RxLatencyTest, FramesAreUsedByTheNextControlIteration)
+{
+    // given
+    loopResult_t result;
+
+    // when
+    simulateLoop(true, &result);
+
+    // then every frame goes into the first control iteration that starts after its last byte
+    EXPECT_GT(result.framesOutput, (uint32_t)(SIMULATION_US / SBUS_FRAME_INTERVAL_US) - 2);
+    EXPECT_EQ(0u, result.framesOutputLate);
+
+    // and the latency is bounded by one loop, the longest periodic task and the control iteration itself
+    EXPECT_LE(rxLatency.max, LOOPTIME_US + MAX_PERIODIC_TASK_US + CONTROL_US + 2 * RX_PROCESS_US + LOOP_OVERHEAD_US);
+
+    // and a frame waits less than a loop on average
+    EXPECT_LT(result.latencySum / result.framesOutput, (uint64_t)LOOPTIME_US);
+}
+
+TEST(RxLatencyTest, PollingOnlyAtTheStartOfTheLoopMissesFrames)
+{
+    // given
+    loopResult_t result;
+
+    // when a frame that completes during a periodic task is only seen by the next loop() call
+    simulateLoop(false, &result);
+
+    // then some frames wait for a later control iteration
+    EXPECT_GT(result.framesOutputLate, 0u);
+
+    // and the average latency is higher than when the receiver is polled again before the control iteration
+    loopResult_t pollBeforeControlResult;
+    simulateLoop(true, &pollBeforeControlResult);
+    EXPECT_GT(
+        result.latencySum / result.framesOutput,
+        pollBeforeControlResult.latencySum / pollBeforeControlResult.framesOutput
+    );
+}
+
+TEST(RxLatencyTest, LatencyIsOnlyMeasuredForReceivedFrames)
+{
+    // given
+    memset(&rxLatency, 0, sizeof(rxLatency));
+    rxFrameCompleted(1000);
+    rxFrameReceived();
+
+    // when
+    rxFrameOutput(3500);
+
+    // then
+    EXPECT_EQ(2500, rxLatency.last);
+
+    // when the motors are updated again without a new frame
+    rxFrameOutput(7000);
+
+    // then
+    EXPECT_EQ(2500, rxLatency.last);
+    EXPECT_EQ(2500, rxLatency.max);
+
+    // when a frame completes but is not picked up yet
+    rxFrameCompleted(8000);
+    rxFrameOutput(8500);
+
+    // then
+    EXPECT_EQ(2500, rxLatency.last);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t debug[4];
+
+uint32_t micros(void)
+{
+    return testMicros;
+}
+
+static serialPortConfig_t testPortConfig;
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return &testPortConfig;
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e functionMask, serialReceiveCallbackPtr callback, uint32_t baudRate, portMode_t mode, serialInversion_e inversion)
+{
+    UNUSED(identifier);
+    UNUSED(functionMask);
+    UNUSED(baudRate);
+    UNUSED(mode);
+    UNUSED(inversion);
+
+    static serialPort_t port;
+    rxCallback = callback;
+    return &port;
+}
+
+}
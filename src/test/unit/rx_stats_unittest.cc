@@ -0,0 +1,249 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/utils.h"
+
+    #include "rx/rx.h"
+    #include "rx/rx_stats.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define FRAME_INTERVAL_US 9000
+#define UPDATE_INTERVAL_US 20000            // the receiver task runs at least at 50Hz
+
+static uint32_t testMicros;
+static uint32_t nextUpdateAt;
+
+static void runUntil(uint32_t until)
+{
+    while ((int32_t)(until - nextUpdateAt) >= 0) {
+        rxStatsUpdate(nextUpdateAt);
+        nextUpdateAt += UPDATE_INTERVAL_US;
+    }
+    testMicros = until;
+}
+
+static void receiveFrame(uint32_t completedAt, uint8_t frameStatus)
+{
+    runUntil(completedAt);
+    rxStatsFrameReceived(completedAt, frameStatus);
+}
+
+static void startLink(void)
+{
+    rxStatsReset();
+    testMicros = 1000000;
+    nextUpdateAt = testMicros;
+}
+
+TEST(RxStatsTest, SteadyFramesGiveFullLinkQuality)
+{
+    // given
+    startLink();
+
+    // when
+    for (int i = 0; i < 2 * RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+
+    // then
+    EXPECT_EQ(FRAME_INTERVAL_US, rxStats.frameIntervalUs);
+    EXPECT_EQ(100, rxStats.linkQuality);
+    EXPECT_EQ(0u, rxStats.framesLost);
+    EXPECT_EQ((uint32_t)2 * RX_STATS_LINK_QUALITY_WINDOW, rxStats.framesReceived);
+
+    // and every frame after the first interval was on time
+    EXPECT_EQ(2 * RX_STATS_LINK_QUALITY_WINDOW - 2, rxStats.jitterHistogram[0]);
+}
+
+TEST(RxStatsTest, FramesPerSecondAreCounted)
+{
+    // given
+    startLink();
+    uint32_t end = testMicros + 3000000;
+
+    // when
+    while ((int32_t)(end - testMicros) > 0) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+
+    // then
+    EXPECT_NEAR(1000000 / FRAME_INTERVAL_US, rxStats.framesPerSecond, 3);
+    EXPECT_EQ(0, rxStats.lostFramePercent);
+}
+
+TEST(RxStatsTest, GapsCountAsLostFrames)
+{
+    // given
+    startLink();
+    for (int i = 0; i < RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+
+    // when every tenth frame is lost
+    uint32_t frameAt = testMicros;
+    for (int i = 0; i < 10 * RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        frameAt += FRAME_INTERVAL_US;
+        if (i % 10 != 9) {
+            receiveFrame(frameAt, SERIAL_RX_FRAME_COMPLETE);
+        }
+    }
+    receiveFrame(frameAt + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+
+    // then
+    EXPECT_EQ((uint32_t)RX_STATS_LINK_QUALITY_WINDOW, rxStats.framesLost);
+    EXPECT_NEAR(90, rxStats.linkQuality, 1);
+    EXPECT_EQ(FRAME_INTERVAL_US, rxStats.frameIntervalUs);
+
+    // and a lost frame is not mistaken for jitter
+    EXPECT_EQ(10 * RX_STATS_LINK_QUALITY_WINDOW - 1, rxStats.jitterHistogram[0]);
+}
+
+TEST(RxStatsTest, UpdateOlderThanTheLastFrameIsIgnored)
+{
+    // given
+    startLink();
+    for (int i = 0; i < RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+    uint32_t framesPerSecond = rxStats.framesPerSecond;
+
+    // when the time was read before the last frame completed
+    rxStatsUpdate(testMicros - 100);
+    receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+
+    // then
+    EXPECT_EQ(0u, rxStats.framesLost);
+    EXPECT_EQ(100, rxStats.linkQuality);
+    EXPECT_EQ(framesPerSecond, rxStats.framesPerSecond);
+}
+
+TEST(RxStatsTest, LinkQualityFallsWhenNoFramesArrive)
+{
+    // given
+    startLink();
+    for (int i = 0; i < RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+    EXPECT_EQ(100, rxStats.linkQuality);
+
+    // when half a window passes without frames
+    uint32_t lastFrameAt = testMicros;
+    runUntil(lastFrameAt + RX_STATS_LINK_QUALITY_WINDOW / 2 * FRAME_INTERVAL_US + FRAME_INTERVAL_US / 4);
+
+    // then, give or take the frames in one update interval
+    EXPECT_NEAR(50, rxStats.linkQuality, UPDATE_INTERVAL_US / FRAME_INTERVAL_US + 1);
+
+    // when the link is gone
+    runUntil(lastFrameAt + 5000000);
+
+    // then
+    EXPECT_EQ(0, rxStats.linkQuality);
+    EXPECT_EQ(100, rxStats.lostFramePercent);
+
+    // when the link comes back the lost frames are not counted twice
+    uint32_t lostBeforeReconnect = rxStats.framesLost;
+    receiveFrame(lastFrameAt + 600 * FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+
+    // then
+    EXPECT_EQ(599u, rxStats.framesLost);
+    EXPECT_GE(rxStats.framesLost, lostBeforeReconnect);
+    EXPECT_EQ(1, rxStats.linkQuality);
+}
+
+TEST(RxStatsTest, FramesFlaggedByTheReceiverCountAsLost)
+{
+    // given
+    startLink();
+
+    // when
+    for (int i = 0; i < RX_STATS_LINK_QUALITY_WINDOW; i++) {
+        uint8_t frameStatus = SERIAL_RX_FRAME_COMPLETE;
+        if (i % 4 == 0) {
+            frameStatus |= SERIAL_RX_FRAME_DROPPED;
+        } else if (i % 4 == 1) {
+            frameStatus |= SERIAL_RX_FRAME_FAILSAFE;
+        }
+        receiveFrame(testMicros + FRAME_INTERVAL_US, frameStatus);
+    }
+
+    // then
+    EXPECT_EQ(50, rxStats.linkQuality);
+    EXPECT_EQ((uint32_t)RX_STATS_LINK_QUALITY_WINDOW / 2, rxStats.signalLossFrames);
+    EXPECT_EQ(0u, rxStats.framesLost);
+}
+
+TEST(RxStatsTest, JitterIsSortedIntoBuckets)
+{
+    static const uint16_t deviations[] = { 0, 31, 40, 100, 200, 500, 1000, 2000, 3000 };
+    static const uint8_t expectedBuckets[] = { 0, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    for (uint8_t i = 0; i < ARRAYLEN(deviations); i++) {
+        // given
+        startLink();
+        for (int frame = 0; frame < 20; frame++) {
+            receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+        }
+        uint16_t before = rxStats.jitterHistogram[expectedBuckets[i]];
+
+        // when
+        receiveFrame(testMicros + FRAME_INTERVAL_US + deviations[i], SERIAL_RX_FRAME_COMPLETE);
+
+        // then
+        EXPECT_EQ(before + 1, rxStats.jitterHistogram[expectedBuckets[i]]);
+    }
+}
+
+TEST(RxStatsTest, FrameIntervalIsLearntAfterAStartWithLostFrames)
+{
+    // given
+    startLink();
+
+    // when the second frame is lost right away
+    receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    receiveFrame(testMicros + 2 * FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    for (int i = 0; i < 10; i++) {
+        receiveFrame(testMicros + FRAME_INTERVAL_US, SERIAL_RX_FRAME_COMPLETE);
+    }
+
+    // then
+    EXPECT_EQ(FRAME_INTERVAL_US, rxStats.frameIntervalUs);
+}
+
+TEST(RxStatsTest, RejectedFramesAreCounted)
+{
+    // given
+    startLink();
+
+    // when
+    rxStatsFramesRejected(3);
+    rxStatsFramesRejected(1);
+
+    // then
+    EXPECT_EQ(4u, rxStats.crcErrors);
+    EXPECT_EQ(0u, rxStats.framesReceived);
+}
@@ -0,0 +1,274 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+
+    #include "drivers/system.h"
+    #include "drivers/serial.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/battery.h"
+
+    #include "io/serial.h"
+
+    #include "config/runtime_config.h"
+    #include "config/config.h"
+
+    #include "telemetry/telemetry.h"
+    #include "telemetry/frsky.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define ID_VOLT             0x06
+#define ID_ALTITUDE_BP      0x10
+#define ID_COURSE_BP        0x14
+#define ID_HOUR_MINUTE      0x17
+#define ID_ACC_X            0x24
+#define ID_VERT_SPEED       0x30
+#define ID_TEMPRATURE1      0x02
+#define ID_LATITUDE_BP      0x13
+
+#define SECONDS_SIMULATED 20
+
+static uint32_t testMicros;
+static uint32_t testFeatureMask;
+
+static uint8_t written[8192];
+static int writtenCount;
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+static telemetryConfig_t testTelemetryConfig;
+
+typedef struct frskyReceived_s {
+    uint32_t idCount[256];
+    uint32_t idFirstAt[256];
+    uint32_t frames;
+    uint32_t bytes;
+} frskyReceived_t;
+
+/*
+ * Splits the written bytes into values, 0x5E ID followed by two stuffed data bytes, and frame tails.
+ */
+static void parseWritten(frskyReceived_t *received, uint32_t atMicros)
+{
+    int index = 0;
+
+    while (index < writtenCount) {
+        ASSERT_EQ(0x5E, written[index]);
+        if (index + 1 == writtenCount || written[index + 1] == 0x5E) {
+            received->frames++;
+            index++;
+            continue;
+        }
+
+        uint8_t id = written[index + 1];
+        if (received->idCount[id]++ == 0) {
+            received->idFirstAt[id] = atMicros;
+        }
+
+        index += 2;
+        for (int dataByte = 0; dataByte < 2; dataByte++) {
+            index += (written[index] == 0x5D) ? 2 : 1;
+        }
+    }
+
+    received->bytes += writtenCount;
+    writtenCount = 0;
+}
+
+/*
+ * Runs the main loop every 2ms, only calling the backend when it asked to be serviced.
+ */
+static uint32_t runTelemetry(frskyReceived_t *received)
+{
+    uint32_t serviceCount = 0;
+    uint32_t nextServiceAt = 0;
+
+    memset(received, 0, sizeof(*received));
+    writtenCount = 0;
+
+    for (testMicros = 0; testMicros < SECONDS_SIMULATED * 1000000; testMicros += 2000) {
+        if ((int32_t)(testMicros - nextServiceAt) < 0) {
+            continue;
+        }
+        serviceCount++;
+        nextServiceAt = handleFrSkyTelemetry(testMicros);
+        parseWritten(received, testMicros);
+    }
+
+    return serviceCount;
+}
+
+static void enableTelemetry(uint32_t features)
+{
+    testFeatureMask = features;
+    testMicros = 0;
+    writtenCount = 0;
+
+    initFrSkyTelemetry(&testTelemetryConfig);
+    freeFrSkyTelemetryPort();
+    checkFrSkyTelemetryState();
+}
+
+TEST(TelemetryFrSkyTest, ValuesAreSentAtTheirRates)
+{
+    // given
+    frskyReceived_t received;
+    enableTelemetry(FEATURE_VBAT);
+
+    // when
+    uint32_t serviceCount = runTelemetry(&received);
+
+    // then, 8Hz, 2Hz, 1Hz and every 5s as with the fixed cycle
+    EXPECT_NEAR(SECONDS_SIMULATED * 8, received.idCount[ID_ACC_X + 0], 2);
+    EXPECT_NEAR(SECONDS_SIMULATED * 8, received.idCount[ID_VERT_SPEED], 2);
+    EXPECT_NEAR(SECONDS_SIMULATED * 2, received.idCount[ID_COURSE_BP], 1);
+    EXPECT_NEAR(SECONDS_SIMULATED, received.idCount[ID_VOLT], 1);
+    EXPECT_NEAR(SECONDS_SIMULATED, received.idCount[ID_TEMPRATURE1], 1);
+    EXPECT_NEAR(SECONDS_SIMULATED / 5, received.idCount[ID_HOUR_MINUTE], 1);
+
+    // and the link budget is respected
+    EXPECT_LE(received.bytes, SECONDS_SIMULATED * 240 + 64);
+
+    // and the backend was only serviced when a frame was due, not every loop
+    EXPECT_LE(serviceCount, received.frames + 2);
+    EXPECT_LT(serviceCount, SECONDS_SIMULATED * 500 / 20);
+}
+
+TEST(TelemetryFrSkyTest, UnavailableValuesAreNotSent)
+{
+    // given
+    frskyReceived_t received;
+    enableTelemetry(0);
+
+    // when
+    runTelemetry(&received);
+
+    // then
+    EXPECT_EQ(0, received.idCount[ID_VOLT]);
+    EXPECT_EQ(0, received.idCount[ID_LATITUDE_BP]);
+
+    // and the baro altitude only once the baro had time to initialise
+    EXPECT_GT(received.idCount[ID_ALTITUDE_BP], 0);
+    EXPECT_GT(received.idFirstAt[ID_ALTITUDE_BP], 5 * 1000000);
+}
+
+TEST(TelemetryFrSkyTest, DisabledBackendIsRarelyServiced)
+{
+    // given
+    testFeatureMask = 0;
+    freeFrSkyTelemetryPort();
+
+    // when
+    uint32_t nextServiceAt = handleFrSkyTelemetry(1000);
+
+    // then
+    EXPECT_EQ(1000 + TELEMETRY_MAX_SERVICE_INTERVAL_US, nextServiceAt);
+    EXPECT_EQ(0, writtenCount);
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t armingFlags;
+uint8_t stateFlags;
+uint16_t flightModeFlags;
+
+int16_t accSmooth[XYZ_AXIS_COUNT];
+uint16_t acc_1G = 256;
+int32_t BaroAlt;
+int32_t baroTemperature;
+int32_t vario;
+int16_t heading;
+int16_t rcCommand[4];
+int16_t telemTemperature1;
+
+uint8_t vbat = 168;
+uint8_t batteryCellCount = 4;
+int32_t amperage;
+int32_t mAhDrawn;
+
+static batteryConfig_t testBatteryConfig;
+batteryConfig_t *batteryConfig = &testBatteryConfig;
+
+int32_t GPS_coord[2];
+uint8_t GPS_numSat;
+uint16_t GPS_hdop;
+uint16_t GPS_altitude;
+uint16_t GPS_speed;
+
+uint32_t micros(void) { return testMicros; }
+uint32_t millis(void) { return testMicros / 1000; }
+
+bool feature(uint32_t mask) { return testFeatureMask & mask; }
+bool sensors(uint32_t mask) { UNUSED(mask); return false; }
+
+uint8_t calculateBatteryCapacityRemainingPercentage(void) { return 50; }
+
+void serialWrite(serialPort_t *instance, uint8_t ch)
+{
+    EXPECT_EQ(&testPort, instance);
+    if (writtenCount < (int)sizeof(written)) {
+        written[writtenCount++] = ch;
+    }
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e functionMask, serialReceiveCallbackPtr callback, uint32_t baudRate, portMode_t mode, serialInversion_e inversion)
+{
+    UNUSED(identifier);
+    UNUSED(functionMask);
+    UNUSED(callback);
+    UNUSED(baudRate);
+    UNUSED(mode);
+    UNUSED(inversion);
+
+    return &testPort;
+}
+
+void closeSerialPort(serialPort_t *serialPort) { UNUSED(serialPort); }
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return &testPortConfig;
+}
+
+portSharing_e determinePortSharing(serialPortConfig_t *portConfig, serialPortFunction_e function)
+{
+    UNUSED(portConfig);
+    UNUSED(function);
+    return PORTSHARING_NOT_SHARED;
+}
+
+bool determineNewTelemetryEnabledState(portSharing_e portSharing)
+{
+    UNUSED(portSharing);
+    return true;
+}
+
+}
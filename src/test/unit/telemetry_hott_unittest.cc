@@ -16,7 +16,9 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <limits.h>
@@ -25,6 +27,7 @@ extern "C" {
     #include "platform.h"
 
     #include "common/axis.h"
+    #include "common/maths.h"
 
     #include "drivers/system.h"
     #include "drivers/serial.h"
@@ -144,6 +147,198 @@ TEST(TelemetryHottTest, PrepareGPSMessage_Altitude1m)
 }
 
 
+#define HOTT_TX_DELAY_MS 3
+#define MAX_WRITES 256
+
+static uint32_t testMicros;
+static uint32_t testSensorsMask;
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+static telemetryConfig_t testTelemetryConfig;
+
+static sysTickCallbackPtr sysTickCallback;
+static bool inSysTick;
+
+static portMode_t portMode;
+static uint8_t rxQueue[8];
+static uint8_t rxQueueLength;
+
+typedef struct hottWrite_s {
+    uint8_t data;
+    uint32_t at;
+    portMode_t mode;
+} hottWrite_t;
+
+static hottWrite_t writes[MAX_WRITES];
+static int writeCount;
+static int writesOutsideSysTick;
+static uint32_t switchedToReceiveAt;
+
+typedef struct hottSimulationResult_s {
+    uint32_t requestedAt;
+    uint32_t handlerCallsWhileSending;
+    uint32_t minGapMs;
+    uint32_t maxGapMs;
+} hottSimulationResult_t;
+
+static void enableTelemetry(void)
+{
+    testMicros = 0;
+    writeCount = 0;
+    writesOutsideSysTick = 0;
+    rxQueueLength = 0;
+    sysTickCallback = NULL;
+
+    initHoTTTelemetry(&testTelemetryConfig);
+    freeHoTTTelemetryPort();
+    checkHoTTTelemetryState();
+}
+
+static void request(uint8_t address)
+{
+    rxQueue[rxQueueLength++] = HOTT_BINARY_MODE_REQUEST_ID;
+    rxQueue[rxQueueLength++] = address;
+}
+
+/*
+ * Runs the systick every millisecond and the main loop every loopTimeMs, the backend is
+ * serviced when it asks to be.  The request is made at the start, the simulation ends when
+ * the port is switched back to receive.
+ */
+static void simulate(hottSimulationResult_t *result, uint8_t address, uint32_t loopTimeMs)
+{
+    uint32_t serviceAt = testMicros;
+    uint32_t endAt = testMicros + 1000 * 1000;
+
+    memset(result, 0, sizeof(*result));
+    writeCount = 0;
+    switchedToReceiveAt = 0;
+
+    request(address);
+    result->requestedAt = testMicros;
+
+    for (uint32_t ms = 0; testMicros < endAt; ms++, testMicros += 1000) {
+        if (sysTickCallback) {
+            inSysTick = true;
+            sysTickCallback();
+            inSysTick = false;
+        }
+
+        if (ms % loopTimeMs == 0 && (int32_t)(testMicros - serviceAt) >= 0) {
+            if (portMode == MODE_TX) {
+                result->handlerCallsWhileSending++;
+            }
+            serviceAt = handleHoTTTelemetry(testMicros);
+        }
+
+        if (switchedToReceiveAt) {
+            break;
+        }
+    }
+
+    result->minGapMs = UINT32_MAX;
+    for (int index = 1; index < writeCount; index++) {
+        uint32_t gapMs = (writes[index].at - writes[index - 1].at) / 1000;
+        result->minGapMs = MIN(result->minGapMs, gapMs);
+        result->maxGapMs = MAX(result->maxGapMs, gapMs);
+    }
+}
+
+static uint8_t responseChecksum(void)
+{
+    uint8_t crc = 0;
+    for (int index = 0; index < writeCount - 1; index++) {
+        crc += writes[index].data;
+    }
+    return crc;
+}
+
+TEST(TelemetryHottTest, ResponseIsSentFromTheSysTickWithFixedGaps)
+{
+    // given
+    hottSimulationResult_t result;
+    testSensorsMask = 0;
+    vbat = 123;
+    enableTelemetry();
+
+    // when
+    simulate(&result, HOTT_TELEMETRY_EAM_SENSOR_ID, 2);
+
+    // then, the whole message and its checksum is sent from the interrupt while the port transmits
+    EXPECT_EQ((int)sizeof(HOTT_EAM_MSG_t) + 1, writeCount);
+    EXPECT_EQ(0, writesOutsideSysTick);
+    for (int index = 0; index < writeCount; index++) {
+        EXPECT_EQ(MODE_TX, writes[index].mode);
+    }
+    EXPECT_EQ(0x7C, writes[0].data);
+    EXPECT_EQ(HOTT_TELEMETRY_EAM_SENSOR_ID, writes[1].data);
+    EXPECT_EQ(vbat, writes[offsetof(HOTT_EAM_MSG_t, main_voltage_L)].data);
+    EXPECT_EQ(0x7D, writes[sizeof(HOTT_EAM_MSG_t) - 1].data);
+    EXPECT_EQ(responseChecksum(), writes[writeCount - 1].data);
+
+    // and every byte is followed by the same gap
+    EXPECT_EQ((uint32_t)HOTT_TX_DELAY_MS, result.minGapMs);
+    EXPECT_EQ((uint32_t)HOTT_TX_DELAY_MS, result.maxGapMs);
+    EXPECT_GE(switchedToReceiveAt - writes[writeCount - 1].at, HOTT_TX_DELAY_MS * 1000U);
+
+    // and the main loop isn't needed while the response goes out
+    EXPECT_LE(result.handlerCallsWhileSending, 3U);
+}
+
+TEST(TelemetryHottTest, SlowLoopDoesNotStretchTheResponse)
+{
+    // given
+    hottSimulationResult_t result;
+    testSensorsMask = 0;
+    enableTelemetry();
+
+    // when
+    simulate(&result, HOTT_TELEMETRY_EAM_SENSOR_ID, 10);
+
+    // then
+    EXPECT_EQ((int)sizeof(HOTT_EAM_MSG_t) + 1, writeCount);
+    EXPECT_EQ((uint32_t)HOTT_TX_DELAY_MS, result.minGapMs);
+    EXPECT_EQ((uint32_t)HOTT_TX_DELAY_MS, result.maxGapMs);
+}
+
+TEST(TelemetryHottTest, GPSResponseFollowsPositionChanges)
+{
+    // given
+    hottSimulationResult_t result;
+    HOTT_GPS_MSG_t expected;
+    testSensorsMask = SENSOR_GPS;
+    stateFlags = GPS_FIX;
+    GPS_numSat = 6;
+    GPS_coord[LAT] = GPS_coord_to_degrees("4710.5186");
+    GPS_coord[LON] = GPS_coord_to_degrees("1151.4252");
+    enableTelemetry();
+
+    // when
+    simulate(&result, HOTT_TELEMETRY_GPS_SENSOR_ID, 2);
+
+    // then
+    memset(&expected, 0, sizeof(expected));
+    addGPSCoordinates(&expected, GPS_coord[LAT], GPS_coord[LON]);
+    EXPECT_EQ(expected.pos_NS_dm_L, writes[offsetof(HOTT_GPS_MSG_t, pos_NS_dm_L)].data);
+    EXPECT_EQ(expected.pos_EW_sec_L, writes[offsetof(HOTT_GPS_MSG_t, pos_EW_sec_L)].data);
+
+    // when, the position changes and the message is due again
+    GPS_coord[LAT] = GPS_coord_to_degrees("5156.3886");
+    GPS_coord[LON] = -GPS_coord_to_degrees("015.9960");
+    testMicros += 200 * 1000;
+    simulate(&result, HOTT_TELEMETRY_GPS_SENSOR_ID, 2);
+
+    // then
+    addGPSCoordinates(&expected, GPS_coord[LAT], GPS_coord[LON]);
+    EXPECT_EQ(expected.pos_NS_dm_L, writes[offsetof(HOTT_GPS_MSG_t, pos_NS_dm_L)].data);
+    EXPECT_EQ(expected.pos_EW, writes[offsetof(HOTT_GPS_MSG_t, pos_EW)].data);
+    EXPECT_EQ(expected.pos_EW_sec_L, writes[offsetof(HOTT_GPS_MSG_t, pos_EW_sec_L)].data);
+    EXPECT_EQ(responseChecksum(), writes[writeCount - 1].data);
+
+    stateFlags = 0;
+}
+
 // STUBS
 
 extern "C" {
@@ -164,26 +359,43 @@ int16_t GPS_directionToHome;        // direction to home or hol point in degrees
 int32_t amperage;
 int32_t mAhDrawn;
 
-uint32_t micros(void) { return 0; }
+uint32_t micros(void) { return testMicros; }
+
+void setSysTickCallback(sysTickCallbackPtr callback) {
+    sysTickCallback = callback;
+}
 
 uint8_t serialTotalBytesWaiting(serialPort_t *instance) {
     UNUSED(instance);
-    return 0;
+    return rxQueueLength;
 }
 
 uint8_t serialRead(serialPort_t *instance) {
     UNUSED(instance);
-    return 0;
+    uint8_t c = rxQueue[0];
+    memmove(rxQueue, rxQueue + 1, --rxQueueLength);
+    return c;
 }
 
 void serialWrite(serialPort_t *instance, uint8_t ch) {
-    UNUSED(instance);
-    UNUSED(ch);
+    EXPECT_EQ(&testPort, instance);
+    if (!inSysTick) {
+        writesOutsideSysTick++;
+    }
+    if (writeCount < MAX_WRITES) {
+        writes[writeCount].data = ch;
+        writes[writeCount].at = testMicros;
+        writes[writeCount].mode = portMode;
+        writeCount++;
+    }
 }
 
 void serialSetMode(serialPort_t *instance, portMode_t mode) {
-    UNUSED(instance);
-    UNUSED(mode);
+    EXPECT_EQ(&testPort, instance);
+    if (portMode == MODE_TX && mode == MODE_RX) {
+        switchedToReceiveAt = testMicros;
+    }
+    portMode = mode;
 }
 
 
@@ -192,10 +404,10 @@ serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFuncti
     UNUSED(functionMask);
     UNUSED(baudRate);
     UNUSED(callback);
-    UNUSED(mode);
     UNUSED(inversion);
 
-    return NULL;
+    portMode = mode;
+    return &testPort;
 }
 
 void closeSerialPort(serialPort_t *serialPort) {
@@ -205,12 +417,11 @@ void closeSerialPort(serialPort_t *serialPort) {
 serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function) {
     UNUSED(function);
 
-    return NULL;
+    return &testPortConfig;
 }
 
 bool sensors(uint32_t mask) {
-    UNUSED(mask);
-    return false;
+    return testSensorsMask & mask;
 }
 
 bool determineNewTelemetryEnabledState(portSharing_e) {
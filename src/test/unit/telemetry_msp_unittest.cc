@@ -0,0 +1,196 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/system.h"
+    #include "drivers/serial.h"
+
+    #include "io/serial.h"
+    #include "io/serial_msp.h"
+
+    #include "telemetry/telemetry.h"
+    #include "telemetry/msp.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define MSP_RESPONSE_OVERHEAD 6
+
+static uint32_t testMicros;
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+static telemetryConfig_t testTelemetryConfig;
+
+static uint32_t commandsSent[MSP_TELEMETRY_COMMAND_COUNT];
+static uint32_t bytesSent;
+
+static const uint16_t responseBodySizes[MSP_TELEMETRY_COMMAND_COUNT] = {
+    [MSP_TELEMETRY_BOXNAMES]   = 180,
+    [MSP_TELEMETRY_STATUS]     = 11,
+    [MSP_TELEMETRY_IDENT]      = 7,
+    [MSP_TELEMETRY_RAW_IMU]    = 18,
+    [MSP_TELEMETRY_ALTITUDE]   = 6,
+    [MSP_TELEMETRY_RAW_GPS]    = 16,
+    [MSP_TELEMETRY_RC]         = 36,
+    [MSP_TELEMETRY_MOTOR_PINS] = 8,
+    [MSP_TELEMETRY_ATTITUDE]   = 6,
+    [MSP_TELEMETRY_SERVO]      = 16,
+};
+
+static void enableTelemetry(baudRate_e baudRateIndex)
+{
+    testMicros = 0;
+    bytesSent = 0;
+    memset(commandsSent, 0, sizeof(commandsSent));
+
+    testPortConfig.telemetry_baudrateIndex = baudRateIndex;
+
+    initMSPTelemetry(&testTelemetryConfig);
+    freeMSPTelemetryPort();
+    checkMSPTelemetryState();
+}
+
+/*
+ * Runs a 2ms main loop, the backend is only called when it asked to be.
+ * Returns the number of times it was called.
+ */
+static uint32_t runLoops(uint32_t loopCount)
+{
+    uint32_t serviceCount = 0;
+    uint32_t serviceAt = 0;
+
+    for (uint32_t loop = 0; loop < loopCount; loop++) {
+        if ((int32_t)(testMicros - serviceAt) >= 0) {
+            serviceAt = handleMSPTelemetry(testMicros);
+            serviceCount++;
+        }
+        testMicros += 2000;
+    }
+
+    return serviceCount;
+}
+
+TEST(TelemetryMspTest, RepliesFitTheBaudRate)
+{
+    // given
+    enableTelemetry(BAUD_9600);
+
+    // when
+    uint32_t serviceCount = runLoops(5000);
+
+    // then, 10 seconds at 960 bytes per second
+    EXPECT_LE(bytesSent / 10, 960U);
+    EXPECT_GT(bytesSent / 10, 600U);
+    EXPECT_LT(serviceCount, 5000U / 2);
+
+    // and attitude and status, the most important replies, are not starved by the big ones on a busy link
+    EXPECT_NEAR(100, commandsSent[MSP_TELEMETRY_ATTITUDE], 5);
+    EXPECT_NEAR(40, commandsSent[MSP_TELEMETRY_STATUS], 2);
+}
+
+TEST(TelemetryMspTest, EveryReplyIsSentAtAFastLink)
+{
+    // given
+    enableTelemetry(BAUD_115200);
+
+    // when
+    runLoops(5000);
+
+    // then, every reply goes out at its own rate
+    EXPECT_NEAR(100, commandsSent[MSP_TELEMETRY_ATTITUDE], 2);
+    EXPECT_NEAR(50, commandsSent[MSP_TELEMETRY_RC], 2);
+    EXPECT_NEAR(20, commandsSent[MSP_TELEMETRY_SERVO], 2);
+    EXPECT_NEAR(2, commandsSent[MSP_TELEMETRY_BOXNAMES], 1);
+}
+
+TEST(TelemetryMspTest, NothingIsSentWhenDisabled)
+{
+    // given
+    enableTelemetry(BAUD_9600);
+    freeMSPTelemetryPort();
+
+    // when
+    uint32_t serviceCount = runLoops(5000);
+
+    // then
+    EXPECT_EQ(0U, bytesSent);
+    EXPECT_LE(serviceCount, 5000U * 2000 / TELEMETRY_MAX_SERVICE_INTERVAL_US + 1);
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000};
+
+uint32_t micros(void) { return testMicros; }
+
+uint16_t sendMspTelemetry(mspTelemetryCommand_e command)
+{
+    uint16_t size = responseBodySizes[command] + MSP_RESPONSE_OVERHEAD;
+
+    commandsSent[command]++;
+    bytesSent += size;
+    return size;
+}
+
+void mspSetTelemetryPort(serialPort_t *serialPort) { EXPECT_EQ(&testPort, serialPort); }
+void mspReleasePortIfAllocated(serialPort_t *serialPort) { UNUSED(serialPort); }
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e functionMask, serialReceiveCallbackPtr callback, uint32_t baudRate, portMode_t mode, serialInversion_e inversion)
+{
+    UNUSED(identifier);
+    UNUSED(functionMask);
+    UNUSED(callback);
+    UNUSED(baudRate);
+    UNUSED(mode);
+    UNUSED(inversion);
+
+    return &testPort;
+}
+
+void closeSerialPort(serialPort_t *serialPort) { UNUSED(serialPort); }
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return &testPortConfig;
+}
+
+portSharing_e determinePortSharing(serialPortConfig_t *portConfig, serialPortFunction_e function)
+{
+    UNUSED(portConfig);
+    UNUSED(function);
+    return PORTSHARING_NOT_SHARED;
+}
+
+bool determineNewTelemetryEnabledState(portSharing_e portSharing)
+{
+    UNUSED(portSharing);
+    return true;
+}
+
+}
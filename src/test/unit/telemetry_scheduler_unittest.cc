@@ -0,0 +1,276 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "telemetry/scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static bool sensorAvailable;
+
+static bool isTestSensorAvailable(void)
+{
+    return sensorAvailable;
+}
+
+typedef enum {
+    SENSOR_FAST = 0,
+    SENSOR_SLOW,
+    SENSOR_LARGE,
+    SENSOR_OPTIONAL,
+    SENSOR_COUNT
+} testSensor_e;
+
+static const telemetrySensor_t testSensors[SENSOR_COUNT] = {
+    [SENSOR_FAST]     = { 0, 4,  100,  NULL },
+    [SENSOR_SLOW]     = { 1, 4,  500,  NULL },
+    [SENSOR_LARGE]    = { 2, 20, 1000, NULL },
+    [SENSOR_OPTIONAL] = { 1, 4,  200,  isTestSensorAvailable },
+};
+
+static telemetryScheduler_t scheduler;
+
+/*
+ * Calls the scheduler every millisecond from start for the given time, the way a backend would, counting how often
+ * each sensor was sent and how often a slot was open.
+ */
+static uint32_t runFrames(uint32_t start, uint32_t durationMs, uint8_t frameSize, uint32_t *sentCount)
+{
+    uint32_t slots = 0;
+
+    for (uint32_t ms = 0; ms < durationMs; ms++) {
+        uint32_t now = start + ms * 1000;
+
+        if (!telemetrySchedulerIsSlotOpen(&scheduler, now)) {
+            continue;
+        }
+        slots++;
+
+        uint8_t frame[SENSOR_COUNT];
+        uint8_t count = telemetrySchedulerFillFrame(&scheduler, now, frameSize, frame, SENSOR_COUNT);
+        uint16_t bytes = 0;
+        for (uint8_t index = 0; index < count; index++) {
+            sentCount[frame[index]]++;
+            bytes += testSensors[frame[index]].size;
+        }
+        telemetrySchedulerFrameSent(&scheduler, now, bytes);
+    }
+
+    return slots;
+}
+
+TEST(TelemetrySchedulerTest, SensorsAreSentAtTheirIntervals)
+{
+    // given
+    uint32_t sentCount[SENSOR_COUNT] = { 0 };
+    sensorAvailable = true;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 10000, 1000);
+
+    // when
+    uint32_t slots = runFrames(1000, 10000, 64, sentCount);
+
+    // then
+    EXPECT_EQ(100, sentCount[SENSOR_FAST]);
+    EXPECT_EQ(20, sentCount[SENSOR_SLOW]);
+    EXPECT_EQ(10, sentCount[SENSOR_LARGE]);
+    EXPECT_EQ(50, sentCount[SENSOR_OPTIONAL]);
+
+    // and the backend only did work when something was due
+    EXPECT_LE(slots, 101);
+}
+
+TEST(TelemetrySchedulerTest, UnavailableSensorsDontKeepTheSlotOpen)
+{
+    // given
+    uint32_t sentCount[SENSOR_COUNT] = { 0 };
+    sensorAvailable = false;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 10000, 0);
+
+    // when
+    uint32_t slots = runFrames(0, 10000, 64, sentCount);
+
+    // then
+    EXPECT_EQ(0, sentCount[SENSOR_OPTIONAL]);
+    EXPECT_EQ(100, sentCount[SENSOR_FAST]);
+    EXPECT_LE(slots, 101);
+}
+
+TEST(TelemetrySchedulerTest, MostImportantSensorsFillTheFrameFirst)
+{
+    // given
+    uint8_t frame[SENSOR_COUNT];
+    sensorAvailable = true;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 10000, 0);
+
+    // when
+    uint8_t count = telemetrySchedulerFillFrame(&scheduler, 0, 8, frame, SENSOR_COUNT);
+
+    // then, the large sensor doesn't fit, of the two priority 1 sensors the first one due wins
+    ASSERT_EQ(2, count);
+    EXPECT_EQ(SENSOR_FAST, frame[0]);
+    EXPECT_EQ(SENSOR_SLOW, frame[1]);
+
+    // when
+    count = telemetrySchedulerFillFrame(&scheduler, 0, 8, frame, SENSOR_COUNT);
+
+    // then, a sensor that doesn't fit is skipped for smaller ones
+    ASSERT_EQ(1, count);
+    EXPECT_EQ(SENSOR_OPTIONAL, frame[0]);
+
+    // when
+    count = telemetrySchedulerFillFrame(&scheduler, 0, 20, frame, SENSOR_COUNT);
+
+    // then
+    ASSERT_EQ(1, count);
+    EXPECT_EQ(SENSOR_LARGE, frame[0]);
+}
+
+TEST(TelemetrySchedulerTest, SlotsArePacedByTheLinkBudget)
+{
+    // given
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 100, 0);
+
+    // when
+    telemetrySchedulerFrameSent(&scheduler, 0, 50);
+
+    // then, 50 bytes take half a second at 100 bytes per second
+    EXPECT_FALSE(telemetrySchedulerIsSlotOpen(&scheduler, 499999));
+    EXPECT_TRUE(telemetrySchedulerIsSlotOpen(&scheduler, 500000));
+}
+
+TEST(TelemetrySchedulerTest, SlotOpensWhenTheNextSensorIsDue)
+{
+    // given
+    uint8_t frame[SENSOR_COUNT];
+    sensorAvailable = true;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 10000, 0);
+
+    // when
+    uint8_t count = telemetrySchedulerFillFrame(&scheduler, 0, 255, frame, SENSOR_COUNT);
+    telemetrySchedulerFrameSent(&scheduler, 0, 32);
+
+    // then
+    EXPECT_EQ(SENSOR_COUNT, count);
+    EXPECT_EQ(100000, scheduler.nextSlotAt);
+}
+
+TEST(TelemetrySchedulerTest, CongestedLinkSendsImportantSensorsMoreOften)
+{
+    // given, a link that can carry 40 bytes per second while 100 are wanted
+    uint32_t sentCount[SENSOR_COUNT] = { 0 };
+    sensorAvailable = true;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 40, 0);
+
+    // when
+    runFrames(0, 10000, 8, sentCount);
+
+    // then
+    uint32_t bytes = 0;
+    for (int index = 0; index < SENSOR_COUNT; index++) {
+        bytes += sentCount[index] * testSensors[index].size;
+    }
+    EXPECT_LE(bytes, 10 * 40 + 8);
+    // and the most important sensor made it into every one of the 50 frames
+    EXPECT_GE(sentCount[SENSOR_FAST], 49);
+    EXPECT_GT(sentCount[SENSOR_FAST], sentCount[SENSOR_SLOW]);
+    EXPECT_GT(sentCount[SENSOR_SLOW], 0);
+}
+
+TEST(TelemetrySchedulerTest, PollsAreAnsweredEvenIfNothingIsDue)
+{
+    // given
+    sensorAvailable = false;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 0, 0);
+
+    // when
+    int sent[SENSOR_COUNT] = { 0 };
+    for (uint32_t poll = 0; poll < 1000; poll++) {
+        int8_t sensor = telemetrySchedulerNextSensor(&scheduler, poll * 12000);
+        ASSERT_GE(sensor, 0);
+        sent[sensor]++;
+    }
+
+    // then every poll was answered, important and frequent values more often
+    EXPECT_EQ(0, sent[SENSOR_OPTIONAL]);
+    EXPECT_EQ(1000, sent[SENSOR_FAST] + sent[SENSOR_SLOW] + sent[SENSOR_LARGE]);
+    EXPECT_GT(sent[SENSOR_FAST], sent[SENSOR_SLOW]);
+    EXPECT_GE(sent[SENSOR_SLOW], 24);
+    EXPECT_GE(sent[SENSOR_LARGE], 12);
+}
+
+TEST(TelemetrySchedulerTest, NoPollAnswerWithoutAvailableSensors)
+{
+    // given
+    static const telemetrySensor_t optionalSensors[] = {
+        { 0, 4, 100, isTestSensorAvailable },
+    };
+    sensorAvailable = false;
+    telemetrySchedulerInit(&scheduler, optionalSensors, 1, 0, 0);
+
+    // expect
+    EXPECT_EQ(-1, telemetrySchedulerNextSensor(&scheduler, 0));
+}
+
+TEST(TelemetrySchedulerTest, TakeSensorOnlyWhenDue)
+{
+    // given
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 0, 0);
+
+    // expect
+    EXPECT_TRUE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, 0));
+    EXPECT_FALSE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, 100000));
+    EXPECT_FALSE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, 499999));
+    EXPECT_TRUE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, 500000));
+}
+
+TEST(TelemetrySchedulerTest, MicrosWrapAround)
+{
+    // given
+    uint32_t sentCount[SENSOR_COUNT] = { 0 };
+    sensorAvailable = true;
+    uint32_t start = 0xFFFFFFFF - 5000 * 1000;
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 10000, start);
+
+    // when
+    runFrames(start, 10000, 64, sentCount);
+
+    // then
+    EXPECT_EQ(100, sentCount[SENSOR_FAST]);
+    EXPECT_EQ(20, sentCount[SENSOR_SLOW]);
+}
+
+TEST(TelemetrySchedulerTest, StaleSensorIsDueAfterALongGap)
+{
+    // given
+    telemetrySchedulerInit(&scheduler, testSensors, SENSOR_COUNT, 0, 0);
+    EXPECT_TRUE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, 0));
+
+    // when, micros() has moved on so far that the due time looks like the future
+    uint32_t now = 0x80000000 + 1000;
+
+    // then
+    EXPECT_TRUE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, now));
+    EXPECT_FALSE(telemetrySchedulerTakeSensor(&scheduler, SENSOR_SLOW, now + 1000));
+}
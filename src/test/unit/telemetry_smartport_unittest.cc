@@ -0,0 +1,431 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "drivers/system.h"
+    #include "drivers/serial.h"
+
+    #include "sensors/sensors.h"
+    #include "sensors/battery.h"
+
+    #include "io/serial.h"
+
+    #include "config/runtime_config.h"
+
+    #include "telemetry/telemetry.h"
+    #include "telemetry/smartport.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define FSSP_START_STOP     0x7E
+#define FSSP_DATA_FRAME     0x10
+#define FSSP_SENSOR_ID1     0x1B
+
+#define FSSP_DATAID_VFAS    0x0210
+#define FSSP_DATAID_LATLONG 0x0800
+#define FSSP_DATAID_VARIO   0x0110
+
+#define FSSP_SENSOR_OTHER   0x22
+
+// the receiver polls one sensor ID after another and only waits a few ms for the answer
+#define POLL_INTERVAL_US        12000
+#define RESPONSE_WINDOW_US      4000
+#define SIMULATION_TICK_US      500
+
+static uint32_t testMicros;
+static uint32_t testSensorsMask;
+
+// ports receiving with DMA don't call back, the bytes have to be read
+static bool useRxCallback;
+static serialReceiveCallbackPtr rxCallback;
+static bool inRxCallback;
+
+static uint8_t rxBuffer[16];
+static int rxHead;
+static int rxTail;
+
+static uint8_t written[256];
+static int writtenCount;
+static uint32_t firstWrittenAt;
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+static telemetryConfig_t testTelemetryConfig;
+
+typedef struct smartPortResponse_s {
+    uint16_t id;
+    uint32_t value;
+} smartPortResponse_t;
+
+typedef struct simulationResult_s {
+    int polls;
+    int answered;
+    uint32_t maxLatencyUs;
+    uint32_t handlerCalls;
+    uint32_t vfasValue;
+    int varioCount;
+    int latitudeCount;
+    int longitudeCount;
+} simulationResult_t;
+
+static void receive(uint8_t c)
+{
+    if (useRxCallback) {
+        inRxCallback = true;
+        rxCallback(c);
+        inRxCallback = false;
+        return;
+    }
+
+    rxBuffer[rxHead] = c;
+    rxHead = (rxHead + 1) % sizeof(rxBuffer);
+}
+
+/*
+ * Unstuffs and checks a response package, returns false if nothing was written.
+ */
+static bool parseResponse(smartPortResponse_t *response)
+{
+    uint8_t package[8];
+    int length = 0;
+    uint16_t crc = 0;
+
+    if (writtenCount == 0) {
+        return false;
+    }
+
+    for (int index = 0; index < writtenCount && length < 8; index++) {
+        uint8_t c = written[index];
+        if (c == 0x7D) {
+            c = written[++index] ^ 0x20;
+        }
+        package[length++] = c;
+    }
+    writtenCount = 0;
+
+    EXPECT_EQ(8, length);
+    EXPECT_EQ(FSSP_DATA_FRAME, package[0]);
+
+    for (int index = 0; index < 7; index++) {
+        crc += package[index];
+        crc += crc >> 8;
+        crc &= 0x00FF;
+    }
+    EXPECT_EQ(0xFF - (uint8_t)crc, package[7]);
+
+    response->id = package[1] | package[2] << 8;
+    response->value = package[3] | package[4] << 8 | package[5] << 16 | (uint32_t)package[6] << 24;
+    return true;
+}
+
+static void enableTelemetry(bool withRxCallback)
+{
+    testMicros = 0;
+    rxHead = rxTail = 0;
+    writtenCount = 0;
+    useRxCallback = withRxCallback;
+    rxCallback = NULL;
+
+    initSmartPortTelemetry(&testTelemetryConfig);
+    freeSmartPortTelemetryPort();
+    checkSmartPortTelemetryState();
+}
+
+static void checkResponse(simulationResult_t *result, uint32_t polledAt)
+{
+    smartPortResponse_t response;
+
+    if (writtenCount == 0 || firstWrittenAt - polledAt > RESPONSE_WINDOW_US) {
+        return;
+    }
+
+    result->maxLatencyUs = MAX(result->maxLatencyUs, firstWrittenAt - polledAt);
+
+    if (!parseResponse(&response)) {
+        return;
+    }
+    result->answered++;
+
+    if (response.id == FSSP_DATAID_VFAS) {
+        result->vfasValue = response.value;
+    } else if (response.id == FSSP_DATAID_VARIO) {
+        result->varioCount++;
+    } else if (response.id == FSSP_DATAID_LATLONG) {
+        if (response.value & 0x80000000) {
+            result->longitudeCount++;
+        } else {
+            result->latitudeCount++;
+        }
+    }
+}
+
+/*
+ * Simulates a receiver polling our sensor ID and a main loop that services the backend when it asks to be.
+ * The main loop can be stalled once, e.g. by a slow flash write.
+ */
+static void simulate(simulationResult_t *result, int pollCount, uint32_t loopTimeUs, uint32_t stallAtUs, uint32_t stallUs)
+{
+    uint32_t nextPollAt = POLL_INTERVAL_US / 2;
+    uint32_t polledAt = 0;
+    uint32_t nextLoopAt = 0;
+    uint32_t serviceAt = 0;
+
+    memset(result, 0, sizeof(*result));
+
+    for (testMicros = 0; result->polls < pollCount || testMicros <= polledAt + RESPONSE_WINDOW_US; testMicros += SIMULATION_TICK_US) {
+        if (result->polls < pollCount && testMicros == nextPollAt) {
+            writtenCount = 0;
+            polledAt = testMicros;
+            result->polls++;
+            nextPollAt += POLL_INTERVAL_US;
+
+            receive(FSSP_START_STOP);
+            receive(FSSP_SENSOR_ID1);
+        }
+
+        if (testMicros == nextLoopAt) {
+            if ((int32_t)(testMicros - serviceAt) >= 0) {
+                serviceAt = handleSmartPortTelemetry(testMicros);
+                result->handlerCalls++;
+            }
+            nextLoopAt += loopTimeUs;
+            if (stallUs && testMicros >= stallAtUs) {
+                nextLoopAt += stallUs;
+                stallUs = 0;
+            }
+        }
+
+        if (result->polls && testMicros == polledAt + RESPONSE_WINDOW_US) {
+            checkResponse(result, polledAt);
+        }
+    }
+}
+
+TEST(TelemetrySmartPortTest, EveryPollIsAnsweredFromTheReceiveCallback)
+{
+    // given
+    simulationResult_t result;
+    testSensorsMask = 0;
+    enableTelemetry(true);
+
+    // when
+    simulate(&result, 1000, 2000, 0, 0);
+
+    // then, each poll is answered while the receiver is still listening
+    EXPECT_EQ(1000, result.answered);
+    EXPECT_EQ(0U, result.maxLatencyUs);
+
+    // and the main loop only needs to prepare values, not to catch the polls
+    EXPECT_LT(result.handlerCalls, (uint32_t)1000 * POLL_INTERVAL_US / 2000 / 2);
+
+    // and no poll is wasted on values that can't be sent
+    EXPECT_EQ(0, result.latitudeCount + result.longitudeCount);
+
+    // and the vario goes out at least at its 10Hz, spare polls are used to send values early
+    EXPECT_GE(result.varioCount, 1000 * POLL_INTERVAL_US / 100000 - 2);
+
+    // and values are encoded as before
+    EXPECT_EQ(vbat * 83, result.vfasValue);
+
+    const smartPortStats_t *stats = getSmartPortStats();
+    EXPECT_EQ(1000U, stats->polls);
+    EXPECT_EQ(1000U, stats->responses);
+    EXPECT_EQ(0U, stats->droppedPolls);
+}
+
+TEST(TelemetrySmartPortTest, SlowLoopDoesNotDelayResponses)
+{
+    // given
+    simulationResult_t result;
+    testSensorsMask = 0;
+    enableTelemetry(true);
+
+    // when, the main loop is slower than the receiver's response window
+    simulate(&result, 1000, 10000, 0, 0);
+
+    // then
+    EXPECT_EQ(1000, result.answered);
+    EXPECT_EQ(0U, result.maxLatencyUs);
+    EXPECT_EQ(0U, getSmartPortStats()->droppedPolls);
+}
+
+TEST(TelemetrySmartPortTest, StalledLoopDropsPolls)
+{
+    // given
+    simulationResult_t result;
+    testSensorsMask = 0;
+    enableTelemetry(true);
+
+    // when, the main loop stalls for 100ms
+    simulate(&result, 1000, 2000, 1000000, 100000);
+
+    // then, the value prepared before the stall is sent, the following polls can't be answered
+    const smartPortStats_t *stats = getSmartPortStats();
+    EXPECT_NEAR(100000 / POLL_INTERVAL_US - 1, stats->droppedPolls, 1);
+    EXPECT_EQ(stats->polls, stats->responses + stats->droppedPolls);
+    EXPECT_EQ(stats->responses, (uint32_t)result.answered);
+}
+
+TEST(TelemetrySmartPortTest, PollsAreReadByTheMainLoopWithoutACallback)
+{
+    // given
+    simulationResult_t result;
+    testSensorsMask = 0;
+    enableTelemetry(false);
+
+    // when
+    simulate(&result, 1000, 2000, 0, 0);
+
+    // then, polls are answered on the next loop
+    EXPECT_EQ(1000, result.answered);
+    EXPECT_LE(result.maxLatencyUs, 2000U);
+    EXPECT_EQ(0U, getSmartPortStats()->droppedPolls);
+}
+
+TEST(TelemetrySmartPortTest, GpsPositionIsSentWithAFix)
+{
+    // given
+    simulationResult_t result;
+    testSensorsMask = SENSOR_GPS;
+    ENABLE_STATE(GPS_FIX);
+    enableTelemetry(true);
+
+    // when
+    simulate(&result, 1000, 2000, 0, 0);
+
+    // then
+    EXPECT_NEAR(12, result.latitudeCount, 1);
+    EXPECT_EQ(result.latitudeCount, result.longitudeCount);
+
+    DISABLE_STATE(GPS_FIX);
+}
+
+TEST(TelemetrySmartPortTest, RequestsForOtherSensorsAreIgnored)
+{
+    // given
+    testSensorsMask = 0;
+    enableTelemetry(true);
+    handleSmartPortTelemetry(testMicros);
+
+    // when
+    receive(FSSP_START_STOP);
+    receive(FSSP_SENSOR_OTHER);
+
+    // then
+    EXPECT_EQ(0, writtenCount);
+    EXPECT_EQ(0U, getSmartPortStats()->polls);
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t armingFlags;
+uint8_t stateFlags;
+uint16_t flightModeFlags;
+
+int16_t accSmooth[XYZ_AXIS_COUNT];
+int32_t BaroAlt;
+int32_t vario;
+int16_t heading;
+
+uint8_t vbat = 168;
+int32_t amperage;
+int32_t mAhDrawn;
+
+int32_t GPS_coord[2] = { 515000000, -1000000 };
+uint8_t GPS_numSat;
+uint16_t GPS_altitude;
+uint16_t GPS_speed;
+
+uint32_t micros(void) { return testMicros; }
+uint32_t millis(void) { return testMicros / 1000; }
+
+bool sensors(uint32_t mask) { return testSensorsMask & mask; }
+
+uint8_t serialTotalBytesWaiting(serialPort_t *instance)
+{
+    UNUSED(instance);
+    return (rxHead - rxTail + sizeof(rxBuffer)) % sizeof(rxBuffer);
+}
+
+uint8_t serialRead(serialPort_t *instance)
+{
+    UNUSED(instance);
+    uint8_t c = rxBuffer[rxTail];
+    rxTail = (rxTail + 1) % sizeof(rxBuffer);
+    return c;
+}
+
+void serialWrite(serialPort_t *instance, uint8_t ch)
+{
+    EXPECT_EQ(&testPort, instance);
+    EXPECT_EQ(useRxCallback, inRxCallback);
+    if (writtenCount == 0) {
+        firstWrittenAt = testMicros;
+    }
+    if (writtenCount < (int)sizeof(written)) {
+        written[writtenCount++] = ch;
+    }
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e functionMask, serialReceiveCallbackPtr callback, uint32_t baudRate, portMode_t mode, serialInversion_e inversion)
+{
+    UNUSED(identifier);
+    UNUSED(functionMask);
+    UNUSED(baudRate);
+    UNUSED(mode);
+    UNUSED(inversion);
+
+    rxCallback = callback;
+    return &testPort;
+}
+
+void closeSerialPort(serialPort_t *serialPort) { UNUSED(serialPort); }
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return &testPortConfig;
+}
+
+portSharing_e determinePortSharing(serialPortConfig_t *portConfig, serialPortFunction_e function)
+{
+    UNUSED(portConfig);
+    UNUSED(function);
+    return PORTSHARING_NOT_SHARED;
+}
+
+bool determineNewTelemetryEnabledState(portSharing_e portSharing)
+{
+    UNUSED(portSharing);
+    return true;
+}
+
+}
@@ -0,0 +1,166 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+    #include "build_config.h"
+
+    #include "common/color.h"
+    #include "common/colorconversion.h"
+
+    #include "drivers/light_ws2811strip.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+extern "C" {
+STATIC_UNIT_TESTED void ws2811ExpandLed(const rgbColor24bpp_t *color, uint8_t *dst);
+}
+
+#define STRIP_DATA_SLOTS (WS2811_LED_STRIP_LENGTH * WS2811_BITS_PER_LED)
+
+static uint32_t dmaEnableCount;
+
+// one compare value per bit, the way the full size DMA buffer was filled
+static void referenceExpandLed(const rgbColor24bpp_t *color, uint8_t *dst)
+{
+    uint32_t grb = (color->rgb.g << 16) | (color->rgb.r << 8) | (color->rgb.b);
+
+    for (int8_t index = 23; index >= 0; index--) {
+        *dst++ = (grb & (1 << index)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+    }
+}
+
+/*
+ * Plays the part of the circular DMA channel, appending each half buffer to the transmitted slots once it has been
+ * transferred and handing it back to the driver to refill, until the driver stops the transfer.
+ */
+static int transmitStrip(uint8_t *slots, int maxSlots)
+{
+    int count = 0;
+    uint8_t half = 0;
+
+    while (count + WS2811_DMA_HALF_BUFFER_SIZE <= maxSlots) {
+        memcpy(&slots[count], &ledStripDMABuffer[half * WS2811_DMA_HALF_BUFFER_SIZE], WS2811_DMA_HALF_BUFFER_SIZE);
+        count += WS2811_DMA_HALF_BUFFER_SIZE;
+
+        if (!ws2811FillDMAHalfBuffer(half)) {
+            // the half in flight when the DMA is stopped must keep the line low
+            uint8_t *inFlight = &ledStripDMABuffer[(half ^ 1) * WS2811_DMA_HALF_BUFFER_SIZE];
+            for (int index = 0; index < WS2811_DMA_HALF_BUFFER_SIZE; index++) {
+                EXPECT_EQ(0, inFlight[index]);
+            }
+            ws2811LedDataTransferInProgress = 0;
+            return count;
+        }
+        half ^= 1;
+    }
+
+    ADD_FAILURE() << "transfer did not stop";
+    return count;
+}
+
+static void expectStripTransmitted(const hsvColor_t *colors, const uint8_t *slots, int count)
+{
+    uint8_t expected[WS2811_BITS_PER_LED];
+
+    ASSERT_GE(count, STRIP_DATA_SLOTS + WS2811_DELAY_BUFFER_LENGTH);
+
+    for (uint16_t index = 0; index < WS2811_LED_STRIP_LENGTH; index++) {
+        referenceExpandLed(hsvToRgb24(&colors[index]), expected);
+        EXPECT_EQ(0, memcmp(expected, &slots[index * WS2811_BITS_PER_LED], sizeof(expected))) << "LED " << index;
+    }
+    for (int index = STRIP_DATA_SLOTS; index < count; index++) {
+        EXPECT_EQ(0, slots[index]);
+    }
+}
+
+TEST(WS2812Packed, expansionIsBitExact) {
+    uint8_t expected[WS2811_BITS_PER_LED];
+    uint8_t actual[WS2811_BITS_PER_LED];
+
+    // expect
+    for (uint32_t value = 0; value < 0x1000000; value += 0x010101 + 0x1000) {
+        rgbColor24bpp_t color = { .raw = { (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value } };
+
+        referenceExpandLed(&color, expected);
+        ws2811ExpandLed(&color, actual);
+
+        EXPECT_EQ(0, memcmp(expected, actual, sizeof(expected))) << "colour " << value;
+    }
+}
+
+TEST(WS2812Packed, dmaBufferIsSmall) {
+    // expect
+    EXPECT_EQ(WS2811_DMA_BUFFER_LEDS * WS2811_BITS_PER_LED, sizeof(ledStripDMABuffer));
+    EXPECT_EQ(0, WS2811_DMA_HALF_BUFFER_SIZE % WS2811_BITS_PER_LED);
+    // and a fraction of the buffer that holds the whole encoded strip
+    EXPECT_LT(sizeof(ledStripDMABuffer) * 8, (size_t)(STRIP_DATA_SLOTS + WS2811_DELAY_BUFFER_LENGTH));
+}
+
+TEST(WS2812Packed, transferMatchesFullBuffer) {
+    // given
+    hsvColor_t colors[WS2811_LED_STRIP_LENGTH];
+    static uint8_t slots[4096];
+
+    for (uint16_t index = 0; index < WS2811_LED_STRIP_LENGTH; index++) {
+        colors[index].h = (index * 37) % (HSV_HUE_MAX + 1);
+        colors[index].s = index * 8;
+        colors[index].v = 255 - index * 5;
+    }
+    setStripColors(colors);
+
+    // when
+    dmaEnableCount = 0;
+    ws2811LedStripInit();
+    int count = transmitStrip(slots, sizeof(slots));
+
+    // then
+    EXPECT_EQ(1, dmaEnableCount);
+    expectStripTransmitted(colors, slots, count);
+
+    // when, one LED changes
+    colors[17] = hsv_white;
+    setLedHsv(17, &colors[17]);
+    ws2811UpdateStrip();
+    count = transmitStrip(slots, sizeof(slots));
+
+    // then the whole strip is sent again
+    EXPECT_EQ(2, dmaEnableCount);
+    expectStripTransmitted(colors, slots, count);
+
+    // when, nothing changes
+    ws2811UpdateStrip();
+
+    // then
+    EXPECT_EQ(2, dmaEnableCount);
+    EXPECT_FALSE(ws2811LedDataTransferInProgress);
+}
+
+// STUBS
+
+extern "C" {
+void ws2811LedStripHardwareInit(void) {}
+void ws2811LedStripDMAEnable(void) { dmaEnableCount++; }
+
+const hsvColor_t hsv_white = { 0, 255, 255 };
+const hsvColor_t hsv_black = { 0, 0, 0 };
+}
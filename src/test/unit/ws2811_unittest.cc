@@ -18,11 +18,13 @@
 #include <stdlib.h>
 
 #include <limits.h>
+#include <string.h>
 
 extern "C" {
     #include "build_config.h"
 
     #include "common/color.h"
+    #include "common/colorconversion.h"
 
     #include "drivers/light_ws2811strip.h"
 }
@@ -32,9 +34,12 @@ extern "C" {
 
 extern "C" {
 STATIC_UNIT_TESTED extern uint16_t dmaBufferOffset;
+STATIC_UNIT_TESTED extern uint32_t hsvToRgbCacheMisses;
+STATIC_UNIT_TESTED extern uint32_t ws2811LedsEncoded;
+
+STATIC_UNIT_TESTED rgbColor24bpp_t *cachedHsvToRgb24(const hsvColor_t *color);
 
 STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color);
-STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue);
 }
 
 TEST(WS2812, updateDMABuffer) {
@@ -45,13 +50,7 @@ TEST(WS2812, updateDMABuffer) {
     dmaBufferOffset = 0;
 
     // when
-#if 0
-    updateLEDDMABuffer(color1.rgb.g);
-    updateLEDDMABuffer(color1.rgb.r);
-    updateLEDDMABuffer(color1.rgb.b);
-#else
     fastUpdateLEDDMABuffer(&color1);
-#endif
 
     // then
     EXPECT_EQ(24, dmaBufferOffset);
@@ -90,12 +89,155 @@ TEST(WS2812, updateDMABuffer) {
     byteIndex++;
 }
 
-extern "C" {
-rgbColor24bpp_t* hsvToRgb24(const hsvColor_t *c) {
-    UNUSED(c);
-    return NULL;
+static uint32_t dmaEnableCount;
+
+static void expectLedEncoded(uint16_t index, const hsvColor_t *hsv)
+{
+    uint8_t expected[WS2811_BITS_PER_LED];
+    uint16_t savedOffset = dmaBufferOffset;
+    uint8_t saved[WS2811_BITS_PER_LED];
+
+    memcpy(saved, ledStripDMABuffer, sizeof(saved));
+    dmaBufferOffset = 0;
+    fastUpdateLEDDMABuffer(hsvToRgb24(hsv));
+    memcpy(expected, ledStripDMABuffer, sizeof(expected));
+    memcpy(ledStripDMABuffer, saved, sizeof(saved));
+    dmaBufferOffset = savedOffset;
+
+    EXPECT_EQ(0, memcmp(expected, &ledStripDMABuffer[index * WS2811_BITS_PER_LED], sizeof(expected)));
+}
+
+static void resetStrip(void)
+{
+    setStripColor(&hsv_black);
+    ws2811LedDataTransferInProgress = 0;
+    ws2811LedStripInit();
+    ws2811LedDataTransferInProgress = 0;
+    dmaEnableCount = 0;
+    ws2811LedsEncoded = 0;
+}
+
+TEST(WS2812, initEncodesAllLeds) {
+    // when
+    resetStrip();
+
+    // then
+    for (uint16_t index = 0; index < WS2811_LED_STRIP_LENGTH; index++) {
+        expectLedEncoded(index, &hsv_black);
+    }
+}
+
+TEST(WS2812, unchangedStripIsNotTransferred) {
+    // given
+    resetStrip();
+
+    // when
+    setStripColor(&hsv_black);
+    ws2811UpdateStrip();
+
+    // then
+    EXPECT_EQ(0, dmaEnableCount);
+    EXPECT_EQ(0, ws2811LedsEncoded);
 }
 
+TEST(WS2812, onlyChangedLedsAreEncoded) {
+    // given
+    resetStrip();
+
+    // when
+    setLedHsv(5, &hsv_white);
+    setLedHsv(31, &hsv_white);
+    setLedHsv(7, &hsv_black);
+    ws2811UpdateStrip();
+
+    // then
+    EXPECT_EQ(1, dmaEnableCount);
+    EXPECT_EQ(2, ws2811LedsEncoded);
+    expectLedEncoded(4, &hsv_black);
+    expectLedEncoded(5, &hsv_white);
+    expectLedEncoded(6, &hsv_black);
+    expectLedEncoded(31, &hsv_white);
+
+    // when
+    ws2811LedDataTransferInProgress = 0;
+    setLedValue(5, 100);
+    scaleLedValue(31, 50);
+    ws2811UpdateStrip();
+
+    // then
+    hsvColor_t expected = hsv_white;
+    expected.v = 100;
+    expectLedEncoded(5, &expected);
+    expected.v = 127;
+    expectLedEncoded(31, &expected);
+    EXPECT_EQ(2, dmaEnableCount);
+    EXPECT_EQ(4, ws2811LedsEncoded);
+}
+
+TEST(WS2812, hsvCacheMatchesConversion) {
+    // given
+    uint32_t missesBefore = hsvToRgbCacheMisses;
+
+    // expect
+    for (uint16_t h = 0; h <= HSV_HUE_MAX; h += 7) {
+        for (uint16_t s = 0; s <= HSV_SATURATION_MAX; s += 51) {
+            for (uint16_t v = 0; v <= HSV_VALUE_MAX; v += 51) {
+                hsvColor_t hsv = { h, (uint8_t)s, (uint8_t)v };
+                rgbColor24bpp_t expected = *hsvToRgb24(&hsv);
+                rgbColor24bpp_t *actual = cachedHsvToRgb24(&hsv);
+
+                EXPECT_EQ(0, memcmp(expected.raw, actual->raw, sizeof(expected.raw)));
+                // and a repeated lookup hits
+                uint32_t misses = hsvToRgbCacheMisses;
+                cachedHsvToRgb24(&hsv);
+                EXPECT_EQ(misses, hsvToRgbCacheMisses);
+            }
+        }
+    }
+    EXPECT_GT(hsvToRgbCacheMisses, missesBefore);
+}
+
+TEST(WS2812, updateStripEncodingCost) {
+    // given
+    const int frames = 1000;
+    const hsvColor_t palette[] = { hsv_white, hsv_black, { 120, 0, 255 }, { 240, 0, 255 } };
+    resetStrip();
+    setStripColor(&palette[2]);
+    ws2811UpdateStrip();
+    ws2811LedDataTransferInProgress = 0;
+    ws2811LedsEncoded = 0;
+    uint32_t missesBefore = hsvToRgbCacheMisses;
+
+    // when, a typical frame in which one warning LED blinks
+    for (int i = 0; i < frames; i++) {
+        setStripColor(&palette[2]);
+        setLedHsv(3, &palette[i & 1]);
+        ws2811UpdateStrip();
+        ws2811LedDataTransferInProgress = 0;
+    }
+
+    // then only the blinking LED is encoded, and its colours come from the cache
+    EXPECT_EQ((uint32_t)frames, ws2811LedsEncoded);
+    EXPECT_LE(hsvToRgbCacheMisses - missesBefore, 2U);
+
+    // when, every LED changes every frame
+    ws2811LedsEncoded = 0;
+    for (int i = 0; i < frames; i++) {
+        setStripColor(&palette[i & 3]);
+        ws2811UpdateStrip();
+        ws2811LedDataTransferInProgress = 0;
+    }
+
+    // then every LED is encoded
+    EXPECT_EQ((uint32_t)frames * WS2811_LED_STRIP_LENGTH, ws2811LedsEncoded);
+}
+
+// STUBS
+
+extern "C" {
 void ws2811LedStripHardwareInit(void) {}
-void ws2811LedStripDMAEnable(void) {}
+void ws2811LedStripDMAEnable(void) { dmaEnableCount++; }
+
+const hsvColor_t hsv_white = { 0, 255, 255 };
+const hsvColor_t hsv_black = { 0, 0, 0 };
 }